@@ -0,0 +1,119 @@
+/*
+ * Benchmark of batched value updates.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "testblock.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define DEVICES     20
+#define VALUES      60
+#define CYCLES      1000
+
+/**
+ * Simulate given number of devices, sending info updates to a client.
+ * Prints number of write calls and time needed to send and process the updates.
+ */
+void benchUpdates (TestBlock &block, bool batch)
+{
+	std::vector <rts2core::Connection *> senders;
+	std::vector <rts2core::Connection *> receivers;
+
+	for (int d = 0; d < DEVICES; d++)
+	{
+		int sv[2];
+		if (socketpair (AF_UNIX, SOCK_STREAM, 0, sv))
+		{
+			perror ("socketpair");
+			exit (1);
+		}
+		rts2core::Connection *s = new rts2core::Connection (sv[0], &block);
+		rts2core::Connection *r = new rts2core::Connection (sv[1], &block);
+		s->setBatchValues (batch);
+		for (int i = 0; i < VALUES; i++)
+		{
+			std::ostringstream _os;
+			_os << "value_" << i;
+			r->metaInfo (RTS2_VALUE_DOUBLE, _os.str (), "benchmark value");
+		}
+		block.addConnection (s);
+		block.addConnection (r);
+		senders.push_back (s);
+		receivers.push_back (r);
+	}
+	block.callIdle ();
+
+	struct timeval tv_start, tv_end;
+	gettimeofday (&tv_start, NULL);
+
+	for (int c = 0; c < CYCLES; c++)
+	{
+		for (std::vector <rts2core::Connection *>::iterator iter = senders.begin (); iter != senders.end (); iter++)
+		{
+			(*iter)->startValueBatch ();
+			for (int i = 0; i < VALUES; i++)
+			{
+				std::ostringstream _os;
+				_os << "value_" << i;
+				(*iter)->sendValue (_os.str (), c * 0.001 + i);
+			}
+			(*iter)->endValueBatch ();
+		}
+		block.oneRunLoop ();
+	}
+	for (int i = 0; i < 100; i++)
+		block.oneRunLoop ();
+
+	gettimeofday (&tv_end, NULL);
+
+	unsigned long long total = 0;
+	for (std::vector <rts2core::Connection *>::iterator iter = senders.begin (); iter != senders.end (); iter++)
+		total += (*iter)->getWriteCalls ();
+
+	double dur = (tv_end.tv_sec - tv_start.tv_sec) + (tv_end.tv_usec - tv_start.tv_usec) / 1e6;
+
+	std::cout << std::setw (10) << (batch ? "batched" : "single")
+		<< std::setw (14) << total
+		<< std::setw (14) << (double) total / (DEVICES * CYCLES)
+		<< std::setw (14) << dur
+		<< std::setw (10) << receivers.front ()->getValueDouble ("value_1") << std::endl;
+
+	rts2core::connections_t *conns = block.getConnections ();
+	for (rts2core::connections_t::iterator iter = conns->begin (); iter != conns->end (); iter = conns->erase (iter))
+		delete *iter;
+}
+
+int main (int argc, char **argv)
+{
+	TestBlock block (argc, argv);
+
+	std::cout << DEVICES << " devices, " << VALUES << " values, " << CYCLES << " info cycles" << std::endl;
+	std::cout << std::setw (10) << "mode" << std::setw (14) << "writes" << std::setw (14) << "writes/info" << std::setw (14) << "time [s]" << std::setw (10) << "value_1" << std::endl;
+
+	benchUpdates (block, false);
+	benchUpdates (block, true);
+
+	return 0;
+}
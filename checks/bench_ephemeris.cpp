@@ -0,0 +1,227 @@
+/*
+ * Benchmark of precomputed target ephemeris.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "ephemeris.h"
+
+#include <iostream>
+#include <iomanip>
+
+#include <math.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#define TARGETS        500
+// night length in days
+#define NIGHT          (10 / 24.0)
+// step of constraint checks, in seconds
+#define CONSTRAINT_STEP    60
+// number of schedule entries evaluated for each target, as in GA generations
+#define MERIT_EVALS    2000
+
+double getTime ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/**
+ * Target with constant position and proper motion, as ConstTarget.
+ */
+struct BenchTarget
+{
+	struct ln_equ_posn position;
+	struct ln_equ_posn pm;
+
+	void getPosition (struct ln_equ_posn *pos, double JD)
+	{
+		ln_get_equ_pm (&position, &pm, JD, pos);
+	}
+};
+
+struct ln_lnlat_posn observer = {-17.88, 28.76};
+
+/**
+ * Minimal and maximal altitude, as Target::getMinMaxAlt computes it without tables.
+ */
+void plainMinMaxAlt (BenchTarget *tar, double _start, double _end, double &_min, double &_max)
+{
+	struct ln_equ_posn mid, pos;
+	struct ln_hrz_posn startHrz, endHrz;
+	tar->getPosition (&mid, (_start + _end) / 2.0);
+	double absLat = fabs (observer.lat);
+
+	tar->getPosition (&pos, _start);
+	ln_get_hrz_from_equ (&pos, &observer, _start, &startHrz);
+	tar->getPosition (&pos, _end);
+	ln_get_hrz_from_equ (&pos, &observer, _end, &endHrz);
+
+	_min = (startHrz.alt < endHrz.alt) ? startHrz.alt : endHrz.alt;
+	_max = (startHrz.alt > endHrz.alt) ? startHrz.alt : endHrz.alt;
+
+	double midRa = mid.ra;
+	double startLst = ln_range_degrees (ln_get_mean_sidereal_time (_start) * 15.0 + observer.lng);
+	double endLst = ln_range_degrees (ln_get_mean_sidereal_time (_end) * 15.0 + observer.lng);
+	if (startLst > endLst)
+	{
+		endLst += 360.0;
+		if (startLst > midRa)
+			midRa += 360.0;
+	}
+	if (midRa > startLst && midRa < endLst)
+		_max = 90 - absLat + mid.dec;
+	midRa = ln_range_degrees (midRa + 180);
+	if (midRa > endLst + 360)
+		midRa = endLst - 360;
+	if (midRa > startLst && midRa < endLst)
+		_min = absLat - 90 + mid.dec;
+}
+
+/**
+ * Constraint checks and merits computed with libnova calls.
+ */
+double plainNight (BenchTarget *targets, double from, double *intervals)
+{
+	double ret = 0;
+	struct ln_equ_posn pos, moon;
+	struct ln_hrz_posn hrz;
+	for (int t = 0; t < TARGETS; t++)
+	{
+		BenchTarget *tar = targets + t;
+		for (double JD = from; JD <= from + NIGHT; JD += CONSTRAINT_STEP / 86400.0)
+		{
+			tar->getPosition (&pos, JD);
+			ln_get_hrz_from_equ (&pos, &observer, JD, &hrz);
+			ret += ln_get_airmass (hrz.alt, 750.0);
+
+			tar->getPosition (&pos, JD);
+			double ha = ln_range_degrees (ln_get_mean_sidereal_time (JD) * 15.0 + observer.lng - pos.ra);
+			if (ha > 180)
+				ha -= 360;
+			ret += ha;
+
+			ln_get_lunar_equ_coords (JD, &moon);
+			tar->getPosition (&pos, JD);
+			ret += ln_get_angular_separation (&pos, &moon);
+		}
+		for (int m = 0; m < MERIT_EVALS; m++)
+		{
+			double minA, maxA;
+			double s = intervals[2 * m];
+			double e = intervals[2 * m + 1];
+			plainMinMaxAlt (tar, s, e, minA, maxA);
+			tar->getPosition (&pos, (s + e) / 2.0);
+			ln_get_hrz_from_equ (&pos, &observer, (s + e) / 2.0, &hrz);
+			ret += hrz.alt + minA + maxA;
+		}
+	}
+	return ret;
+}
+
+/**
+ * Constraint checks and merits computed from precomputed tables.
+ */
+double tableNight (BenchTarget *targets, double from, double *intervals, double step, double &buildTime)
+{
+	double t1 = getTime ();
+	rts2core::NightEphemeris night (&observer, from, from + NIGHT, step);
+	rts2core::TargetEphemeris **tables = new rts2core::TargetEphemeris*[TARGETS];
+	for (int t = 0; t < TARGETS; t++)
+	{
+		tables[t] = new rts2core::TargetEphemeris (&night);
+		tables[t]->fill (targets + t);
+	}
+	buildTime = getTime () - t1;
+
+	double ret = 0;
+	struct ln_hrz_posn hrz;
+	for (int t = 0; t < TARGETS; t++)
+	{
+		rts2core::TargetEphemeris *tab = tables[t];
+		for (double JD = from; JD <= from + NIGHT; JD += CONSTRAINT_STEP / 86400.0)
+		{
+			tab->getAltAz (&hrz, JD);
+			ret += ln_get_airmass (hrz.alt, 750.0);
+			ret += tab->getHourAngle (JD);
+			ret += tab->getLunarDistance (JD);
+		}
+		for (int m = 0; m < MERIT_EVALS; m++)
+		{
+			double minA, maxA;
+			double s = intervals[2 * m];
+			double e = intervals[2 * m + 1];
+			tab->getMinMaxAlt (s, e, minA, maxA);
+			tab->getAltAz (&hrz, (s + e) / 2.0);
+			ret += hrz.alt + minA + maxA;
+		}
+		delete tab;
+	}
+	delete[] tables;
+	return ret;
+}
+
+int main (int argc, char **argv)
+{
+	double from = 2461000.3;
+
+	srandom (1);
+
+	BenchTarget *targets = new BenchTarget[TARGETS];
+	for (int t = 0; t < TARGETS; t++)
+	{
+		targets[t].position.ra = 360.0 * random () / RAND_MAX;
+		targets[t].position.dec = -60 + 150.0 * random () / RAND_MAX;
+		targets[t].pm.ra = 0.001 * random () / RAND_MAX;
+		targets[t].pm.dec = 0.001 * random () / RAND_MAX;
+	}
+
+	// observation intervals, 5 to 60 minutes long
+	double *intervals = new double[2 * MERIT_EVALS];
+	for (int m = 0; m < MERIT_EVALS; m++)
+	{
+		double len = (5 + 55.0 * random () / RAND_MAX) / 1440.0;
+		intervals[2 * m] = from + (NIGHT - len) * random () / RAND_MAX;
+		intervals[2 * m + 1] = intervals[2 * m] + len;
+	}
+
+	std::cout << TARGETS << " targets, " << NIGHT * 24 << " hours night, constraints checked every " << CONSTRAINT_STEP << " s, " << MERIT_EVALS << " merit evaluations per target" << std::endl;
+
+	double t1 = getTime ();
+	double r1 = plainNight (targets, from, intervals);
+	double t2 = getTime ();
+
+	std::cout << std::setw (12) << "step [s]" << std::setw (14) << "plain [ms]" << std::setw (14) << "build [ms]" << std::setw (14) << "table [ms]" << std::setw (10) << "speedup" << std::setw (14) << "rel. diff" << std::endl;
+
+	double steps[] = {30, 60, 300};
+	for (size_t i = 0; i < sizeof (steps) / sizeof (double); i++)
+	{
+		double buildTime;
+		double t3 = getTime ();
+		double r2 = tableNight (targets, from, intervals, steps[i], buildTime);
+		double t4 = getTime ();
+
+		std::cout << std::setw (12) << steps[i] << std::setw (14) << (t2 - t1) * 1000 << std::setw (14) << buildTime * 1000
+			<< std::setw (14) << (t4 - t3) * 1000 << std::setw (10) << (t2 - t1) / (t4 - t3)
+			<< std::setw (14) << fabs (r1 - r2) / fabs (r1) << std::endl;
+	}
+
+	delete[] intervals;
+	delete[] targets;
+	return 0;
+}
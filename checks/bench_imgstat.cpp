@@ -0,0 +1,111 @@
+/*
+ * Benchmark of image statistics calculation.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "imgstat.h"
+
+#include <iostream>
+#include <iomanip>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+// size of readout chunk
+#define CHUNK_SIZE     (1024 * 1024)
+
+double getTime ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/**
+ * Per-pixel loop, as it was used before ImageStatistics.
+ */
+double plainStatistics (uint16_t *data, size_t npix, uint32_t *modeCount)
+{
+	long double tSum = 0;
+	double tMin = 65536;
+	double tMax = -1;
+	memset (modeCount, 0, 65536 * sizeof (uint32_t));
+	for (size_t c = 0; c < npix; c += CHUNK_SIZE)
+	{
+		uint16_t *end = data + (c + CHUNK_SIZE < npix ? c + CHUNK_SIZE : npix);
+		for (uint16_t *tData = data + c; tData < end; tData++)
+		{
+			uint16_t tD = *tData;
+			tSum += tD;
+			if (tD < tMin)
+				tMin = tD;
+			if (tD > tMax)
+				tMax = tD;
+			modeCount[(long) tD]++;
+		}
+	}
+	return tSum / npix + tMin + tMax;
+}
+
+double kernelStatistics (uint16_t *data, size_t npix, rts2core::ImageStatistics &stat)
+{
+	stat.reset ();
+	for (size_t c = 0; c < npix; c += CHUNK_SIZE)
+		stat.update (data + c, c + CHUNK_SIZE < npix ? CHUNK_SIZE : npix - c);
+	return stat.getAverage () + stat.getMin () + stat.getMax ();
+}
+
+int main (int argc, char **argv)
+{
+	int sizes[] = {4096, 9216};
+
+	uint32_t *modeCount = new uint32_t[65536];
+	rts2core::ImageStatistics stat;
+
+	std::cout << std::setw (12) << "frame" << std::setw (14) << "plain [ms]" << std::setw (14) << "kernel [ms]" << std::setw (10) << "speedup" << std::endl;
+
+	for (size_t i = 0; i < sizeof (sizes) / sizeof (int); i++)
+	{
+		size_t npix = (size_t) sizes[i] * sizes[i];
+		uint16_t *data = new uint16_t[npix];
+		// sky background with some noise
+		for (size_t p = 0; p < npix; p++)
+			data[p] = 1000 + random () % 200;
+
+		double t1 = getTime ();
+		double r1 = plainStatistics (data, npix, modeCount);
+		double t2 = getTime ();
+		double r2 = kernelStatistics (data, npix, stat);
+		double t3 = getTime ();
+
+		if (fabs (r1 - r2) > 1e-6)
+		{
+			std::cerr << "results differ: " << r1 << " " << r2 << std::endl;
+			return 1;
+		}
+
+		std::cout << std::setw (6) << sizes[i] << "x" << std::setw (5) << sizes[i]
+			<< std::setw (14) << (t2 - t1) * 1000 << std::setw (14) << (t3 - t2) * 1000
+			<< std::setw (10) << (t2 - t1) / (t3 - t2) << std::endl;
+
+		delete[] data;
+	}
+	delete[] modeCount;
+	return 0;
+}
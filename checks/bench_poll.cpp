@@ -0,0 +1,96 @@
+/*
+ * Benchmark of Block event loop with many idle connections.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "testblock.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/**
+ * Run event loop with given number of idle connections, return time of single iteration in usec.
+ */
+double benchLoop (TestBlock &block, int nconn, int loops)
+{
+	std::vector <int> peers;
+	for (int i = 0; i < nconn; i++)
+	{
+		int sv[2];
+		if (socketpair (AF_UNIX, SOCK_STREAM, 0, sv))
+		{
+			perror ("socketpair");
+			exit (1);
+		}
+		block.addConnection (new rts2core::Connection (sv[0], &block));
+		peers.push_back (sv[1]);
+	}
+	// move connections from added list
+	block.callIdle ();
+
+	struct timeval tv_start, tv_end;
+	gettimeofday (&tv_start, NULL);
+	for (int i = 0; i < loops; i++)
+		block.oneRunLoop ();
+	gettimeofday (&tv_end, NULL);
+
+	rts2core::connections_t *conns = block.getConnections ();
+	for (rts2core::connections_t::iterator iter = conns->begin (); iter != conns->end (); iter = conns->erase (iter))
+		delete *iter;
+	for (std::vector <int>::iterator iter = peers.begin (); iter != peers.end (); iter++)
+		close (*iter);
+
+	return ((tv_end.tv_sec - tv_start.tv_sec) * 1e6 + (tv_end.tv_usec - tv_start.tv_usec)) / loops;
+}
+
+int main (int argc, char **argv)
+{
+	struct rlimit rl;
+	getrlimit (RLIMIT_NOFILE, &rl);
+	rl.rlim_cur = rl.rlim_max;
+	setrlimit (RLIMIT_NOFILE, &rl);
+
+	TestBlock block (argc, argv);
+
+	int sizes[] = {10, 100, 1000};
+
+	std::cout << std::setw (12) << "connections" << std::setw (16) << "ppoll [usec]" << std::setw (16) << "epoll [usec]" << std::endl;
+
+	for (size_t i = 0; i < sizeof (sizes) / sizeof (int); i++)
+	{
+		int loops = 100000 / sizes[i];
+
+		block.setUseEpoll (false);
+		double t_ppoll = benchLoop (block, sizes[i], loops);
+
+		if (block.setUseEpoll (true))
+		{
+			std::cout << std::setw (12) << sizes[i] << std::setw (16) << t_ppoll << std::setw (16) << "n/a" << std::endl;
+			continue;
+		}
+		double t_epoll = benchLoop (block, sizes[i], loops);
+
+		std::cout << std::setw (12) << sizes[i] << std::setw (16) << t_ppoll << std::setw (16) << t_epoll << std::endl;
+	}
+	return 0;
+}
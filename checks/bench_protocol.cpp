@@ -0,0 +1,120 @@
+/*
+ * Benchmark of RTS2 protocol parsing.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "testblock.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/**
+ * Generate stream which looks like value updates from a mount - metainfo
+ * for values, followed by value updates.
+ */
+std::string generateStream (int nvalues, int updates)
+{
+	std::ostringstream _os;
+	_os.setf (std::ios_base::fixed, std::ios_base::floatfield);
+	_os.precision (20);
+	for (int i = 0; i < nvalues; i++)
+		_os << PROTO_METAINFO " " << (i % 2 ? RTS2_VALUE_DOUBLE : RTS2_VALUE_INTEGER) << " \"value_" << i << "\" \"benchmark value " << i << "\"\n";
+	for (int u = 0; u < updates; u++)
+	{
+		for (int i = 0; i < nvalues; i++)
+		{
+			_os << PROTO_VALUE " value_" << i << " ";
+			if (i % 2)
+				_os << (u * 0.001 + i);
+			else
+				_os << (u + i);
+			_os << "\n";
+		}
+	}
+	return _os.str ();
+}
+
+/**
+ * Replay protocol stream, captured for example with socat, or generated by the benchmark.
+ * Prints number of processed lines per second.
+ */
+int main (int argc, char **argv)
+{
+	std::string stream;
+	if (argc > 1)
+	{
+		std::ifstream ifs (argv[1]);
+		if (!ifs.good ())
+		{
+			std::cerr << "cannot open " << argv[1] << std::endl;
+			return 1;
+		}
+		std::ostringstream _os;
+		_os << ifs.rdbuf ();
+		stream = _os.str ();
+	}
+	else
+	{
+		stream = generateStream (200, 1000);
+	}
+
+	long lines = std::count (stream.begin (), stream.end (), '\n');
+
+	TestBlock block (1, argv);
+
+	int sv[2];
+	if (socketpair (AF_UNIX, SOCK_STREAM, 0, sv))
+	{
+		perror ("socketpair");
+		return 1;
+	}
+	fcntl (sv[1], F_SETFL, O_NONBLOCK);
+
+	rts2core::Connection *conn = new rts2core::Connection (sv[0], &block);
+	block.addConnection (conn);
+	block.callIdle ();
+
+	struct timeval tv_start, tv_end;
+	gettimeofday (&tv_start, NULL);
+
+	size_t written = 0;
+	while (written < stream.length ())
+	{
+		ssize_t ret = write (sv[1], stream.c_str () + written, stream.length () - written);
+		if (ret > 0)
+			written += ret;
+		block.oneRunLoop ();
+	}
+	// process rest of the data
+	for (int i = 0; i < 1000; i++)
+		block.oneRunLoop ();
+
+	gettimeofday (&tv_end, NULL);
+
+	double dur = (tv_end.tv_sec - tv_start.tv_sec) + (tv_end.tv_usec - tv_start.tv_usec) / 1e6;
+
+	std::cout << lines << " lines in " << dur << " seconds, " << (lines / dur) << " lines/second, " << conn->valueSize () << " values" << std::endl;
+
+	close (sv[1]);
+	return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * Benchmark of value lookup by name.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "valuelist.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include <stdlib.h>
+#include <sys/time.h>
+
+// number of values of the simulated device
+#define VALUES      300
+// number of value updates in the storm
+#define UPDATES     1000000
+// metaInfo re-creation of a value happens once per this number of updates
+#define META_EVERY  1000
+
+double getTime ()
+{
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+/**
+ * Linear lookup, as ValueVector::getValue did before it was indexed.
+ */
+rts2core::Value *linearGetValue (rts2core::ValueVector &values, const char *name)
+{
+	for (rts2core::ValueVector::iterator iter = values.begin (); iter != values.end (); iter++)
+	{
+		if ((*iter)->isValue (name))
+			return *iter;
+	}
+	return NULL;
+}
+
+/**
+ * Replay update storm. Every META_EVERY update the value is removed
+ * and created again, as happens when metaInfo is received.
+ */
+double replay (rts2core::ValueVector &values, std::vector <std::string> &names, std::vector <int> &updates, bool indexed)
+{
+	double sum = 0;
+	char buf[50];
+	for (size_t i = 0; i < updates.size (); i++)
+	{
+		const char *name = names[updates[i]].c_str ();
+		if (i % META_EVERY == 0)
+		{
+			rts2core::ValueVector::iterator iter = values.removeValue (name);
+			values.insert (iter, new rts2core::ValueDouble (name));
+		}
+		rts2core::Value *val = indexed ? values.getValue (name) : linearGetValue (values, name);
+		if (val == NULL)
+		{
+			std::cerr << "value " << name << " not found" << std::endl;
+			exit (1);
+		}
+		snprintf (buf, 50, "%d", (int) i);
+		val->setValueCharArr (buf);
+		sum += val->getValueDouble ();
+	}
+	return sum;
+}
+
+int main (int argc, char **argv)
+{
+	rts2core::ValueVector values;
+	std::vector <std::string> names;
+
+	for (int i = 0; i < VALUES; i++)
+	{
+		std::ostringstream os;
+		os << "DEVICE_VALUE_" << i;
+		names.push_back (os.str ());
+		values.push_back (new rts2core::ValueDouble (os.str ()));
+	}
+
+	srandom (1);
+	std::vector <int> updates (UPDATES);
+	for (size_t i = 0; i < updates.size (); i++)
+		updates[i] = random () % VALUES;
+
+	std::cout << VALUES << " values, " << UPDATES << " updates, value re-created every " << META_EVERY << " updates" << std::endl;
+
+	double t1 = getTime ();
+	double s1 = replay (values, names, updates, false);
+	double t2 = getTime ();
+	double s2 = replay (values, names, updates, true);
+	double t3 = getTime ();
+
+	if (s1 != s2)
+	{
+		std::cerr << "checksum mismatch " << s1 << " " << s2 << std::endl;
+		return 1;
+	}
+
+	std::cout << std::setw (12) << "linear [ms]" << std::setw (14) << "indexed [ms]" << std::setw (10) << "speedup" << std::endl;
+	std::cout << std::setw (12) << (t2 - t1) * 1000 << std::setw (14) << (t3 - t2) * 1000 << std::setw (10) << (t2 - t1) / (t3 - t2) << std::endl;
+
+	for (rts2core::ValueVector::iterator iter = values.begin (); iter != values.end (); iter++)
+		delete *iter;
+	values.clear ();
+	return 0;
+}
@@ -0,0 +1,197 @@
+#include "binlog.h"
+#include "value.h"
+
+#include <check.h>
+#include <check_utils.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sstream>
+
+#define BINLOG_TEST_FILE   "check_binlog.bin"
+
+using namespace rts2logd;
+
+void setup_binlog (void)
+{
+	unlink (BINLOG_TEST_FILE);
+}
+
+void teardown_binlog (void)
+{
+	unlink (BINLOG_TEST_FILE);
+}
+
+static int writeRecords (const char *filename, int from, int to)
+{
+	std::vector <BinLogColumn> cols;
+	cols.push_back (BinLogColumn ("temperature", RTS2_VALUE_DOUBLE));
+	cols.push_back (BinLogColumn ("TEL", RTS2_VALUE_RADEC));
+
+	BinLogWriter *w = BinLogWriter::open (filename);
+	int d = w->addDevice ("T0", cols);
+	for (int i = from; i < to; i++)
+	{
+		double v[3] = {i * 0.5, i, -i};
+		w->writeRecord (d, 1000 + i, v);
+	}
+	w->release ();
+	return d;
+}
+
+START_TEST(query)
+{
+	int d = writeRecords (BINLOG_TEST_FILE, 0, 1000);
+	// appended records reuse device
+	ck_assert_int_eq (writeRecords (BINLOG_TEST_FILE, 1000, 1100), d);
+
+	BinLogReader reader;
+	reader.open (BINLOG_TEST_FILE);
+	ck_assert_int_eq (reader.getRecordCount (), 1100);
+	ck_assert_int_eq (reader.getDevices ().size (), 1);
+	ck_assert_dbl_eq (reader.getStart (), 1000, 10e-10);
+	ck_assert_dbl_eq (reader.getEnd (), 2099, 10e-10);
+
+	BinLogDevice *dev = reader.getDevice ("T0");
+	ck_assert (dev != NULL);
+	ck_assert_int_eq (dev->findSlot ("temperature"), 0);
+	ck_assert_int_eq (dev->findSlot ("TEL.RA"), 1);
+	ck_assert_int_eq (dev->findSlot ("TEL.DEC"), 2);
+	ck_assert_int_eq (dev->findSlot ("TEL.ALT"), 1);
+	ck_assert_int_eq (dev->findSlot ("nonexistent"), -1);
+
+	std::vector <const BinLogRecordHeader *> records;
+	reader.query (d, 1500, 1599.5, records);
+	ck_assert_int_eq (records.size (), 100);
+	ck_assert_dbl_eq (records[0]->time, 1500, 10e-10);
+	ck_assert_dbl_eq (BinLogReader::getValues (records[0])[2], -500, 10e-10);
+
+	std::vector <BinLogBin> bins;
+	reader.downsample (d, 0, 1000, 2099, 100, bins);
+	ck_assert_int_eq (bins.size (), 11);
+	ck_assert_int_eq (bins[0].count, 100);
+	ck_assert_dbl_eq (bins[0].mean, 24.75, 10e-10);
+	ck_assert_dbl_eq (bins[0].min, 0, 10e-10);
+	ck_assert_dbl_eq (bins[0].max, 49.5, 10e-10);
+}
+END_TEST
+
+START_TEST(damaged_end)
+{
+	writeRecords (BINLOG_TEST_FILE, 0, 300);
+
+	// incomplete record at the end of file
+	FILE *f = fopen (BINLOG_TEST_FILE, "a");
+	fwrite ("RREC", 4, 1, f);
+	fclose (f);
+
+	BinLogReader reader;
+	reader.open (BINLOG_TEST_FILE);
+	ck_assert_int_eq (reader.getRecordCount (), 300);
+	reader.close ();
+
+	// writer truncates damaged data
+	writeRecords (BINLOG_TEST_FILE, 300, 310);
+	reader.open (BINLOG_TEST_FILE);
+	ck_assert_int_eq (reader.getRecordCount (), 310);
+}
+END_TEST
+
+START_TEST(from_text)
+{
+	std::map <std::string, std::vector <std::string> > config;
+	config["T0"].push_back ("infotime");
+	config["T0"].push_back ("TEL:radec");
+	config["T0"].push_back ("temperature");
+	// device without values
+	config["D0"];
+
+	std::istringstream is (
+		"T0 1000.5 120.5 -20.25 12.5\n"
+		"D0\n"
+		"T0 1001.5 nan nan 13.5\n"
+		"T0 1002.5 121.5 14.5\n");
+
+	BinLogWriter *w = BinLogWriter::open (BINLOG_TEST_FILE);
+	ck_assert_int_eq (textToBinary (is, config, w), 3);
+	w->release ();
+
+	BinLogReader reader;
+	reader.open (BINLOG_TEST_FILE);
+	ck_assert_int_eq (reader.getRecordCount (), 3);
+
+	BinLogDevice *dev = reader.getDevice ("T0");
+	ck_assert (dev != NULL);
+	ck_assert_int_eq (dev->nslots, 4);
+	ck_assert_int_eq (dev->findSlot ("TEL.RA"), 1);
+	ck_assert_int_eq (dev->findSlot ("TEL.DEC"), 2);
+	ck_assert_int_eq (dev->findSlot ("temperature"), 3);
+
+	BinLogDevice *empty = reader.getDevice ("D0");
+	ck_assert (empty != NULL);
+	ck_assert_int_eq (empty->nslots, 0);
+
+	int d = dev->id;
+	std::vector <const BinLogRecordHeader *> records;
+	reader.query (d, 1000, 1002, records);
+	ck_assert_int_eq (records.size (), 2);
+	ck_assert_dbl_eq (records[0]->time, 1000.5, 10e-10);
+	const double *v = BinLogReader::getValues (records[0]);
+	ck_assert_dbl_eq (v[1], 120.5, 10e-10);
+	ck_assert_dbl_eq (v[2], -20.25, 10e-10);
+	ck_assert_dbl_eq (v[3], 12.5, 10e-10);
+	v = BinLogReader::getValues (records[1]);
+	ck_assert (isnan (v[1]) && isnan (v[2]));
+	ck_assert_dbl_eq (v[3], 13.5, 10e-10);
+
+	// composite value printed as two tokens, even when not set
+	std::ostringstream os;
+	reader.toText (os, 1000, 1002);
+	std::istringstream ts (os.str ());
+	std::string line;
+	while (std::getline (ts, line))
+	{
+		std::istringstream ls (line);
+		std::string t;
+		int n = 0;
+		while (ls >> t)
+			n++;
+		if (line.compare (0, 2, "T0") == 0)
+			ck_assert_int_eq (n, 5);
+	}
+}
+END_TEST
+
+Suite * binlog_suite (void)
+{
+	Suite *s;
+	TCase *tc_binlog;
+
+	s = suite_create ("BinLog");
+	tc_binlog = tcase_create ("Binary log");
+
+	tcase_add_checked_fixture (tc_binlog, setup_binlog, teardown_binlog);
+	tcase_add_test (tc_binlog, query);
+	tcase_add_test (tc_binlog, damaged_end);
+	tcase_add_test (tc_binlog, from_text);
+
+	suite_add_tcase (s, tc_binlog);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = binlog_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,227 @@
+#include "testblock.h"
+
+#include <string>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <check.h>
+#include <check_utils.h>
+
+/**
+ * Connection counting received bytes.
+ */
+class PollConnection:public rts2core::Connection
+{
+	public:
+		PollConnection (int _sock, rts2core::Block *_master):rts2core::Connection (_sock, _master) { received = 0; }
+
+		virtual int receive (rts2core::Block *block)
+		{
+			if (sock >= 0 && block->isForRead (sock))
+			{
+				char rbuf[100];
+				int ret = read (sock, rbuf, 100);
+				if (ret > 0)
+					received += ret;
+			}
+			return 0;
+		}
+
+		/**
+		 * Close socket and replace it with a new one.
+		 */
+		void reopen (int _sock)
+		{
+			closeSocket ();
+			sock = _sock;
+		}
+
+		int received;
+};
+
+/**
+ * Connection polling for configurable events.
+ */
+class EventsConnection:public PollConnection
+{
+	public:
+		EventsConnection (int _sock, rts2core::Block *_master):PollConnection (_sock, _master) { events = POLLIN; }
+
+		virtual int add (rts2core::Block *block)
+		{
+			block->addPollFD (sock, events);
+			return 0;
+		}
+
+		/**
+		 * Close socket without removing it from poll structures and replace it with a new one.
+		 */
+		void reopenUnsafe (int _sock)
+		{
+			if (sock >= 0)
+				close (sock);
+			sock = _sock;
+		}
+
+		short events;
+};
+
+void setup_block (void)
+{
+}
+
+void teardown_block (void)
+{
+}
+
+static void pollReuse (bool useEpoll)
+{
+	char *argv[] = {(char *) "check_block", NULL};
+	TestBlock block (1, argv);
+	if (block.setUseEpoll (useEpoll))
+		return;
+
+	int sv[2];
+	ck_assert_int_eq (socketpair (AF_UNIX, SOCK_STREAM, 0, sv), 0);
+
+	PollConnection *conn = new PollConnection (sv[0], &block);
+	block.addConnection (conn);
+	block.callIdle ();
+
+	block.oneRunLoop ();
+	ck_assert_int_eq (conn->received, 0);
+
+	ck_assert_int_eq (write (sv[1], "a", 1), 1);
+	block.oneRunLoop ();
+	ck_assert_int_eq (conn->received, 1);
+
+	// lowest free descriptors are reused, new socket gets the same number
+	int nsv[2];
+	close (sv[1]);
+	conn->reopen (-1);
+	ck_assert_int_eq (socketpair (AF_UNIX, SOCK_STREAM, 0, nsv), 0);
+	ck_assert_int_eq (nsv[0], sv[0]);
+	conn->reopen (nsv[0]);
+
+	ck_assert_int_eq (write (nsv[1], "bc", 2), 2);
+	block.oneRunLoop ();
+	ck_assert_int_eq (conn->received, 3);
+
+	ck_assert_int_eq (write (nsv[1], "d", 1), 1);
+	block.oneRunLoop ();
+	ck_assert_int_eq (conn->received, 4);
+
+	close (nsv[1]);
+}
+
+START_TEST(pipe_nonblocking)
+{
+	char *argv[] = {(char *) "check_block", NULL};
+	TestBlock block (1, argv);
+
+	int pfd[2];
+	ck_assert_int_eq (pipe (pfd), 0);
+
+	PollConnection *conn = new PollConnection (pfd[1], &block);
+	block.addConnection (conn);
+
+	// pipe buffer is much smaller, data which cannot be written must be queued
+	std::string line (1000, 'x');
+	for (int i = 0; i < 1000; i++)
+		ck_assert_int_eq (conn->sendMsg (line), 0);
+
+	ck_assert (conn->getWriteBufferSize () > 0);
+	ck_assert (conn->getBytesQueued () >= conn->getWriteBufferSize ());
+	ck_assert_int_eq (block.getWriteQueued (), conn->getBytesQueued ());
+
+	// data which were not written are dropped when connection is deleted
+	size_t pending = conn->getWriteBufferSize ();
+	block.getConnections ()->clear ();
+	delete conn;
+	ck_assert_int_eq (block.getWriteDropped (), pending);
+
+	close (pfd[0]);
+}
+END_TEST
+
+START_TEST(ppoll_reuse)
+{
+	pollReuse (false);
+}
+END_TEST
+
+START_TEST(epoll_reuse)
+{
+	pollReuse (true);
+}
+END_TEST
+
+START_TEST(epoll_closed_reuse)
+{
+	char *argv[] = {(char *) "check_block", NULL};
+	TestBlock block (1, argv);
+	if (block.setUseEpoll (true))
+		return;
+
+	int sv[2];
+	ck_assert_int_eq (socketpair (AF_UNIX, SOCK_STREAM, 0, sv), 0);
+
+	EventsConnection *conn = new EventsConnection (sv[0], &block);
+	block.addConnection (conn);
+	block.callIdle ();
+
+	ck_assert_int_eq (write (sv[1], "a", 1), 1);
+	block.oneRunLoop ();
+	ck_assert_int_eq (conn->received, 1);
+
+	// kernel drops registration of the closed descriptor, new one must be added again
+	int nsv[2];
+	close (sv[1]);
+	conn->reopenUnsafe (-1);
+	ck_assert_int_eq (socketpair (AF_UNIX, SOCK_STREAM, 0, nsv), 0);
+	ck_assert_int_eq (nsv[0], sv[0]);
+	conn->reopenUnsafe (nsv[0]);
+	conn->events = POLLIN | POLLPRI;
+
+	ck_assert_int_eq (write (nsv[1], "bc", 2), 2);
+	block.oneRunLoop ();
+	ck_assert_int_eq (conn->received, 3);
+
+	close (nsv[1]);
+}
+END_TEST
+
+Suite * block_suite (void)
+{
+	Suite *s;
+	TCase *tc_block;
+
+	s = suite_create ("Block");
+	tc_block = tcase_create ("Block event loop");
+
+	tcase_add_checked_fixture (tc_block, setup_block, teardown_block);
+	tcase_add_test (tc_block, pipe_nonblocking);
+	tcase_add_test (tc_block, ppoll_reuse);
+	tcase_add_test (tc_block, epoll_reuse);
+	tcase_add_test (tc_block, epoll_closed_reuse);
+
+	suite_add_tcase (s, tc_block);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = block_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,161 @@
+#include "rts2fits/calibframes.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <check.h>
+#include <check_utils.h>
+
+using namespace rts2image;
+
+// directory without masters, masters are added by the tests
+static CalibrationFrames *frames;
+
+static MasterFrame *addMaster (const char *filename, time_t mtime, calibrationType_t type, double exposure, double temperature, const char *filter = "")
+{
+	MasterFrame *m = new MasterFrame (filename, mtime);
+	m->type = type;
+	m->camera = "C0";
+	m->filter = filter;
+	m->binx = 1;
+	m->biny = 1;
+	m->exposure = exposure;
+	m->temperature = temperature;
+	frames->addMaster (m);
+	return m;
+}
+
+void setup_calibframes (void)
+{
+	frames = new CalibrationFrames ("/nonexistent", 2.0);
+}
+
+void teardown_calibframes (void)
+{
+	delete frames;
+	frames = NULL;
+}
+
+START_TEST(select_bias)
+{
+	MasterFrame *bias, *dark, *flat;
+
+	frames->selectMasters ("C0", 1, 1, NULL, 10, -20, bias, dark, flat);
+	ck_assert (bias == NULL && dark == NULL && flat == NULL);
+
+	MasterFrame *b1 = addMaster ("b1.fits", 100, CALIBRATION_BIAS, 0, -19);
+	MasterFrame *b2 = addMaster ("b2.fits", 100, CALIBRATION_BIAS, 0, -20.5);
+	addMaster ("b3.fits", 200, CALIBRATION_BIAS, 0, -25);
+
+	// closest temperature, master out of tolerance is not used
+	frames->selectMasters ("C0", 1, 1, NULL, 10, -20, bias, dark, flat);
+	ck_assert (bias == b2);
+	ck_assert (dark == NULL && flat == NULL);
+
+	// same temperature difference - the newest wins
+	MasterFrame *b4 = addMaster ("b4.fits", 300, CALIBRATION_BIAS, 0, -19.5);
+	frames->selectMasters ("C0", 1, 1, NULL, 10, -20, bias, dark, flat);
+	ck_assert (bias == b4);
+
+	// different camera and binning
+	frames->selectMasters ("C1", 1, 1, NULL, 10, -20, bias, dark, flat);
+	ck_assert (bias == NULL);
+	frames->selectMasters ("C0", 2, 2, NULL, 10, -20, bias, dark, flat);
+	ck_assert (bias == NULL);
+
+	frames->selectMasters ("C0", 1, 1, NULL, 10, -18, bias, dark, flat);
+	ck_assert (bias == b1);
+}
+END_TEST
+
+START_TEST(select_dark)
+{
+	MasterFrame *bias, *dark, *flat;
+
+	MasterFrame *d10 = addMaster ("d10.fits", 100, CALIBRATION_DARK, 10, -20);
+	MasterFrame *d60 = addMaster ("d60.fits", 100, CALIBRATION_DARK, 60, -20);
+
+	// without bias, dark is used only with matching exposure
+	frames->selectMasters ("C0", 1, 1, NULL, 10, -20, bias, dark, flat);
+	ck_assert (bias == NULL && dark == d10);
+
+	frames->selectMasters ("C0", 1, 1, NULL, 30, -20, bias, dark, flat);
+	ck_assert (dark == NULL);
+
+	// dark with subtracted bias cannot be used without bias
+	d10->darkSubtracted = true;
+	frames->selectMasters ("C0", 1, 1, NULL, 10, -20, bias, dark, flat);
+	ck_assert (dark == NULL);
+
+	// with bias, the closest dark is scaled to exposure
+	MasterFrame *b = addMaster ("b.fits", 100, CALIBRATION_BIAS, 0, -20);
+	frames->selectMasters ("C0", 1, 1, NULL, 30, -20, bias, dark, flat);
+	ck_assert (bias == b && dark == d10);
+
+	frames->selectMasters ("C0", 1, 1, NULL, 50, -20, bias, dark, flat);
+	ck_assert (bias == b && dark == d60);
+
+	// same exposure - the newest wins
+	MasterFrame *n60 = addMaster ("n60.fits", 200, CALIBRATION_DARK, 60, -20);
+	frames->selectMasters ("C0", 1, 1, NULL, 50, -20, bias, dark, flat);
+	ck_assert (dark == n60);
+
+	// replaced master
+	addMaster ("n60.fits", 50, CALIBRATION_DARK, 60, -20);
+	frames->selectMasters ("C0", 1, 1, NULL, 50, -20, bias, dark, flat);
+	ck_assert (dark == d60);
+}
+END_TEST
+
+START_TEST(select_flat)
+{
+	MasterFrame *bias, *dark, *flat;
+
+	addMaster ("fr.fits", 100, CALIBRATION_FLAT, NAN, NAN, "R");
+	addMaster ("fv.fits", 100, CALIBRATION_FLAT, NAN, NAN, "V");
+	MasterFrame *nv = addMaster ("nv.fits", 200, CALIBRATION_FLAT, NAN, NAN, "V");
+
+	// flats do not depend on temperature, newest flat in the filter is used
+	frames->selectMasters ("C0", 1, 1, "V", 10, -20, bias, dark, flat);
+	ck_assert (flat == nv);
+
+	frames->selectMasters ("C0", 1, 1, "B", 10, -20, bias, dark, flat);
+	ck_assert (flat == NULL);
+
+	frames->selectMasters ("C0", 1, 1, NULL, 10, -20, bias, dark, flat);
+	ck_assert (flat == NULL);
+}
+END_TEST
+
+Suite * calibframes_suite (void)
+{
+	Suite *s;
+	TCase *tc_calibframes;
+
+	s = suite_create ("CalibrationFrames");
+	tc_calibframes = tcase_create ("Master selection");
+
+	tcase_add_checked_fixture (tc_calibframes, setup_calibframes, teardown_calibframes);
+	tcase_add_test (tc_calibframes, select_bias);
+	tcase_add_test (tc_calibframes, select_dark);
+	tcase_add_test (tc_calibframes, select_flat);
+
+	suite_add_tcase (s, tc_calibframes);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = calibframes_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,86 @@
+#include "data.h"
+
+#include <string.h>
+
+#include <check.h>
+#include <check_utils.h>
+
+void setup_dataread (void)
+{
+}
+
+void teardown_dataread (void)
+{
+}
+
+START_TEST(full)
+{
+	rts2core::DataRead dr (100, 0);
+	dr.setChunkSizeFromData ();
+	ck_assert_int_eq (dr.addData ((char *) "0123456789", 10), 10);
+	ck_assert_int_eq (dr.getRestSize (), 90);
+	ck_assert (dr.discardData (5) == false);
+	ck_assert_int_eq (dr.getDataOffset (), 0);
+	ck_assert_int_eq (dr.getDataTop () - dr.getDataBuff (), 10);
+	ck_assert (memcmp (dr.getDataBuff (), "0123456789", 10) == 0);
+}
+END_TEST
+
+START_TEST(streaming)
+{
+	rts2core::DataRead dr (30, 0);
+	dr.setStreaming ();
+	dr.setChunkSizeFromData ();
+
+	size_t processed = 0;
+	const char *data = "abcdefghijklmnopqrstuvwxyz0123";
+	for (int i = 0; i < 30; i += 7)
+	{
+		ssize_t len = i + 7 > 30 ? 30 - i : 7;
+		ck_assert_int_eq (dr.addData ((char *) data + i, len), len);
+		// process data in 4 bytes blocks
+		char *start = dr.getDataBuff () + (processed - dr.getDataOffset ());
+		size_t blocks = (dr.getDataTop () - start) / 4;
+		ck_assert (memcmp (start, data + processed, blocks * 4) == 0);
+		processed += blocks * 4;
+		ck_assert (dr.discardData (processed - dr.getDataOffset ()));
+		ck_assert_int_eq (dr.getDataOffset (), processed);
+		ck_assert_int_lt (dr.getDataTop () - dr.getDataBuff (), 4);
+	}
+	ck_assert_int_eq (processed, 28);
+	ck_assert_int_eq (dr.getRestSize (), 0);
+	ck_assert (memcmp (dr.getDataBuff (), "23", 2) == 0);
+}
+END_TEST
+
+Suite * dataread_suite (void)
+{
+	Suite *s;
+	TCase *tc_dataread;
+
+	s = suite_create ("DataRead");
+	tc_dataread = tcase_create ("Data read");
+
+	tcase_add_checked_fixture (tc_dataread, setup_dataread, teardown_dataread);
+	tcase_add_test (tc_dataread, full);
+	tcase_add_test (tc_dataread, streaming);
+
+	suite_add_tcase (s, tc_dataread);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = dataread_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
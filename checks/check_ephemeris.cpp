@@ -0,0 +1,202 @@
+#include "ephemeris.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <check.h>
+#include <check_utils.h>
+
+struct FixedTarget
+{
+	struct ln_equ_posn position;
+
+	void getPosition (struct ln_equ_posn *pos, double JD) { *pos = position; }
+};
+
+// moves linearly, crosses RA 0 during the night
+struct MovingTarget
+{
+	double from;
+
+	void getPosition (struct ln_equ_posn *pos, double JD)
+	{
+		pos->ra = ln_range_degrees (359 + (JD - from) * 5.0);
+		pos->dec = 20 + (JD - from) * 10.0;
+	}
+};
+
+static struct ln_lnlat_posn observer = {-17.88, 28.76};
+
+static double from = 2461000.3;
+
+rts2core::NightEphemeris *night;
+
+void setup_ephemeris (void)
+{
+	night = new rts2core::NightEphemeris (&observer, from, from + 0.4, 60);
+}
+
+void teardown_ephemeris (void)
+{
+	delete night;
+	night = NULL;
+}
+
+START_TEST(grid)
+{
+	ck_assert (night->contains (from));
+	ck_assert (night->contains (from + 0.4));
+	ck_assert (!night->contains (from + 0.41));
+	// rounding of night boundaries is tolerated
+	ck_assert (night->contains (from - 10 / 86400.0));
+	ck_assert (night->contains (from + 0.4 + 10 / 86400.0));
+	ck_assert (!night->contains (from - 40 / 86400.0));
+	// last sample is at or after night end, previous before
+	size_t n = night->getSize ();
+	ck_assert (n >= 577);
+	ck_assert (night->getJD (n - 1) >= night->getTo ());
+	ck_assert (night->getJD (n - 2) < night->getTo ());
+
+	rts2core::NightEphemeris shortNight (&observer, from, from, 60);
+	ck_assert_int_eq (shortNight.getSize (), 2);
+}
+END_TEST
+
+START_TEST(interpolation)
+{
+	struct FixedTarget tar;
+	srandom (1);
+
+	for (int t = 0; t < 20; t++)
+	{
+		tar.position.ra = 360.0 * random () / RAND_MAX;
+		tar.position.dec = -60 + 150.0 * random () / RAND_MAX;
+
+		rts2core::TargetEphemeris table (night);
+		table.fill (&tar);
+
+		for (int i = 0; i < 100; i++)
+		{
+			double JD = from + 0.4 * random () / RAND_MAX;
+			struct ln_hrz_posn hrz, c_hrz;
+			struct ln_equ_posn moon;
+
+			ln_get_hrz_from_equ (&tar.position, &observer, JD, &hrz);
+			table.getAltAz (&c_hrz, JD);
+			ck_assert_dbl_eq (c_hrz.alt, hrz.alt, 0.01);
+			ck_assert_dbl_eq (c_hrz.alt, table.getAlt (JD), 10e-6);
+			// azimuth changes fast close to zenith
+			if (hrz.alt < 80)
+			{
+				double daz = fabs (c_hrz.az - hrz.az);
+				ck_assert (daz < 0.05 || daz > 359.95);
+			}
+
+			double ha = ln_range_degrees (ln_get_mean_sidereal_time (JD) * 15.0 + observer.lng - tar.position.ra);
+			if (ha > 180)
+				ha -= 360;
+			double c_ha = table.getHourAngle (JD);
+			ck_assert (c_ha > -180 && c_ha <= 180);
+			double dha = fabs (c_ha - ha);
+			ck_assert (dha < 10e-4 || dha > 360 - 10e-4);
+
+			ln_get_lunar_equ_coords (JD, &moon);
+			ck_assert_dbl_eq (table.getLunarDistance (JD), ln_get_angular_separation (&tar.position, &moon), 0.01);
+		}
+	}
+}
+END_TEST
+
+START_TEST(position)
+{
+	struct MovingTarget tar;
+	tar.from = from;
+
+	rts2core::TargetEphemeris table (night);
+	table.fill (&tar);
+
+	srandom (3);
+
+	for (int i = 0; i < 1000; i++)
+	{
+		double JD = from + 0.4 * random () / RAND_MAX;
+		struct ln_equ_posn pos, c_pos;
+		tar.getPosition (&pos, JD);
+		table.getPosition (&c_pos, JD);
+		double dra = fabs (c_pos.ra - pos.ra);
+		ck_assert (dra < 10e-4 || dra > 360 - 10e-4);
+		ck_assert (c_pos.ra >= 0 && c_pos.ra < 360);
+		ck_assert_dbl_eq (c_pos.dec, pos.dec, 10e-4);
+	}
+}
+END_TEST
+
+START_TEST(minmax)
+{
+	struct FixedTarget tar;
+	srandom (2);
+
+	for (int t = 0; t < 20; t++)
+	{
+		tar.position.ra = 360.0 * random () / RAND_MAX;
+		tar.position.dec = -60 + 150.0 * random () / RAND_MAX;
+
+		rts2core::TargetEphemeris table (night);
+		table.fill (&tar);
+
+		double start = from + 0.3 * random () / RAND_MAX;
+		double end = start + 0.1 * random () / RAND_MAX;
+
+		double minA = 90;
+		double maxA = -90;
+		for (double JD = start; JD <= end; JD += 1 / 86400.0)
+		{
+			struct ln_hrz_posn hrz;
+			ln_get_hrz_from_equ (&tar.position, &observer, JD, &hrz);
+			if (hrz.alt < minA)
+				minA = hrz.alt;
+			if (hrz.alt > maxA)
+				maxA = hrz.alt;
+		}
+
+		double c_minA, c_maxA;
+		table.getMinMaxAlt (start, end, c_minA, c_maxA);
+		ck_assert_dbl_eq (c_minA, minA, 0.01);
+		ck_assert_dbl_eq (c_maxA, maxA, 0.01);
+	}
+}
+END_TEST
+
+Suite * ephemeris_suite (void)
+{
+	Suite *s;
+	TCase *tc_ephemeris;
+
+	s = suite_create ("Ephemeris");
+	tc_ephemeris = tcase_create ("Ephemeris tables");
+
+	tcase_add_checked_fixture (tc_ephemeris, setup_ephemeris, teardown_ephemeris);
+	tcase_add_test (tc_ephemeris, grid);
+	tcase_add_test (tc_ephemeris, interpolation);
+	tcase_add_test (tc_ephemeris, position);
+	tcase_add_test (tc_ephemeris, minmax);
+
+	suite_add_tcase (s, tc_ephemeris);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = ephemeris_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,4 +1,5 @@
 #include "gpointmodel.h"
+#include "gpointfit.h"
 
 #include <check.h>
 #include <check_utils.h>
@@ -2099,6 +2100,179 @@ START_TEST(model_n32)
 }
 END_TEST
 
+START_TEST(batch_altaz)
+{
+	double az[500], alt[500], errAz[500], errAlt[500];
+	struct ln_hrz_posn test_hrz;
+	struct ln_equ_posn test_equ;
+	struct ln_hrz_posn test_err;
+
+	test_equ.ra = 0;
+	test_equ.dec = 0;
+
+	srandom (1);
+	for (int i = 0; i < 500; i++)
+	{
+		az[i] = 360.0 * random () / RAND_MAX;
+		alt[i] = 5 + 84.0 * random () / RAND_MAX;
+	}
+
+	rts2telmodel::GPointModel *models[] = {&testGPoint_altaz_34, &testGPoint_n32};
+	for (int m = 0; m < 2; m++)
+	{
+		models[m]->getErrAltAz (500, az, alt, NULL, NULL, errAz, errAlt);
+		for (int i = 0; i < 500; i++)
+		{
+			test_hrz.az = az[i];
+			test_hrz.alt = alt[i];
+			models[m]->getErrAltAz (&test_hrz, &test_equ, &test_err);
+
+			ck_assert_dbl_eq (errAz[i], test_err.az, 10e-9);
+			ck_assert_dbl_eq (errAlt[i], test_err.alt, 10e-9);
+		}
+	}
+}
+END_TEST
+
+START_TEST(batch_equ)
+{
+	double ha[500], dec[500], ra[500], dec2[500];
+	struct ln_hrz_posn test_hrz;
+	struct ln_equ_posn test_equ;
+
+	test_hrz.az = 0;
+	test_hrz.alt = 0;
+
+	rts2telmodel::GPointModel model (34);
+	std::istringstream iss ("RTS2_MODEL 10\" -20\" 5\" 3\" -30\" 15\" 7\" -4\" 2\"\nHA 5\" sin ha 2\nDEC -3\" cos dec 1");
+	model.load (iss);
+
+	srandom (2);
+	for (int i = 0; i < 500; i++)
+	{
+		ra[i] = ha[i] = 360.0 * random () / RAND_MAX - 180;
+		dec2[i] = dec[i] = 150.0 * random () / RAND_MAX - 60;
+	}
+
+	model.reverse (500, ha, dec, NULL, NULL);
+	model.apply (500, ra, dec2);
+
+	srandom (2);
+	for (int i = 0; i < 500; i++)
+	{
+		test_equ.ra = 360.0 * random () / RAND_MAX - 180;
+		test_equ.dec = 150.0 * random () / RAND_MAX - 60;
+		struct ln_equ_posn test_apply = test_equ;
+
+		model.reverse (&test_equ, &test_hrz);
+		ck_assert_dbl_eq (ha[i], test_equ.ra, 10e-9);
+		ck_assert_dbl_eq (dec[i], test_equ.dec, 10e-9);
+
+		model.apply (&test_apply);
+		ck_assert_dbl_eq (ra[i], test_apply.ra, 10e-9);
+		ck_assert_dbl_eq (dec2[i], test_apply.dec, 10e-9);
+	}
+}
+END_TEST
+
+START_TEST(fit_altaz)
+{
+	rts2telmodel::GPointFit fit;
+	fit.setAltAz (true);
+	fit.setLatitude (-32.53);
+
+	struct ln_equ_posn test_equ;
+	struct ln_hrz_posn test_err;
+
+	test_equ.ra = 0;
+	test_equ.dec = 0;
+
+	srandom (3);
+	for (int i = 0; i < 2000; i++)
+	{
+		rts2telmodel::GPointMeasurement m;
+		struct ln_hrz_posn test_hrz;
+		m.az = test_hrz.az = 360.0 * random () / RAND_MAX;
+		m.alt = test_hrz.alt = 10 + 75.0 * random () / RAND_MAX;
+		testGPoint_n32.getErrAltAz (&test_hrz, &test_equ, &test_err);
+		m.r_az = test_hrz.az;
+		m.r_alt = test_hrz.alt;
+		fit.addMeasurement (m);
+	}
+
+	// same terms as testGPoint_n32, all parameters zero
+	rts2telmodel::GPointModel model (-32.53);
+	std::istringstream iss ("RTS2_ALTAZ 0 0 0 0 0 0 0\nAZ 0 sincos az;el 2.0;2.0\nAZ 0 sincos el;az 5.0;3.0\nEL 0 sincos az;el 4.0;4.0\nEL 0 sin az 1.0");
+	model.load (iss);
+
+	ck_assert (fit.getRMS (&model) > 10e-3);
+	ck_assert_int_eq (fit.fit (&model), 0);
+	ck_assert (fit.getRMS (&model) < 10e-6);
+
+	for (int i = 0; i < 7; i++)
+		ck_assert_dbl_eq (model.params[i], testGPoint_n32.params[i], 10e-11);
+
+	ck_assert_int_eq (fit.getParamNames ().size (), 11);
+	ck_assert (fit.getParamNames ()[7] == "az_sincos_az_el");
+
+	std::vector <rts2telmodel::CompiledTerm> &fitted = model.getCompiledAz ();
+	std::vector <rts2telmodel::CompiledTerm> &orig = testGPoint_n32.getCompiledAz ();
+	ck_assert_int_eq (fitted.size (), 2);
+	for (size_t i = 0; i < fitted.size (); i++)
+		ck_assert_dbl_eq (fitted[i].multi, orig[i].multi, 10e-11);
+
+	// fitted model can be saved and loaded
+	std::ostringstream os;
+	model.print (os);
+	rts2telmodel::GPointModel loaded (-32.53);
+	std::istringstream lis (os.str ());
+	loaded.load (lis);
+	ck_assert (fit.getRMS (&loaded) < 10e-6);
+}
+END_TEST
+
+START_TEST(fit_gem)
+{
+	rts2telmodel::GPointFit fit;
+	fit.setAltAz (false);
+	fit.setLatitude (34);
+
+	rts2telmodel::GPointModel orig (34);
+	std::istringstream iss ("RTS2_MODEL 10\" -20\" 5\" 3\" -30\" 15\" 7\" -4\" 2\"");
+	orig.load (iss);
+
+	struct ln_hrz_posn test_hrz;
+	test_hrz.az = 0;
+	test_hrz.alt = 0;
+
+	srandom (4);
+	for (int i = 0; i < 2000; i++)
+	{
+		rts2telmodel::GPointMeasurement m;
+		struct ln_equ_posn pos;
+		m.r_ha = pos.ra = 160.0 * random () / RAND_MAX - 80;
+		m.r_dec = pos.dec = 130.0 * random () / RAND_MAX - 45;
+		orig.reverse (&pos, &test_hrz);
+		m.ha = pos.ra;
+		m.dec = pos.dec;
+		fit.addMeasurement (m);
+	}
+
+	// fix TF to its value
+	ck_assert_int_eq (fit.setFixed ("tf"), 0);
+	ck_assert_int_eq (fit.setFixed ("npae"), -1);
+
+	rts2telmodel::GPointModel model (34);
+	model.params[3] = orig.params[3];
+	ck_assert_int_eq (fit.fit (&model), 0);
+	ck_assert (fit.getRMS (&model) < 10e-6);
+	ck_assert_int_eq (fit.getParamNames ().size (), 8);
+
+	for (int i = 0; i < 9; i++)
+		ck_assert_dbl_eq (model.params[i], orig.params[i], 10e-11);
+}
+END_TEST
+
 Suite * gpoint_suite (void)
 {
 	Suite *s;
@@ -2110,6 +2284,10 @@ Suite * gpoint_suite (void)
 	tcase_add_checked_fixture (tc_gpoint, setup_gpoint, teardown_gpoint);
 	tcase_add_test (tc_gpoint, model_altaz_34);
 	tcase_add_test (tc_gpoint, model_n32);
+	tcase_add_test (tc_gpoint, batch_altaz);
+	tcase_add_test (tc_gpoint, batch_equ);
+	tcase_add_test (tc_gpoint, fit_altaz);
+	tcase_add_test (tc_gpoint, fit_gem);
 	suite_add_tcase (s, tc_gpoint);
 
 	return s;
@@ -0,0 +1,120 @@
+#include "xmlrpc++/XmlRpcServerConnection.h"
+#include "xmlrpc++/XmlRpcServerGetRequest.h"
+
+#include <check.h>
+#include <check_utils.h>
+
+#include <stdlib.h>
+
+using namespace XmlRpc;
+
+START_TEST(single)
+{
+	size_t first, last;
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("bytes=0-499", 1000, first, last), HTTP_PARTIAL_CONTENT);
+	ck_assert_int_eq (first, 0);
+	ck_assert_int_eq (last, 499);
+
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange (" bytes=500-999 \t", 1000, first, last), HTTP_PARTIAL_CONTENT);
+	ck_assert_int_eq (first, 500);
+	ck_assert_int_eq (last, 999);
+
+	// last byte is capped at file length
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("Bytes=900-2000", 1000, first, last), HTTP_PARTIAL_CONTENT);
+	ck_assert_int_eq (first, 900);
+	ck_assert_int_eq (last, 999);
+
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("bytes=10-10", 1000, first, last), HTTP_PARTIAL_CONTENT);
+	ck_assert_int_eq (first, 10);
+	ck_assert_int_eq (last, 10);
+}
+END_TEST
+
+START_TEST(suffix)
+{
+	size_t first, last;
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("bytes=-100", 1000, first, last), HTTP_PARTIAL_CONTENT);
+	ck_assert_int_eq (first, 900);
+	ck_assert_int_eq (last, 999);
+
+	// suffix longer than file selects the whole file
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("bytes=-5000", 1000, first, last), HTTP_PARTIAL_CONTENT);
+	ck_assert_int_eq (first, 0);
+	ck_assert_int_eq (last, 999);
+
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("bytes=-0", 1000, first, last), HTTP_RANGE_NOT_SATISFIABLE);
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("bytes=-10", 0, first, last), HTTP_RANGE_NOT_SATISFIABLE);
+}
+END_TEST
+
+START_TEST(open_ended)
+{
+	size_t first, last;
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("bytes=100-", 1000, first, last), HTTP_PARTIAL_CONTENT);
+	ck_assert_int_eq (first, 100);
+	ck_assert_int_eq (last, 999);
+
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("bytes=0-", 1000, first, last), HTTP_PARTIAL_CONTENT);
+	ck_assert_int_eq (first, 0);
+	ck_assert_int_eq (last, 999);
+}
+END_TEST
+
+START_TEST(unsatisfiable)
+{
+	size_t first, last;
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("bytes=1000-", 1000, first, last), HTTP_RANGE_NOT_SATISFIABLE);
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("bytes=1000-1500", 1000, first, last), HTTP_RANGE_NOT_SATISFIABLE);
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("bytes=0-", 0, first, last), HTTP_RANGE_NOT_SATISFIABLE);
+}
+END_TEST
+
+START_TEST(ignored)
+{
+	size_t first, last;
+	// whole file is sent for invalid or unsupported ranges
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("", 1000, first, last), HTTP_OK);
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("bytes=0-10,20-30", 1000, first, last), HTTP_OK);
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("bytes=20-10", 1000, first, last), HTTP_OK);
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("bytes=a-10", 1000, first, last), HTTP_OK);
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("bytes=--10", 1000, first, last), HTTP_OK);
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("bytes=10", 1000, first, last), HTTP_OK);
+	ck_assert_int_eq (XmlRpcServerConnection::parseRange ("items=0-10", 1000, first, last), HTTP_OK);
+	ck_assert_int_eq (first, 0);
+	ck_assert_int_eq (last, 999);
+}
+END_TEST
+
+Suite * httprange_suite (void)
+{
+	Suite *s;
+	TCase *tc_range;
+
+	s = suite_create ("HTTP range");
+	tc_range = tcase_create ("Range header");
+
+	tcase_add_test (tc_range, single);
+	tcase_add_test (tc_range, suffix);
+	tcase_add_test (tc_range, open_ended);
+	tcase_add_test (tc_range, unsatisfiable);
+	tcase_add_test (tc_range, ignored);
+
+	suite_add_tcase (s, tc_range);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = httprange_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,222 @@
+#include "imgcombine.h"
+#include "imghdr.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+
+#include <check.h>
+#include <check_utils.h>
+
+void setup_imgcombine (void)
+{
+}
+
+void teardown_imgcombine (void)
+{
+}
+
+/**
+ * Fill frames with random values around 1000, with some outliers.
+ */
+static void fillFrames (std::vector <std::vector <float> > &data, std::vector <const float *> &frames, int nframes, size_t npix)
+{
+	data.resize (nframes);
+	frames.resize (nframes);
+	for (int f = 0; f < nframes; f++)
+	{
+		data[f].resize (npix);
+		for (size_t p = 0; p < npix; p++)
+		{
+			data[f][p] = 1000 + (random () % 2001 - 1000) / 100.0;
+			if (random () % 20 == 0)
+				data[f][p] += 5000;
+		}
+		frames[f] = &(data[f][0]);
+	}
+}
+
+static float referenceMedian (std::vector <float> v)
+{
+	std::sort (v.begin (), v.end ());
+	size_t n = v.size ();
+	if (n % 2)
+		return v[n / 2];
+	return (v[n / 2 - 1] + v[n / 2]) / 2.0;
+}
+
+static float referenceSigmaClip (std::vector <float> v, float sigma, int iterations)
+{
+	double c = referenceMedian (v);
+	double limit = INFINITY;
+	for (int it = 0; it < iterations; it++)
+	{
+		double ss = 0;
+		int cnt = 0;
+		for (size_t i = 0; i < v.size (); i++)
+		{
+			if (fabs (v[i] - c) <= limit)
+			{
+				ss += (v[i] - c) * (v[i] - c);
+				cnt++;
+			}
+		}
+		if (cnt == 0)
+			break;
+		limit = sigma * sqrt (ss / cnt);
+		double sum = 0;
+		cnt = 0;
+		for (size_t i = 0; i < v.size (); i++)
+		{
+			if (fabs (v[i] - c) <= limit)
+			{
+				sum += v[i];
+				cnt++;
+			}
+		}
+		if (cnt == 0)
+			break;
+		c = sum / cnt;
+	}
+	return c;
+}
+
+START_TEST(median)
+{
+	// odd and even number of frames, number of pixels not divisible by vector size
+	for (int nframes = 1; nframes < 12; nframes++)
+	{
+		size_t npix = 1003;
+		std::vector <std::vector <float> > data;
+		std::vector <const float *> frames;
+		fillFrames (data, frames, nframes, npix);
+
+		std::vector <float> out (npix);
+		rts2core::combineMedian (&frames[0], nframes, npix, &out[0]);
+
+		for (size_t p = 0; p < npix; p++)
+		{
+			std::vector <float> v;
+			for (int f = 0; f < nframes; f++)
+				v.push_back (data[f][p]);
+			ck_assert_dbl_eq (out[p], referenceMedian (v), 10e-4);
+		}
+	}
+}
+END_TEST
+
+START_TEST(sigma_clip)
+{
+	for (int nframes = 3; nframes < 40; nframes += 7)
+	{
+		size_t npix = 2001;
+		std::vector <std::vector <float> > data;
+		std::vector <const float *> frames;
+		fillFrames (data, frames, nframes, npix);
+		// all values equal
+		for (int f = 0; f < nframes; f++)
+		{
+			data[f][7] = 1234;
+			data[f][11] = 1000 + (f % 2 ? 1 : -1);
+		}
+		data[0][11] = 8000;
+
+		std::vector <float> out (npix);
+		rts2core::combineSigmaClip (&frames[0], nframes, npix, 3.0, 3, &out[0]);
+
+		for (size_t p = 0; p < npix; p++)
+		{
+			std::vector <float> v;
+			for (int f = 0; f < nframes; f++)
+				v.push_back (data[f][p]);
+			ck_assert_dbl_eq (out[p], referenceSigmaClip (v, 3.0, 3), 10e-2);
+		}
+		ck_assert_dbl_eq (out[7], 1234, 10e-4);
+		// single outlier is rejected
+		if (nframes >= 10)
+			ck_assert_dbl_eq (out[11], 1000, 0.2);
+	}
+}
+END_TEST
+
+START_TEST(calibrate)
+{
+	size_t npix = 1003;
+	std::vector <uint16_t> ushort_raw (npix);
+	std::vector <int16_t> short_raw (npix);
+	std::vector <float> float_raw (npix);
+	std::vector <int32_t> long_raw (npix);
+	std::vector <float> offset (npix);
+	std::vector <float> dark (npix);
+	std::vector <float> gain (npix);
+	for (size_t p = 0; p < npix; p++)
+	{
+		ushort_raw[p] = 60000 + random () % 5000;
+		short_raw[p] = random () % 60000 - 30000;
+		float_raw[p] = short_raw[p] / 3.0;
+		long_raw[p] = 100000 + random () % 100000;
+		offset[p] = 100 + (random () % 1000) / 10.0;
+		dark[p] = (random () % 500) / 10.0;
+		gain[p] = 0.9 + (random () % 200) / 1000.0;
+	}
+
+	std::vector <float> out (npix);
+
+	ck_assert_int_eq (rts2core::calibratePixels (RTS2_DATA_USHORT, &ushort_raw[0], npix, &offset[0], NULL, 1, &gain[0], &out[0]), 0);
+	for (size_t p = 0; p < npix; p++)
+		ck_assert_dbl_eq (out[p], (ushort_raw[p] - offset[p]) * gain[p], 10e-2);
+
+	ck_assert_int_eq (rts2core::calibratePixels (RTS2_DATA_USHORT, &ushort_raw[0], npix, &offset[0], &dark[0], 2.5, &gain[0], &out[0]), 0);
+	for (size_t p = 0; p < npix; p++)
+		ck_assert_dbl_eq (out[p], (ushort_raw[p] - offset[p] - 2.5 * dark[p]) * gain[p], 10e-2);
+
+	ck_assert_int_eq (rts2core::calibratePixels (RTS2_DATA_SHORT, &short_raw[0], npix, &offset[0], NULL, 1, NULL, &out[0]), 0);
+	for (size_t p = 0; p < npix; p++)
+		ck_assert_dbl_eq (out[p], short_raw[p] - offset[p], 10e-3);
+
+	ck_assert_int_eq (rts2core::calibratePixels (RTS2_DATA_FLOAT, &float_raw[0], npix, NULL, &dark[0], 0.5, &gain[0], &out[0]), 0);
+	for (size_t p = 0; p < npix; p++)
+		ck_assert_dbl_eq (out[p], (float_raw[p] - 0.5 * dark[p]) * gain[p], 10e-2);
+
+	ck_assert_int_eq (rts2core::calibratePixels (RTS2_DATA_LONG, &long_raw[0], npix, &offset[0], NULL, 1, &gain[0], &out[0]), 0);
+	for (size_t p = 0; p < npix; p++)
+		ck_assert_dbl_eq (out[p], (long_raw[p] - offset[p]) * gain[p], 10e-1);
+
+	ck_assert_int_eq (rts2core::calibratePixels (RTS2_DATA_LONGLONG, &long_raw[0], npix / 2, NULL, NULL, 1, NULL, &out[0]), -1);
+}
+END_TEST
+
+Suite * imgcombine_suite (void)
+{
+	Suite *s;
+	TCase *tc_imgcombine;
+
+	s = suite_create ("ImageCombine");
+	tc_imgcombine = tcase_create ("Image combination");
+
+	tcase_add_checked_fixture (tc_imgcombine, setup_imgcombine, teardown_imgcombine);
+	tcase_add_test (tc_imgcombine, median);
+	tcase_add_test (tc_imgcombine, sigma_clip);
+	tcase_add_test (tc_imgcombine, calibrate);
+
+	suite_add_tcase (s, tc_imgcombine);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = imgcombine_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,171 @@
+#include "imgstat.h"
+
+#include <limits>
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <check.h>
+#include <check_utils.h>
+
+void setup_imgstat (void)
+{
+}
+
+void teardown_imgstat (void)
+{
+}
+
+/**
+ * Compute statistics with plain loop, compare them with ImageStatistics
+ * updated in chunks of random size.
+ */
+template <typename t> void checkStatistics (t *data, size_t npix)
+{
+	rts2core::ImageStatistics stat;
+	for (size_t c = 0; c < npix;)
+	{
+		size_t l = 1 + random () % 10000;
+		if (c + l > npix)
+			l = npix - c;
+		stat.update (data + c, l);
+		c += l;
+	}
+
+	long double sum = 0;
+	long double sumSquares = 0;
+	double min = INFINITY;
+	double max = -INFINITY;
+	for (size_t i = 0; i < npix; i++)
+	{
+		sum += data[i];
+		sumSquares += (long double) data[i] * data[i];
+		if (data[i] < min)
+			min = data[i];
+		if (data[i] > max)
+			max = data[i];
+	}
+
+	ck_assert_int_eq (stat.getPixels (), npix);
+	if (std::numeric_limits <t>::is_integer)
+	{
+		ck_assert (stat.getSum () == sum);
+		ck_assert (stat.getSumSquares () == sumSquares);
+	}
+	else
+	{
+		// floating point sums of chunks differ by rounding
+		ck_assert_lng_dbl_eq (stat.getSum (), sum, fabsl (sum) * 1e-15);
+		ck_assert_lng_dbl_eq (stat.getSumSquares (), sumSquares, sumSquares * 1e-15);
+	}
+	ck_assert (stat.getMin () == min);
+	ck_assert (stat.getMax () == max);
+}
+
+START_TEST(unsigned16)
+{
+	size_t npix = 1000003;
+	uint16_t *data = new uint16_t[npix];
+	for (size_t i = 0; i < npix; i++)
+		data[i] = random () % 65536;
+	data[17] = 0;
+	data[npix - 1] = 65535;
+	// mode
+	for (size_t i = 0; i < npix; i += 3)
+		data[i] = 1234;
+	checkStatistics (data, npix);
+
+	rts2core::ImageStatistics stat;
+	stat.update (data, npix);
+	ck_assert (stat.getMode () == 1234);
+
+	stat.reset (false);
+	stat.update (data, npix);
+	ck_assert (isnan (stat.getMode ()));
+
+	// histogram is allocated only when mode is requested
+	rts2core::ImageStatistics nomode (false);
+	nomode.update (data, npix);
+	ck_assert (isnan (nomode.getMode ()));
+	ck_assert_int_eq (nomode.getPixels (), npix);
+	nomode.reset (true);
+	nomode.update (data, npix);
+	ck_assert (nomode.getMode () == 1234);
+	delete[] data;
+}
+END_TEST
+
+START_TEST(signed16)
+{
+	size_t npix = 1000003;
+	int16_t *data = new int16_t[npix];
+	for (size_t i = 0; i < npix; i++)
+		data[i] = random () % 65536 - 32768;
+	data[0] = -32768;
+	data[npix - 2] = 32767;
+	for (size_t i = 0; i < npix; i += 3)
+		data[i] = -20;
+	checkStatistics (data, npix);
+
+	rts2core::ImageStatistics stat;
+	stat.update (data, npix);
+	ck_assert (stat.getMode () == -20);
+	delete[] data;
+}
+END_TEST
+
+START_TEST(other_types)
+{
+	size_t npix = 10001;
+	int32_t *data = new int32_t[npix];
+	float *fdata = new float[npix];
+	for (size_t i = 0; i < npix; i++)
+	{
+		data[i] = random () % 200000 - 1000;
+		fdata[i] = data[i] / 3.0;
+	}
+	for (size_t i = 0; i < npix; i += 2)
+		data[i] = 5000;
+	checkStatistics (data, npix);
+	checkStatistics (fdata, npix);
+
+	rts2core::ImageStatistics stat;
+	stat.update (data, npix);
+	ck_assert (stat.getMode () == 5000);
+	delete[] data;
+	delete[] fdata;
+}
+END_TEST
+
+Suite * imgstat_suite (void)
+{
+	Suite *s;
+	TCase *tc_imgstat;
+
+	s = suite_create ("ImageStatistics");
+	tc_imgstat = tcase_create ("Image statistics");
+
+	tcase_add_checked_fixture (tc_imgstat, setup_imgstat, teardown_imgstat);
+	tcase_add_test (tc_imgstat, unsigned16);
+	tcase_add_test (tc_imgstat, signed16);
+	tcase_add_test (tc_imgstat, other_types);
+
+	suite_add_tcase (s, tc_imgstat);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = imgstat_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,230 @@
+#include "rts2json/previewcache.h"
+
+#include <check.h>
+#include <check_utils.h>
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define PREVIEW_TEST_DIR    "check_previewcache.d"
+#define PREVIEW_TEST_FILE   "check_previewcache.fits"
+
+using namespace rts2json;
+
+static void cleanDir ()
+{
+	DIR *d = opendir (PREVIEW_TEST_DIR);
+	struct dirent *de;
+	while (d && (de = readdir (d)) != NULL)
+	{
+		if (de->d_name[0] != '.')
+			unlink ((std::string (PREVIEW_TEST_DIR) + "/" + de->d_name).c_str ());
+	}
+	if (d)
+		closedir (d);
+	rmdir (PREVIEW_TEST_DIR);
+}
+
+static size_t dirSize ()
+{
+	size_t total = 0;
+	DIR *d = opendir (PREVIEW_TEST_DIR);
+	struct dirent *de;
+	while (d && (de = readdir (d)) != NULL)
+	{
+		struct stat st;
+		if (de->d_name[0] != '.' && stat ((std::string (PREVIEW_TEST_DIR) + "/" + de->d_name).c_str (), &st) == 0)
+			total += st.st_size;
+	}
+	if (d)
+		closedir (d);
+	return total;
+}
+
+// returns true if preview was found, onDisk is set if it was returned as file
+static bool getData (PreviewCache &cache, const char *key, char fill, size_t len, bool *onDisk = NULL)
+{
+	char *response = NULL;
+	size_t response_length = 0;
+	int fd;
+	if (cache.get (key, response, response_length, fd) == false)
+		return false;
+	if (onDisk)
+		*onDisk = fd >= 0;
+	if (fd >= 0)
+	{
+		ck_assert (response == NULL);
+		response = new char[response_length];
+		ck_assert_int_eq (pread (fd, response, response_length, 0), response_length);
+		close (fd);
+	}
+	bool ret = response_length == len;
+	for (size_t i = 0; ret && i < len; i++)
+		ret = response[i] == fill;
+	delete[] response;
+	return ret;
+}
+
+static void putData (PreviewCache &cache, const char *key, char fill, size_t len)
+{
+	std::vector <char> data (len, fill);
+	cache.put (key, &data[0], len);
+}
+
+void setup_previewcache (void)
+{
+	cleanDir ();
+	unlink (PREVIEW_TEST_FILE);
+}
+
+void teardown_previewcache (void)
+{
+	cleanDir ();
+	unlink (PREVIEW_TEST_FILE);
+}
+
+START_TEST(memory_lru)
+{
+	PreviewCache cache;
+	cache.setParameters (100, NULL, 0);
+	ck_assert_int_eq (cache.start (), 0);
+
+	putData (cache, "a", 'a', 40);
+	putData (cache, "b", 'b', 40);
+	ck_assert_int_eq (cache.getMemorySize (), 80);
+
+	// a becomes most recently used, b is evicted
+	ck_assert (getData (cache, "a", 'a', 40));
+	putData (cache, "c", 'c', 40);
+	ck_assert_int_eq (cache.getMemorySize (), 80);
+
+	ck_assert (getData (cache, "a", 'a', 40));
+	ck_assert (getData (cache, "c", 'c', 40));
+	ck_assert (getData (cache, "b", 'b', 40) == false);
+
+	// larger than the limit is not cached
+	putData (cache, "d", 'd', 101);
+	ck_assert (getData (cache, "d", 'd', 101) == false);
+	ck_assert_int_eq (cache.getMemorySize (), 80);
+
+	ck_assert_int_eq (cache.getHits (), 3);
+	ck_assert_int_eq (cache.getMisses (), 2);
+
+	cache.stop ();
+}
+END_TEST
+
+START_TEST(disk_tier)
+{
+	PreviewCache cache;
+	cache.setParameters (50, PREVIEW_TEST_DIR, 1024 * 1024);
+	ck_assert_int_eq (cache.start (), 0);
+
+	putData (cache, "a", 'a', 40);
+	putData (cache, "b", 'b', 40);
+	// writes queued previews
+	cache.stop ();
+
+	// a was evicted from memory, but is on disk
+	bool onDisk;
+	ck_assert (getData (cache, "a", 'a', 40, &onDisk));
+	ck_assert (onDisk);
+	ck_assert (getData (cache, "b", 'b', 40, &onDisk));
+	ck_assert (onDisk == false);
+
+	// disk cache survives restart
+	PreviewCache cache2;
+	cache2.setParameters (50, PREVIEW_TEST_DIR, 1024 * 1024);
+	ck_assert_int_eq (cache2.start (), 0);
+	ck_assert (getData (cache2, "a", 'a', 40));
+	ck_assert (getData (cache2, "b", 'b', 40));
+	ck_assert (getData (cache2, "c", 'c', 40) == false);
+	cache2.stop ();
+}
+END_TEST
+
+START_TEST(disk_prune)
+{
+	PreviewCache cache;
+	cache.setParameters (0, PREVIEW_TEST_DIR, 1000);
+	ck_assert_int_eq (cache.start (), 0);
+
+	char key[2] = "a";
+	for (int i = 0; i < 10; i++)
+	{
+		key[0] = 'a' + i;
+		putData (cache, key, key[0], 200);
+	}
+	cache.stop ();
+
+	ck_assert (dirSize () <= 900);
+	ck_assert (dirSize () > 0);
+	// the last one was written after pruning
+	ck_assert (getData (cache, "j", 'j', 200));
+}
+END_TEST
+
+START_TEST(key)
+{
+	std::string k1, k2, k3;
+	ck_assert_int_eq (PreviewCache::getKey (k1, PREVIEW_TEST_FILE, PREVIEW_ZOOM, 128, "label", 0.005, -1, 0), -1);
+
+	FILE *f = fopen (PREVIEW_TEST_FILE, "w");
+	fputs ("test", f);
+	fclose (f);
+
+	ck_assert_int_eq (PreviewCache::getKey (k1, PREVIEW_TEST_FILE, PREVIEW_ZOOM, 128, "label", 0.005, -1, 0), 0);
+	ck_assert_int_eq (PreviewCache::getKey (k2, "./" PREVIEW_TEST_FILE, PREVIEW_ZOOM, 128, "label", 0.005, -1, 0), 0);
+	ck_assert (k1 == k2);
+
+	ck_assert_int_eq (PreviewCache::getKey (k3, PREVIEW_TEST_FILE, PREVIEW_FULL, 128, "label", 0.005, -1, 0), 0);
+	ck_assert (k1 != k3);
+	ck_assert_int_eq (PreviewCache::getKey (k3, PREVIEW_TEST_FILE, PREVIEW_ZOOM, 64, "label", 0.005, -1, 0), 0);
+	ck_assert (k1 != k3);
+
+	// modified file gets new key
+	f = fopen (PREVIEW_TEST_FILE, "a");
+	fputs ("more", f);
+	fclose (f);
+	ck_assert_int_eq (PreviewCache::getKey (k3, PREVIEW_TEST_FILE, PREVIEW_ZOOM, 128, "label", 0.005, -1, 0), 0);
+	ck_assert (k1 != k3);
+}
+END_TEST
+
+Suite * previewcache_suite (void)
+{
+	Suite *s;
+	TCase *tc_previewcache;
+
+	s = suite_create ("PreviewCache");
+	tc_previewcache = tcase_create ("Preview cache");
+
+	tcase_add_checked_fixture (tc_previewcache, setup_previewcache, teardown_previewcache);
+	tcase_add_test (tc_previewcache, memory_lru);
+	tcase_add_test (tc_previewcache, disk_tier);
+	tcase_add_test (tc_previewcache, disk_prune);
+	tcase_add_test (tc_previewcache, key);
+
+	suite_add_tcase (s, tc_previewcache);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = previewcache_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,351 @@
+#include "testblock.h"
+#include "status.h"
+
+#include <sstream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <check.h>
+#include <check_utils.h>
+
+/**
+ * Connection recording results of parameter parsing.
+ */
+class ProtoConnection:public rts2core::Connection
+{
+	public:
+		ProtoConnection (int _sock, rts2core::Block *_master):rts2core::Connection (_sock, _master)
+		{
+			parsed = 0;
+			d = f = 0;
+			d_ret = f_ret = 0;
+		}
+
+		int parsed;
+		double d;
+		float f;
+		int d_ret;
+		int f_ret;
+
+	protected:
+		virtual int command ()
+		{
+			if (isCommand ("parse"))
+			{
+				parsed++;
+				d = 12.5;
+				f = 2.5;
+				d_ret = paramNextDouble (&d);
+				f_ret = paramNextFloat (&f);
+				return -1;
+			}
+			return rts2core::Connection::command ();
+		}
+};
+
+static TestBlock *block;
+static ProtoConnection *conn;
+static int peer;
+
+void setup_protocol (void)
+{
+	static char *argv[] = {(char *) "check_protocol", NULL};
+	block = new TestBlock (1, argv);
+
+	int sv[2];
+	ck_assert_int_eq (socketpair (AF_UNIX, SOCK_STREAM, 0, sv), 0);
+	fcntl (sv[1], F_SETFL, O_NONBLOCK);
+	peer = sv[1];
+
+	conn = new ProtoConnection (sv[0], block);
+	block->addConnection (conn);
+	block->callIdle ();
+}
+
+void teardown_protocol (void)
+{
+	delete block;
+	close (peer);
+}
+
+/**
+ * Write protocol lines to connection and let block process them.
+ */
+static void feed (std::string lines)
+{
+	ck_assert_int_eq (write (peer, lines.c_str (), lines.length ()), lines.length ());
+	for (int i = 0; i < 3; i++)
+		block->oneRunLoop ();
+}
+
+/**
+ * Returns metainfo line for value of given type.
+ */
+static std::string metaLine (int type, const char *name)
+{
+	std::ostringstream _os;
+	_os << PROTO_METAINFO " " << type << " \"" << name << "\" \"test value\"\n";
+	return _os.str ();
+}
+
+/**
+ * Returns what connection sent to the other side.
+ */
+static std::string replies ()
+{
+	std::string ret;
+	char rbuf[500];
+	ssize_t len;
+	while ((len = read (peer, rbuf, sizeof (rbuf))) > 0)
+		ret.append (rbuf, len);
+	return ret;
+}
+
+START_TEST(dispatch)
+{
+	feed (PROTO_STATUS " 5\n");
+	ck_assert_int_eq (conn->getState (), 5);
+
+	feed (PROTO_TECHNICAL " ready\n");
+	ck_assert_string_eq (PROTO_TECHNICAL " OK\n", replies ());
+
+	feed (metaLine (RTS2_VALUE_DOUBLE, "d1") + metaLine (RTS2_VALUE_INTEGER, "i1"));
+	ck_assert_int_eq (conn->valueSize (), 2);
+	ck_assert_int_eq (conn->getValue ("d1")->getValueType (), RTS2_VALUE_DOUBLE);
+	ck_assert_int_eq (conn->getValue ("i1")->getValueType (), RTS2_VALUE_INTEGER);
+
+	feed (PROTO_VALUE " d1 1.25\n" PROTO_VALUE " i1 42\n");
+	ck_assert_dbl_eq (conn->getValueDouble ("d1"), 1.25, 10e-10);
+	ck_assert_int_eq (conn->getValueInteger ("i1"), 42);
+
+	// multi-character commands are not protocol commands
+	feed ("parse 1 2\n");
+	ck_assert_int_eq (conn->parsed, 1);
+	ck_assert_int_eq (conn->getState (), 5);
+}
+END_TEST
+
+START_TEST(numbers)
+{
+	feed ("parse 1e3 -0.125\n");
+	ck_assert_int_eq (conn->d_ret, 0);
+	ck_assert_int_eq (conn->f_ret, 0);
+	ck_assert_dbl_eq (conn->d, 1000, 10e-10);
+	ck_assert_dbl_eq (conn->f, -0.125, 10e-10);
+
+	feed ("parse nan NaN\n");
+	ck_assert_int_eq (conn->d_ret, 0);
+	ck_assert (isnan (conn->d));
+	ck_assert_int_eq (conn->f_ret, 0);
+	ck_assert (isnan (conn->f));
+
+	// values which cannot be parsed are not changed
+	feed ("parse abc -\n");
+	ck_assert_int_eq (conn->parsed, 3);
+	ck_assert_int_eq (conn->d_ret, -1);
+	ck_assert_int_eq (conn->f_ret, -1);
+	ck_assert_dbl_eq (conn->d, 12.5, 10e-10);
+	ck_assert_dbl_eq (conn->f, 2.5, 10e-10);
+
+	feed ("parse 7\n");
+	ck_assert_int_eq (conn->d_ret, 0);
+	ck_assert_int_eq (conn->f_ret, -1);
+	ck_assert_dbl_eq (conn->d, 7, 10e-10);
+	ck_assert_dbl_eq (conn->f, 2.5, 10e-10);
+
+	// invalid value update does not change the value
+	feed (metaLine (RTS2_VALUE_DOUBLE, "d1") + PROTO_VALUE " d1 3.5\n" PROTO_VALUE " d1 x\n");
+	ck_assert_dbl_eq (conn->getValueDouble ("d1"), 3.5, 10e-10);
+}
+END_TEST
+
+START_TEST(batch_roundtrip)
+{
+	int sv[2];
+	ck_assert_int_eq (socketpair (AF_UNIX, SOCK_STREAM, 0, sv), 0);
+	rts2core::Connection *sender = new rts2core::Connection (sv[0], block);
+	ProtoConnection *receiver = new ProtoConnection (sv[1], block);
+	block->addConnection (sender);
+	block->addConnection (receiver);
+	block->callIdle ();
+
+	std::string meta = metaLine (RTS2_VALUE_DOUBLE, "d1") + metaLine (RTS2_VALUE_INTEGER, "i1");
+	ck_assert_int_eq (sender->sendMsg (meta.substr (0, meta.length () - 1)), 0);
+
+	sender->setBatchValues (true);
+	sender->startValueBatch ();
+	sender->sendMsg (PROTO_VALUE " d1 2.5");
+	sender->sendMsg (PROTO_VALUE " i1 12");
+	sender->sendMsg (PROTO_VALUE " d1 3.5");
+	// nothing is written before batch ends
+	ck_assert_int_eq (sender->getWriteCalls (), 1);
+	ck_assert_int_eq (sender->endValueBatch (), 0);
+	ck_assert_int_eq (sender->getWriteCalls (), 2);
+
+	for (int i = 0; i < 3; i++)
+		block->oneRunLoop ();
+
+	ck_assert_int_eq (receiver->valueSize (), 2);
+	ck_assert_dbl_eq (receiver->getValueDouble ("d1"), 3.5, 10e-10);
+	ck_assert_int_eq (receiver->getValueInteger ("i1"), 12);
+
+	// single update is sent without batch header, empty batch is not sent
+	sender->startValueBatch ();
+	sender->sendMsg (PROTO_VALUE " i1 13");
+	ck_assert_int_eq (sender->endValueBatch (), 0);
+	sender->startValueBatch ();
+	ck_assert_int_eq (sender->endValueBatch (), 0);
+	ck_assert_int_eq (sender->getWriteCalls (), 3);
+
+	for (int i = 0; i < 3; i++)
+		block->oneRunLoop ();
+	ck_assert_int_eq (receiver->getValueInteger ("i1"), 13);
+}
+END_TEST
+
+START_TEST(batch_partial)
+{
+	feed (metaLine (RTS2_VALUE_DOUBLE, "d1") + metaLine (RTS2_VALUE_INTEGER, "i1"));
+
+	// batch is applied only when all its lines are received
+	feed (PROTO_VALUE " i1 1\n");
+
+	feed (PROTO_VALUE_BATCH " 2\n" PROTO_VALUE " d1 1.5\n");
+	ck_assert (isnan (conn->getValueDouble ("d1")));
+
+	feed (PROTO_VALUE " i1");
+	ck_assert (isnan (conn->getValueDouble ("d1")));
+	ck_assert_int_eq (conn->getValueInteger ("i1"), 1);
+
+	feed (" 7\n" PROTO_VALUE " d1 4\n");
+	ck_assert_dbl_eq (conn->getValueDouble ("d1"), 4, 10e-10);
+	ck_assert_int_eq (conn->getValueInteger ("i1"), 7);
+
+	// empty batch
+	feed (PROTO_VALUE_BATCH " 0\n" PROTO_VALUE " i1 8\n");
+	ck_assert_int_eq (conn->getValueInteger ("i1"), 8);
+	ck_assert_int_eq (block->getConnections ()->size (), 1);
+}
+END_TEST
+
+START_TEST(batch_nested)
+{
+	feed (metaLine (RTS2_VALUE_INTEGER, "i1"));
+	// nested batch header closes connection, rest of the batch is ignored
+	feed (PROTO_VALUE_BATCH " 1\n" PROTO_VALUE_BATCH " 1\n" PROTO_VALUE " i1 1\n");
+	ck_assert (conn->isConnState (CONN_DELETE));
+	ck_assert_int_eq (conn->getValueInteger ("i1"), 0);
+}
+END_TEST
+
+START_TEST(batch_invalid)
+{
+	feed (PROTO_VALUE_BATCH " x\n");
+	ck_assert (conn->isConnState (CONN_DELETE));
+}
+END_TEST
+
+START_TEST(batch_negative)
+{
+	feed (PROTO_VALUE_BATCH " -1\n");
+	ck_assert (conn->isConnState (CONN_DELETE));
+}
+END_TEST
+
+START_TEST(batch_extra_param)
+{
+	feed (metaLine (RTS2_VALUE_INTEGER, "i1"));
+	feed (PROTO_VALUE_BATCH " 1 2\n" PROTO_VALUE " i1 1\n");
+	ck_assert (conn->isConnState (CONN_DELETE));
+	ck_assert_int_eq (conn->getValueInteger ("i1"), 0);
+}
+END_TEST
+
+START_TEST(batch_unknown_value)
+{
+	feed (metaLine (RTS2_VALUE_DOUBLE, "d1") + metaLine (RTS2_VALUE_INTEGER, "i1"));
+	// batch with unknown value is not applied at all
+	feed (PROTO_VALUE_BATCH " 3\n" PROTO_VALUE " d1 1.5\n" PROTO_VALUE " x1 2\n" PROTO_VALUE " i1 3\n");
+	ck_assert (conn->isConnState (CONN_DELETE));
+	ck_assert (isnan (conn->getValueDouble ("d1")));
+	ck_assert_int_eq (conn->getValueInteger ("i1"), 0);
+}
+END_TEST
+
+START_TEST(batch_flush)
+{
+	int sv[2];
+	ck_assert_int_eq (socketpair (AF_UNIX, SOCK_STREAM, 0, sv), 0);
+	rts2core::Connection *sender = new rts2core::Connection (sv[0], block);
+	block->addConnection (sender);
+
+	sender->setBatchValues (true);
+	sender->startValueBatch ();
+	sender->sendMsg (PROTO_VALUE " d1 2.5");
+	sender->sendMsg (PROTO_VALUE " i1 12");
+	// other messages and binary data are sent after collected values
+	sender->sendMsg (PROTO_MESSAGE " test");
+	sender->sendMsg (PROTO_VALUE " i1 13");
+	size_t chansize = 2;
+	int data_conn = sender->startBinaryData (1, 1, &chansize);
+	ck_assert (data_conn > 0);
+	sender->sendMsg (PROTO_VALUE " i1 14");
+	ck_assert_int_eq (sender->sendBinaryData (data_conn, 0, (char *) "ab", 2), 0);
+	sender->sendMsg (PROTO_VALUE " d1 3.5");
+	ck_assert_int_eq (sender->endValueBatch (), 0);
+
+	char rbuf[500];
+	ssize_t len = read (sv[1], rbuf, sizeof (rbuf));
+	ck_assert (len > 0);
+	std::ostringstream _os;
+	_os << PROTO_VALUE_BATCH " 2\n" PROTO_VALUE " d1 2.5\n" PROTO_VALUE " i1 12\n"
+		PROTO_MESSAGE " test\n" PROTO_VALUE " i1 13\n"
+		PROTO_BINARY " " << data_conn << " 1 1 2\n" PROTO_VALUE " i1 14\n"
+		PROTO_DATA " " << data_conn << " 0 2\nab" PROTO_VALUE " d1 3.5\n";
+	ck_assert_str_eq (std::string (rbuf, len).c_str (), _os.str ().c_str ());
+	close (sv[1]);
+}
+END_TEST
+
+Suite * protocol_suite (void)
+{
+	Suite *s;
+	TCase *tc_protocol;
+
+	s = suite_create ("Protocol");
+	tc_protocol = tcase_create ("RTS2 protocol processing");
+
+	tcase_add_checked_fixture (tc_protocol, setup_protocol, teardown_protocol);
+	tcase_add_test (tc_protocol, dispatch);
+	tcase_add_test (tc_protocol, numbers);
+	tcase_add_test (tc_protocol, batch_roundtrip);
+	tcase_add_test (tc_protocol, batch_partial);
+	tcase_add_test (tc_protocol, batch_nested);
+	tcase_add_test (tc_protocol, batch_invalid);
+	tcase_add_test (tc_protocol, batch_negative);
+	tcase_add_test (tc_protocol, batch_extra_param);
+	tcase_add_test (tc_protocol, batch_unknown_value);
+	tcase_add_test (tc_protocol, batch_flush);
+
+	suite_add_tcase (s, tc_protocol);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = protocol_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
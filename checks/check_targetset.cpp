@@ -0,0 +1,148 @@
+#include "rts2db/appdb.h"
+#include "rts2db/target.h"
+#include "rts2db/targetset.h"
+#include "configuration.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <check.h>
+#include <check_utils.h>
+
+// test database, set in RTS2_TEST_DATABASE environment variable
+static const char *database = NULL;
+
+class TargetSetApp:public rts2db::AppDb
+{
+	public:
+		TargetSetApp (int argc, char **argv):rts2db::AppDb (argc, argv) {}
+
+	protected:
+		virtual int doProcessing () { return 0; }
+};
+
+static TargetSetApp *app = NULL;
+
+void setup_targetset (void)
+{
+	if (app != NULL)
+		return;
+	char *argv[] = {(char *) "check_targetset", (char *) "--database", (char *) database, (char *) "--config", (char *) "rts2.ini"};
+	app = new TargetSetApp (5, argv);
+	ck_assert_int_eq (app->init (), 0);
+}
+
+void teardown_targetset (void)
+{
+}
+
+static void compareTargets (rts2db::Target *set, rts2db::Target *single, double JD)
+{
+	ck_assert_int_eq (set->getTargetID (), single->getTargetID ());
+	ck_assert_int_eq (set->getTargetType (), single->getTargetType ());
+	ck_assert_str_eq (set->getTargetName (), single->getTargetName ());
+	ck_assert_str_eq (set->getTargetInfo (), single->getTargetInfo ());
+	ck_assert (set->getTargetEnabled () == single->getTargetEnabled ());
+	ck_assert_dbl_eq (set->getTargetPriority (), single->getTargetPriority (), 10e-5);
+	ck_assert_dbl_eq (set->getTargetBonus (), single->getTargetBonus (), 10e-5);
+	ck_assert_int_eq (*(set->getTargetBonusTime ()), *(single->getTargetBonusTime ()));
+	ck_assert_int_eq (set->getTelescopeMode (), single->getTelescopeMode ());
+
+	struct ln_equ_posn setPos, singlePos;
+	set->getPosition (&setPos, JD);
+	single->getPosition (&singlePos, JD);
+	ck_assert (isnan (setPos.ra) == isnan (singlePos.ra));
+	ck_assert (isnan (setPos.dec) == isnan (singlePos.dec));
+	if (!isnan (setPos.ra))
+		ck_assert_dbl_eq (setPos.ra, singlePos.ra, 10e-8);
+	if (!isnan (setPos.dec))
+		ck_assert_dbl_eq (setPos.dec, singlePos.dec, 10e-8);
+}
+
+START_TEST(set_vs_single)
+{
+	rts2core::Configuration *config = rts2core::Configuration::instance ();
+	double JD = 2456000.5;
+
+	rts2db::TargetSet ts;
+	ts.load ();
+
+	for (rts2db::TargetSet::iterator iter = ts.begin (); iter != ts.end (); iter++)
+	{
+		rts2db::Target *single = createTarget (iter->first, config->getObserver (), config->getObservatoryAltitude ());
+		ck_assert (single != NULL);
+		compareTargets (iter->second, single, JD);
+		delete single;
+	}
+}
+END_TEST
+
+START_TEST(set_ids)
+{
+	rts2core::Configuration *config = rts2core::Configuration::instance ();
+	double JD = 2456000.5;
+
+	rts2db::TargetSet all;
+	all.load ();
+
+	// every other target, loaded by list of IDs
+	std::list <int> ids;
+	int i = 0;
+	for (rts2db::TargetSet::iterator iter = all.begin (); iter != all.end (); iter++, i++)
+	{
+		if (i % 2 == 0)
+			ids.push_back (iter->first);
+	}
+
+	rts2db::TargetSet ts;
+	ts.load (ids);
+	ck_assert_int_eq (ts.size (), ids.size ());
+
+	for (rts2db::TargetSet::iterator iter = ts.begin (); iter != ts.end (); iter++)
+	{
+		rts2db::Target *single = createTarget (iter->first, config->getObserver (), config->getObservatoryAltitude ());
+		ck_assert (single != NULL);
+		compareTargets (iter->second, single, JD);
+		delete single;
+	}
+}
+END_TEST
+
+Suite * targetset_suite (void)
+{
+	Suite *s;
+	TCase *tc_targetset;
+
+	s = suite_create ("TargetSet");
+	tc_targetset = tcase_create ("Set and single target loading");
+
+	tcase_add_checked_fixture (tc_targetset, setup_targetset, teardown_targetset);
+	tcase_set_timeout (tc_targetset, 120);
+	tcase_add_test (tc_targetset, set_vs_single);
+	tcase_add_test (tc_targetset, set_ids);
+
+	suite_add_tcase (s, tc_targetset);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	// tests need a database with targets, skip them without it
+	database = getenv ("RTS2_TEST_DATABASE");
+	if (database == NULL)
+		return 77;
+
+	s = targetset_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
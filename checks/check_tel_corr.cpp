@@ -2,6 +2,7 @@
 #include "altaztest.h"
 #include "check_utils.h"
 
+#include <math.h>
 #include <time.h>
 #include <stdlib.h>
 #include <check.h>
@@ -608,6 +609,42 @@ START_TEST(test_refraction4000)
 }
 END_TEST
 
+#ifdef RTS2_LIBERFA
+START_TEST(test_astrom_cache)
+{
+	eraASTROM astrom;
+	double utc1 = 2456000.5;
+	double utc2 = 0.25;
+
+	ck_assert_int_eq (gemTest->test_getAstrom (utc1, utc2, &astrom), 0);
+	double pmt = astrom.pmt;
+
+	// context computed 10 seconds ago is reused, only Earth rotation angle changes
+	ck_assert_int_eq (gemTest->test_getAstrom (utc1, utc2 + 10 / 86400.0, &astrom), 0);
+	ck_assert (astrom.pmt == pmt);
+
+	// older than astrometry_interval
+	ck_assert_int_eq (gemTest->test_getAstrom (utc1, utc2 + 120 / 86400.0, &astrom), 0);
+	ck_assert (astrom.pmt != pmt);
+	pmt = astrom.pmt;
+
+	// weather change invalidates the context
+	gemTest->test_setWeather (5, 40);
+	ck_assert_int_eq (gemTest->test_getAstrom (utc1, utc2 + 130 / 86400.0, &astrom), 0);
+	ck_assert (astrom.pmt != pmt);
+	pmt = astrom.pmt;
+
+	// unknown humidity is not a change
+	gemTest->test_setWeather (5, NAN);
+	ck_assert_int_eq (gemTest->test_getAstrom (utc1, utc2 + 140 / 86400.0, &astrom), 0);
+	ck_assert (astrom.pmt != pmt);
+	pmt = astrom.pmt;
+	ck_assert_int_eq (gemTest->test_getAstrom (utc1, utc2 + 150 / 86400.0, &astrom), 0);
+	ck_assert (astrom.pmt == pmt);
+}
+END_TEST
+#endif
+
 Suite * tel_suite (void)
 {
 	Suite *s;
@@ -624,6 +661,9 @@ Suite * tel_suite (void)
 	tcase_add_test (tc_tel_corrs, test_nutation);
 	tcase_add_test (tc_tel_corrs, test_mean2apparent);
 	tcase_add_test (tc_tel_corrs, test_refraction4000);
+#ifdef RTS2_LIBERFA
+	tcase_add_test (tc_tel_corrs, test_astrom_cache);
+#endif
 	suite_add_tcase (s, tc_tel_corrs);
 
 	return s;
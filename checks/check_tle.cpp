@@ -4,6 +4,8 @@
 
 #include "pluto/norad.h"
 #include "pluto/observe.h"
+#include "pluto/satprop.h"
+#include "pluto/satcatalogue.h"
 #include <libnova/libnova.h>
 
 void setup_tle (void)
@@ -209,6 +211,148 @@ Zapadá	19:55:46	0°	95° (V)	16 852	9,7	14,5° */
 }
 END_TEST
 
+START_TEST(PROPAGATOR)
+{
+	const char *tle1 = "1 25544U 98067A   16128.85424799  .00005564  00000-0  90091-4 0  9999";
+	const char *tle2 = "2 25544  51.6438 259.2325 0002021  92.7504  10.7493 15.54477273998701";
+
+	struct ln_date test_t;
+	test_t.years = 2016;
+	test_t.months = 5;
+	test_t.days = 10;
+	test_t.hours = 3;
+	test_t.minutes = 40;
+	test_t.seconds = 0;
+
+	double JD = ln_get_julian_day (&test_t);
+
+	struct ln_lnlat_posn observer;
+	observer.lng = -4.4643;
+	observer.lat = 40.4610;
+
+	rts2sat::SatPropagator prop;
+	ck_assert_int_eq (prop.setTLE (tle1, tle2), 0);
+	ck_assert (prop.isDeep () == false);
+	ck_assert_dbl_eq (prop.getPeriod (), 92.64, 0.1);
+
+	prop.setObserver (observer.lng, observer.lat, 791);
+
+	// cached propagator must give same results as one-shot calculation, in any order
+	double t[4] = {JD + 0.02, JD, JD + 0.01, JD + 0.005};
+	double ra[4], dec[4], dist[4], alt[4];
+
+	ck_assert_int_eq (prop.getPositions (t, 4, ra, dec, dist, alt), 0);
+
+	for (int i = 0; i < 4; i++)
+	{
+		double sat_pos[3], observer_loc[3];
+		double rho_cos, rho_sin;
+		double s_ra, s_dec, s_dist;
+
+		test_tle (tle1, tle2, t[i], &observer, 791, sat_pos);
+		lat_alt_to_parallax (ln_deg_to_rad (observer.lat), 791, &rho_cos, &rho_sin);
+		observer_cartesian_coords (t[i], ln_deg_to_rad (observer.lng), rho_cos, rho_sin, observer_loc);
+		get_satellite_ra_dec_delta (observer_loc, sat_pos, &s_ra, &s_dec, &s_dist);
+
+		ck_assert_dbl_eq (ra[i], ln_rad_to_deg (s_ra), 10e-8);
+		ck_assert_dbl_eq (dec[i], ln_rad_to_deg (s_dec), 10e-8);
+		ck_assert_dbl_eq (dist[i], s_dist, 10e-6);
+		ck_assert_dbl_eq (alt[i], prop.getAltitude (t[i]), 10e-8);
+	}
+
+	// 03:47:26, 03:49:08, 03:52:12 and 03:54:22
+	ck_assert_dbl_eq (prop.getAltitude (JD + 446 / 86400.0), 21, 0.5);
+	ck_assert_dbl_eq (prop.getAltitude (JD + 548 / 86400.0), 39, 0.5);
+	ck_assert_dbl_eq (prop.getAltitude (JD + 732 / 86400.0), 10, 0.5);
+	ck_assert_dbl_eq (prop.getAltitude (JD + 862 / 86400.0), 0, 0.5);
+
+	double rise, transit, set;
+	ck_assert_int_eq (prop.getRST (JD, 0, rise, transit, set), 0);
+
+	ck_assert (rise < transit);
+	ck_assert (transit < set);
+	ck_assert_dbl_eq (prop.getAltitude (rise), 0, 0.01);
+	ck_assert_dbl_eq (prop.getAltitude (set), 0, 0.01);
+	ck_assert_dbl_eq (set, JD + 862 / 86400.0, 30 / 86400.0);
+	ck_assert_dbl_eq (transit, JD + 548 / 86400.0, 60 / 86400.0);
+	ck_assert (prop.getAltitude (transit) >= prop.getAltitude (transit - 5 / 86400.0));
+	ck_assert (prop.getAltitude (transit) >= prop.getAltitude (transit + 5 / 86400.0));
+
+	// before culmination, rise is start of the search
+	ck_assert_int_eq (prop.getRST (JD + 500 / 86400.0, 0, rise, transit, set), 0);
+	ck_assert_dbl_eq (rise, JD + 500 / 86400.0, 10e-8);
+	ck_assert_dbl_eq (transit, JD + 548 / 86400.0, 60 / 86400.0);
+	ck_assert_dbl_eq (set, JD + 862 / 86400.0, 30 / 86400.0);
+
+	// after culmination, transit is culmination of the current pass
+	ck_assert_int_eq (prop.getRST (JD + 600 / 86400.0, 0, rise, transit, set), 0);
+	ck_assert_dbl_eq (rise, JD + 600 / 86400.0, 10e-8);
+	ck_assert_dbl_eq (transit, JD + 548 / 86400.0, 60 / 86400.0);
+	ck_assert_dbl_eq (set, JD + 862 / 86400.0, 30 / 86400.0);
+
+	// above horizon during the whole search window
+	ck_assert_int_eq (prop.getRST (JD + 500 / 86400.0, 0, rise, transit, set, 100 / 86400.0), 1);
+	ck_assert (isnan (rise) && isnan (transit) && isnan (set));
+
+	ck_assert_int_eq (prop.getRST (JD, -91, rise, transit, set), 1);
+	ck_assert (isnan (rise) && isnan (transit) && isnan (set));
+
+	// never rises
+	ck_assert_int_eq (prop.getRST (JD, 89.9, rise, transit, set), -1);
+	ck_assert (isnan (rise) && isnan (transit) && isnan (set));
+}
+END_TEST
+
+START_TEST(CATALOGUE)
+{
+	const char *tle1 = "1 25544U 98067A   16128.85424799  .00005564  00000-0  90091-4 0  9999";
+	const char *tle2 = "2 25544  51.6438 259.2325 0002021  92.7504  10.7493 15.54477273998701";
+
+	struct ln_date test_t;
+	test_t.years = 2016;
+	test_t.months = 5;
+	test_t.days = 10;
+	test_t.hours = 3;
+	test_t.minutes = 40;
+	test_t.seconds = 0;
+
+	double JD = ln_get_julian_day (&test_t);
+
+	rts2sat::SatCatalogue cat (2);
+	ck_assert_int_eq (cat.add ("ISS", tle1, tle2), 0);
+	ck_assert_int_eq (cat.add ("broken", "1 garbage", "2 garbage"), -1);
+	ck_assert_int_eq (cat.size (), 1);
+	ck_assert_int_eq (cat.getNorad (0), 25544);
+
+	// position during the pass, precessed to J2000
+	rts2sat::SatPropagator prop;
+	prop.setTLE (tle1, tle2);
+	prop.setObserver (-4.4643, 40.4610, 791);
+
+	struct ln_equ_posn pos, pos_2000;
+	ck_assert_int_eq (prop.getPosition (JD + 548 / 86400.0, &pos.ra, &pos.dec), 0);
+	ln_get_equ_prec2 (&pos, JD + 548 / 86400.0, JD2000, &pos_2000);
+
+	std::vector <rts2sat::SatMatch> matches;
+	cat.query (JD + 500 / 86400.0, 100, -4.4643, 40.4610, 791, pos_2000.ra, pos_2000.dec, 0.5, matches);
+	ck_assert_int_eq (matches.size (), 1);
+	ck_assert_int_eq (matches[0].norad, 25544);
+	ck_assert_dbl_eq (matches[0].JD, JD + 548 / 86400.0, 2 / 86400.0);
+	ck_assert (matches[0].separation < 0.05);
+
+	// exposure which ends before satellite reaches the field
+	cat.query (JD + 400 / 86400.0, 60, -4.4643, 40.4610, 791, pos_2000.ra, pos_2000.dec, 0.5, matches);
+	ck_assert_int_eq (matches.size (), 0);
+
+	// long exposure with short step is screened with limited number of buckets
+	cat.setBucketStep (0);
+	ck_assert_dbl_eq (cat.getBucketStep (), SAT_MIN_BUCKET_STEP, 10e-8);
+	cat.query (JD - 1800 / 86400.0, 3600, -4.4643, 40.4610, 791, pos_2000.ra, pos_2000.dec, 0.5, matches);
+	ck_assert_int_eq (matches.size (), 1);
+	ck_assert_dbl_eq (matches[0].JD, JD + 548 / 86400.0, 2 / 86400.0);
+}
+END_TEST
+
 Suite * tle_suite (void)
 {
 	Suite *s;
@@ -220,6 +364,8 @@ Suite * tle_suite (void)
 	tcase_add_checked_fixture (tc_tle, setup_tle, teardown_tle);
 	tcase_add_test (tc_tle, PLUTO);
 	tcase_add_test (tc_tle, ISS);
+	tcase_add_test (tc_tle, PROPAGATOR);
+	tcase_add_test (tc_tle, CATALOGUE);
 //	tcase_add_test (tc_tle, XMM);
 	suite_add_tcase (s, tc_tle);
 
@@ -0,0 +1,292 @@
+#include "ucac5/UCAC5Catalogue.hpp"
+
+#include <check.h>
+#include <check_utils.h>
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define UCAC5_TEST_DIR    "check_ucac5.d"
+// zones with stars, declination -10 to +10 degrees
+#define FIRST_ZONE        400
+#define LAST_ZONE         499
+#define ZONE_STARS        200
+
+static std::vector <struct ucac5> records[UCAC5_ZONES];
+static std::vector <Vector> vectors[UCAC5_ZONES];
+
+static uint32_t rnd = 1;
+
+static double nextRandom ()
+{
+	rnd = rnd * 1103515245 + 12345;
+	return ((rnd >> 8) & 0xffffff) / (double) 0x1000000;
+}
+
+static bool byRa (const struct ucac5 &a, const struct ucac5 &b)
+{
+	return a.ira < b.ira;
+}
+
+static void writeFile (const char *fn, const void *data, size_t len)
+{
+	FILE *f = fopen (fn, "w");
+	fwrite (data, len, 1, f);
+	fclose (f);
+}
+
+void setup_ucac5 (void)
+{
+	mkdir (UCAC5_TEST_DIR, 0755);
+
+	std::vector <uint32_t> index (2 * UCAC5_ZONES * UCAC5_RA_BINS, 0);
+	uint64_t srcid = 1;
+
+	for (int z = FIRST_ZONE; z <= LAST_ZONE; z++)
+	{
+		records[z].clear ();
+		vectors[z].clear ();
+		for (int i = 0; i < ZONE_STARS; i++)
+		{
+			struct ucac5 rec;
+			memset (&rec, 0, sizeof (rec));
+			rec.srcid = srcid++;
+			rec.ira = nextRandom () * 360 * 3600 * 1000;
+			rec.idc = ((z + nextRandom ()) * 0.2 - 90) * 3600 * 1000;
+			rec.gmag = 8000 + nextRandom () * 10000;
+			records[z].push_back (rec);
+		}
+		std::sort (records[z].begin (), records[z].end (), byRa);
+
+		for (size_t i = 0; i < records[z].size (); i++)
+		{
+			Vector v;
+			eraS2c (records[z][i].ira * ERFA_DAS2R / 1000.0, records[z][i].idc * ERFA_DAS2R / 1000.0, v.data);
+			vectors[z].push_back (v);
+
+			int b = records[z][i].ira / (1000.0 * 3600.0 * 360.0 / UCAC5_RA_BINS);
+			size_t bi = b * UCAC5_ZONES + z;
+			if (index[UCAC5_ZONES * UCAC5_RA_BINS + bi] == 0)
+				index[bi] = i;
+			index[UCAC5_ZONES * UCAC5_RA_BINS + bi]++;
+		}
+		// empty bins start at the next star
+		uint32_t next = records[z].size ();
+		for (int b = UCAC5_RA_BINS - 1; b >= 0; b--)
+		{
+			size_t bi = b * UCAC5_ZONES + z;
+			if (index[UCAC5_ZONES * UCAC5_RA_BINS + bi] == 0)
+				index[bi] = next;
+			else
+				next = index[bi];
+		}
+
+		char fn[50];
+		snprintf (fn, sizeof (fn), UCAC5_TEST_DIR "/z%03d", z + 1);
+		writeFile (fn, &(records[z][0]), records[z].size () * sizeof (struct ucac5));
+		strcat (fn, ".xyz");
+		writeFile (fn, &(vectors[z][0]), vectors[z].size () * sizeof (Vector));
+	}
+
+	writeFile (UCAC5_TEST_DIR "/u5index.unf", &index[0], index.size () * sizeof (uint32_t));
+}
+
+void teardown_ucac5 (void)
+{
+	char fn[50];
+	for (int z = FIRST_ZONE; z <= LAST_ZONE; z++)
+	{
+		snprintf (fn, sizeof (fn), UCAC5_TEST_DIR "/z%03d", z + 1);
+		unlink (fn);
+		strcat (fn, ".xyz");
+		unlink (fn);
+	}
+	unlink (UCAC5_TEST_DIR "/u5index.unf");
+	rmdir (UCAC5_TEST_DIR);
+}
+
+// magnitudes of stars found by brute force search
+static std::vector <int> bruteCone (double ra, double dec, double radius, double magLimit)
+{
+	std::vector <int> ret;
+	double t[3];
+	eraS2c (ra, dec, t);
+	double cosMax = cos (radius);
+	for (int z = FIRST_ZONE; z <= LAST_ZONE; z++)
+	{
+		for (size_t i = 0; i < records[z].size (); i++)
+		{
+			const double *p = vectors[z][i].data;
+			double dot = p[0] * t[0] + p[1] * t[1] + p[2] * t[2];
+			if (dot >= cosMax && records[z][i].gmag / 1000.0 <= magLimit)
+				ret.push_back (records[z][i].gmag);
+		}
+	}
+	std::sort (ret.begin (), ret.end ());
+	return ret;
+}
+
+static std::vector <int> bruteBox (double ra1, double dec1, double ra2, double dec2)
+{
+	std::vector <int> ret;
+	double r1 = ra1 * ERFA_DR2AS * 1000.0;
+	double r2 = ra2 * ERFA_DR2AS * 1000.0;
+	double d1 = dec1 * ERFA_DR2AS * 1000.0;
+	double d2 = dec2 * ERFA_DR2AS * 1000.0;
+	for (int z = FIRST_ZONE; z <= LAST_ZONE; z++)
+	{
+		for (size_t i = 0; i < records[z].size (); i++)
+		{
+			const struct ucac5 *rec = &(records[z][i]);
+			if (rec->idc < d1 || rec->idc > d2)
+				continue;
+			if (r1 <= r2 ? (rec->ira < r1 || rec->ira > r2) : (rec->ira < r1 && rec->ira > r2))
+				continue;
+			ret.push_back (rec->gmag);
+		}
+	}
+	std::sort (ret.begin (), ret.end ());
+	return ret;
+}
+
+static std::vector <int> magnitudes (std::vector <UCAC5Star> &stars)
+{
+	std::vector <int> ret;
+	for (size_t i = 0; i < stars.size (); i++)
+		ret.push_back (stars[i].record->gmag);
+	return ret;
+}
+
+START_TEST(cone)
+{
+	UCAC5Catalogue catalogue;
+	ck_assert_int_eq (catalogue.open (UCAC5_TEST_DIR), 0);
+
+	// second search crosses 0h
+	double centres[3][2] = {{120, 2}, {0.5, -3}, {359, 0}};
+	for (int c = 0; c < 3; c++)
+	{
+		double ra = centres[c][0] * ERFA_DD2R;
+		double dec = centres[c][1] * ERFA_DD2R;
+		double r = 4 * ERFA_DD2R;
+
+		std::vector <UCAC5Star> stars;
+		ck_assert_int_eq (catalogue.cone (ra, dec, 0, r, 99, 100000, stars), 0);
+		std::vector <int> brute = bruteCone (ra, dec, r, 99);
+		ck_assert (brute.size () > 50);
+		// returned sorted by magnitude
+		ck_assert (magnitudes (stars) == brute);
+
+		for (size_t i = 0; i < stars.size (); i++)
+			ck_assert (stars[i].distance <= r);
+
+		// magnitude limit and number of stars
+		ck_assert_int_eq (catalogue.cone (ra, dec, 0, r, 15, 20, stars), 0);
+		brute = bruteCone (ra, dec, r, 15);
+		brute.resize (20);
+		ck_assert (magnitudes (stars) == brute);
+
+		ck_assert_int_eq (catalogue.cone (ra, dec, 0, r, 15, 0, stars), 0);
+		ck_assert_int_eq (stars.size (), 0);
+	}
+
+	// zone outside of the test catalogue
+	std::vector <UCAC5Star> stars;
+	ck_assert_int_eq (catalogue.cone (0, 45 * ERFA_DD2R, 0, ERFA_DD2R, 99, 100, stars), -1);
+}
+END_TEST
+
+START_TEST(cone_simd)
+{
+	UCAC5Catalogue catalogue;
+	ck_assert_int_eq (catalogue.open (UCAC5_TEST_DIR), 0);
+
+	for (int c = 0; c < 20; c++)
+	{
+		double ra = nextRandom () * 2 * M_PI;
+		double dec = (nextRandom () * 8 - 4) * ERFA_DD2R;
+		double r1 = nextRandom () * ERFA_DD2R;
+		double r2 = r1 + (nextRandom () * 4) * ERFA_DD2R;
+
+		std::vector <UCAC5Star> simd, scalar;
+		catalogue.setSimd (true);
+		ck_assert_int_eq (catalogue.cone (ra, dec, r1, r2, 99, 100000, simd), 0);
+		catalogue.setSimd (false);
+		ck_assert_int_eq (catalogue.cone (ra, dec, r1, r2, 99, 100000, scalar), 0);
+
+		ck_assert_int_eq (simd.size (), scalar.size ());
+		for (size_t i = 0; i < simd.size (); i++)
+		{
+			ck_assert (simd[i].record->gmag == scalar[i].record->gmag);
+			ck_assert_dbl_eq (simd[i].distance, scalar[i].distance, 10e-12);
+			ck_assert (simd[i].distance >= r1 - 10e-10);
+		}
+	}
+}
+END_TEST
+
+START_TEST(box)
+{
+	UCAC5Catalogue catalogue;
+	ck_assert_int_eq (catalogue.open (UCAC5_TEST_DIR), 0);
+
+	// second box crosses 0h
+	double boxes[2][4] = {{100, -3, 108, 1}, {356, -2, 4, 2}};
+	for (int b = 0; b < 2; b++)
+	{
+		double ra1 = boxes[b][0] * ERFA_DD2R;
+		double dec1 = boxes[b][1] * ERFA_DD2R;
+		double ra2 = boxes[b][2] * ERFA_DD2R;
+		double dec2 = boxes[b][3] * ERFA_DD2R;
+
+		std::vector <UCAC5Star> stars;
+		ck_assert_int_eq (catalogue.box (ra1, dec1, ra2, dec2, 99, 100000, stars), 0);
+		std::vector <int> brute = bruteBox (ra1, dec1, ra2, dec2);
+		ck_assert (brute.size () > 50);
+		ck_assert (magnitudes (stars) == brute);
+		ck_assert (isnan (stars[0].distance));
+
+		ck_assert_int_eq (catalogue.box (ra1, dec1, ra2, dec2, 99, 10, stars), 0);
+		brute.resize (10);
+		ck_assert (magnitudes (stars) == brute);
+	}
+}
+END_TEST
+
+Suite * ucac5_suite (void)
+{
+	Suite *s;
+	TCase *tc_ucac5;
+
+	s = suite_create ("UCAC5");
+	tc_ucac5 = tcase_create ("UCAC5 catalogue");
+
+	tcase_add_checked_fixture (tc_ucac5, setup_ucac5, teardown_ucac5);
+	tcase_add_test (tc_ucac5, cone);
+	tcase_add_test (tc_ucac5, cone_simd);
+	tcase_add_test (tc_ucac5, box);
+
+	suite_add_tcase (s, tc_ucac5);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = ucac5_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
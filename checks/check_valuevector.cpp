@@ -0,0 +1,110 @@
+#include "valuelist.h"
+
+#include <check.h>
+#include <check_utils.h>
+
+#include <sstream>
+
+void setup_valuevector (void)
+{
+}
+
+void teardown_valuevector (void)
+{
+}
+
+std::string valueName (int i)
+{
+	std::ostringstream os;
+	os << "value_" << i;
+	return os.str ();
+}
+
+START_TEST(lookup)
+{
+	rts2core::ValueVector values;
+	for (int i = 0; i < 300; i++)
+		values.push_back (new rts2core::ValueDouble (valueName (i)));
+
+	for (int i = 0; i < 300; i++)
+	{
+		rts2core::Value *val = values.getValue (valueName (i).c_str ());
+		ck_assert (val == values[i]);
+		ck_assert (values.getValueIterator (valueName (i).c_str ()) == values.begin () + i);
+	}
+	// names are compared case insensitive
+	ck_assert (values.getValue ("VALUE_10") == values[10]);
+	ck_assert (values.getValue ("value_300") == NULL);
+	ck_assert (values.getValueIterator ("value_300") == values.end ());
+	ck_assert (values.getValue ("") == NULL);
+
+	// duplicate name returns the first value
+	values.push_back (new rts2core::ValueDouble ("value_20"));
+	ck_assert (values.getValue ("value_20") == values[20]);
+}
+END_TEST
+
+START_TEST(modify)
+{
+	rts2core::ValueVector values;
+	for (int i = 0; i < 10; i++)
+		values.push_back (new rts2core::ValueDouble (valueName (i)));
+	ck_assert (values.getValue ("value_5") == values[5]);
+
+	// remove and insert new value at its place, as metaInfo does
+	rts2core::ValueVector::iterator iter = values.removeValue ("value_5");
+	ck_assert (values.getValue ("value_5") == NULL);
+	ck_assert (values.getValue ("value_6") == values[5]);
+	values.insert (iter, new rts2core::ValueDouble ("new_5"));
+	ck_assert (values.getValue ("new_5") == values[5]);
+	ck_assert (values.getValue ("value_6") == values[6]);
+	ck_assert_int_eq (values.size (), 10);
+
+	// index is valid, push_back must invalidate it
+	values.push_back (new rts2core::ValueDouble ("value_10"));
+	ck_assert (values.getValue ("value_10") == values[10]);
+
+	rts2core::Value *first = values[0];
+	values.erase (values.begin ());
+	delete first;
+	ck_assert (values.getValue ("value_0") == NULL);
+	ck_assert (values.getValue ("value_1") == values[0]);
+
+	for (iter = values.begin (); iter != values.end (); iter++)
+		delete *iter;
+	values.clear ();
+	ck_assert (values.getValue ("value_1") == NULL);
+}
+END_TEST
+
+Suite * valuevector_suite (void)
+{
+	Suite *s;
+	TCase *tc_valuevector;
+
+	s = suite_create ("ValueVector");
+	tc_valuevector = tcase_create ("Value lookup");
+
+	tcase_add_checked_fixture (tc_valuevector, setup_valuevector, teardown_valuevector);
+	tcase_add_test (tc_valuevector, lookup);
+	tcase_add_test (tc_valuevector, modify);
+
+	suite_add_tcase (s, tc_valuevector);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = valuevector_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
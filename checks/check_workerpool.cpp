@@ -0,0 +1,68 @@
+#include "workerpool.h"
+
+#include <vector>
+
+#include <check.h>
+#include <check_utils.h>
+
+void setup_workerpool (void)
+{
+}
+
+void teardown_workerpool (void)
+{
+}
+
+static void square (void *arg, size_t i)
+{
+	std::vector <long> *v = (std::vector <long> *) arg;
+	(*v)[i] = i * i;
+}
+
+START_TEST(parallel_for)
+{
+	for (int threads = 1; threads < 5; threads++)
+	{
+		rts2core::WorkerPool pool (threads);
+		ck_assert_int_eq (pool.getThreads (), threads);
+		for (int run = 0; run < 100; run++)
+		{
+			std::vector <long> v (run, -1);
+			pool.parallelFor (run, square, &v);
+			for (int i = 0; i < run; i++)
+				ck_assert_int_eq (v[i], i * i);
+		}
+	}
+}
+END_TEST
+
+Suite * workerpool_suite (void)
+{
+	Suite *s;
+	TCase *tc_workerpool;
+
+	s = suite_create ("WorkerPool");
+	tc_workerpool = tcase_create ("Worker pool");
+
+	tcase_add_checked_fixture (tc_workerpool, setup_workerpool, teardown_workerpool);
+	tcase_add_test (tc_workerpool, parallel_for);
+
+	suite_add_tcase (s, tc_workerpool);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = workerpool_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,96 @@
+#include "writebuffer.h"
+
+#include <string>
+
+#include <check.h>
+#include <check_utils.h>
+
+void setup_writebuffer (void)
+{
+}
+
+void teardown_writebuffer (void)
+{
+}
+
+/**
+ * Remove up to len bytes from start of the buffer.
+ */
+std::string drain (rts2core::WriteBuffer &wb, size_t len)
+{
+	struct iovec iov[2];
+	int iovcnt = wb.getIovec (iov);
+	std::string ret;
+	for (int i = 0; i < iovcnt; i++)
+		ret.append ((char *) iov[i].iov_base, iov[i].iov_len);
+	ret = ret.substr (0, len);
+	wb.consume (ret.length ());
+	return ret;
+}
+
+START_TEST(wrap_around)
+{
+	rts2core::WriteBuffer wb (100000);
+	std::string expected, received;
+
+	for (int i = 0; i < 20000; i++)
+	{
+		char line[50];
+		snprintf (line, 50, "V value_%d %d\n", i, i * 3);
+		if (wb.push (line, strlen (line)) == 0)
+			expected += line;
+		else
+			received += drain (wb, 777);
+		if (i % 7 == 0)
+			received += drain (wb, 13);
+	}
+	received += drain (wb, wb.size ());
+
+	ck_assert (wb.empty ());
+	ck_assert_int_eq (expected.length (), received.length ());
+	ck_assert (expected == received);
+}
+END_TEST
+
+START_TEST(limit)
+{
+	rts2core::WriteBuffer wb (10);
+	ck_assert_int_eq (wb.push ("123456", 6), 0);
+	ck_assert_int_eq (wb.push ("12345", 5), -1);
+	ck_assert_int_eq (wb.push ("1234", 4), 0);
+	ck_assert_int_eq (wb.size (), 10);
+	ck_assert_string_eq ("1234561234", drain (wb, 10));
+}
+END_TEST
+
+Suite * writebuffer_suite (void)
+{
+	Suite *s;
+	TCase *tc_writebuffer;
+
+	s = suite_create ("WriteBuffer");
+	tc_writebuffer = tcase_create ("Write buffer");
+
+	tcase_add_checked_fixture (tc_writebuffer, setup_writebuffer, teardown_writebuffer);
+	tcase_add_test (tc_writebuffer, wrap_around);
+	tcase_add_test (tc_writebuffer, limit);
+
+	suite_add_tcase (s, tc_writebuffer);
+
+	return s;
+}
+
+int main (void)
+{
+	int number_failed;
+	Suite *s;
+	SRunner *sr;
+
+	s = writebuffer_suite ();
+	sr = srunner_create (s);
+	srunner_run_all (sr, CK_NORMAL);
+	number_failed = srunner_ntests_failed (sr);
+	srunner_free (sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -17,6 +17,11 @@ class GemTest:public rts2teld::GEM
 		void test_getEquFromHrz (struct ln_hrz_posn *hrz, double JD, struct ln_equ_posn *pos) { return getEquFromHrz (hrz, JD, pos); };
 
 		void test_applyRefraction (struct ln_equ_posn *pos, double JD, bool writeValue) { return applyRefraction (pos, JD, writeValue); };
+
+#ifdef RTS2_LIBERFA
+		int test_getAstrom (double utc1, double utc2, eraASTROM *ret) { return getAstrom (utc1, utc2, ret); };
+#endif
+		void test_setWeather (float temperature, float humidity) { telAmbientTemperature->setValueFloat (temperature); telHumidity->setValueFloat (humidity); };
 		/**
 		 * Test movement to given target position, from counts in ac dc parameters.
 		 */
@@ -0,0 +1,21 @@
+#ifndef __CHECK_TESTBLOCK__
+#define __CHECK_TESTBLOCK__
+
+#include "block.h"
+
+/**
+ * Block with connections, which does not connect anywhere. Used to run
+ * event loop in checks and benchmarks.
+ */
+class TestBlock:public rts2core::Block
+{
+	public:
+		TestBlock (int argc, char **argv):rts2core::Block (argc, argv) { setTimeout (0); }
+
+		virtual int run () { return 0; }
+
+	protected:
+		virtual rts2core::Connection *createClientConnection (rts2core::NetworkAddress * in_addr) { return NULL; }
+};
+
+#endif //!__CHECK_TESTBLOCK__
@@ -54,6 +54,8 @@
 // protocol specific commands
 /** The command is variable value update. @ingroup RTS2Protocol */
 #define PROTO_VALUE            "V"
+/** The command is followed by given number of value updates, which shall be applied together. @ingroup RTS2Protocol */
+#define PROTO_VALUE_BATCH      "W"
 /** The command set variable value. @ingroup RTS2Protocol */
 #define PROTO_SET_VALUE        "X"
 /** The command is authorization request. @ingroup RTS2Protocol */
@@ -682,15 +684,48 @@ class Block: public App
 		virtual void fileModified (struct inotify_event *event) {};
 
 		/**
-		 * Add entry to block pole.
+		 * Add entry to block pole. Can be called multiple times for
+		 * the same descriptor during single addPollSocks run, events
+		 * are then merged.
 		 */
 		void addPollFD (int fd, short events);
 
 		/**
-		 * Returns events associated with the given descriptor.
+		 * Remove descriptor from poll structures. Must be called
+		 * before the descriptor is closed, as epoll backend otherwise
+		 * keeps registration of the closed descriptor and will not
+		 * register new descriptor with the same number. Connections
+		 * shall use Connection::closeFD or Connection::closeSocket.
+		 *
+		 * @param fd descriptor which will be closed
+		 */
+		void removePollFD (int fd);
+
+		/**
+		 * Returns events associated with the given descriptor. Events
+		 * are found through descriptor index, so the call takes
+		 * constant time.
 		 */
 		short getPollEvents (int fd);
 
+		/**
+		 * Use epoll instead of ppoll for the main event loop. Epoll
+		 * instance is created on first oneRunLoop call. Descriptors
+		 * are registered with the kernel only when they appear, change
+		 * requested events or disappear from the list of polled
+		 * descriptors. Connections are still asked for their
+		 * descriptors and checked for events on every loop, so the
+		 * per-loop cost stays proportional to the number of
+		 * connections, only the kernel part is saved.
+		 *
+		 * @param use  true if epoll shall be used
+		 *
+		 * @return -1 when epoll is not available on this system, 0 on success
+		 */
+		int setUseEpoll (bool use);
+
+		bool getUseEpoll () { return useEpoll; }
+
 		/**
 		 * Returns true, if some data awaits on the file descriptor.
 		 */
@@ -706,6 +741,46 @@ class Block: public App
 		 */
 		bool isForWrite (int fd) { return getPollEvents (fd) & POLLOUT; }
 
+		/**
+		 * Account write buffer statistics of a connection.
+		 *
+		 * @param queued   bytes which were queued in the write buffer
+		 * @param dropped  bytes which were dropped from the write buffer
+		 * @param stall    time (in seconds) data were waiting in the write buffer
+		 */
+		void addWriteStats (unsigned long long queued, unsigned long long dropped, double stall)
+		{
+			writeQueued += queued;
+			writeDropped += dropped;
+			writeStall += stall;
+		}
+
+		/**
+		 * Returns total number of bytes queued in connections write buffers.
+		 */
+		unsigned long long getWriteQueued () { return writeQueued; }
+
+		/**
+		 * Returns total number of bytes dropped from connections write buffers.
+		 */
+		unsigned long long getWriteDropped () { return writeDropped; }
+
+		/**
+		 * Returns total time of finished write stalls.
+		 */
+		double getWriteStall () { return writeStall; }
+
+		/**
+		 * Set write buffer limit of new connections.
+		 *
+		 * @param limit  limit in bytes
+		 *
+		 * @see Connection::setWriteBufferLimit
+		 */
+		void setWriteBufferLimit (size_t limit) { writeBufferLimit = limit; }
+
+		size_t getWriteBufferLimit () { return writeBufferLimit; }
+
 	protected:
 
 		virtual Connection *createClientConnection (NetworkAddress * in_addr) = 0;
@@ -810,6 +885,47 @@ class Block: public App
 		nfds_t pollsize;
 		nfds_t npolls;
 
+		/**
+		 * Registration of a descriptor, indexed by descriptor number.
+		 */
+		struct PollRegistration
+		{
+			// generation in which descriptor was added by addPollFD
+			uint32_t generation;
+			// index of descriptor in fds array
+			nfds_t slot;
+			// events registered with epoll
+			short events;
+			// epoll registration tag, 0 if descriptor is not registered
+			uint32_t tag;
+		};
+
+		std::vector <PollRegistration> pollRegs;
+		uint32_t pollGeneration;
+
+		unsigned long long writeQueued;
+		unsigned long long writeDropped;
+		double writeStall;
+		size_t writeBufferLimit;
+
+		bool useEpoll;
+		int epollfd;
+		uint32_t epollTag;
+		// descriptors registered with epoll
+		std::vector <int> epollFds;
+
+		/**
+		 * Remove from epoll descriptors which were not added in the last addPollSocks call.
+		 */
+		void epollSync ();
+
+		/**
+		 * Wait for epoll events, fill revents in fds array.
+		 *
+		 * @return number of descriptors with events, -1 on error
+		 */
+		int epollWait (const struct timespec *tout);
+
 		// timers - time when they should be executed, event which should be triggered
 		std::map <double, Event*> timers;
 
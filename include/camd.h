@@ -22,9 +22,16 @@
 
 #include <sys/time.h>
 #include <time.h>
+#include <pthread.h>
+
+#include <deque>
+#include <list>
+#include <vector>
 
 #include "scriptdevice.h"
 #include "imghdr.h"
+#include "imgstat.h"
+#include "workerpool.h"
 
 #define MAX_CHIPS  3
 #define MAX_DATA_RETRY 100
@@ -102,6 +109,87 @@ class DataType: public rts2core::Rts2SelData
 
 class Camera;
 
+/**
+ * Center box parameters and results of its calculation.
+ */
+struct ReadoutCenter
+{
+	// box position and size in binned pixels, relative to readout window
+	int x;
+	int y;
+	int w;
+	int h;
+	// width of image row
+	int rowWidth;
+	double cutLevel;
+
+	std::vector <double> sumsX;
+	std::vector <double> sumsY;
+	double max;
+	double avg;
+	int npix;
+};
+
+/**
+ * Chunk of image data passed through readout pipeline. Chunks are filled
+ * by driver doReadout call, statistics are calculated on them in pipeline
+ * thread, and they are send to client from the main thread.
+ */
+struct ReadoutChunk
+{
+	char *data;
+	size_t capacity;
+	size_t size;
+	int chan;
+	int dataType;
+	size_t pixels;
+
+	bool statistics;
+	bool center;
+	ReadoutCenter cen;
+
+	// statistics of image after the chunk was processed
+	double sum;
+	double min;
+	double max;
+	double average;
+	double stdev;
+	double mode;
+
+	// time (in seconds) spend on statistics calculation
+	double processTime;
+};
+
+/**
+ * Frame processed by SEP stage. Buffers hold all memory needed to process
+ * the frame, and are kept and reused for the next frames.
+ */
+struct SepFrame
+{
+	// copy of image data
+	std::vector <uint16_t> raw;
+	// background subtracted image
+	std::vector <float> image;
+	int w;
+	int h;
+	// number of threads used for processing
+	int threads;
+
+	// extracted sources
+	std::vector <double> x;
+	std::vector <double> y;
+	std::vector <double> flux;
+	std::vector <double> fluxerr;
+	std::vector <double> area;
+	std::vector <short> flag;
+
+	// SEP status, 0 on success
+	int status;
+	std::string error;
+	// time (in seconds) spend on processing
+	double processTime;
+};
+
 /**
  * Contains values for camera-filter client. This class is created
  * in camera init function and destroyed when destructor is called.
@@ -309,6 +397,9 @@ class Camera:public rts2core::ScriptDevice
 		double pixelX;
 		double pixelY;
 
+		virtual void addPollSocks ();
+		virtual void pollSuccess ();
+
 		// buffer used to read data
 		char* getDataBuffer (int chan);
 		char* getDataTop (int chan);
@@ -449,6 +540,19 @@ class Camera:public rts2core::ScriptDevice
 		 */
 		int sendImage (char *data, size_t dataSize);
 
+		/**
+		 * Send data read from the chip. Statistics are calculated on
+		 * data, and data are send to the client. If readout_pipeline is
+		 * on, data are copied to the pipeline buffer, and statistics and
+		 * sending run in parallel with the readout, so the caller can
+		 * reuse its buffer once the call returns.
+		 *
+		 * @param data      data to send
+		 * @param dataSize  size of data in bytes
+		 * @param chan      channel number
+		 *
+		 * @return -1 on error, 0 otherwise
+		 */
 		int sendReadoutData (char *data, size_t dataSize, int chan = 0);
 
 		int fitsDataTransfer (const char *fn)
@@ -469,8 +573,9 @@ class Camera:public rts2core::ScriptDevice
 			if (currentImageData < 0 && calculateStatistics->getValueInteger () == STATISTIC_ONLY)
 				// end bytes
 				return calculateDataSize;
+			// data waiting in readout pipeline were not yet send
 			if (exposureConn)
-				return exposureConn->getWriteBinaryDataSize (currentImageData);
+				return exposureConn->getWriteBinaryDataSize (currentImageData) - pipelinePendingTotal;
 			return 0;
 		}
 
@@ -485,7 +590,7 @@ class Camera:public rts2core::ScriptDevice
 				// end bytes
 				return calculateDataSize;
 			if (exposureConn)
-				return exposureConn->getWriteBinaryDataSize (currentImageData, chan);
+				return exposureConn->getWriteBinaryDataSize (currentImageData, chan) - pipelinePending[chan];
 			return 0;
 		}
 
@@ -994,7 +1099,10 @@ class Camera:public rts2core::ScriptDevice
 		void startExposureConnImageData () { startImageData (exposureConn); }
 
 		/**
-		 * Runs SEP on stars, find stars centers.
+		 * Queue frame for SEP source extraction. Data are copied, and
+		 * extraction runs in SEP thread, so the camera can start next
+		 * exposure. Results are published to sep_X, sep_Y and
+		 * sep_fluxes once extraction finishes.
 		 */
 		void findSepStars (uint16_t *data);
 
@@ -1061,9 +1169,10 @@ class Camera:public rts2core::ScriptDevice
 		rts2core::ValueDouble *max;
 		rts2core::ValueDouble *sum;
 		rts2core::ValueDouble *image_mode;
+		rts2core::ValueDouble *image_stdev;
 
-		uint32_t *modeCount;
-		long long unsigned int modeCountSize;
+		// statistics of current image
+		rts2core::ImageStatistics imageStatistics;
 
 		rts2core::ValueLong *computedPix;
 
@@ -1079,6 +1188,38 @@ class Camera:public rts2core::ScriptDevice
 		rts2core::DoubleArray *sepX;
 		rts2core::DoubleArray *sepY;
 		rts2core::DoubleArray *sepFluxes;
+		rts2core::ValueInteger *sepThreads;
+		rts2core::ValueDouble *sepDuration;
+
+		// SEP stage
+		pthread_t sepThread;
+		bool sepRunning;
+		pthread_mutex_t sepMutex;
+		// signals new frame for SEP thread
+		pthread_cond_t sepCond;
+		// pipe to wake up main loop when frame was processed
+		int sepNotify[2];
+		// frame waiting for processing
+		SepFrame *sepQueued;
+		// processed frame, waiting to be published
+		SepFrame *sepDone;
+		std::list <SepFrame *> sepFree;
+		// used only from SEP thread
+		rts2core::WorkerPool *sepPool;
+
+		int startSep ();
+
+		/**
+		 * Subtract background, extract sources and calculate their fluxes.
+		 */
+		void processSepFrame (SepFrame *frame);
+
+		/**
+		 * Publish processed frame results.
+		 */
+		void publishSep ();
+
+		static void *sepWorker (void *arg);
 
 		/**
 		 * Center box. Statistics is not calculated and values
@@ -1110,140 +1251,125 @@ class Camera:public rts2core::ScriptDevice
 		rts2core::ValueDouble *centerAvg;
 		rts2core::ValueDoubleStat *centerAvgStat;
 
-		// update statistics
-		template <typename t> int updateStatistics (t *data, size_t dataSize)
-		{
-			long double tSum = 0;
-			double tMin = min->getValueDouble ();
-			double tMax = max->getValueDouble ();
-			int pixNum = 0;
-			t *tData = data;
-			if (modeCountSize < (((long long unsigned int) 1) << (sizeof (t) * 8)))
-			{
-				delete[] modeCount;
-				modeCountSize = ((long long unsigned int) 1) << (sizeof (t) * 8);
-				modeCount = new uint32_t[modeCountSize];
-				memset (modeCount, 0, modeCountSize * sizeof (uint32_t));
-			}
-			while (((char *) tData) < ((char *) data) + dataSize)
-			{
-				t tD = *tData;
-				tSum += tD;
-				if (tD < tMin)
-					tMin = tD;
-				if (tD > tMax)
-				  	tMax = tD;
-				modeCount[(long) tD]++;
-				tData++;
-				pixNum++;
-			}
-			sum->setValueDouble (sum->getValueDouble () + tSum);
-			if (tMin < min->getValueDouble ())
-				min->setValueDouble (tMin);
-			if (tMax > max->getValueDouble ())
-				max->setValueDouble (tMax);
-			return pixNum;
-		}
+		/**
+		 * Fill center box parameters.
+		 *
+		 * @return -1 if box is not inside readout window, 0 on success
+		 */
+		int getCenterBox (ReadoutCenter &cen);
 
-		// update center box
-		template <typename t> int updateCenter (t *data, size_t dataSize)
+		// calculate center box, uses only values from cen, so can be called from pipeline thread
+		template <typename t> void computeCenter (t *data, ReadoutCenter &cen)
 		{
-			// check if box is inside window
-			int x = centerBox->getXInt ();
-			if (x < 0)
-				x = getUsedX ();
-			int y = centerBox->getYInt ();
-			if (y < 0)
-				y = getUsedY ();
-			int w = centerBox->getWidthInt () / binningHorizontal ();
-			if (w < 0)
-				w = (getUsedWidth () - (x - getUsedX ())) / binningHorizontal ();
-			int h = centerBox->getHeightInt () / binningVertical ();
-			if (h < 0)
-				h = (getUsedHeight () - (y - getUsedY ())) / binningVertical ();
-
-			double center_max = centerCutLevel->getValueDouble ();
-			double center_avg = 0;
-			int center_npix = 0;
-			
-			x -= getUsedX ();
-			y -= getUsedY ();
-
-			if (x < 0 || y < 0 || (w + ceil ((double) x / binningHorizontal ())) > getUsedWidthBinned () || (h + ceil ((double) y / binningVertical ())) > getUsedHeightBinned ())
-				return -1;
+			cen.max = cen.cutLevel;
+			cen.avg = 0;
+			cen.npix = 0;
 
 			t *tData = data;
 			// move to the first calculated pixel
-			tData += y * getUsedWidthBinned () + x;
-
-			int i;
+			tData += cen.y * cen.rowWidth + cen.x;
 
-			double sx[w];
-			for (i = 0; i < w; i++)
-				sx[i] = 0;
+			cen.sumsX.assign (cen.w, 0);
+			cen.sumsY.clear ();
 
-			sumsY->clear ();
-
-			for (int row = 0; row < h; row++)
+			for (int row = 0; row < cen.h; row++)
 			{
 				double rs = 0;
-				for (int col = 0; col < w; col++, tData++)
+				for (int col = 0; col < cen.w; col++, tData++)
 				{
-					if (*tData >= centerCutLevel->getValueDouble ())
+					if (*tData >= cen.cutLevel)
 					{
-						sx[col] += *tData;
+						cen.sumsX[col] += *tData;
 						rs += *tData;
-						center_npix++;
-						if (std::isnan (center_max) || *tData > center_max)
-							center_max = *tData;
+						cen.npix++;
+						if (std::isnan (cen.max) || *tData > cen.max)
+							cen.max = *tData;
 					}
 				}
 
-				sumsY->addValue (rs);
-				center_avg += rs;
+				cen.sumsY.push_back (rs);
+				cen.avg += rs;
 			}
+		}
 
-			sumsX->clear ();
+		/**
+		 * Set center values from calculated center box.
+		 */
+		void publishCenter (ReadoutCenter &cen);
 
-			for (i = 0; i < w; i++)
-				sumsX->addValue (sx[i]);
+		// readout pipeline
+		rts2core::ValueBool *readoutPipeline;
+		rts2core::ValueLong *readoutPipelineSize;
 
-			sendValueAll (sumsX);
-			sendValueAll (sumsY);
+		// time spend in readout stages
+		rts2core::ValueDouble *stageReadout;
+		rts2core::ValueDouble *stageProcess;
+		rts2core::ValueDouble *stageSend;
+		rts2core::ValueDouble *stageWait;
 
-			centerX->setValueDouble (sumsX->calculateMedianIndex ());
-			centerY->setValueDouble (sumsY->calculateMedianIndex ());
+		// time spend in sendReadoutData during doReadout call
+		double sendReadoutDuration;
 
-			centerMax->setValueDouble (center_max);
+		pthread_t pipelineThread;
+		bool pipelineRunning;
+		pthread_mutex_t pipelineMutex;
+		// signals new chunk for processing to pipeline thread
+		pthread_cond_t pipelineCond;
+		// signals processed chunk to the main thread
+		pthread_cond_t pipelineDoneCond;
+		// pipe to wake up main loop when chunk was processed
+		int pipelineNotify[2];
 
-			centerStat->addValue (center_max, centerSums->getValueInteger ());
+		std::deque <ReadoutChunk *> pipelineQueue;
+		std::deque <ReadoutChunk *> pipelineDone;
+		std::list <ReadoutChunk *> pipelineFree;
+		// bytes allocated in chunks
+		size_t pipelineBytes;
+		// number of chunks inside pipeline
+		int pipelineInFlight;
+		// bytes not yet send, for each channel
+		size_t *pipelinePending;
+		size_t pipelinePendingTotal;
+		// true if sending of chunk failed
+		bool pipelineError;
 
-			if (center_npix > 0)
-			{
-				center_avg /= center_npix;
-				centerAvg->setValueDouble (center_avg);
-				centerAvgStat->addValue (center_avg, centerSums->getValueInteger ());
-			}
-			else
-			{
-				centerAvg->setValueDouble (0);
-				centerAvgStat->addValue (0, centerSums->getValueInteger ());
-			}
+		enum { PIPELINE_NOWAIT, PIPELINE_WAIT_ONE, PIPELINE_WAIT_ALL };
 
-			sendValueAll (centerX);
-			sendValueAll (centerY);
+		void fillChunk (ReadoutChunk *chunk, size_t dataSize, int chan);
 
-			sendValueAll (centerMax);
+		/**
+		 * Calculate statistics and center of the chunk.
+		 */
+		void processChunk (ReadoutChunk *chunk);
+
+		/**
+		 * Update statistics values from the chunk, send chunk to client.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int publishChunk (ReadoutChunk *chunk);
 
-			centerStat->calculate ();
-			sendValueAll (centerStat);
+		int startPipeline ();
 
-			sendValueAll (centerAvg);
-			centerAvgStat->calculate ();
-			sendValueAll (centerAvgStat);
+		int queueReadoutData (char *data, size_t dataSize, int chan);
 
-			return 0;
-		}
+		/**
+		 * Returns chunk for data of given size. Waits for processing of
+		 * chunks in pipeline if memory limit would be exceeded.
+		 */
+		ReadoutChunk *getPipelineChunk (size_t size);
+
+		/**
+		 * Publish chunks processed in pipeline thread.
+		 *
+		 * @param wait  PIPELINE_NOWAIT to publish chunks processed so far, PIPELINE_WAIT_ONE to wait
+		 *   for at least one chunk, PIPELINE_WAIT_ALL to wait for all chunks inside pipeline
+		 *
+		 * @return -1 if some chunk cannot be send, 0 on success
+		 */
+		int publishPipeline (int wait);
+
+		static void *pipelineWorker (void *arg);
 
 		char multi_wcs;
 
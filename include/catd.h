@@ -21,6 +21,9 @@
 #define __RTS2_CATD__
 
 #include "device.h"
+#include "valuearray.h"
+
+#include <vector>
 
 /**
  * Abstract sensors, SensorWeather with functions to set weather state, and various other sensors.
@@ -28,10 +31,31 @@
 namespace rts2catd
 {
 
+/**
+ * Star found in a catalogue.
+ */
+struct CatalogueStar
+{
+	std::string id;
+	// J2000 position (degrees)
+	double ra;
+	double dec;
+	double mag;
+	// distance from the search centre (degrees), NAN for box searches
+	double distance;
+};
+
 /**
  * Class for a catalogue. Sensor can be any device which produce some information
  * which RTS2 can use.
  *
+ * Catalogue is searched by commands. cone RA DEC RADIUS searches circle
+ * around the given position, box RA1 DEC1 RA2 DEC2 searches RA/DEC
+ * rectangle, cones RADIUS RA1 DEC1 RA2 DEC2.. searches circles around
+ * multiple field centres. Found stars are returned in array values, with
+ * index of the field the star belongs to in stars_field array. Cone radius
+ * is limited by max_radius value.
+ *
  * For special devices, which are ussually to be found in an observatory,
  * please see special classes (Dome, Camera, Telescope etc..).
  *
@@ -43,13 +67,61 @@ class Catd:public rts2core::Device
 		Catd (int argc, char **argv, const char *cn = "CAT1");
 		virtual ~Catd (void);
 
+		virtual int commandAuthorized (rts2core::Connection * conn);
+
 	protected:
-		virtual int searchCataloge (struct ln_equ_posn *c1, struct ln_equ_posn *c2, int num) = 0;
+		/**
+		 * Search stars inside circle.
+		 *
+		 * @param c          circle centre (degrees)
+		 * @param radius     circle radius (degrees)
+		 * @param magLimit   faintest magnitude of returned stars
+		 * @param maxStars   maximal number of returned stars; brightest stars are returned if more stars are found
+		 * @param stars      found stars
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		virtual int searchCone (struct ln_equ_posn *c, double radius, double magLimit, int maxStars, std::vector <CatalogueStar> &stars) = 0;
+
+		/**
+		 * Search stars inside RA/DEC box. If c1 RA is larger than c2 RA,
+		 * the box crosses 0h.
+		 *
+		 * @param c1   box corner with lower RA and DEC (degrees)
+		 * @param c2   box corner with higher RA and DEC (degrees)
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		virtual int searchBox (struct ln_equ_posn *c1, struct ln_equ_posn *c2, double magLimit, int maxStars, std::vector <CatalogueStar> &stars) = 0;
+
+		/**
+		 * Search stars around multiple field centres. Default
+		 * implementation calls searchCone for every field.
+		 *
+		 * @param stars   found stars, one vector for every field
+		 */
+		virtual int searchCones (std::vector <struct ln_equ_posn> &centres, double radius, double magLimit, int maxStars, std::vector <std::vector <CatalogueStar> > &stars);
 
 	private:
 		rts2core::ValueRaDec *corner1;
 		rts2core::ValueRaDec *corner2;
+		rts2core::ValueDouble *coneRadius;
+		rts2core::ValueDouble *maxRadius;
+		rts2core::ValueDouble *magnitudeLimit;
+		rts2core::ValueInteger *starsLimit;
 		rts2core::ValueInteger *numStars;
+		rts2core::ValueDouble *searchDuration;
+
+		rts2core::IntegerArray *starsField;
+		rts2core::StringArray *starsId;
+		rts2core::DoubleArray *starsRa;
+		rts2core::DoubleArray *starsDec;
+		rts2core::DoubleArray *starsMag;
+		rts2core::DoubleArray *starsDistance;
+
+		void clearStars ();
+		void addStars (int field, std::vector <CatalogueStar> &stars);
+		void sendStars (double start);
 };
 
 };
@@ -406,6 +406,25 @@ class Rts2CentraldCommand:public Command
 		}
 };
 
+/**
+ * Ask other side to send value updates in batches. Old devices do not
+ * know the command and return an error, which is silently ignored.
+ *
+ * @see PROTO_VALUE_BATCH
+ *
+ * @ingroup RTS2Command
+ */
+class CommandBatchValues:public Command
+{
+	public:
+		CommandBatchValues (Block * _master):Command (_master, "batch_values") {}
+
+		virtual int commandReturnFailed (int status, Connection * conn)
+		{
+			return -1;
+		}
+};
+
 /**
  * Send and process authorization request.
  *
@@ -423,6 +442,7 @@ class CommandSendKey:public Command
 
 		virtual int commandReturnOK (Connection * conn)
 		{
+			connection->queSend (new CommandBatchValues (owner));
 			connection->setConnState (CONN_AUTH_OK);
 			return -1;
 		}
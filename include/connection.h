@@ -41,6 +41,7 @@
 #include "message.h"
 #include "logstream.h"
 #include "valuelist.h"
+#include "writebuffer.h"
 
 #define MAX_DATA    2000
 
@@ -222,10 +223,13 @@ class Connection:public Object
 		 *
 		 * @return 1 if the input string match the current command, 0 otherwise.
 		 */
-		inline int isCommand (const char *cmd) { return !strcmp (cmd, getCommand ()); }
+		inline int isCommand (const char *cmd) { return *cmd == *getCommand () && !strcmp (cmd, getCommand ()); }
 
 		/**
-		 * Send char message to other side.
+		 * Send char message to other side. Message is written without
+		 * blocking. If socket cannot accept the whole message, rest of
+		 * the message is queued in the write buffer and flushed when the
+		 * socket becomes writable.
 		 *
 		 * @return -1 on error, 0 on sucess
 		 */
@@ -254,6 +258,75 @@ class Connection:public Object
 		 */
 		int sendBinaryData (int data_conn, int chan, char *data, size_t dataSize);
 
+		/**
+		 * Returns number of bytes waiting in the write buffer.
+		 */
+		size_t getWriteBufferSize () { return writeBuffer.size (); }
+
+		/**
+		 * Set maximal size of the write buffer. If the other side does
+		 * not read data fast enough and buffer exceeds this size, the
+		 * connection is closed.
+		 *
+		 * @param limit  buffer limit in bytes
+		 */
+		void setWriteBufferLimit (size_t limit) { writeBuffer.setLimit (limit); }
+
+		/**
+		 * Returns total number of bytes which were queued in the write
+		 * buffer, as they could not be written directly.
+		 */
+		unsigned long long getBytesQueued () { return bytesQueued; }
+
+		/**
+		 * Returns total number of bytes flushed from the write buffer.
+		 */
+		unsigned long long getBytesFlushed () { return bytesFlushed; }
+
+		/**
+		 * Returns total number of bytes dropped from the write buffer,
+		 * as the connection was closed before they were written.
+		 */
+		unsigned long long getBytesDropped () { return bytesDropped; }
+
+		/**
+		 * Returns total time (in seconds) during which some data were
+		 * waiting in the write buffer.
+		 */
+		double getWriteStallTime ();
+
+		/**
+		 * Returns number of write calls made on connection socket.
+		 */
+		unsigned long long getWriteCalls () { return writeCalls; }
+
+		/**
+		 * Set if the other side accepts batched value updates.
+		 *
+		 * @see PROTO_VALUE_BATCH
+		 */
+		void setBatchValues (bool _batchValues) { batchValues = _batchValues; }
+
+		bool getBatchValues () { return batchValues; }
+
+		/**
+		 * Start collecting value updates. All value updates sent until
+		 * endValueBatch is called are collected, and send as a single
+		 * batch. Other messages and binary data flush collected updates
+		 * before they are sent, so the order of messages is kept. Does
+		 * nothing if the other side does not support batched value
+		 * updates.
+		 */
+		void startValueBatch ();
+
+		/**
+		 * Send collected value updates. Updates are prefixed with
+		 * PROTO_VALUE_BATCH line if there are more of them.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int endValueBatch ();
+
 		void endBinaryData (int data_conn);
 
 		/**
@@ -649,6 +722,13 @@ class Connection:public Object
 		 */
 		DataAbstractRead *lastDataChannel (int chan);
 
+		/**
+		 * Return channels of data connection, NULL if data connection is not active.
+		 *
+		 * @param data_conn  data connection number
+		 */
+		DataChannels *getDataChannels (int data_conn);
+
 		/**
 		 * Send value using sendValueAll?
 		 */
@@ -684,6 +764,23 @@ class Connection:public Object
 		 */
 		int sock;
 
+		/**
+		 * Remove descriptor from master poll structures and close it.
+		 * Descriptors registered with addPollFD must be closed through
+		 * this call, otherwise epoll backend will not register the
+		 * descriptor number when it is reused.
+		 *
+		 * @param fd  descriptor to close, set to -1
+		 *
+		 * @return close call return value, 0 if descriptor was not open
+		 */
+		int closeFD (int &fd);
+
+		/**
+		 * Close connection socket, remove it from master poll structures.
+		 */
+		void closeSocket () { closeFD (sock); }
+
 		// if we will print connection communication
 		bool debugComm;
 
@@ -810,6 +907,78 @@ class Connection:public Object
 		// ID of outgoing data connection
 		int dataConn;
 
+		// data which were not yet written to socket
+		WriteBuffer writeBuffer;
+
+		unsigned long long bytesQueued;
+		unsigned long long bytesFlushed;
+		unsigned long long bytesDropped;
+		// total stall time, and start of current stall (NAN if write buffer is empty)
+		double stallTime;
+		double stallStart;
+
+		unsigned long long writeCalls;
+
+		// other side accepts batched values
+		bool batchValues;
+		// collecting outgoing value updates
+		bool batchOpen;
+		std::string batchBuf;
+		int batchLines;
+
+		// remaining lines of incoming batch, received lines of the batch and values changed by the batch
+		int batchRemaining;
+		std::vector <std::string> batchReceived;
+		bool batchApplying;
+		std::vector <Value *> batchChanged;
+
+		/**
+		 * Send value updates collected so far. Batch stays open.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int flushValueBatch ();
+
+		/**
+		 * Apply received batch. Batch is applied only if all its
+		 * lines are updates of known values, otherwise connection is
+		 * closed with protocol error and no value is changed.
+		 */
+		void applyValueBatch ();
+
+		/**
+		 * Write IO vectors to socket without blocking.
+		 *
+		 * @return number of bytes written, -1 on error (errno is set)
+		 */
+		ssize_t writeVector (struct iovec *iov, int iovcnt);
+
+		/**
+		 * Account end of write stall.
+		 */
+		void endWriteStall ();
+
+		/**
+		 * Clear write buffer, log and account data which were not written.
+		 */
+		void dropWriteBuffer ();
+
+		/**
+		 * Send data described by IO vectors. Data which cannot be
+		 * written immediately are put to the write buffer.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int sendVector (struct iovec *iov, int iovcnt);
+
+		/**
+		 * Write out data from the write buffer, until it is empty or
+		 * the socket would block.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int flushWriteBuffer ();
+
 		// connectionTimeout in seconds
 		int connectionTimeout;
 		conn_state_t conn_state;
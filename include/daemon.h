@@ -689,6 +689,17 @@ class Daemon:public Block
 		ValueTime *info_time;
 		ValueTime *uptime;
 
+		// write buffers statistics, NULL unless --write-buffer option was used
+		ValueLong *write_pending;
+		ValueLong *write_queued;
+		ValueLong *write_dropped;
+		ValueDouble *write_stall;
+
+		/**
+		 * Update write buffers statistics values.
+		 */
+		void updateWriteStats ();
+
 		double idleInfoInterval;
 
 		bool doHupIdleLoop;
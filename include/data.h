@@ -21,7 +21,9 @@
 #define __RTS2_DATA__
 
 #include <errno.h>
+#include <string.h>
 #include <unistd.h>
+#include <map>
 #include <vector>
 
 // maximal number of shared clients
@@ -79,6 +81,28 @@ class DataAbstractRead
 		 * Return remaining size of chunk, which has to be read from actual data chunk.
 		 */
 		virtual size_t getChunkSize () = 0;
+
+		/**
+		 * Keep in memory only data which were not yet processed by the
+		 * client. Must be called before data arrives. Client is then
+		 * responsible to call discardData once it processed the data.
+		 */
+		virtual void setStreaming () {}
+
+		/**
+		 * Remove processed data from the beginning of the buffer.
+		 *
+		 * @param len  number of bytes to remove
+		 *
+		 * @return true if data were removed, false if the buffer does not support streaming
+		 */
+		virtual bool discardData (size_t len) { return false; }
+
+		/**
+		 * Return offset of the first byte in buffer (returned by
+		 * getDataBuff) from the beginning of channel data.
+		 */
+		virtual size_t getDataOffset () { return 0; }
 };
 
 /**
@@ -92,10 +116,14 @@ class DataRead:public DataAbstractRead
 		DataRead (size_t in_binaryReadDataSize, int in_type)
 		{
 			binaryReadDataSize = in_binaryReadDataSize;
-			binaryReadBuff = new char[binaryReadDataSize];
+			// buffer is allocated when size of the first chunk is known
+			binaryReadBuff = NULL;
+			binaryReadBuffSize = 0;
 			binaryReadTop = binaryReadBuff;
 			binaryReadType = in_type;
 			binaryReadChunkSize = -1;
+			streaming = false;
+			discarded = 0;
 		}
 
 		~DataRead (void)
@@ -105,7 +133,7 @@ class DataRead:public DataAbstractRead
 
 		virtual int readDataSize (Connection *conn);
 
-		void setChunkSizeFromData () { binaryReadChunkSize = binaryReadDataSize; }
+		void setChunkSizeFromData () { binaryReadChunkSize = binaryReadDataSize; allocateBuffer (); }
 
 		/**
 		 * Receive data from socket.
@@ -149,6 +177,20 @@ class DataRead:public DataAbstractRead
 
 		virtual size_t getChunkSize () { return binaryReadChunkSize; }
 
+		virtual void setStreaming () { streaming = true; }
+
+		virtual bool discardData (size_t len)
+		{
+			if (!streaming)
+				return false;
+			memmove (binaryReadBuff, binaryReadBuff + len, (binaryReadTop - binaryReadBuff) - len);
+			binaryReadTop -= len;
+			discarded += len;
+			return true;
+		}
+
+		virtual size_t getDataOffset () { return discarded; }
+
 	private:
 		// binary data
 		// when it is positive, there are binary data to read from connection
@@ -157,8 +199,20 @@ class DataRead:public DataAbstractRead
 		size_t binaryReadDataSize;
 
 		char *binaryReadBuff;
+		size_t binaryReadBuffSize;
 		char *binaryReadTop;
 
+		// if true, buffer holds only data not yet discarded by the client
+		bool streaming;
+		// number of bytes discarded from the buffer
+		size_t discarded;
+
+		/**
+		 * Make sure the buffer can hold rest of the current chunk. Whole
+		 * channel is allocated at once, unless data are streamed.
+		 */
+		void allocateBuffer ();
+
 		// type of data we are reading
 		int binaryReadType;
 
@@ -0,0 +1,187 @@
+/*
+ * Precomputed target ephemeris for a night.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_EPHEMERIS__
+#define __RTS2_EPHEMERIS__
+
+#include <libnova/libnova.h>
+#include <stddef.h>
+#include <vector>
+
+namespace rts2core
+{
+
+/**
+ * Time grid of a night, shared by target ephemeris tables. Holds
+ * values which do not depend on target - sidereal time and Moon
+ * position - so they are computed only once for all targets.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class NightEphemeris
+{
+	public:
+		/**
+		 * Compute night grid.
+		 *
+		 * @param _observer  observer position
+		 * @param _from      JD of the night start
+		 * @param _to        JD of the night end
+		 * @param _step      grid step in seconds
+		 */
+		NightEphemeris (struct ln_lnlat_posn *_observer, double _from, double _to, double _step);
+
+		struct ln_lnlat_posn *getObserver () { return observer; }
+
+		double getFrom () { return from; }
+		double getTo () { return to; }
+
+		/**
+		 * Returns grid step in days.
+		 */
+		double getStep () { return step; }
+
+		/**
+		 * Returns number of grid samples.
+		 */
+		size_t getSize () { return gmst.size (); }
+
+		/**
+		 * Returns JD of the sample.
+		 */
+		double getJD (size_t i) { return from + i * step; }
+
+		/**
+		 * Returns Greenwich mean sidereal time (in hours) of the sample.
+		 */
+		double getSiderealTime (size_t i) { return gmst[i]; }
+
+		/**
+		 * Returns Moon equatorial coordinates at the sample.
+		 */
+		struct ln_equ_posn *getMoon (size_t i) { return &(moon[i]); }
+
+		/**
+		 * Returns true if JD is inside the night. Dates less than
+		 * half of the step outside the grid are accepted, so rounding
+		 * of computed night boundaries does not switch to full
+		 * calculation.
+		 */
+		bool contains (double JD) { return JD >= from - step / 2.0 && JD <= getJD (getSize () - 1) + step / 2.0; }
+
+	private:
+		struct ln_lnlat_posn *observer;
+		double from;
+		double to;
+		double step;
+
+		std::vector <double> gmst;
+		std::vector <struct ln_equ_posn> moon;
+};
+
+/**
+ * Target ephemeris sample. Single precision is good to 0.1 arcsec,
+ * which is far bellow interpolation error.
+ */
+struct EphemerisSample
+{
+	float ra;
+	float dec;
+	float alt;
+	float az;
+	// hour angle, -180..180
+	float ha;
+	float lunarDistance;
+};
+
+/**
+ * Table of target equatorial position, altitude, azimuth, hour angle
+ * and lunar distance sampled on night grid. Values between samples are linearly
+ * interpolated. Airmass and zenith distance are derived from
+ * interpolated altitude.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class TargetEphemeris
+{
+	public:
+		TargetEphemeris (NightEphemeris *_night):night (_night), samples (_night->getSize ()) {}
+
+		/**
+		 * Fill table with target positions.
+		 *
+		 * @param tar  target, provides getPosition (struct ln_equ_posn *pos, double JD) method
+		 */
+		template <typename t> void fill (t *tar)
+		{
+			struct ln_equ_posn pos;
+			for (size_t i = 0; i < samples.size (); i++)
+			{
+				tar->getPosition (&pos, night->getJD (i));
+				setSample (i, &pos);
+			}
+		}
+
+		NightEphemeris *getNight () { return night; }
+
+		/**
+		 * Returns true if the table can be used for given date and observer.
+		 */
+		bool contains (double JD, struct ln_lnlat_posn *obs) { return obs == night->getObserver () && night->contains (JD); }
+
+		bool contains (double JD) { return night->contains (JD); }
+
+		/**
+		 * Returns interpolated equatorial position. Unlike target
+		 * getPosition, it only reads the table, so it can be called
+		 * from multiple threads.
+		 */
+		void getPosition (struct ln_equ_posn *pos, double JD);
+
+		void getAltAz (struct ln_hrz_posn *hrz, double JD);
+
+		double getAlt (double JD);
+
+		double getHourAngle (double JD);
+
+		double getLunarDistance (double JD);
+
+		/**
+		 * Returns minimal and maximal altitude during given interval.
+		 * Extremes are searched in the samples inside the interval, and
+		 * at its start and end.
+		 */
+		void getMinMaxAlt (double _start, double _end, double &_min, double &_max);
+
+	private:
+		NightEphemeris *night;
+		std::vector <EphemerisSample> samples;
+
+		void setSample (size_t i, struct ln_equ_posn *pos);
+
+		/**
+		 * Returns index of the sample before JD, and fraction of
+		 * step between the sample and JD.
+		 */
+		size_t locate (double JD, double &frac);
+};
+
+}
+
+#endif // !__RTS2_EPHEMERIS__
@@ -0,0 +1,160 @@
+/*
+ * Least-squares fitting of RTS2 telescope pointing model.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_GPOINTFIT__
+#define __RTS2_GPOINTFIT__
+
+#include "gpointmodel.h"
+
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace rts2telmodel
+{
+
+/**
+ * Single pointing measurement. All values are in degrees.
+ */
+struct GPointMeasurement
+{
+	// mount (commanded) position
+	double az;
+	double alt;
+	double ha;
+	double dec;
+
+	// true position, from astrometry
+	double r_az;
+	double r_alt;
+	double r_ha;
+	double r_dec;
+};
+
+/**
+ * Fit GPointModel parameters to measured data.
+ *
+ * All model terms are linear in their parameters, so the model is
+ * fitted with a single linear least-squares solution. Alt-az models
+ * are fitted to make getErrAltAz of mount position equal to
+ * difference between true and mount position. Equatorial models are
+ * fitted to make reverse of true position equal to mount position.
+ * Residuals along azimuth (hour angle) are scaled by cosine of
+ * altitude (declination), so the fit minimizes on-sky distance.
+ *
+ * Multipliers of model extra terms are fitted together with base
+ * parameters. Terms which do not scale with their multiplier (sinsin)
+ * are kept fixed.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class GPointFit
+{
+	public:
+		GPointFit ();
+
+		/**
+		 * Load data in gpoint input format. Lines starting with # are
+		 * comments, except #observatory, #gem, #altaz and #altaz-manual
+		 * lines, which specify mount type and observatory longitude,
+		 * latitude and altitude.
+		 *
+		 * @throw rts2core::Error on invalid input
+		 */
+		void loadData (std::istream &is);
+
+		/**
+		 * Add measurement. Either alt-az or HA-DEC coordinates, depending
+		 * on mount type, must be set. The other coordinates are
+		 * calculated from latitude, which must be set before.
+		 */
+		void addMeasurement (GPointMeasurement &m);
+
+		std::vector <GPointMeasurement> &getData () { return data; }
+
+		bool isAltAz () { return altaz; }
+		void setAltAz (bool _altaz) { altaz = _altaz; }
+
+		double getLatitude () { return latitude; }
+		void setLatitude (double _latitude) { latitude = _latitude; }
+
+		/**
+		 * Fix parameter, so it is not fitted.
+		 *
+		 * @param name  parameter name (ia, tn,.. for alt-az, id, me,.. for GEM models)
+		 *
+		 * @return -1 if parameter name is not known
+		 */
+		int setFixed (const char *name);
+
+		/**
+		 * Fit model to loaded data. Model parameters and multipliers
+		 * of extra terms are updated.
+		 *
+		 * @return 0 on success, -1 if there is not enough data or the problem is singular
+		 */
+		int fit (GPointModel *model);
+
+		/**
+		 * Return RMS of on-sky distances between model and data, in degrees.
+		 */
+		double getRMS (GPointModel *model);
+
+		/**
+		 * Names of fitted parameters, in the order of fit results.
+		 */
+		std::vector <std::string> &getParamNames () { return paramNames; }
+
+		/**
+		 * Fitted values, in radians.
+		 */
+		std::vector <double> &getParamValues () { return paramValues; }
+
+		/**
+		 * Standard errors of fitted values, in radians.
+		 */
+		std::vector <double> &getParamErrors () { return paramErrors; }
+
+		/**
+		 * Returns names of base parameters for the mount type.
+		 */
+		static const char **getBaseNames (bool _altaz);
+
+	private:
+		std::vector <GPointMeasurement> data;
+		bool altaz;
+		double latitude;
+
+		std::vector <std::string> fixed;
+
+		std::vector <std::string> paramNames;
+		std::vector <double> paramValues;
+		std::vector <double> paramErrors;
+
+		/**
+		 * Fill missing alt-az or HA-DEC coordinates of the measurement.
+		 */
+		void completeMeasurement (GPointMeasurement &m);
+
+		bool isFixed (const char *name);
+};
+
+}
+
+#endif // !__RTS2_GPOINTFIT__
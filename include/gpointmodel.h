@@ -32,6 +32,33 @@ namespace rts2telmodel
 typedef enum { GPOINT_OFFSET=0, GPOINT_SIN, GPOINT_COS, GPOINT_TAN, GPOINT_SINCOS, GPOINT_COSCOS, GPOINT_SINSIN, GPOINT_ABSSIN, GPOINT_ABSCOS, GPOINT_CSC, GPOINT_SEC, GPOINT_COT, GPOINT_SINH, GPOINT_COSH, GPOINT_TANH, GPOINT_SECH, GPOINT_CSCH, GPOINT_COTH, GPOINT_LASTFUN } function_t;
 typedef enum { GPOINT_AZ=0, GPOINT_EL, GPOINT_ZD, GPOINT_HA, GPOINT_DEC, GPOINT_PD, GPOINT_LASTTERM } terms_t;
 
+/**
+ * Number of term arguments used by compiled terms. Arguments are
+ * indexed by terms_t, PD and LASTTERM arguments are always 0.
+ */
+#define GPOINT_ARGS    (GPOINT_LASTTERM + 1)
+
+typedef double (*term_function_t) (double a, double b);
+
+/**
+ * Extra parameter compiled for batch evaluation. Value of the term
+ * is multi * fn (c0 * args[a0], c1 * args[a1]), where args are
+ * term arguments in radians.
+ */
+struct CompiledTerm
+{
+	term_function_t fn;
+	double multi;
+	double c0;
+	double c1;
+	int a0;
+	int a1;
+	// false if term value does not scale with parameter, and thus cannot be fitted
+	bool linear;
+
+	double getValue (const double *args) { return multi * fn (c0 * args[a0], c1 * args[a1]); }
+};
+
 /**
  * Extra parameters, currently only for Alt-Az telescopes.
  *
@@ -46,6 +73,11 @@ class ExtraParam
 
 		std::string toString (char frmt = 'r');
 
+		/**
+		 * Fill compiled term from parameter.
+		 */
+		void compile (CompiledTerm *term);
+
 		static const char *fns[];
 		static const char *pns[];
 
@@ -87,6 +119,39 @@ class GPointModel:public TelModel
 		 */
 		void getErrAltAz (struct ln_hrz_posn *hrz, struct ln_equ_posn *equ, struct ln_hrz_posn *err);
 
+		/**
+		 * Batch version of apply. Coordinates are in degrees, and are
+		 * modified in place.
+		 */
+		void apply (size_t n, double *ra, double *dec);
+
+		/**
+		 * Batch version of reverse. HA and DEC are in degrees, and are
+		 * modified in place. Azimuth and altitude are needed only for
+		 * extra terms; pass NULL if the model does not use them.
+		 */
+		void reverse (size_t n, double *ha, double *dec, const double *az, const double *alt);
+
+		/**
+		 * Batch version of getErrAltAz. Computes errors (in degrees)
+		 * for arrays of positions. HA and DEC can be NULL if extra
+		 * terms do not use them. Unlike getErrAltAz, input positions
+		 * are not modified.
+		 */
+		void getErrAltAz (size_t n, const double *az, const double *alt, const double *ha, const double *dec, double *errAz, double *errAlt);
+
+		/**
+		 * Compile extra parameters into tables used by batch calls.
+		 * Called from load; must be called again if extra parameters
+		 * are changed directly.
+		 */
+		void compile ();
+
+		std::vector <CompiledTerm> &getCompiledAz () { return compiledAz; }
+		std::vector <CompiledTerm> &getCompiledEl () { return compiledEl; }
+		std::vector <CompiledTerm> &getCompiledHa () { return compiledHa; }
+		std::vector <CompiledTerm> &getCompiledDec () { return compiledDec; }
+
 		virtual std::istream & load (std::istream & is);
 		virtual std::ostream & print (std::ostream & os, char frmt = 'r');
 
@@ -99,8 +164,19 @@ class GPointModel:public TelModel
 		std::list <ExtraParam *> extraParamsDec;
 
 		bool altaz;
+
+	private:
+		std::vector <CompiledTerm> compiledAz;
+		std::vector <CompiledTerm> compiledEl;
+		std::vector <CompiledTerm> compiledHa;
+		std::vector <CompiledTerm> compiledDec;
 };
 
+/**
+ * Fill term arguments, indexed by terms_t. Inputs are in radians.
+ */
+void fillTermArgs (double *args, double az, double el, double ha, double dec);
+
 std::istream & operator >> (std::istream & is, GPointModel * model);
 std::ostream & operator << (std::ostream & os, GPointModel * model);
 
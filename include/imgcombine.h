@@ -0,0 +1,77 @@
+/*
+ * Pixel by pixel combination of image frames.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_IMGCOMBINE__
+#define __RTS2_IMGCOMBINE__
+
+#include <stddef.h>
+
+namespace rts2core
+{
+
+/**
+ * Median of frames. Median of even number of values is average of the
+ * two central values. Four pixels are processed at once with SSE2
+ * instructions, if those are available at compile time - their values
+ * are partially sorted by min/max exchanges, up to the central value.
+ *
+ * @param frames   array of nframes pointers to frame data
+ * @param nframes  number of frames
+ * @param npix     number of pixels in each frame
+ * @param out      output, npix pixels
+ */
+void combineMedian (const float * const *frames, int nframes, size_t npix, float *out);
+
+/**
+ * Sigma clipped mean of frames. Starts with median of pixel values,
+ * values further than sigma * standard deviation from the current
+ * centre are rejected and centre is replaced by mean of the remaining
+ * values. Rejection is repeated given number of times.
+ *
+ * @param frames      array of nframes pointers to frame data
+ * @param nframes     number of frames
+ * @param npix        number of pixels in each frame
+ * @param sigma       rejection limit, in standard deviations
+ * @param iterations  number of rejection iterations
+ * @param out         output, npix pixels
+ */
+void combineSigmaClip (const float * const *frames, int nframes, size_t npix, float sigma, int iterations, float *out);
+
+/**
+ * Calibrate raw pixels - subtract offset (bias) frame and scaled dark
+ * current frame and multiply by gain (inverse normalised flat) frame. 16 bit and float
+ * pixels are converted and calibrated four at once with SSE2
+ * instructions, if those are available at compile time.
+ *
+ * @param dataType  type of raw pixels, one of the RTS2_DATA_XXXX constants
+ * @param raw       raw pixels
+ * @param npix      number of pixels
+ * @param offset    offset subtracted from raw pixels, NULL if none
+ * @param dark      dark current subtracted from raw pixels, NULL if none
+ * @param darkScale multiplicator of dark current
+ * @param gain      multiplicator of offset subtracted pixels, NULL if none
+ * @param out       output, npix pixels
+ *
+ * @return -1 if raw data type is not supported, 0 on success
+ */
+int calibratePixels (int dataType, const void *raw, size_t npix, const float *offset, const float *dark, float darkScale, const float *gain, float *out);
+
+}
+
+#endif // !__RTS2_IMGCOMBINE__
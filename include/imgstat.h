@@ -0,0 +1,137 @@
+/*
+ * Single pass image statistics.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_IMGSTAT__
+#define __RTS2_IMGSTAT__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Number of histogram bins. Values of 8 and 16 bit types are binned
+ * exactly, values of other types are binned only if they fall into
+ * 0..IMGSTAT_HISTOGRAM_SIZE-1 range.
+ */
+#define IMGSTAT_HISTOGRAM_SIZE    65536
+
+namespace rts2core
+{
+
+/**
+ * Offset of value in histogram. Signed types are shifted, so their
+ * minimal value is in the first bin.
+ */
+template <typename t> struct ImageStatisticsOffset { static const long offset = 0; };
+template <> struct ImageStatisticsOffset <int8_t> { static const long offset = 128; };
+template <> struct ImageStatisticsOffset <int16_t> { static const long offset = 32768; };
+
+/**
+ * Statistics of image pixel values - sum, sum of squares, minimum,
+ * maximum and mode. Statistics are updated incrementally with chunks of
+ * data as they are read out from the camera. 16 bit data are processed
+ * with SSE2/AVX2 instructions, if those are available at compile time.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class ImageStatistics
+{
+	public:
+		/**
+		 * @param _computeMode  if true, histogram for mode calculation is filled
+		 */
+		ImageStatistics (bool _computeMode = true);
+		~ImageStatistics ();
+
+		/**
+		 * Clear statistics, prepare for new image. Histogram is
+		 * allocated on first reset which computes mode.
+		 *
+		 * @param _computeMode  if true, histogram for mode calculation is filled
+		 */
+		void reset (bool _computeMode = true);
+
+		/**
+		 * Update statistics with new pixels.
+		 *
+		 * @param data  pixel data
+		 * @param npix  number of pixels
+		 */
+		template <typename t> void update (const t *data, size_t npix)
+		{
+			long double tSum = 0;
+			long double tSumSquares = 0;
+			double tMin = min;
+			double tMax = max;
+			const long off = ImageStatisticsOffset <t>::offset;
+			for (const t *tData = data; tData < data + npix; tData++)
+			{
+				t tD = *tData;
+				tSum += tD;
+				tSumSquares += (long double) tD * tD;
+				if (tD < tMin)
+					tMin = tD;
+				if (tD > tMax)
+					tMax = tD;
+				if (histogram)
+				{
+					long idx = (long) tD + off;
+					if (idx >= 0 && idx < IMGSTAT_HISTOGRAM_SIZE)
+						histogram[idx]++;
+				}
+			}
+			addChunk (tSum, tSumSquares, tMin, tMax, npix, off);
+		}
+
+		long double getSum () { return sum; }
+		long double getSumSquares () { return sumSquares; }
+		double getMin () { return min; }
+		double getMax () { return max; }
+		size_t getPixels () { return pixels; }
+
+		double getAverage ();
+		double getStDev ();
+
+		/**
+		 * Returns most often pixel value, NAN if mode is not computed.
+		 */
+		double getMode ();
+
+	private:
+		long double sum;
+		long double sumSquares;
+		double min;
+		double max;
+		size_t pixels;
+
+		// histogram for mode calculation, NULL if mode is not computed
+		uint32_t *histogram;
+		uint32_t *histogramBuffer;
+		long histogramOffset;
+
+		void addChunk (long double _sum, long double _sumSquares, double _min, double _max, size_t _npix, long _offset);
+
+		void update16 (const uint16_t *data, size_t npix, bool is_signed);
+};
+
+template <> void ImageStatistics::update (const uint16_t *data, size_t npix);
+template <> void ImageStatistics::update (const int16_t *data, size_t npix);
+
+}
+
+#endif // !__RTS2_IMGSTAT__
@@ -197,6 +197,11 @@ class IniParser: public std::vector < IniSection * >
 		virtual ~ IniParser (void);
 		int loadFile (const char *filename = NULL, bool parseFullLine = false);
 
+		/**
+		 * Return name of the last loaded file.
+		 */
+		const char *getFilename () { return loadedFile.c_str (); }
+
 		/**
 		 * Return full section from the configuration file.
 		 *
@@ -319,6 +324,8 @@ class IniParser: public std::vector < IniSection * >
 		bool verboseEntry;
 		bool addDefaultSection;
 
+		std::string loadedFile;
+
 		void setVerboseEntry () { verboseEntry = true; }
 
 		void clearVerboseEntry () { verboseEntry = false; }
@@ -0,0 +1,183 @@
+/*
+ * Catalogue of satellites for screening of images.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_SATCATALOGUE__
+#define __RTS2_SATCATALOGUE__
+
+#include "pluto/satprop.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+// maximal exposure length of a query (seconds)
+#define SAT_MAX_DURATION     14400
+// minimal time step of the position index (seconds)
+#define SAT_MIN_BUCKET_STEP  1
+
+namespace rts2core
+{
+class WorkerPool;
+}
+
+namespace rts2sat
+{
+
+/**
+ * Satellite found close to the searched position.
+ */
+struct SatMatch
+{
+	// index of the satellite in catalogue
+	size_t index;
+	int norad;
+	// JD of the closest approach to the search centre
+	double JD;
+	// J2000 position at the closest approach (degrees)
+	double ra;
+	double dec;
+	// distance from the search centre (degrees)
+	double separation;
+	// distance from observer (km)
+	double range;
+	// apparent motion (degrees/second) and its position angle (degrees)
+	double motion;
+	double pa;
+};
+
+/**
+ * Catalogue of satellites. TLEs are loaded and propagators initialized
+ * once. Queries for satellites close to a position use index of
+ * geocentric positions of all satellites, calculated for buckets of
+ * time. Satellites which cannot move close enough to the search position
+ * from their bucket position are rejected, the rest is propagated in
+ * parallel to find their closest approach.
+ *
+ * Buckets are calculated on the first query needing them, and the least
+ * recently used ones are dropped when their number exceeds the limit. As
+ * propagators keep their state, queries must not be run in parallel.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class SatCatalogue
+{
+	public:
+		/**
+		 * @param nthreads  number of threads used for queries, including the calling thread
+		 */
+		SatCatalogue (int nthreads = 1);
+		~SatCatalogue ();
+
+		/**
+		 * Load TLEs from file. TLEs can be preceded by a line with satellite
+		 * name. Previously loaded satellites are discarded.
+		 *
+		 * @return number of loaded satellites, -1 if file cannot be read
+		 */
+		int load (const char *filename);
+
+		/**
+		 * Add single TLE to catalogue.
+		 *
+		 * @return 0 on success, -1 if TLE cannot be parsed
+		 */
+		int add (const char *name, const char *tle1, const char *tle2);
+
+		size_t size () { return sats.size (); }
+
+		int getNorad (size_t i) { return sats[i].getTLE ()->norad_number; }
+		const char *getIntlDesig (size_t i) { return sats[i].getTLE ()->intl_desig; }
+		const std::string &getName (size_t i) { return names[i]; }
+
+		/**
+		 * Returns number of TLEs which cannot be parsed during the last load.
+		 */
+		int getRejected () { return rejected; }
+
+		/**
+		 * Set time step of position index. Steps shorter than
+		 * SAT_MIN_BUCKET_STEP are increased to it.
+		 *
+		 * @param step  step in seconds
+		 */
+		void setBucketStep (double step);
+		double getBucketStep () { return bucketStep * 86400.0; }
+
+		/**
+		 * Set maximal number of buckets kept in memory.
+		 */
+		void setMaxBuckets (size_t _maxBuckets) { maxBuckets = _maxBuckets; }
+
+		int getThreads ();
+
+		/**
+		 * Find satellites which are within radius of the given position
+		 * during exposure.
+		 *
+		 * @param JD        exposure start
+		 * @param duration  exposure length in seconds, 0 for an instant, at most SAT_MAX_DURATION
+		 * @param lng       observer longitude (degrees, east positive)
+		 * @param lat       observer latitude (degrees)
+		 * @param altitude  observer altitude (meters)
+		 * @param ra        J2000 RA of the search centre (degrees)
+		 * @param dec       J2000 DEC of the search centre (degrees)
+		 * @param radius    search radius (degrees)
+		 * @param matches   found satellites, sorted by separation
+		 *
+		 * @return number of satellites propagated in the refinement step
+		 */
+		size_t query (double JD, double duration, double lng, double lat, double altitude, double ra, double dec, double radius, std::vector <SatMatch> &matches);
+
+	private:
+		std::vector <SatPropagator> sats;
+		std::vector <std::string> names;
+		// maximal speed (km/s), at perigee
+		std::vector <double> maxSpeed;
+
+		int rejected;
+
+		rts2core::WorkerPool *pool;
+
+		struct Bucket
+		{
+			double JD;
+			// geocentric positions (km), NAN if satellite cannot be propagated
+			std::vector <float> pos;
+			unsigned long lastUsed;
+		};
+
+		// buckets indexed by bucket number ((JD - J2000) / bucketStep)
+		std::map <long, Bucket *> buckets;
+		// in days
+		double bucketStep;
+		size_t maxBuckets;
+		unsigned long useCounter;
+
+		void clearBuckets ();
+		Bucket *getBucket (long b);
+
+		// task functions for worker pool
+		static void fillBucket (void *arg, size_t i);
+		static void screenBucket (void *arg, size_t i);
+		static void refine (void *arg, size_t i);
+};
+
+}
+
+#endif // !__RTS2_SATCATALOGUE__
@@ -0,0 +1,180 @@
+/*
+ * Satellite propagator with cached model state.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_SATPROP__
+#define __RTS2_SATPROP__
+
+#include <stddef.h>
+
+#include "pluto/norad.h"
+
+namespace rts2sat
+{
+
+/**
+ * SGP4/SDP4 propagator of a single TLE. Model parameters are initialized
+ * once, when TLE is set, and observer parallax constants once, when
+ * observer is set. Positions are topocentric, of date.
+ *
+ * Deep space integrator keeps its state inside model parameters, so a
+ * propagator instance must not be used from multiple threads at once.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class SatPropagator
+{
+	public:
+		SatPropagator ();
+
+		/**
+		 * Parse TLE lines and initialize propagator.
+		 *
+		 * @return 0 on success, -1 if TLE cannot be parsed, 1 - 3 if TLE
+		 * has checksum error in first, second or both lines (propagator is
+		 * initialized in that case)
+		 */
+		int setTLE (const char *tle1, const char *tle2);
+
+		const tle_t *getTLE () const { return &tle; }
+
+		/**
+		 * Returns true if the TLE was successfully parsed.
+		 */
+		bool isValid () const { return ephem >= 0; }
+
+		/**
+		 * Returns true for deep space (SDP4) objects.
+		 */
+		bool isDeep () const { return ephem == 3; }
+
+		/**
+		 * Returns orbital period in minutes.
+		 */
+		double getPeriod () const;
+
+		/**
+		 * Set observer location.
+		 *
+		 * @param lng       longitude in degrees, east positive
+		 * @param lat       latitude in degrees
+		 * @param altitude  altitude above sea level in meters
+		 */
+		void setObserver (double lng, double lat, double altitude);
+
+		/**
+		 * Calculate geocentric satellite position.
+		 *
+		 * @param JD       Julian date
+		 * @param sat_pos  returned position (km, equatorial of date)
+		 *
+		 * @return 0 on success, propagator error code (< 0) on error.
+		 * Warnings about perigee inside Earth are not reported.
+		 */
+		int propagate (double JD, double *sat_pos);
+
+		/**
+		 * Calculate topocentric position.
+		 *
+		 * @param JD    Julian date
+		 * @param ra    returned RA in degrees
+		 * @param dec   returned DEC in degrees
+		 * @param dist  returned distance in km, can be NULL
+		 * @param alt   returned altitude above horizon in degrees, can be NULL
+		 *
+		 * @return 0 on success, propagator error code (< 0) on error
+		 */
+		int getPosition (double JD, double *ra, double *dec, double *dist = NULL, double *alt = NULL);
+
+		/**
+		 * Calculate topocentric positions for an array of times. Positions
+		 * which cannot be calculated are set to NAN.
+		 *
+		 * @param JD    array of Julian dates
+		 * @param n     number of dates
+		 * @param ra    returned RAs in degrees
+		 * @param dec   returned DECs in degrees
+		 * @param dist  returned distances in km, can be NULL
+		 * @param alt   returned altitudes in degrees, can be NULL
+		 *
+		 * @return number of positions which cannot be calculated
+		 */
+		size_t getPositions (const double *JD, size_t n, double *ra, double *dec, double *dist = NULL, double *alt = NULL);
+
+		/**
+		 * Returns altitude above horizon in degrees, NAN if it cannot
+		 * be calculated.
+		 */
+		double getAltitude (double JD);
+
+		/**
+		 * Calculate altitudes for an array of times.
+		 */
+		void getAltitudes (const double *JD, size_t n, double *alt);
+
+		/**
+		 * Find next rise, culmination and set. Altitudes are sampled with
+		 * step derived from the orbital period, crossings of horizon are
+		 * refined with regula falsi and culmination with golden section
+		 * search, all to about a second. Passes shorter than the sampling
+		 * step (~1/90 of the period) might be missed.
+		 *
+		 * All events belong to the same pass. If the object is above
+		 * horizon at JD, rise is set to JD and transit is culmination of
+		 * the current pass, which can be before JD.
+		 *
+		 * @param JD       Julian date to start search from
+		 * @param horizon  horizon altitude in degrees
+		 * @param rise     rise of the pass
+		 * @param transit  culmination of the pass
+		 * @param set      set of the pass
+		 * @param length   maximal search length in days
+		 *
+		 * @return 0 if the pass was found, 1 if object is above horizon
+		 * during the whole search window, -1 if it does not rise or set in
+		 * the search window or cannot be propagated. Rise, transit and set
+		 * are NAN if the pass was not found.
+		 */
+		int getRST (double JD, double horizon, double &rise, double &transit, double &set, double length = 3);
+
+	private:
+		tle_t tle;
+		// 1 - SGP4, 3 - SDP4, -1 not initialized
+		int ephem;
+		double sat_params[N_SAT_PARAMS];
+
+		// observer longitude in radians, parallax constants and geodetic
+		// zenith components
+		double obs_lng;
+		double rho_cos_phi;
+		double rho_sin_phi;
+		double sin_lat;
+		double cos_lat;
+
+		// propagate and calculate topocentric vector, its length and altitude
+		int topocentric (double JD, double *vect, double *dist, double *alt);
+
+		double findCrossing (double t1, double a1, double t2, double a2, double horizon);
+		double findCulmination (double t1, double t2);
+		// culmination of pass in progress at JD, if object descends at JD
+		double findPastCulmination (double JD, double step);
+};
+
+}
+
+#endif // !__RTS2_SATPROP__
@@ -48,11 +48,12 @@ class DeviceDb:public rts2core::Device
 		/**
 		 * Create database connection.
 		 *
-		 * @param conn_name   connection name
+		 * @param conn_name     connection name
+		 * @param loadCameras   if camera list should be loaded; false for connections opened from threads
 		 *
 		 * @return -1 on error, 0 on sucess. 
 		 */
-		int initDB (const char *conn_name);
+		int initDB (const char *conn_name, bool loadCameras = true);
 
 	protected:
 		virtual int willConnect (rts2core::NetworkAddress * in_addr);
@@ -36,6 +36,7 @@ class MPECTarget:public EllTarget
 		virtual ~MPECTarget (void);
 
 		virtual void load ();
+		virtual void loadRow (const TargetRow &row) { load (); }
 };
 
 }
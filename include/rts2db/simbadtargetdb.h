@@ -41,6 +41,7 @@ class SimbadTargetDb: public ConstTarget, public rts2core::SimbadTarget
 		virtual ~SimbadTargetDb (void);
 
 		virtual void load ();
+		virtual void loadRow (const TargetRow &row) { load (); }
 
 		virtual void printExtra (Rts2InfoValStream & _os);
 };
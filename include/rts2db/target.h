@@ -34,6 +34,7 @@
 #include "device.h"
 #include "rts2target.h"
 #include "counted_ptr.h"
+#include "ephemeris.h"
 
 #include "targetset.h"
 #include "labels.h"
@@ -128,6 +129,55 @@ class CameraMissingExcetion:public rts2core::Error
 		}
 };
 
+/**
+ * Row of the targets table, with NULLs already replaced by default values.
+ * Used to construct targets from set queries, without separate database
+ * query for each target, and to hold cached target data.
+ *
+ * GRB targets row holds values from the grb table as well, if they were
+ * retrieved (has_grb is true).
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class TargetRow
+{
+	public:
+		TargetRow ();
+
+		/**
+		 * Load row of target with given ID.
+		 *
+		 * @throw SqlError when target cannot be found
+		 */
+		void load (int in_tar_id);
+
+		int tar_id;
+		char type_id;
+		std::string tar_name;
+		std::string tar_info;
+		float tar_priority;
+		float tar_bonus;
+		time_t tar_bonus_time;
+		time_t tar_next_observable;
+		bool tar_enabled;
+		int tar_telescope_mode;
+		double tar_ra;
+		double tar_dec;
+		double tar_pm_ra;
+		double tar_pm_dec;
+
+		bool has_grb;
+		double grb_date;
+		double grb_last_update;
+		int grb_type;
+		int grb_id;
+		bool grb_is_grb;
+		double grb_ra;
+		double grb_dec;
+		double grb_errorbox;
+		bool grb_autodisabled;
+};
+
 /**
  * Class for one observation target.
  *
@@ -179,9 +229,26 @@ class Target:public Rts2Target
 		 * @throw rts2core::Error and descendants on error
 		 */
 		virtual void load ();
+
+		/**
+		 * Load target from already retrieved targets table row. Targets
+		 * which need only targets table data override this method to
+		 * avoid database queries; default implementation calls load ().
+		 *
+		 * @param row   row of targets table, with ID of the target
+		 *
+		 * @throw rts2core::Error and descendants on error
+		 */
+		virtual void loadRow (const TargetRow &row) { load (); }
+
 		// load target data from give target id
 		void loadTarget (int in_tar_id);
 
+		/**
+		 * Set target data from targets table row.
+		 */
+		void loadTarget (const TargetRow &row);
+
 		virtual int save (bool overwrite);
 		virtual int saveWithID (bool overwrite, int tar_id);
 
@@ -280,6 +347,23 @@ class Target:public Rts2Target
 		 */
 		virtual void getAltAz (struct ln_hrz_posn *hrz, double JD, struct ln_lnlat_posn *obs);
 
+		/**
+		 * Use precomputed table for altitude, azimuth, hour angle,
+		 * airmass and lunar distance calculations during the night.
+		 * Table is computed from the current target position, and
+		 * must be recomputed if target position is changed. While the
+		 * table is used, those calculations return NAN for dates
+		 * outside of the night.
+		 *
+		 * @param night  night grid, NULL to stop using the table. It must not be deleted while target uses it.
+		 */
+		void setEphemeris (rts2core::NightEphemeris *night);
+
+		/**
+		 * Returns target ephemeris table, NULL if table is not used.
+		 */
+		rts2core::TargetEphemeris *getEphemeris () { return ephemeris; }
+
 		/**
 		 * Returns target minimal and maximal altitude during
 		 * given time period. This method may return negative values
@@ -887,6 +971,8 @@ class Target:public Rts2Target
 		double satisfiedFrom;
 		double satisfiedTo;
 		double satisfiedProbedUntil;
+		// precomputed ephemeris, NULL if not used
+		rts2core::TargetEphemeris *ephemeris;
 };
 
 /**
@@ -901,6 +987,7 @@ class ConstTarget:public Target
 		ConstTarget (int in_tar_id, struct ln_lnlat_posn *in_obs, double in_altitude);
 		ConstTarget (int in_tar_id, struct ln_lnlat_posn *in_obs, double in_altitude, struct ln_equ_posn *pos);
 		virtual void load ();
+		virtual void loadRow (const TargetRow &row);
 		virtual int saveWithID (bool overwrite, int tar_id);
 		virtual void getPosition (struct ln_equ_posn *pos, double JD);
 
@@ -944,6 +1031,7 @@ class DarkTarget:public Target
 	public:
 		DarkTarget (int in_tar_id, struct ln_lnlat_posn *in_obs, double in_altitude);
 		virtual ~ DarkTarget (void);
+		virtual void loadRow (const TargetRow &row) { loadTarget (row); }
 		virtual bool getScript (const char *deviceName, std::string & buf);
 		virtual void getPosition (struct ln_equ_posn *pos, double JD);
 		virtual int getRST (struct ln_rst_time *rst, double JD, double horizon) { return 1; }
@@ -957,6 +1045,7 @@ class FlatTarget:public ConstTarget
 		FlatTarget (int in_tar_id, struct ln_lnlat_posn *in_obs, double in_altitude);
 		virtual bool getScript (const char *deviceName, std::string & buf);
 		virtual void load ();
+		virtual void loadRow (const TargetRow &row);
 		virtual void getPosition (struct ln_equ_posn *pos, double JD);
 		virtual int considerForObserving (double JD);
 		virtual int isContinues () { return 1; }
@@ -1009,6 +1098,7 @@ class CalibrationTarget:public ConstTarget
 	public:
 		CalibrationTarget (int in_tar_id, struct ln_lnlat_posn *in_obs, double in_altitude);
 		virtual void load ();
+		virtual void loadRow (const TargetRow &row);
 		virtual int beforeMove ();
 		virtual int endObservation (int in_next_id);
 		virtual void getPosition (struct ln_equ_posn *pos, double JD);
@@ -1055,6 +1145,7 @@ class ModelTarget:public ConstTarget
 		ModelTarget (int in_tar_id, struct ln_lnlat_posn *in_obs, double in_altitude);
 		virtual ~ ModelTarget (void);
 		virtual void load ();
+		virtual void loadRow (const TargetRow &row) { load (); }
 		virtual int beforeMove ();
 		virtual moveType afterSlewProcessed ();
 		virtual int endObservation (int in_next_id);
@@ -1083,6 +1174,7 @@ class LunarTarget:public Target
 {
 	public:
 		LunarTarget (int in_tar_id, struct ln_lnlat_posn * in_obs, double in_altitude);
+		virtual void loadRow (const TargetRow &row) { loadTarget (row); }
 		virtual void getPosition (struct ln_equ_posn *pos, double JD);
 		virtual int getRST (struct ln_rst_time *rst, double jd, double horizon);
 };
@@ -1226,6 +1318,20 @@ Rts2InfoValStream & operator << (Rts2InfoValStream & _os, rts2db::Target & targe
  */
 rts2db::Target *createTarget (int tar_id, struct ln_lnlat_posn *obs, double altitude);
 
+/**
+ * Create target from already retrieved targets table row. Does not query
+ * database, unless target type needs data from other tables.
+ *
+ * @param row         targets table row
+ * @param obs         observer position
+ * @param altitude    observator altitude
+ *
+ * @return New target.
+ *
+ * @throw rts2core::Error when target cannot be loaded
+ */
+rts2db::Target *createTarget (const rts2db::TargetRow &row, struct ln_lnlat_posn *obs, double altitude);
+
 /**
  * Create target by name.
  *
@@ -0,0 +1,109 @@
+/*
+ * Process-wide cache of target rows.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_TARGETCACHE__
+#define __RTS2_TARGETCACHE__
+
+#include "connnosend.h"
+#include "rts2db/target.h"
+
+namespace rts2db
+{
+
+/**
+ * Cache of targets table rows. Used by createTarget and TargetSet to
+ * construct targets without querying the database. Cache is disabled
+ * by default, it is enabled once ConnTargetNotify starts to listen for
+ * targets table changes, so entries are removed as soon as targets are
+ * modified by other processes.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class TargetCache
+{
+	public:
+		static void setEnabled (bool _enabled);
+		static bool isEnabled ();
+
+		/**
+		 * Retrieve cached row.
+		 *
+		 * @param tar_id   target ID
+		 * @param row      returned row
+		 *
+		 * @return true if row was found in the cache
+		 */
+		static bool get (int tar_id, TargetRow &row);
+
+		/**
+		 * Put row to the cache. Does nothing if cache is not enabled.
+		 */
+		static void put (const TargetRow &row);
+
+		/**
+		 * Remove row of the target from the cache.
+		 */
+		static void invalidate (int tar_id);
+
+		/**
+		 * Remove all entries.
+		 */
+		static void clear ();
+
+		static long getHits ();
+		static long getMisses ();
+};
+
+/**
+ * Listen for targets table notifications, send by the trigger created
+ * in rel_1_0_1.sql, on the default database connection. Invalidate
+ * TargetCache entries of the notified targets.
+ *
+ * Connection shares socket with the database connection, so it must be
+ * created after the database connection is opened.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class ConnTargetNotify:public rts2core::ConnNoSend
+{
+	public:
+		ConnTargetNotify (rts2core::Block *_master);
+		virtual ~ConnTargetNotify ();
+
+		/**
+		 * Start listening for notifications and enable TargetCache.
+		 *
+		 * @return -1 on error, 0 on success. Cache is not enabled on error.
+		 */
+		virtual int init ();
+
+		virtual int idle ();
+
+		virtual int receive (rts2core::Block *block);
+
+	private:
+		// PGconn of the database connection
+		void *pgconn;
+
+		void processNotifies ();
+};
+
+}
+
+#endif // !__RTS2_TARGETCACHE__
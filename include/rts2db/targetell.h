@@ -37,6 +37,7 @@ class EllTarget:public Target
 		EllTarget (std::string _tar_info):Target () { setTargetInfo (_tar_info); }
 		EllTarget ():Target () { }
 		virtual void load ();
+		virtual void loadRow (const TargetRow &row);
 
 		/**
 		 * Get orbit structure from target info.
@@ -66,6 +67,9 @@ class EllTarget:public Target
 
 		std::string designation;
 		void getPosition (struct ln_equ_posn *pos, double JD, struct ln_equ_posn *parallax);
+
+		// parse orbit from target info
+		void parseOrbit ();
 };
 
 }
@@ -32,6 +32,14 @@ class TargetGRB:public ConstTarget
 	public:
 		TargetGRB (int in_tar_id, struct ln_lnlat_posn *in_obs, double _altitude, int in_maxBonusTimeout, int in_dayBonusTimeout, int in_fiveBonusTimeout);
 		virtual void load ();
+		virtual void loadRow (const TargetRow &row);
+
+		/**
+		 * Fill GRB part of the target row from grb table.
+		 *
+		 * @throw SqlError when GRB data cannot be loaded
+		 */
+		static void loadGrbRow (TargetRow &row);
 		virtual void getPosition (struct ln_equ_posn *pos, double JD);
 		virtual int compareWithTarget (Target * in_target, double grb_sep_limit);
 		virtual bool getScript (const char *deviceName, std::string & buf);
@@ -96,6 +104,8 @@ class TargetGRB:public ConstTarget
 		bool autodisabled;
 
 		const char *getSatelite ();
+
+		void setGrb (const TargetRow &row);
 };
 
 }
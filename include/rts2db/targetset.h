@@ -34,6 +34,7 @@ namespace rts2db
 
 class Target;
 class TargetGRB;
+class TargetRow;
 
 class Constraints;
 
@@ -114,16 +115,17 @@ class TargetSet:public std::map <int, Target * >
 		virtual ~TargetSet (void);
 
 		/**
-		 * Load target set from database.
+		 * Load target set from database. All targets table rows are
+		 * retrieved with a single query, targets are created from them.
 		 *
 		 * @throw SqlError if target set cannot be loaded.
 		 */
 		virtual void load ();
 
 		/**
-		 * Create set from given target ids.
-		 *
-		 * @throw SqlError when some target cannot be created.
+		 * Create set from given target ids. Rows which are not in
+		 * TargetCache are retrieved in batches. Targets which cannot
+		 * be created are not added to the set.
 		 */
 		void load (std::list < int >&target_ids);
 
@@ -227,6 +229,23 @@ class TargetSet:public std::map <int, Target * >
 		// values for load operation
 		std::string where;
 		std::string order_by;
+
+	private:
+		/**
+		 * Retrieve targets table rows matching given condition. Fills
+		 * GRB data of GRB targets.
+		 */
+		void loadRows (const std::string &_where, const std::string &_order_by, std::vector <TargetRow> &rows);
+
+		/**
+		 * Fill GRB data of GRB rows, with a single query.
+		 */
+		void loadGrbRows (std::vector <TargetRow> &rows);
+
+		/**
+		 * Create targets from rows and add them to the set.
+		 */
+		void addRows (std::vector <TargetRow> &rows);
 };
 
 class TargetSetSelectable:public TargetSet
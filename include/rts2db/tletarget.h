@@ -22,7 +22,9 @@
 
 #include "target.h"
 
-#include "pluto/norad.h"
+#include "pluto/satprop.h"
+
+#include <math.h>
 
 namespace rts2db
 {
@@ -36,9 +38,10 @@ class TLETarget:public Target
 {
 	public:
 		TLETarget (int in_tar_id, struct ln_lnlat_posn *in_obs, double in_altitude);
-		TLETarget (std::string _tar_info):Target () { setTargetInfo (_tar_info); }
-		TLETarget ():Target () { }
+		TLETarget (std::string _tar_info):Target () { setTargetInfo (_tar_info); prop_lng = prop_lat = prop_alt = NAN; }
+		TLETarget ():Target () { prop_lng = prop_lat = prop_alt = NAN; }
 		virtual void load ();
+		virtual void loadRow (const TargetRow &row);
 
 		/**
 		 * Get orbit from TLE, separated with |
@@ -48,6 +51,25 @@ class TLETarget:public Target
 		void orbitFromTLE (std::string tle);
 
 		virtual void getPosition (struct ln_equ_posn *pos, double JD);
+
+		/**
+		 * Calculate positions for array of times. Propagator is
+		 * initialized only once, so this is much faster than repeated
+		 * calls to getPosition.
+		 *
+		 * @param JD     array of Julian dates
+		 * @param n      number of dates
+		 * @param pos    returned positions, NAN if position cannot be calculated
+		 * @param alt    if not NULL, returned altitudes
+		 *
+		 * @return number of positions which cannot be calculated
+		 */
+		size_t getPositions (const double *JD, size_t n, struct ln_equ_posn *pos, double *alt = NULL);
+
+		/**
+		 * Search for next pass. Rise and set are moments when satellite
+		 * crosses horizon, transit is its culmination.
+		 */
 		virtual int getRST (struct ln_rst_time *rst, double jd, double horizon);
 
 		virtual moveType startSlew (struct ln_equ_posn *position, std::string &p1, std::string &p2, bool update_position, int plan_id = -1);
@@ -63,12 +85,14 @@ class TLETarget:public Target
 		std::string tle1;
 		std::string tle2;
 
-		tle_t tle;
+		rts2sat::SatPropagator propagator;
 
-		int ephem;
-		int is_deep;
+		// observer for which propagator was set
+		double prop_lng;
+		double prop_lat;
+		double prop_alt;
 
-		void getPosition (struct ln_equ_posn *pos, double JD, struct ln_equ_posn *parallax);
+		void checkObserver ();
 };
 
 }
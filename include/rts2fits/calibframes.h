@@ -0,0 +1,231 @@
+/*
+ * Library of master calibration frames.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_CALIBFRAMES__
+#define __RTS2_CALIBFRAMES__
+
+#include <map>
+#include <string>
+#include <vector>
+#include <time.h>
+
+namespace rts2image
+{
+
+typedef enum { CALIBRATION_BIAS, CALIBRATION_DARK, CALIBRATION_FLAT } calibrationType_t;
+
+/**
+ * Master calibration frame found in the calibration directory. Headers
+ * are read when the file is found, data are read when the frame is
+ * first used.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class MasterFrame
+{
+	public:
+		MasterFrame (const char *_filename, time_t _mtime);
+		~MasterFrame ();
+
+		/**
+		 * Read master headers and sizes of its channels.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int readHeaders ();
+
+		/**
+		 * Read master data, if they were not yet read.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int load ();
+
+		size_t getChannelSize () { return widths.size (); }
+		long getWidth (size_t chan) { return widths[chan]; }
+		long getHeight (size_t chan) { return heights[chan]; }
+
+		/**
+		 * Return channel data. Valid only after successful load.
+		 */
+		const float *getData (size_t chan) { return data[chan]; }
+
+		std::string filename;
+		time_t mtime;
+
+		calibrationType_t type;
+		std::string camera;
+		std::string filter;
+		int binx;
+		int biny;
+		double exposure;
+		double temperature;
+		// master dark with bias subtracted
+		bool darkSubtracted;
+
+	private:
+		std::vector <int> hdus;
+		std::vector <long> widths;
+		std::vector <long> heights;
+		std::vector <float *> data;
+};
+
+/**
+ * Set of master frames selected for an exposure, prepared for
+ * calibration of raw data. Offset frame holds bias, or dark including
+ * bias if dark is used without bias. If bias is available, dark is kept
+ * as separate dark current frame (with bias subtracted), which is scaled
+ * to exposure time during calibration, so the same set can be used for
+ * exposures of any length. Flat is converted to gain frame, holding mean
+ * of the flat divided by the flat value.
+ *
+ * Sets are created and reference counted by CalibrationFrames.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class CalibrationSet
+{
+	public:
+		CalibrationSet ();
+		~CalibrationSet ();
+
+		size_t getChannelSize () { return widths.size (); }
+		long getWidth (size_t chan) { return widths[chan]; }
+		long getHeight (size_t chan) { return heights[chan]; }
+
+		/**
+		 * Offset subtracted from raw data, NULL if neither bias nor dark is applied.
+		 */
+		const float *getOffset (size_t chan) { return offsets[chan]; }
+
+		/**
+		 * Dark current subtracted from raw data after being scaled by
+		 * getDarkScale, NULL if dark is not scaled.
+		 */
+		const float *getDark (size_t chan) { return darks[chan]; }
+
+		/**
+		 * Return scale of dark current for exposure of given length.
+		 */
+		double getDarkScale (double exposure) { return (darkExposure > 0) ? exposure / darkExposure : 1; }
+
+		/**
+		 * Multiplicator of offset subtracted data, NULL if flat is not applied.
+		 */
+		const float *getGain (size_t chan) { return gains[chan]; }
+
+		std::string bias;
+		std::string dark;
+		std::string flat;
+
+	private:
+		friend class CalibrationFrames;
+
+		std::string key;
+		int refs;
+		std::vector <long> widths;
+		std::vector <long> heights;
+		std::vector <float *> offsets;
+		std::vector <float *> darks;
+		std::vector <float *> gains;
+		// exposure of the scaled dark, NAN if dark is not scaled
+		double darkExposure;
+};
+
+/**
+ * Master calibration frames of a camera. Masters are FITS files in a
+ * directory, as created by rts2-mastercal. Their type is taken from
+ * IMAGETYP keyword, or derived from the combination keywords - flats
+ * are normalised, biases have zero exposure. Masters are matched to
+ * exposure by CCD_NAME, BINX, BINY, CCD_TEMP, EXPOSURE and FILTER
+ * (flats only) keywords.
+ *
+ * Directory is checked for new and changed files each time a set is
+ * requested, so masters are reloaded as soon as they land on disk.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class CalibrationFrames
+{
+	public:
+		/**
+		 * @param _directory    directory holding master frames
+		 * @param _tolerance    maximal difference (in deg C) of master and exposure CCD temperature
+		 */
+		CalibrationFrames (const char *_directory, double _tolerance);
+		~CalibrationFrames ();
+
+		/**
+		 * Return calibration set for an exposure. Set must be returned
+		 * with release call once it is not needed.
+		 *
+		 * @param camera       camera name
+		 * @param binx         binning along X axis, -1 if not known
+		 * @param biny         binning along Y axis, -1 if not known
+		 * @param filter       filter name, NULL if not known
+		 * @param exposure     exposure time (in seconds)
+		 * @param temperature  CCD temperature, NAN if not known
+		 *
+		 * @return NULL if no master is available for the exposure
+		 */
+		CalibrationSet *acquire (const char *camera, int binx, int biny, const char *filter, double exposure, double temperature);
+
+		void release (CalibrationSet *set);
+
+		/**
+		 * Select masters for an exposure. Bias and dark are matched by
+		 * temperature, dark by exposure; dark is used without bias only
+		 * if its exposure matches. Flat is matched by filter.
+		 *
+		 * @param bias  selected bias, NULL if none matches
+		 * @param dark  selected dark, NULL if none matches
+		 * @param flat  selected flat, NULL if none matches
+		 */
+		void selectMasters (const char *camera, int binx, int biny, const char *filter, double exposure, double temperature, MasterFrame *&bias, MasterFrame *&dark, MasterFrame *&flat);
+
+		/**
+		 * Add master frame. Masters are added by directory scan, and
+		 * are deleted on the next scan if their file does not exist.
+		 */
+		void addMaster (MasterFrame *m);
+
+	private:
+		std::string directory;
+		double tolerance;
+
+		std::map <std::string, MasterFrame *> masters;
+		// files which cannot be read, with their modification times
+		std::map <std::string, time_t> failed;
+
+		// last used set
+		CalibrationSet *last;
+
+		/**
+		 * Check directory for new, changed and removed masters.
+		 */
+		void rescan ();
+
+		bool matches (MasterFrame *m, const char *camera, int binx, int biny, double temperature);
+
+		CalibrationSet *createSet (MasterFrame *bias, MasterFrame *dark, MasterFrame *flat);
+};
+
+}
+
+#endif // !__RTS2_CALIBFRAMES__
@@ -89,7 +89,20 @@ class CameraImage
 
 		void writeMetaData (struct imghdr *im_h) { image->writeMetaData (im_h); }
 
-		void writeData (char *_data, char *_fullTop, int nchan) { image->writeData (_data, _fullTop, nchan); dataWriten = true; }
+		void writeData (char *_data, char *_fullTop, int nchan, bool raw = false) { image->writeData (_data, _fullTop, nchan, raw); dataWriten = true; }
+
+		void endStreamData (int schan) { image->endStreamData (schan); dataWriten = true; }
+
+		/**
+		 * Allocate buffer for data written to image. Buffers are freed
+		 * together with the image, as image channels can refer to them.
+		 */
+		char *allocateData (size_t size)
+		{
+			char *buf = new char[size];
+			dataBuffers.push_back (buf);
+			return buf;
+		}
 
 		bool canDelete ();
 
@@ -101,6 +114,7 @@ class CameraImage
 		std::vector < ImageDeviceWait * > deviceWaits;
 		std::vector < rts2core::DevClient * > triggerWaits;
 		std::vector < rts2core::DevClient * > prematurelyReceived;
+		std::vector < char * > dataBuffers;
 };
 
 /**
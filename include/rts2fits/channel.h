@@ -92,6 +92,13 @@ class Channel
 
 		const char *getData () { return (char *) data; }
 
+		/**
+		 * Set channel data. Channel takes ownership of the data.
+		 * Used to fill channels of streamed images, which are
+		 * created without data.
+		 */
+		void setData (char *_data);
+
 		void computeStatistics (size_t _from = 0, size_t _dataSize = 0);
 
 	private:
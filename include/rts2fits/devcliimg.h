@@ -26,6 +26,7 @@
 
 #include "image.h"
 #include "cameraimage.h"
+#include "calibframes.h"
 #include "valuerectangle.h"
 
 #include <libnova/libnova.h>
@@ -39,6 +40,28 @@ namespace rts2image
 
 typedef enum { IMAGE_DO_BASIC_PROCESSING, IMAGE_KEEP_COPY } imageProceRes;
 
+/**
+ * Channel data written to image as they arrive.
+ */
+struct StreamedData
+{
+	CameraImage *image;
+	// number of channels in data connection
+	int nchan;
+	// streamed channel index in image, -1 if header was not yet received
+	int schan;
+	// channel header
+	struct imghdr imgh;
+	// bytes of channel data (including header) already written to image
+	size_t written;
+	// calibration applied to channel data, NULL if data are written as received
+	CalibrationSet *calibration;
+	// streamed channel index of raw data, -1 if raw data are not written
+	int rawchan;
+	// calibrated data of the last chunk
+	std::vector <float> calibrated;
+};
+
 /**
  * Defines client descendants capable to stream themselves
  * to an Image.
@@ -52,6 +75,7 @@ class DevClientCameraImage:public rts2core::DevClientCamera
 		virtual void postEvent (rts2core::Event * event);
 
 		virtual void newDataConn (int data_conn);
+		virtual void dataReceived (rts2core::DataAbstractRead *data);
 		virtual void fullDataReceived (int data_conn, rts2core::DataChannels *data) { allImageDataReceived (data_conn, data, true); }
 		virtual void fitsData (const char *fn);
 		virtual Image *createImage (const struct timeval *expStart);
@@ -62,6 +86,26 @@ class DevClientCameraImage:public rts2core::DevClientCamera
  
 		void setSaveImage (int in_saveImage) { saveImage = in_saveImage; }
 
+		/**
+		 * Write image data to FITS file as they arrive, keeping in memory
+		 * only the last data chunk. Image data are not available for
+		 * processing once written, so streaming cannot be used with
+		 * images which keep their data.
+		 */
+		void setStreamImage (bool in_streamImage) { streamImage = in_streamImage; }
+
+		/**
+		 * Calibrate image data before they are written. Data are
+		 * calibrated with masters found in the given directory. Calibrated
+		 * data are written as float HDU, optionally followed by the raw
+		 * data HDU.
+		 *
+		 * @param directory    directory with master frames
+		 * @param tolerance    maximal difference (in deg C) of master and exposure CCD temperature
+		 * @param writeRaw     write raw data together with calibrated data
+		 */
+		void setCalibration (const char *directory, double tolerance, bool writeRaw);
+
 		void setWriteConnnection (bool write_conn, bool write_rts2)
 		{
 			writeConnection = write_conn;
@@ -146,6 +190,34 @@ class DevClientCameraImage:public rts2core::DevClientCamera
 
 		void writeFilter (Image *img);
 
+		/**
+		 * Find calibration set for channel data.
+		 *
+		 * @return NULL if channel data should not be calibrated
+		 */
+		CalibrationSet *getCalibration (Image *img, struct imghdr *imgh);
+
+		/**
+		 * Write calibration keywords to the current HDU.
+		 */
+		void writeCalibrationHeaders (Image *img, CalibrationSet *set);
+
+		/**
+		 * Start streaming of channel, and of its raw data if those
+		 * should be kept.
+		 */
+		int startStreamedChannel (StreamedData &sdata);
+
+		/**
+		 * Write calibrated channel data which were not streamed.
+		 */
+		void writeCalibratedData (CameraImage *ci, CalibrationSet *set, char *in_data, char *fullTop, int nchan);
+
+		/**
+		 * Release calibration of streamed data and remove them.
+		 */
+		void eraseStreamedData (rts2core::DataAbstractRead *data);
+
 		rts2core::DoubleArray * getDoubleArray (const char *name);
 		rts2core::ValueRectangle * getRectangle (const char *name);
 
@@ -156,6 +228,12 @@ class DevClientCameraImage:public rts2core::DevClientCamera
 		// current image
 		CameraImage *actualImage;
 
+		bool streamImage;
+		std::map <rts2core::DataAbstractRead *, StreamedData> streamedData;
+
+		CalibrationFrames *calibration;
+		bool calibrationRaw;
+
 		// number of exposure
 		int expNum;
 
@@ -27,6 +27,7 @@
 #include <fitsio.h>
 
 #include "imghdr.h"
+#include "imgstat.h"
 
 #include "rts2fits/fitsfile.h"
 #include "rts2fits/channel.h"
@@ -98,6 +99,21 @@ typedef enum
 { EXPOSURE_START, INFO_CALLED, EXPOSURE_END, TRIGGERED }
 imageWriteWhich_t;
 
+/**
+ * Channel written incrementally, as data arrives.
+ */
+struct StreamChannel
+{
+	// HDU holding channel data
+	int hdu;
+	// data type of the channel, channels can differ in data type
+	int16_t dataType;
+	// raw data HDU, not included in image channels
+	bool raw;
+	// statistics accumulated over written pixels
+	rts2core::ImageStatistics *statistics;
+};
+
 const void * getScaledData (int dataType, const void *data, size_t numpix, long smin, long smax, scaling_type scaling, int newType);
 
 /**
@@ -261,7 +277,47 @@ class Image:public FitsFile
 				setValue (name, value, comment);
 		}
 
-		int writeData (char *in_data, char *fullTop, int nchan);
+		/**
+		 * Write channel data.
+		 *
+		 * @param raw  raw data, written together with calibrated data of
+		 *   the same channel. Raw data HDU is written, but is not added
+		 *   to image channels, and does not change image data type and
+		 *   statistics.
+		 */
+		int writeData (char *in_data, char *fullTop, int nchan, bool raw = false);
+
+		/**
+		 * Start streaming of channel data. Creates HDU of full size
+		 * described by the header and writes image header. Channel data
+		 * are then written with writeStreamData as they arrive.
+		 *
+		 * @param im_h   image header
+		 * @param nchan  number of channels in image
+		 * @param raw    raw data, see writeData
+		 *
+		 * @return index of streamed channel, -1 on error
+		 */
+		int startStreamData (struct imghdr *im_h, int nchan, bool raw = false);
+
+		/**
+		 * Write part of the channel data.
+		 *
+		 * @param schan    streamed channel index, as returned by startStreamData
+		 * @param firstpix index of the first pixel in data, counted from 0
+		 * @param data     pixel data
+		 * @param npix     number of pixels
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int writeStreamData (int schan, long firstpix, char *data, long npix);
+
+		/**
+		 * Finish streamed channel - write channel statistics.
+		 *
+		 * @param schan    streamed channel index, as returned by startStreamData
+		 */
+		int endStreamData (int schan);
 
 		/**
 		 * Fill image header structure.
@@ -477,6 +533,15 @@ class Image:public FitsFile
 		 */
 		void loadChannels ();
 
+		/**
+		 * Make sure channels hold image data. Loads channels if
+		 * there are not any, and reads data of streamed channels back
+		 * from the file.
+		 *
+		 * @throw rts2core::Error
+		 */
+		void loadChannelData ();
+
 		const void *getChannelData (int chan);
 		const void *getChannelDataScaled (int chan, long smin, long smax, scaling_type scaling, int newType);
 
@@ -792,11 +857,33 @@ class Image:public FitsFile
 
 		void initData ();
 
+		std::vector <StreamChannel> streamChannels;
+
 		/**
 		 * Write data channel (image) header).
 		 */
 		int writeImgHeader (struct imghdr *im_h, int nchan);
 
+		/**
+		 * Parse image header, create channel and its HDU. Caller shall
+		 * write HDU header with writeImgHeader if HDU was created.
+		 *
+		 * @param im_h      image header
+		 * @param pixelData pixel data, NULL if data will be streamed
+		 * @param dataSize  size of pixel data in bytes
+		 * @param nchan     number of channels; if negative, HDU is not created
+		 * @param raw       if true, channel is not created and image data type is not changed
+		 */
+		int createChannelHDU (struct imghdr *im_h, char *pixelData, long dataSize, int nchan, bool raw = false);
+
+		/**
+		 * Write pixels to current HDU.
+		 *
+		 * @param pixelType  type of pixels, one of the RTS2_DATA_XXXX constants
+		 * @param firstpix   index of the first pixel, counted from 0
+		 */
+		int writePixels (int pixelType, long firstpix, char *pixelData, long npix);
+
 		void writeConnBaseValue (const std::string name, rts2core::Value *val, const std::string desc);
 
 		/**
@@ -0,0 +1,167 @@
+/*
+ * Master calibration frames builder.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_MASTERCAL__
+#define __RTS2_MASTERCAL__
+
+#include "image.h"
+#include "workerpool.h"
+
+#include <string>
+#include <vector>
+
+namespace rts2image
+{
+
+typedef enum { COMBINE_MEDIAN, COMBINE_SIGMA_CLIP } combineMethod_t;
+
+/**
+ * Builds master dark or flat frame from set of input frames.
+ *
+ * Input files are not loaded into memory. They are read in bands of
+ * full rows (tiles), all input files in parallel if cfitsio was built
+ * reentrant (serially otherwise), and the tiles are combined by the worker
+ * pool. Combined tiles are streamed to the output
+ * file with Image::writeStreamData. Memory used is thus limited to input
+ * and output buffers of the tiles processed at once.
+ *
+ * Optionally, master dark (or bias) is subtracted from input frames, and
+ * frames are normalised by mean value of their central region, as
+ * needed for flat fields.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class MasterCalibration
+{
+	public:
+		MasterCalibration ();
+		~MasterCalibration ();
+
+		void addInput (const char *filename) { inputs.push_back (filename); }
+
+		/**
+		 * Set master dark, which will be subtracted from the input frames.
+		 */
+		void setDark (const char *filename) { dark = filename; }
+
+		void setMethod (combineMethod_t _method, float _sigma = 3.0)
+		{
+			method = _method;
+			sigma = _sigma;
+		}
+
+		/**
+		 * Set number of sigma clipping iterations.
+		 */
+		void setIterations (int _iterations) { iterations = _iterations; }
+
+		/**
+		 * Normalise input frames by mean of their central region.
+		 */
+		void setNormalize (bool _normalize) { normalize = _normalize; }
+
+		/**
+		 * Set number of threads, including the calling thread.
+		 */
+		void setThreads (int _threads) { threads = _threads; }
+
+		/**
+		 * Set memory (in bytes) available for input buffers of one tile.
+		 * Number of rows in a tile is derived from it.
+		 */
+		void setTileMemory (size_t _tileMemory) { tileMemory = _tileMemory; }
+
+		/**
+		 * Build master frame.
+		 *
+		 * @param output     output file name
+		 * @param overwrite  overwrite existing output file
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int build (const char *output, bool overwrite = false);
+
+		/**
+		 * Find HDUs holding 2D images.
+		 *
+		 * @return -1 if the image does not contain any 2D image, 0 on success
+		 */
+		static int findChannels (FitsFile *image, std::vector <int> &hdus);
+
+	private:
+		std::vector <std::string> inputs;
+		std::string dark;
+
+		combineMethod_t method;
+		float sigma;
+		int iterations;
+		bool normalize;
+		int threads;
+		size_t tileMemory;
+
+		// opened inputs, dark is the last one
+		std::vector <Image *> images;
+		// HDU numbers of channels, for each image
+		std::vector <std::vector <int> > channelHDUs;
+		// mean values of central regions of images
+		std::vector <double> levels;
+		// multiplicators of input frames
+		std::vector <float> scales;
+		// cfitsio status of the last read, for each image
+		std::vector <int> readStatus;
+
+		rts2core::WorkerPool *pool;
+		// true if cfitsio can be called from worker threads
+		bool fitsParallel;
+
+		int channel;
+		long width;
+		long height;
+		long tileRows;
+		// rows in the currently processed batch of tiles
+		long batchFirstRow;
+		long batchRows;
+
+		// input buffers, for each image tileRows * threads rows
+		std::vector <float *> buffers;
+		float *outBuffer;
+
+		int openInputs ();
+		void closeInputs ();
+
+		int processChannel (Image *master, int nchan);
+
+		/**
+		 * Run task calling cfitsio for every image. Tasks run in the
+		 * worker pool only if cfitsio is reentrant.
+		 */
+		void fitsFor (void (*func) (void *arg, size_t i));
+
+		void computeLevel (size_t i);
+		void readInput (size_t i);
+		void combineTile (size_t t);
+
+		static void levelTask (void *arg, size_t i);
+		static void readTask (void *arg, size_t i);
+		static void combineTask (void *arg, size_t t);
+};
+
+}
+
+#endif // !__RTS2_MASTERCAL__
@@ -20,12 +20,23 @@
 #include "rts2-config.h"
 #include "httpreq.h"
 #include "httpserver.h"
+#include "previewcache.h"
 
 #define DEFAULT_QUANTILES    0.005
 #define DEFAULT_COLOURVARIANT    0
 // number of channels in image
 #define CHANNELS             4
 
+namespace rts2image
+{
+class Image;
+}
+
+namespace Magick
+{
+class Image;
+}
+
 namespace rts2json
 {
 
@@ -80,6 +91,73 @@ class Previewer
 
 #if defined(RTS2_HAVE_LIBJPEG) && RTS2_HAVE_LIBJPEG == 1
 
+/**
+ * Renders JPEG image of FITS file in steps. Steps accessing the FITS file
+ * (load and drawLabel, which expands label from FITS header) are not thread
+ * safe and must be called from a single thread. Steps working only with
+ * loaded image data (scale and compress) of different renderers can run in
+ * parallel.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class JpegRenderer
+{
+	public:
+		/**
+		 * @param kind      PREVIEW_FULL for full size image with label, PREVIEW_ZOOM for zoomed preview
+		 * @param prevsize  size of the longest preview axis, used for PREVIEW_ZOOM
+		 */
+		JpegRenderer (const char *_path, char _kind, int _prevsize, const char *_label, float _quantiles, int _chan, int _colourVariant);
+		~JpegRenderer ();
+
+		/**
+		 * Open FITS file and read image data.
+		 */
+		void load ();
+
+		/**
+		 * Scale image data to grayscale or pseudocolour image, zoom it
+		 * to the preview size.
+		 */
+		void scale ();
+
+		/**
+		 * Draw label to the image.
+		 */
+		void drawLabel ();
+
+		/**
+		 * Compress image to JPEG.
+		 *
+		 * @param response         newly allocated (with new[]) buffer with JPEG image
+		 * @param response_length  length of JPEG image
+		 */
+		void compress (char* &response, size_t &response_length);
+
+	private:
+		std::string path;
+		char kind;
+		int prevsize;
+		std::string label;
+		float quantiles;
+		int chan;
+		int colourVariant;
+
+		rts2image::Image *image;
+		Magick::Image *mimage;
+};
+
+/**
+ * Render JPEG image of FITS file.
+ *
+ * @param path             path to FITS file
+ * @param kind             PREVIEW_FULL for full size image with label, PREVIEW_ZOOM for zoomed preview
+ * @param prevsize         size of the longest preview axis, used for PREVIEW_ZOOM
+ * @param response         newly allocated (with new[]) buffer with JPEG image
+ * @param response_length  length of JPEG image
+ */
+void renderJpeg (const char *path, char kind, int prevsize, const char *label, float quantiles, int chan, int colourVariant, char* &response, size_t &response_length);
+
 /**
  * Returns JPEG image, generated from FITS file. Usefull for quick display of images in 
  * web browsers.
@@ -0,0 +1,220 @@
+/*
+ * Cache of rendered image previews.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_PREVIEWCACHE__
+#define __RTS2_PREVIEWCACHE__
+
+#include <deque>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <pthread.h>
+#include <stddef.h>
+
+// full size image, as returned by /jpeg request
+#define PREVIEW_FULL     'j'
+// zoomed preview, as returned by /preview request
+#define PREVIEW_ZOOM     'p'
+
+namespace rts2core
+{
+class WorkerPool;
+}
+
+namespace rts2json
+{
+
+/**
+ * Cache of rendered JPEG previews.
+ *
+ * Previews are identified by key, constructed from canonical path of the
+ * FITS file, its modification time and size, and from all rendering
+ * parameters (preview size, label, quantiles, channel and colour variant).
+ * Modified file thus gets new key, and stale previews are never returned.
+ *
+ * The cache has two tiers. Recently used previews are kept in memory, up to
+ * the configured memory limit. If cache directory is configured, all
+ * rendered previews are also written to it, under name derived from hash of
+ * the key, and survive restarts. Memory misses are looked up on disk, and
+ * previews found there are returned as opened files, which are streamed to
+ * the client without being read into memory.
+ *
+ * Previews of new images can be rendered before they are requested, from
+ * the main loop idle call. FITS file access is not thread safe, so FITS
+ * files are read and labels drawn from the main loop; scaling, zooming and
+ * JPEG compression of queued previews run in parallel on worker pool.
+ * Background thread writes previews to the disk cache.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class PreviewCache
+{
+	public:
+		PreviewCache ();
+		~PreviewCache ();
+
+		/**
+		 * Set cache limits. Must be called before start.
+		 *
+		 * @param _memoryLimit  maximal size (in bytes) of previews kept in memory
+		 * @param _cacheDir     directory for disk cache, NULL or empty to disable disk cache
+		 * @param _diskLimit    maximal size (in bytes) of disk cache
+		 * @param _threads      number of threads rendering queued previews
+		 */
+		void setParameters (size_t _memoryLimit, const char *_cacheDir, size_t _diskLimit, int _threads = 1);
+
+		/**
+		 * Start worker pool rendering queued previews and background
+		 * thread writing the disk cache.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int start ();
+
+		/**
+		 * Stop worker pool and background thread. Queued previews are written to disk,
+		 * queued rendering requests are discarded.
+		 */
+		void stop ();
+
+		/**
+		 * Construct cache key.
+		 *
+		 * @param key   constructed key
+		 * @param path  path to FITS file
+		 * @param kind  PREVIEW_FULL or PREVIEW_ZOOM
+		 *
+		 * @return -1 if the file does not exist, 0 on success
+		 */
+		static int getKey (std::string &key, const char *path, char kind, int prevsize, const char *label, float quantiles, int chan, int colourVariant);
+
+		/**
+		 * Find preview in cache. Preview found in memory is returned in
+		 * response, preview found on disk as opened file.
+		 *
+		 * @param response         newly allocated (with new[]) buffer with the preview, NULL if preview is returned in fd
+		 * @param response_length  preview length
+		 * @param fd               file with the preview in its first response_length bytes, -1 if preview is returned in response; caller must close it
+		 *
+		 * @return true if preview was found
+		 */
+		bool get (const std::string &key, char* &response, size_t &response_length, int &fd);
+
+		/**
+		 * Put rendered preview to cache. Preview is written to disk
+		 * cache by background thread.
+		 */
+		void put (const std::string &key, const char *data, size_t len);
+
+		/**
+		 * Queue rendering of zoomed preview.
+		 */
+		void warm (const char *path, int prevsize, const char *label, float quantiles, int chan, int colourVariant);
+
+		/**
+		 * Render batch of queued previews, which are not already cached.
+		 * Must be called from the main loop.
+		 */
+		void renderWarm ();
+
+		long getHits () { return hits; }
+		long getMisses () { return misses; }
+		size_t getMemorySize () { return memorySize; }
+
+		// thread routine
+		void run ();
+
+	private:
+		size_t memoryLimit;
+		std::string cacheDir;
+		size_t diskLimit;
+		int threads;
+
+		rts2core::WorkerPool *pool;
+
+		pthread_mutex_t mutex;
+
+		struct MemoryEntry
+		{
+			std::vector <char> data;
+			std::list <std::string>::iterator lruIter;
+		};
+
+		// most recently used keys are at front
+		std::list <std::string> lru;
+		std::map <std::string, MemoryEntry> memory;
+		size_t memorySize;
+
+		size_t diskSize;
+
+		long hits;
+		long misses;
+
+		struct WarmRequest
+		{
+			std::string path;
+			int prevsize;
+			std::string label;
+			float quantiles;
+			int chan;
+			int colourVariant;
+		};
+
+		// accessed only from the main loop
+		std::deque <WarmRequest> warmQueue;
+
+		struct DiskRequest
+		{
+			std::string key;
+			std::vector <char> data;
+		};
+
+		pthread_t thread;
+		pthread_cond_t cond;
+		bool running;
+		std::deque <DiskRequest> diskQueue;
+
+		/**
+		 * Put data to memory tier. Must be called with mutex locked.
+		 */
+		void putMemory (const std::string &key, const char *data, size_t len);
+
+		std::string diskPath (const std::string &key);
+
+		/**
+		 * Open disk cache file with the preview.
+		 *
+		 * @param len  preview length
+		 *
+		 * @return file descriptor, -1 if preview is not in disk cache
+		 */
+		int getDisk (const std::string &key, size_t &len);
+		void putDisk (const std::string &key, const char *data, size_t len);
+
+		/**
+		 * Remove least recently used files from disk cache until it fits into the limit.
+		 */
+		void pruneDisk ();
+};
+
+}
+
+#endif // !__RTS2_PREVIEWCACHE__
@@ -19,6 +19,7 @@
 
 #include "schedule.h"
 #include "rts2db/accountset.h"
+#include "workerpool.h"
 
 #include <vector>
 
@@ -102,6 +103,23 @@ class Rts2SchedBag:public std::vector <Rts2Schedule *>
 		 */
 		unsigned int constraintViolation (constraintFunc _type);
 
+		/**
+		 * Set number of threads used to evaluate schedules.
+		 *
+		 * @param _threads  number of threads, including the calling thread
+		 */
+		void setThreads (int _threads);
+
+		/**
+		 * Calculate merits and constraint violations of all
+		 * population members. Schedules are evaluated in parallel
+		 * only when all ticket targets have ephemeris tables covering
+		 * the night - pool threads then only read target tables, and
+		 * never call target methods with lazy caches. Otherwise
+		 * schedules are evaluated on the calling thread.
+		 */
+		void evaluate ();
+
 		/**
 		 * Do one step of a simple GA.
 		 */
@@ -109,7 +127,8 @@ class Rts2SchedBag:public std::vector <Rts2Schedule *>
 
 		/**
 		 * Calculate ranks of the entire population. Ranks are assigned to schedule
-		 * with setNSGARank function.
+		 * with setNSGARank function. Uses values calculated by the last
+		 * evaluate call, population must not be changed since.
 		 */
 		void calculateNSGARanks ();
 
@@ -127,6 +146,14 @@ class Rts2SchedBag:public std::vector <Rts2Schedule *>
 		 */
 		int getNSGARankSize (int _rank);
 
+		/**
+		 * Set step of the precomputed target ephemeris tables. Must be
+		 * called before schedules are constructed.
+		 *
+		 * @param _step  step in seconds, 0 to not use precomputed tables
+		 */
+		void setEphemerisStep (double _step) { ephemerisStep = _step; }
+
 		/**
 		 * Return NSGAII objectives.
 		 */
@@ -152,6 +179,18 @@ class Rts2SchedBag:public std::vector <Rts2Schedule *>
 		rts2sched::TicketSet *ticketSet;
 		rts2db::TargetSet *tarSet;
 
+		// step (in seconds) of target ephemeris tables
+		double ephemerisStep;
+		rts2core::NightEphemeris *ephemerisNight;
+
+		// true if schedules can be evaluated by pool threads
+		bool parallelEvaluation;
+
+		/**
+		 * Precompute ephemeris tables of targets with scheduling tickets.
+		 */
+		void cacheEphemeris ();
+
 		/**
 		 * The algorithm replace randomly selected observation with randomly picked new
 		 * one.
@@ -222,15 +261,51 @@ class Rts2SchedBag:public std::vector <Rts2Schedule *>
 		// vector holding size of individual fronts
 		std::vector <int> NSGAfrontsSize;
 
+		// pool evaluating schedules
+		rts2core::WorkerPool *pool;
+
+		// schedules which can be reused for new population members
+		std::vector <Rts2Schedule *> freeSchedules;
+
+		// constraints and objectives values of population members, row for each member
+		std::vector <double> NSGAvalues;
+
+		// dominance matrix, row for each member, value is result of dominatesNSGA
+		std::vector <signed char> NSGAdominance;
+
+		// number of members which dominate the member
+		std::vector <int> NSGAdominated;
+
+		// indices of members in the current and next front
+		std::vector <int> NSGAcurrentFront;
+		std::vector <int> NSGAnextFront;
+
+		// members selected to the next generation
+		std::vector <Rts2Schedule *> NSGAnewPop;
+
+		/**
+		 * Returns schedule for a new population member, either reused or newly allocated.
+		 */
+		Rts2Schedule *newSchedule ();
+
+		/**
+		 * Put schedule which is not member of the population to reuse list.
+		 */
+		void freeSchedule (Rts2Schedule *sched);
+
 		/**
 		 * Dominance operator.
 		 *
-		 * @param sched_1  First schedule which will be compared.
-		 * @param sched_2  Second schedule which will be compared.
+		 * @param values_1  Constraints and objectives values of the first schedule.
+		 * @param values_2  Constraints and objectives values of the second schedule.
 		 *
 		 * @return <ul><li>-1 if first schedule dominates second</li><li>1 if second schedule dominates first</li><li>0 if schedules are equal</li>
 		 */
-		int dominatesNSGA (Rts2Schedule *sched_1, Rts2Schedule *sched_2);
+		int dominatesNSGA (const double *values_1, const double *values_2);
+
+		static void evaluateSchedule (void *arg, size_t i);
+
+		static void dominanceRow (void *arg, size_t p);
 
 		/** 
 		 * Calculates crowding distance of each member in
@@ -163,19 +163,30 @@ class Rts2SchedObs
 		 *
 		 * @param _pos Returned position.
 		 */
-		void getStartPosition (struct ln_equ_posn &_pos) { getTarget ()->getPosition (&_pos, getJDStart ()); }
+		void getStartPosition (struct ln_equ_posn &_pos) { getPosition (_pos, getJDStart ()); }
 
 		/**
 		 * Get equatiorial position of the target at the end of the observation.
 		 *
 		 * @param _pos Returned position.
 		 */
-		void getEndPosition (struct ln_equ_posn &_pos) { getTarget ()->getPosition (&_pos, getJDEnd ()); }
+		void getEndPosition (struct ln_equ_posn &_pos) { getPosition (_pos, getJDEnd ()); }
 
 		/**
-		 * Returns schedule position at give julian date.
+		 * Returns schedule position at give julian date. Position is
+		 * taken from target ephemeris table if the target uses it, NAN
+		 * is returned for dates not covered by the table.
 		 */
-		void getPosition (struct ln_equ_posn &_pos, double JD) { getTarget ()->getPosition (&_pos, JD); }
+		void getPosition (struct ln_equ_posn &_pos, double JD)
+		{
+			rts2core::TargetEphemeris *ephemeris = getTarget ()->getEphemeris ();
+			if (ephemeris == NULL)
+				getTarget ()->getPosition (&_pos, JD);
+			else if (ephemeris->contains (JD))
+				ephemeris->getPosition (&_pos, JD);
+			else
+				_pos.ra = _pos.dec = NAN;
+		}
 
 		/**
 		 * Return true if schedule for given ticket is violated.
@@ -145,6 +145,27 @@ class Rts2Schedule: public std::vector <Rts2SchedObs*>
 		 */
 		~Rts2Schedule (void);
 
+		/**
+		 * Fill schedule by crossing two schedules. Previous schedule
+		 * entries are deleted.
+		 *
+		 * @param sched1      1st schedule to cross.
+		 * @param sched2      2nd schedule to cross.
+		 * @param crossPoint  Seconds in schedule duration in which schedules will cross.
+		 */
+		void crossSchedules (Rts2Schedule *sched1, Rts2Schedule *sched2, unsigned int crossPoint);
+
+		/**
+		 * Delete all scheduled observations. Schedule can be reused
+		 * with crossSchedules.
+		 */
+		void clearSchedule ();
+
+		/**
+		 * Mark merits for recalculation. Must be called after schedule entries were changed.
+		 */
+		void invalidateMerits () { nanLazyMerits (); }
+
 		/**
 		 * Return schedule start julian date.
 		 *
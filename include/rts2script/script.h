@@ -138,6 +138,15 @@ class Script:public Object, public std::list <Element *>
 		 */
 		int setTarget (const char *cam_name, Rts2Target *target);
 
+		/**
+		 * Set target with script already retrieved from the target.
+		 *
+		 * @params cam_name    Name of the camera.
+		 * @params target      Script target.
+		 * @params scriptLines Script lines, as returned by target->getScript calls.
+		 */
+		void setTarget (const char *cam_name, Rts2Target *target, const std::vector <std::string> &scriptLines);
+
 		virtual void postEvent (rts2core::Event * event);
 
 		/**
@@ -0,0 +1,115 @@
+/*
+ * Cache of parsed target scripts.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_SCRIPTCACHE__
+#define __RTS2_SCRIPTCACHE__
+
+#include "connnotify.h"
+#include "rts2target.h"
+
+#include <libnova/libnova.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace rts2script
+{
+
+/**
+ * Informations derived from parsed script.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class ScriptInfo
+{
+	public:
+		// hash of script lines and of the target acquisition state
+		uint64_t hash;
+
+		// filters requested by filter= commands of the script
+		std::vector <std::string> filters;
+
+		// duration of script elements for the first (0) and subsequent (1) runs
+		double duration[2];
+		double lightTime;
+		int images;
+
+		float telescopeSettleTime;
+		float telescopeSpeed;
+
+		/**
+		 * Return expected script duration, including telescope movement.
+		 *
+		 * @param tel     current telescope position, NULL if telescope movement should not be included
+		 * @param target  target position
+		 * @param runnum  script run number (= 0 before script was run,..)
+		 */
+		double getExpectedDuration (struct ln_equ_posn *tel, struct ln_equ_posn *target, int runnum);
+};
+
+/**
+ * Cache of scripts parsed for target and camera.
+ *
+ * Selector and executor repeatedly ask for required filters and expected
+ * duration of target scripts. Script text is retrieved from target every
+ * time, but is parsed only if its hash differs from hash of the cached
+ * entry. Whole cache is flushed when configuration file, which can
+ * contain scripts and values used for duration estimates, is modified.
+ * Daemons watch the configuration file through their notify connection,
+ * other programs check its modification time.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class ScriptCache
+{
+	public:
+		/**
+		 * Return informations about target script for given camera.
+		 *
+		 * @param cam_name  camera name
+		 * @param target    target
+		 *
+		 * @return cached script informations; if script cannot be
+		 * retrieved, informations about lines retrieved so far
+		 *
+		 * @throw rts2script::ParsingError when script cannot be parsed
+		 */
+		static ScriptInfo &getScriptInfo (const char *cam_name, Rts2Target *target);
+
+		/**
+		 * Remove all entries.
+		 */
+		static void clearCache ();
+
+		/**
+		 * Set connection used to watch for configuration file changes.
+		 * Usually the connection passed to MasterConstraints::setNotifyConnection.
+		 */
+		static void setNotifyConnection (rts2core::ConnNotify *_watchConn);
+
+		/**
+		 * Flush cache if watch_id belongs to the configuration file. Shall
+		 * be called from fileModified.
+		 */
+		static void revalidate (int watch_id);
+};
+
+}
+
+#endif // !__RTS2_SCRIPTCACHE__
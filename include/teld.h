@@ -28,6 +28,10 @@
 #include "device.h"
 #include "objectcheck.h"
 
+#ifdef RTS2_LIBERFA
+#include "erfa.h"
+#endif
+
 // pointing models
 #define POINTING_RADEC          0
 #define POINTING_ALTAZ          1
@@ -239,6 +243,17 @@ class Telescope:public rts2core::Device
 		 * @param dec DEC correction
 		 */
 		virtual int applyCorrectionsFixed (double ra, double dec) { return -1; }
+
+#ifdef RTS2_LIBERFA
+		/**
+		 * Return astrometry context for given UTC. Cached context is
+		 * used if it was computed less than astrometry_interval
+		 * seconds ago with the same site and weather parameters.
+		 *
+		 * @return 0 on success, -1 on error
+		 */
+		int getAstrom (double utc1, double utc2, eraASTROM *ret);
+#endif
 	
 		/**
 		 * Returns telescope target RA.
@@ -1098,6 +1113,28 @@ class Telescope:public rts2core::Device
 		rts2core::ValueFloat *trackingWarning;
 		double lastTrackingRun;
 
+		/**
+		 * Time needed to compute tracking step.
+		 */
+		rts2core::ValueDoubleStat *trackingTime;
+
+#ifdef RTS2_LIBERFA
+		/**
+		 * Interval for full recalculation of astrometry context.
+		 */
+		rts2core::ValueDouble *astromInterval;
+
+		/**
+		 * Cached astrometry context. Earth ephemeris, precession-nutation
+		 * and refraction constants are recomputed once per astromInterval,
+		 * or when any of the site or weather parameters changes. Earth
+		 * rotation angle is updated on each call.
+		 */
+		eraASTROM astrom;
+		double astromUTC;
+		double astromParams[8];
+#endif
+
 		/**
 		 * Last error.
 		 */
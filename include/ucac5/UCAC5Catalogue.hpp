@@ -0,0 +1,158 @@
+/*
+ * In-process UCAC5 catalogue.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __UCAC5CATALOGUE__
+#define __UCAC5CATALOGUE__
+
+#include "ucac5/UCAC5Record.hpp"
+#include "gtp/Vector.h"
+
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+// number of declination zones (0.2 deg wide)
+#define UCAC5_ZONES      900
+// number of RA bins in a zone (0.25 deg wide)
+#define UCAC5_RA_BINS    1440
+
+/**
+ * Star found in UCAC5 catalogue.
+ */
+struct UCAC5Star
+{
+	const struct ucac5 *record;
+	// distance from the search centre (radians), NAN for box searches
+	double distance;
+
+	double getMag () const { return record->gmag / 1000.0; }
+};
+
+/**
+ * UCAC5 catalogue kept open for repeated searches.
+ *
+ * Band index (u5index.unf), zone files (zNNN) and their unit vector
+ * indices (zNNN.xyz, created by ucac5-idx) are memory mapped on the first
+ * access and stay mapped until the catalogue is destroyed. Stars are
+ * selected from the RA bins of the band index overlapping the searched
+ * area, and matched by dot product of their unit vector with the centre
+ * vector against precomputed cosine of the radius.
+ *
+ * Only the brightest stars are kept during the search (in a heap bounded by
+ * the maximal number of stars), so searches of large areas do not
+ * allocate memory for all stars inside the area.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class UCAC5Catalogue
+{
+	public:
+		UCAC5Catalogue ();
+		~UCAC5Catalogue ();
+
+		/**
+		 * Open catalogue.
+		 *
+		 * @param base  directory with u5index.unf, zone and xyz files
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int open (const char *base);
+
+		/**
+		 * Find stars inside annulus around given position.
+		 *
+		 * @param ra         centre RA (radians)
+		 * @param dec        centre DEC (radians)
+		 * @param minRadius  minimal distance (radians)
+		 * @param maxRadius  maximal distance (radians)
+		 * @param magLimit   faintest magnitude of returned stars
+		 * @param maxStars   maximal number of returned stars; brightest stars are returned if more stars are found
+		 * @param stars      found stars, sorted by magnitude (brightest first)
+		 *
+		 * @return -1 when some zone cannot be opened, 0 on success
+		 */
+		int cone (double ra, double dec, double minRadius, double maxRadius, double magLimit, size_t maxStars, std::vector <UCAC5Star> &stars);
+
+		/**
+		 * Find stars inside RA/DEC box. If ra1 is larger than ra2, the box crosses 0h.
+		 *
+		 * @param ra1    minimal RA (radians)
+		 * @param dec1   minimal DEC (radians)
+		 * @param ra2    maximal RA (radians)
+		 * @param dec2   maximal DEC (radians)
+		 *
+		 * @return -1 when some zone cannot be opened, 0 on success
+		 */
+		int box (double ra1, double dec1, double ra2, double dec2, double magLimit, size_t maxStars, std::vector <UCAC5Star> &stars);
+
+		/**
+		 * Enable or disable SSE2 matching of cone searches (enabled by
+		 * default, if compiled in). Used to compare results with the
+		 * scalar code.
+		 */
+		void setSimd (bool _simd) { simd = _simd; }
+
+	private:
+		std::string base;
+
+		int indexFd;
+		uint32_t *index;
+		size_t indexSize;
+
+		struct Zone
+		{
+			int fd;
+			struct ucac5 *records;
+			size_t recordsSize;
+			int xyzFd;
+			Vector *xyz;
+			size_t xyzSize;
+			// number of stars in zone
+			size_t count;
+		};
+
+		Zone zones[UCAC5_ZONES];
+
+		bool simd;
+
+		/**
+		 * Return zone, map it if it was not accessed before.
+		 *
+		 * @return NULL if zone files cannot be opened
+		 */
+		Zone *getZone (int z);
+
+		void closeZone (Zone *zone);
+
+		/**
+		 * Return range of stars in RA bins b1 to b2 (inclusive) of the zone.
+		 */
+		void getRange (Zone *zone, int z, int b1, int b2, size_t &start, size_t &end);
+
+		/**
+		 * Add stars from start to end with dot product of their unit vector and t between cosMax and cosMin.
+		 *
+		 * @param stars  heap of the brightest found stars
+		 */
+		void matchCone (Zone *zone, size_t start, size_t end, const double t[3], double cosMin, double cosMax, double magLimit, size_t maxStars, std::vector <UCAC5Star> &stars);
+};
+
+#endif // !__UCAC5CATALOGUE__
@@ -20,6 +20,7 @@
 #ifndef __RTS2_VALUELIST__
 #define __RTS2_VALUELIST__
 
+#include <ctype.h>
 #include <vector>
 
 #include "value.h"
@@ -28,6 +29,133 @@
 namespace rts2core
 {
 
+class CondValue;
+
+/**
+ * Returns value stored in indexed vector.
+ */
+inline Value *indexedValue (Value *val) { return val; }
+inline Value *indexedValue (CondValue *val);
+
+/**
+ * Vector of values with hash index of value names. Vector keeps order
+ * of values, the index provides constant time search by value name.
+ * Names are compared case insensitive, as Value::isValue does.
+ *
+ * Index is rebuild on first search after vector was changed. Only
+ * operations which keep the index consistent are provided - values can
+ * be added, inserted and erased, but not replaced in place.
+ *
+ * @ingroup RTS2Value
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+template <typename T> class IndexedValueVector
+{
+	public:
+		typedef typename std::vector <T>::const_iterator iterator;
+		typedef typename std::vector <T>::const_iterator const_iterator;
+
+		IndexedValueVector ()
+		{
+			indexValid = false;
+		}
+
+		iterator begin () const { return values.begin (); }
+		iterator end () const { return values.end (); }
+
+		size_t size () const { return values.size (); }
+		bool empty () const { return values.empty (); }
+
+		const T & operator[] (size_t i) const { return values[i]; }
+		const T & back () const { return values.back (); }
+
+		/**
+		 * Returns index of the value with given name.
+		 *
+		 * @param value_name  name of the value
+		 *
+		 * @return index of the value, -1 if value with given name does not exist
+		 */
+		int findValue (const char *value_name)
+		{
+			if (!indexValid)
+				buildIndex ();
+			return lookup (value_name);
+		}
+
+		void push_back (const T &val)
+		{
+			values.push_back (val);
+			indexValid = false;
+		}
+
+		iterator insert (iterator pos, const T &val)
+		{
+			indexValid = false;
+			return values.insert (values.begin () + (pos - values.begin ()), val);
+		}
+
+		iterator erase (iterator pos)
+		{
+			indexValid = false;
+			return values.erase (values.begin () + (pos - values.begin ()));
+		}
+
+		void clear ()
+		{
+			values.clear ();
+			indexValid = false;
+		}
+
+	private:
+		std::vector <T> values;
+
+		// index of the value + 1, 0 for empty slot
+		std::vector <int> slots;
+		bool indexValid;
+
+		static unsigned int hashName (const char *name)
+		{
+			// FNV-1a of lower case name
+			unsigned int h = 2166136261u;
+			for (; *name; name++)
+			{
+				h ^= (unsigned char) tolower (*name);
+				h *= 16777619u;
+			}
+			return h;
+		}
+
+		void buildIndex ()
+		{
+			size_t n = 16;
+			while (n < 2 * values.size ())
+				n *= 2;
+			slots.assign (n, 0);
+			for (size_t i = 0; i < values.size (); i++)
+			{
+				unsigned int h = hashName (indexedValue (values[i])->getName ().c_str ()) & (n - 1);
+				while (slots[h] != 0)
+					h = (h + 1) & (n - 1);
+				slots[h] = i + 1;
+			}
+			indexValid = true;
+		}
+
+		int lookup (const char *value_name)
+		{
+			unsigned int mask = slots.size () - 1;
+			for (unsigned int h = hashName (value_name) & mask; slots[h] != 0; h = (h + 1) & mask)
+			{
+				size_t i = slots[h] - 1;
+				if (i < values.size () && indexedValue (values[i])->isValue (value_name))
+					return i;
+			}
+			return -1;
+		}
+};
+
 /**
  * Represent set of Values. It's used to store values which shall
  * be reseted when new script starts etc..
@@ -36,7 +164,7 @@ namespace rts2core
  *
  * @author Petr Kubanek <petr@kubanek.net>
  */
-class ValueVector:public std::vector < Value * >
+class ValueVector:public IndexedValueVector < Value * >
 {
 	public:
 		ValueVector ()
@@ -57,15 +185,10 @@ class ValueVector:public std::vector < Value * >
 		 */
 		ValueVector::iterator getValueIterator (const char *value_name)
 		{
-			ValueVector::iterator val_iter;
-			for (val_iter = begin (); val_iter != end (); val_iter++)
-			{
-				Value *val;
-				val = (*val_iter);
-				if (val->isValue (value_name))
-					return val_iter;
-			}
-			return val_iter;
+			int i = findValue (value_name);
+			if (i < 0)
+				return end ();
+			return begin () + i;
 		}
 
 		/**
@@ -77,10 +200,10 @@ class ValueVector:public std::vector < Value * >
 		 */
 		Value *getValue (const char *value_name)
 		{
-			ValueVector::iterator val_iter = getValueIterator (value_name);
-			if (val_iter == end ())
+			int i = findValue (value_name);
+			if (i < 0)
 				return NULL;
-			return (*val_iter);
+			return (*this)[i];
 		}
 
 		/**
@@ -134,6 +257,8 @@ class CondValue
 		int save;
 };
 
+inline Value *indexedValue (CondValue *val) { return val->getValue (); }
+
 /**
  * Holds cond values.
  *
@@ -141,7 +266,7 @@ class CondValue
  *
  * @author Petr Kubanek <petr@kubanek.net>
  */
-class CondValueVector:public std::vector < CondValue * >
+class CondValueVector:public IndexedValueVector < CondValue * >
 {
 	public:
 		CondValueVector () {}
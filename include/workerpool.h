@@ -0,0 +1,93 @@
+/*
+ * Pool of worker threads.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_WORKERPOOL__
+#define __RTS2_WORKERPOOL__
+
+#include <pthread.h>
+#include <stddef.h>
+#include <vector>
+
+namespace rts2core
+{
+
+/**
+ * Small pool of threads for data parallel tasks. Tasks are indexed by
+ * integer numbers, and are distributed among pool threads and the
+ * calling thread. Only a single thread can submit tasks to the pool.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class WorkerPool
+{
+	public:
+		/**
+		 * Create pool.
+		 *
+		 * @param nthreads  number of threads processing tasks, including the calling thread
+		 */
+		WorkerPool (int nthreads);
+		~WorkerPool ();
+
+		/**
+		 * Returns number of threads processing tasks, including the calling thread.
+		 */
+		int getThreads () { return threads.size () + 1; }
+
+		/**
+		 * Run func (arg, i) for i in 0..n-1. Returns when all tasks are finished.
+		 *
+		 * @param n     number of tasks
+		 * @param func  task function
+		 * @param arg   argument passed to task function
+		 */
+		void parallelFor (size_t n, void (*func) (void *arg, size_t i), void *arg);
+
+	private:
+		std::vector <pthread_t> threads;
+		pthread_mutex_t mutex;
+		// signals new tasks
+		pthread_cond_t taskCond;
+		// signals all tasks were finished
+		pthread_cond_t doneCond;
+
+		bool running;
+
+		void (*taskFunc) (void *arg, size_t i);
+		void *taskArg;
+		// number of tasks
+		size_t taskCount;
+		// index of the next task to run
+		size_t taskNext;
+		// number of tasks not yet finished
+		size_t taskRemaining;
+		// incremented with each parallelFor call
+		unsigned long generation;
+
+		/**
+		 * Run tasks until there are some not yet started. Must be called with mutex locked.
+		 */
+		void runTasks ();
+
+		static void *worker (void *arg);
+};
+
+}
+
+#endif // !__RTS2_WORKERPOOL__
@@ -0,0 +1,105 @@
+/*
+ * Ring buffer for outgoing connection data.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_WRITEBUFFER__
+#define __RTS2_WRITEBUFFER__
+
+#include <stddef.h>
+#include <sys/uio.h>
+
+/**
+ * Default maximal size of data waiting in the buffer (256 MB).
+ */
+#define WRITEBUFFER_LIMIT     268435456
+
+namespace rts2core
+{
+
+/**
+ * Ring buffer holding data which cannot be written to the connection
+ * socket without blocking. Buffer grows as needed up to its limit, and is
+ * shrinked back to its initial size when it is drained.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class WriteBuffer
+{
+	public:
+		WriteBuffer (size_t _limit = WRITEBUFFER_LIMIT);
+		~WriteBuffer ();
+
+		/**
+		 * Append data to the end of the buffer.
+		 *
+		 * @param data  data to append
+		 * @param len   length of data in bytes
+		 *
+		 * @return -1 if data cannot be added, as buffer would exceed its limit, 0 on success
+		 */
+		int push (const char *data, size_t len);
+
+		/**
+		 * Fill IO vectors with pending data, for writev/sendmsg call.
+		 *
+		 * @param iov  array of (at least) two iovec structures
+		 *
+		 * @return number of filled iovec structures (0-2)
+		 */
+		int getIovec (struct iovec *iov);
+
+		/**
+		 * Remove data from start of the buffer.
+		 *
+		 * @param len  number of bytes which were written out
+		 */
+		void consume (size_t len);
+
+		/**
+		 * Returns number of bytes waiting in the buffer.
+		 */
+		size_t size () { return used; }
+
+		bool empty () { return used == 0; }
+
+		size_t getLimit () { return limit; }
+
+		void setLimit (size_t _limit) { limit = _limit; }
+
+		/**
+		 * Drop all pending data.
+		 */
+		void clear ();
+
+	private:
+		char *buf;
+		size_t capacity;
+		// start of pending data
+		size_t head;
+		size_t used;
+		size_t limit;
+
+		/**
+		 * Reallocate buffer to the given capacity, move pending data to its start.
+		 */
+		void resize (size_t new_capacity);
+};
+
+}
+
+#endif // !__RTS2_WRITEBUFFER__
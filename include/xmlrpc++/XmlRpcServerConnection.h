@@ -14,6 +14,8 @@
 #include <list>
 #include <utility>
 
+#include <sys/types.h>
+
 #include "XmlRpcValue.h"
 #include "XmlRpcSocket.h"
 #include "XmlRpcSource.h"
@@ -95,6 +97,29 @@ namespace XmlRpc
 			// return true if connection is in chunged mode
 			bool isChunked () { return _contentLength == -1; }
 
+			/**
+			 * Stream file as response to GET request. File is written
+			 * directly to the socket (with sendfile, if available), without
+			 * being read into memory. Honors Range header of the request.
+			 *
+			 * @param fd      file descriptor; connection takes its ownership and closes it when response is written
+			 * @param length  file length
+			 */
+			void setFileResponse (int fd, size_t length);
+
+			/**
+			 * Parse value of Range header. Only single byte range is
+			 * supported.
+			 *
+			 * @param range   Range header value, e.g. "bytes=0-499"
+			 * @param length  file length
+			 * @param first   first byte of the selected range
+			 * @param last    last byte of the selected range
+			 *
+			 * @return HTTP_PARTIAL_CONTENT if range was selected, HTTP_RANGE_NOT_SATISFIABLE if it is outside of the file, HTTP_OK if whole file shall be sent
+			 */
+			static int parseRange (const std::string &range, size_t length, size_t &first, size_t &last);
+
 		protected:
 
 			bool readHeader();
@@ -104,6 +129,10 @@ namespace XmlRpc
 			bool writeResponse();
 			bool writeAsyncReponse();
 
+			// Write next part of GET response data
+			bool writeGetData();
+			bool writeFileData();
+
 			// Parses the request, runs the method, generates the response xml.
 			virtual void executeRequest();
 
@@ -168,6 +197,18 @@ namespace XmlRpc
 			char *_get_response;
 			size_t _get_response_length;
 
+			// File streamed as response for GET request, -1 if response is in _get_response
+			int _get_file;
+			// Offset of the first streamed byte
+			off_t _get_file_offset;
+			// Total file length
+			size_t _get_file_length;
+			// Buffer used when sendfile is not available
+			char *_get_file_buf;
+
+			// Range header of the request
+			std::string _range;
+
 			// Number of bytes written for GET header and response so far
 			size_t _getHeaderWritten;
 			size_t _getWritten;
@@ -183,6 +224,12 @@ namespace XmlRpc
 #endif
 			// prepare to receive next data
 			void prepareForNext ();
+
+			// close file streamed as response
+			void closeFileResponse ();
+
+			// select requested range of the file, returns HTTP code
+			int selectFileRange ();
 	};
 
 
@@ -18,9 +18,11 @@
 
 #include "XmlRpcServerConnection.h"
 
-#define HTTP_OK              200
-#define HTTP_BAD_REQUEST     400
-#define HTTP_UNAUTHORIZED    401
+#define HTTP_OK                     200
+#define HTTP_PARTIAL_CONTENT        206
+#define HTTP_BAD_REQUEST            400
+#define HTTP_UNAUTHORIZED           401
+#define HTTP_RANGE_NOT_SATISFIABLE  416
 
 namespace XmlRpc
 {
@@ -126,6 +128,32 @@ namespace XmlRpc
 			XmlRpcServerConnection *connection;
 
 			void addExtraHeader (const char *name, const char *value) { connection->addExtraHeader (name, value); }
+
+			/**
+			 * Respond with file content. File is streamed to the client,
+			 * response and response_length passed to execute shall be left
+			 * unset.
+			 *
+			 * @param path  file path
+			 *
+			 * @throw XmlRpcException when file cannot be opened
+			 */
+			void sendFile (const char *path);
+
+			/**
+			 * Respond with content of an opened file. Takes ownership of
+			 * the file descriptor.
+			 *
+			 * @throw XmlRpcException when file size cannot be determined
+			 */
+			void sendFile (int fd);
+
+			/**
+			 * Respond with the first length bytes of an opened file.
+			 * Takes ownership of the file descriptor.
+			 */
+			void sendFile (int fd, size_t length);
+
 			/**
 			 * Specify max age in seconds. For this time cached response will be valid. This method
 			 * is provide for convinient setting of cache timeout.
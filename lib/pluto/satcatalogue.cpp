@@ -0,0 +1,497 @@
+/*
+ * Catalogue of satellites for screening of images.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "pluto/satcatalogue.h"
+#include "pluto/observe.h"
+#include "workerpool.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PI          3.141592653589793238462643383279
+#define RAD_TO_DEG  (180.0 / PI)
+#define DEG_TO_RAD  (PI / 180.0)
+
+// Earth gravitational parameter, km^3/s^2
+#define EARTH_GM    398600.4418
+// maximal speed of observer due to Earth rotation, km/s
+#define OBSERVER_SPEED  0.47
+
+// bucket numbers are counted from J2000, so they fit into long
+#define BUCKET_EPOCH  2451545.0
+
+// number of satellites processed by a single task
+#define SAT_CHUNK   512
+
+// maximal number of samples of a single exposure in refinement
+#define MAX_SAMPLES 2000
+
+// maximal number of buckets screened by a single query
+#define MAX_QUERY_BUCKETS 60
+
+using namespace rts2sat;
+
+namespace rts2sat
+{
+
+/**
+ * Query parameters shared by tasks.
+ */
+struct QueryTask
+{
+	SatCatalogue *catalogue;
+	std::vector <SatPropagator> *sats;
+	std::vector <double> *maxSpeed;
+
+	// bucket being filled or screened
+	float *pos;
+	double bucketJD;
+	// maximal time distance from the bucket (seconds)
+	double bucketDt;
+	double observerLoc[3];
+
+	double JD;
+	double duration;
+	double lng;
+	double rho_cos_phi;
+	double rho_sin_phi;
+
+	// search centre, J2000 and of date unit vector
+	double ra;
+	double dec;
+	double centre[3];
+	double radius;
+
+	std::vector <char> candidate;
+	std::vector <size_t> candidates;
+	std::vector <SatMatch> matches;
+};
+
+}
+
+/**
+ * Topocentric RA and DEC of date (radians) and distance (km).
+ */
+static int satRaDec (SatPropagator &sat, double JD, double lng, double rho_cos_phi, double rho_sin_phi, double &ra, double &dec, double &range)
+{
+	double sat_pos[3], observer_loc[3];
+	if (sat.propagate (JD, sat_pos))
+		return -1;
+	observer_cartesian_coords (JD, lng, rho_cos_phi, rho_sin_phi, observer_loc);
+	get_satellite_ra_dec_delta (observer_loc, sat_pos, &ra, &dec, &range);
+	return 0;
+}
+
+/**
+ * Angular separation of two positions (radians).
+ */
+static double separation (double ra1, double dec1, double ra2, double dec2)
+{
+	double sd = sin ((dec2 - dec1) / 2);
+	double sr = sin ((ra2 - ra1) / 2);
+	double h = sd * sd + cos (dec1) * cos (dec2) * sr * sr;
+	return 2 * asin (sqrt (h > 1 ? 1 : h));
+}
+
+/**
+ * Separation of satellite J2000 position from the search centre at JD.
+ */
+static double querySeparation (QueryTask *q, SatPropagator &sat, double JD, double &ra, double &dec, double &range)
+{
+	if (satRaDec (sat, JD, q->lng, q->rho_cos_phi, q->rho_sin_phi, ra, dec, range))
+		return NAN;
+	epoch_of_date_to_j2000 (JD, &ra, &dec);
+	return separation (ra, dec, q->ra, q->dec);
+}
+
+SatCatalogue::SatCatalogue (int nthreads)
+{
+	pool = new rts2core::WorkerPool (nthreads < 1 ? 1 : nthreads);
+	rejected = 0;
+	bucketStep = 10 / 86400.0;
+	maxBuckets = 60;
+	useCounter = 0;
+}
+
+SatCatalogue::~SatCatalogue ()
+{
+	clearBuckets ();
+	delete pool;
+}
+
+int SatCatalogue::load (const char *filename)
+{
+	FILE *f = fopen (filename, "r");
+	if (f == NULL)
+		return -1;
+
+	clearBuckets ();
+	sats.clear ();
+	names.clear ();
+	maxSpeed.clear ();
+	rejected = 0;
+
+	char line0[100], line1[100], line2[100];
+	*line0 = *line1 = '\0';
+	while (fgets (line2, sizeof (line2), f))
+	{
+		// strip end of line
+		line2[strcspn (line2, "\r\n")] = '\0';
+		if (line1[0] == '1' && line1[1] == ' ' && line2[0] == '2' && line2[1] == ' ')
+		{
+			// name line is optional, and can start with "0 "
+			const char *name = line0;
+			if (name[0] == '1' && name[1] == ' ')
+				name = "";
+			else if (name[0] == '0' && name[1] == ' ')
+				name += 2;
+			if (add (name, line1, line2))
+				rejected++;
+			*line0 = *line1 = '\0';
+			continue;
+		}
+		strcpy (line0, line1);
+		strcpy (line1, line2);
+	}
+	fclose (f);
+	return sats.size ();
+}
+
+int SatCatalogue::add (const char *name, const char *tle1, const char *tle2)
+{
+	SatPropagator sat;
+	// as sat_id, accept TLEs with checksum errors
+	if (sat.setTLE (tle1, tle2) < 0)
+		return -1;
+
+	// vis viva at perigee; xno is in radians per minute
+	const tle_t *tle = sat.getTLE ();
+	double n = tle->xno / 60.0;
+	double a = cbrt (EARTH_GM / (n * n));
+	double e = tle->eo < 0.999 ? tle->eo : 0.999;
+
+	std::string n_str (name);
+	while (!n_str.empty () && n_str[n_str.length () - 1] == ' ')
+		n_str.erase (n_str.length () - 1);
+
+	clearBuckets ();
+	sats.push_back (sat);
+	names.push_back (n_str);
+	maxSpeed.push_back (sqrt (EARTH_GM * (1 + e) / (a * (1 - e))));
+	return 0;
+}
+
+void SatCatalogue::setBucketStep (double step)
+{
+	clearBuckets ();
+	if (step < SAT_MIN_BUCKET_STEP)
+		step = SAT_MIN_BUCKET_STEP;
+	bucketStep = step / 86400.0;
+}
+
+int SatCatalogue::getThreads ()
+{
+	return pool->getThreads ();
+}
+
+void SatCatalogue::clearBuckets ()
+{
+	for (std::map <long, Bucket *>::iterator iter = buckets.begin (); iter != buckets.end (); iter++)
+		delete iter->second;
+	buckets.clear ();
+}
+
+SatCatalogue::Bucket *SatCatalogue::getBucket (long b)
+{
+	std::map <long, Bucket *>::iterator iter = buckets.find (b);
+	if (iter != buckets.end ())
+	{
+		iter->second->lastUsed = ++useCounter;
+		return iter->second;
+	}
+
+	// drop least recently used bucket
+	if (buckets.size () >= maxBuckets && !buckets.empty ())
+	{
+		std::map <long, Bucket *>::iterator oldest = buckets.begin ();
+		for (iter = buckets.begin (); iter != buckets.end (); iter++)
+		{
+			if (iter->second->lastUsed < oldest->second->lastUsed)
+				oldest = iter;
+		}
+		delete oldest->second;
+		buckets.erase (oldest);
+	}
+
+	Bucket *bucket = new Bucket ();
+	bucket->JD = BUCKET_EPOCH + b * bucketStep;
+	bucket->pos.resize (sats.size () * 3);
+	bucket->lastUsed = ++useCounter;
+
+	QueryTask q;
+	q.catalogue = this;
+	q.sats = &sats;
+	q.pos = &(bucket->pos[0]);
+	q.bucketJD = bucket->JD;
+
+	pool->parallelFor ((sats.size () + SAT_CHUNK - 1) / SAT_CHUNK, fillBucket, &q);
+
+	buckets[b] = bucket;
+	return bucket;
+}
+
+void SatCatalogue::fillBucket (void *arg, size_t i)
+{
+	QueryTask *q = (QueryTask *) arg;
+	size_t end = std::min ((i + 1) * SAT_CHUNK, q->sats->size ());
+	for (size_t s = i * SAT_CHUNK; s < end; s++)
+	{
+		double sat_pos[3];
+		float *p = q->pos + s * 3;
+		if ((*(q->sats))[s].propagate (q->bucketJD, sat_pos))
+		{
+			p[0] = p[1] = p[2] = NAN;
+			continue;
+		}
+		p[0] = sat_pos[0];
+		p[1] = sat_pos[1];
+		p[2] = sat_pos[2];
+	}
+}
+
+void SatCatalogue::screenBucket (void *arg, size_t i)
+{
+	QueryTask *q = (QueryTask *) arg;
+	size_t end = std::min ((i + 1) * SAT_CHUNK, q->sats->size ());
+	for (size_t s = i * SAT_CHUNK; s < end; s++)
+	{
+		if (q->candidate[s])
+			continue;
+		const float *p = q->pos + s * 3;
+		double v[3];
+		v[0] = p[0] - q->observerLoc[0];
+		v[1] = p[1] - q->observerLoc[1];
+		v[2] = p[2] - q->observerLoc[2];
+		double d = sqrt (v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+		// NAN positions are not candidates
+		if (!(d > 0))
+			continue;
+		// maximal displacement of satellite relative to observer, with some reserve for model differences
+		double disp = 1.1 * ((*(q->maxSpeed))[s] + OBSERVER_SPEED) * q->bucketDt;
+		if (disp >= d)
+		{
+			q->candidate[s] = 1;
+			continue;
+		}
+		double limit = q->radius + asin (disp / d);
+		if (limit >= PI || (v[0] * q->centre[0] + v[1] * q->centre[1] + v[2] * q->centre[2]) >= d * cos (limit))
+			q->candidate[s] = 1;
+	}
+}
+
+void SatCatalogue::refine (void *arg, size_t i)
+{
+	QueryTask *q = (QueryTask *) arg;
+	size_t s = q->candidates[i];
+	SatPropagator &sat = (*(q->sats))[s];
+	SatMatch &m = q->matches[i];
+
+	m.index = s;
+	m.norad = sat.getTLE ()->norad_number;
+	m.separation = NAN;
+
+	double ra, dec, range;
+	double best_t = q->JD;
+	double best = querySeparation (q, sat, q->JD, ra, dec, range);
+	if (isnan (best))
+		return;
+
+	if (q->duration > 0)
+	{
+		// sample exposure with step on which satellite moves by a quarter of the radius
+		double ra2, dec2, range2;
+		if (isnan (querySeparation (q, sat, q->JD + 1 / 86400.0, ra2, dec2, range2)))
+			return;
+		double rate = separation (ra, dec, ra2, dec2);
+		double step = q->duration;
+		if (rate > 0)
+			step = std::min (step, q->radius / 4 / rate);
+		size_t samples = (size_t) ceil (q->duration / step);
+		if (samples > MAX_SAMPLES)
+			samples = MAX_SAMPLES;
+		step = q->duration / samples;
+
+		for (size_t j = 1; j <= samples; j++)
+		{
+			double t = q->JD + j * step / 86400.0;
+			double sep = querySeparation (q, sat, t, ra2, dec2, range2);
+			if (sep < best)
+			{
+				best = sep;
+				best_t = t;
+			}
+		}
+
+		// golden section search of the closest approach around the best sample
+		double t1 = std::max (q->JD, best_t - step / 86400.0);
+		double t2 = std::min (q->JD + q->duration / 86400.0, best_t + step / 86400.0);
+		const double gr = (sqrt (5.0) - 1) / 2;
+		double c = t2 - gr * (t2 - t1);
+		double d = t1 + gr * (t2 - t1);
+		double fc = querySeparation (q, sat, c, ra2, dec2, range2);
+		double fd = querySeparation (q, sat, d, ra2, dec2, range2);
+		while ((t2 - t1) > 0.01 / 86400.0)
+		{
+			if (fc < fd)
+			{
+				t2 = d;
+				d = c;
+				fd = fc;
+				c = t2 - gr * (t2 - t1);
+				fc = querySeparation (q, sat, c, ra2, dec2, range2);
+			}
+			else
+			{
+				t1 = c;
+				c = d;
+				fc = fd;
+				d = t1 + gr * (t2 - t1);
+				fd = querySeparation (q, sat, d, ra2, dec2, range2);
+			}
+		}
+		double sep = querySeparation (q, sat, (t1 + t2) / 2, ra2, dec2, range2);
+		if (sep < best)
+		{
+			best = sep;
+			best_t = (t1 + t2) / 2;
+		}
+		best = querySeparation (q, sat, best_t, ra, dec, range);
+	}
+
+	if (!(best <= q->radius))
+		return;
+
+	m.JD = best_t;
+	m.ra = ra * RAD_TO_DEG;
+	m.dec = dec * RAD_TO_DEG;
+	m.separation = best * RAD_TO_DEG;
+	m.range = range;
+
+	// motion from position one second later
+	double ra2, dec2, range2;
+	if (isnan (querySeparation (q, sat, best_t + 1 / 86400.0, ra2, dec2, range2)))
+	{
+		m.motion = m.pa = NAN;
+		return;
+	}
+	double d_ra = ra2 - ra;
+	while (d_ra > PI)
+		d_ra -= 2 * PI;
+	while (d_ra < -PI)
+		d_ra += 2 * PI;
+	d_ra *= cos (dec);
+	double d_dec = dec2 - dec;
+	m.motion = sqrt (d_ra * d_ra + d_dec * d_dec) * RAD_TO_DEG;
+	m.pa = atan2 (d_ra, d_dec) * RAD_TO_DEG;
+	if (m.pa < 0)
+		m.pa += 360;
+}
+
+static bool sortSeparation (const SatMatch &m1, const SatMatch &m2)
+{
+	return m1.separation < m2.separation;
+}
+
+size_t SatCatalogue::query (double JD, double duration, double lng, double lat, double altitude, double ra, double dec, double radius, std::vector <SatMatch> &matches)
+{
+	matches.clear ();
+	if (sats.empty ())
+		return 0;
+
+	if (duration < 0)
+		duration = 0;
+	else if (duration > SAT_MAX_DURATION)
+		duration = SAT_MAX_DURATION;
+
+	QueryTask q;
+	q.catalogue = this;
+	q.sats = &sats;
+	q.maxSpeed = &maxSpeed;
+	q.JD = JD;
+	q.duration = duration;
+	q.lng = lng * DEG_TO_RAD;
+	lat_alt_to_parallax (lat * DEG_TO_RAD, altitude, &q.rho_cos_phi, &q.rho_sin_phi);
+	q.ra = ra * DEG_TO_RAD;
+	q.dec = dec * DEG_TO_RAD;
+	q.radius = radius * DEG_TO_RAD;
+
+	// search centre of date; epoch_of_date_to_j2000 is a linear correction, so reverse it
+	double ra_d = q.ra, dec_d = q.dec;
+	epoch_of_date_to_j2000 (JD, &ra_d, &dec_d);
+	ra_d = q.ra - (ra_d - q.ra);
+	dec_d = q.dec - (dec_d - q.dec);
+	q.centre[0] = cos (dec_d) * cos (ra_d);
+	q.centre[1] = cos (dec_d) * sin (ra_d);
+	q.centre[2] = sin (dec_d);
+
+	q.candidate.resize (sats.size (), 0);
+
+	// screen all buckets overlapping exposure
+	double JD_end = JD + duration / 86400.0;
+	long b_start = lround ((JD - BUCKET_EPOCH) / bucketStep);
+	long b_end = lround ((JD_end - BUCKET_EPOCH) / bucketStep);
+	size_t chunks = (sats.size () + SAT_CHUNK - 1) / SAT_CHUNK;
+
+	// long exposures are screened with every stride-th bucket, covering stride steps
+	long stride = (b_end - b_start) / MAX_QUERY_BUCKETS + 1;
+
+	for (long b = b_start; b <= b_end; b += stride)
+	{
+		Bucket *bucket = getBucket (b);
+		q.pos = &(bucket->pos[0]);
+		q.bucketJD = bucket->JD;
+		// maximal time from bucket to part of exposure covered by bucket
+		double from = std::max (JD, bucket->JD - bucketStep / 2);
+		double to = std::min (JD_end, bucket->JD + (stride - 0.5) * bucketStep);
+		q.bucketDt = std::max (fabs (from - bucket->JD), fabs (to - bucket->JD)) * 86400.0;
+		observer_cartesian_coords (bucket->JD, q.lng, q.rho_cos_phi, q.rho_sin_phi, q.observerLoc);
+
+		pool->parallelFor (chunks, screenBucket, &q);
+	}
+
+	for (size_t s = 0; s < sats.size (); s++)
+	{
+		if (q.candidate[s])
+			q.candidates.push_back (s);
+	}
+
+	q.matches.resize (q.candidates.size ());
+	pool->parallelFor (q.candidates.size (), refine, &q);
+
+	for (std::vector <SatMatch>::iterator iter = q.matches.begin (); iter != q.matches.end (); iter++)
+	{
+		if (!isnan (iter->separation))
+			matches.push_back (*iter);
+	}
+	std::sort (matches.begin (), matches.end (), sortSeparation);
+
+	return q.candidates.size ();
+}
@@ -0,0 +1,341 @@
+/*
+ * Satellite propagator with cached model state.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "pluto/satprop.h"
+#include "pluto/observe.h"
+
+#include <math.h>
+
+#define PI          3.141592653589793238462643383279
+#define RAD_TO_DEG  (180.0 / PI)
+#define DEG_TO_RAD  (PI / 180.0)
+
+// altitudes are sampled in chunks of that size
+#define SCAN_CHUNK  256
+
+// refine crossings and culminations to about 1 second
+#define RST_PRECISION  (1.0 / 86400.0)
+
+using namespace rts2sat;
+
+SatPropagator::SatPropagator ()
+{
+	ephem = -1;
+	setObserver (0, 0, 0);
+}
+
+int SatPropagator::setTLE (const char *tle1, const char *tle2)
+{
+	ephem = -1;
+	int ret = parse_elements (tle1, tle2, &tle);
+	if (ret < 0)
+		return -1;
+
+	if (select_ephemeris (&tle))
+	{
+		ephem = 3;
+		SDP4_init (sat_params, &tle);
+	}
+	else
+	{
+		ephem = 1;
+		SGP4_init (sat_params, &tle);
+	}
+	return ret;
+}
+
+double SatPropagator::getPeriod () const
+{
+	// xno is mean motion in radians per minute
+	return 2 * PI / tle.xno;
+}
+
+void SatPropagator::setObserver (double lng, double lat, double altitude)
+{
+	obs_lng = lng * DEG_TO_RAD;
+	lat_alt_to_parallax (lat * DEG_TO_RAD, altitude, &rho_cos_phi, &rho_sin_phi);
+	sin_lat = sin (lat * DEG_TO_RAD);
+	cos_lat = cos (lat * DEG_TO_RAD);
+}
+
+int SatPropagator::propagate (double JD, double *sat_pos)
+{
+	double t_since = (JD - tle.epoch) * 1440.;
+	int ret;
+	switch (ephem)
+	{
+		case 1:
+			ret = SGP4 (t_since, &tle, sat_params, sat_pos, NULL);
+			break;
+		case 3:
+			ret = SDP4 (t_since, &tle, sat_params, sat_pos, NULL);
+			break;
+		default:
+			return SXPX_ERR_NEARLY_PARABOLIC;
+	}
+	// warnings still produce reasonable position
+	if (ret == SXPX_WARN_ORBIT_WITHIN_EARTH || ret == SXPX_WARN_PERIGEE_WITHIN_EARTH)
+		return 0;
+	return ret;
+}
+
+int SatPropagator::topocentric (double JD, double *vect, double *dist, double *alt)
+{
+	double sat_pos[3];
+	double observer_loc[3];
+
+	int ret = propagate (JD, sat_pos);
+	if (ret)
+		return ret;
+
+	observer_cartesian_coords (JD, obs_lng, rho_cos_phi, rho_sin_phi, observer_loc);
+
+	*dist = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		vect[i] = sat_pos[i] - observer_loc[i];
+		*dist += vect[i] * vect[i];
+	}
+	*dist = sqrt (*dist);
+
+	if (alt != NULL)
+	{
+		// local sidereal time is the direction of the observer's equatorial projection
+		double lst = atan2 (observer_loc[1], observer_loc[0]);
+		double zen = cos_lat * (cos (lst) * vect[0] + sin (lst) * vect[1]) + sin_lat * vect[2];
+		*alt = asin (zen / *dist) * RAD_TO_DEG;
+	}
+	return 0;
+}
+
+int SatPropagator::getPosition (double JD, double *ra, double *dec, double *dist, double *alt)
+{
+	double vect[3];
+	double d;
+
+	int ret = topocentric (JD, vect, &d, alt);
+	if (ret)
+		return ret;
+
+	*ra = atan2 (vect[1], vect[0]) * RAD_TO_DEG;
+	if (*ra < 0)
+		*ra += 360;
+	*dec = asin (vect[2] / d) * RAD_TO_DEG;
+	if (dist != NULL)
+		*dist = d;
+	return 0;
+}
+
+size_t SatPropagator::getPositions (const double *JD, size_t n, double *ra, double *dec, double *dist, double *alt)
+{
+	size_t failed = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		if (getPosition (JD[i], ra + i, dec + i, dist ? dist + i : NULL, alt ? alt + i : NULL))
+		{
+			ra[i] = dec[i] = NAN;
+			if (dist)
+				dist[i] = NAN;
+			if (alt)
+				alt[i] = NAN;
+			failed++;
+		}
+	}
+	return failed;
+}
+
+double SatPropagator::getAltitude (double JD)
+{
+	double vect[3];
+	double d, alt;
+	if (topocentric (JD, vect, &d, &alt))
+		return NAN;
+	return alt;
+}
+
+void SatPropagator::getAltitudes (const double *JD, size_t n, double *alt)
+{
+	double vect[3];
+	double d;
+	for (size_t i = 0; i < n; i++)
+	{
+		if (topocentric (JD[i], vect, &d, alt + i))
+			alt[i] = NAN;
+	}
+}
+
+double SatPropagator::findCrossing (double t1, double a1, double t2, double a2, double horizon)
+{
+	// Illinois variant of regula falsi
+	double f1 = a1 - horizon;
+	double f2 = a2 - horizon;
+	int side = 0;
+	for (int i = 0; i < 50 && (t2 - t1) > RST_PRECISION; i++)
+	{
+		double t = (t1 * f2 - t2 * f1) / (f2 - f1);
+		double f = getAltitude (t);
+		if (isnan (f))
+			return t;
+		f -= horizon;
+		if ((f > 0) == (f2 > 0))
+		{
+			t2 = t;
+			f2 = f;
+			if (side == -1)
+				f1 /= 2;
+			side = -1;
+		}
+		else if ((f > 0) == (f1 > 0))
+		{
+			t1 = t;
+			f1 = f;
+			if (side == 1)
+				f2 /= 2;
+			side = 1;
+		}
+		else
+		{
+			return t;
+		}
+		if (fabs (f) < 1e-4)
+			return t;
+	}
+	return (t1 * f2 - t2 * f1) / (f2 - f1);
+}
+
+double SatPropagator::findCulmination (double t1, double t2)
+{
+	// golden section search for maximum
+	const double gr = (sqrt (5.0) - 1) / 2;
+	double c = t2 - gr * (t2 - t1);
+	double d = t1 + gr * (t2 - t1);
+	double fc = getAltitude (c);
+	double fd = getAltitude (d);
+	while ((t2 - t1) > RST_PRECISION)
+	{
+		if (fc > fd)
+		{
+			t2 = d;
+			d = c;
+			fd = fc;
+			c = t2 - gr * (t2 - t1);
+			fc = getAltitude (c);
+		}
+		else
+		{
+			t1 = c;
+			c = d;
+			fc = fd;
+			d = t1 + gr * (t2 - t1);
+			fd = getAltitude (d);
+		}
+	}
+	return (t1 + t2) / 2;
+}
+
+int SatPropagator::getRST (double JD, double horizon, double &rise, double &transit, double &set, double length)
+{
+	rise = transit = set = NAN;
+	if (ephem < 0)
+		return -1;
+
+	// sample roughly 90 times per orbit, but not more often than 30 seconds
+	// and not less often than 10 minutes
+	double step = getPeriod () / 90.0;
+	if (step < 0.5)
+		step = 0.5;
+	else if (step > 10)
+		step = 10;
+	step /= 1440.0;
+
+	double t[SCAN_CHUNK];
+	double alt[SCAN_CHUNK];
+
+	// object was bellow horizon at some sample
+	bool bellow = false;
+	// previous two samples
+	double t_pp = NAN, a_pp = NAN;
+	double t_p = NAN, a_p = NAN;
+
+	size_t samples = (size_t) ceil (length / step) + 1;
+
+	for (size_t s = 0; s < samples; s += SCAN_CHUNK)
+	{
+		size_t n = samples - s;
+		if (n > SCAN_CHUNK)
+			n = SCAN_CHUNK;
+		for (size_t i = 0; i < n; i++)
+			t[i] = JD + (s + i) * step;
+		getAltitudes (t, n, alt);
+
+		for (size_t i = 0; i < n; i++)
+		{
+			// treat failed propagation as bellow horizon
+			double a = isnan (alt[i]) ? -90 : alt[i];
+			if (a <= horizon)
+				bellow = true;
+			if (isnan (a_p))
+			{
+				// pass in progress
+				if (a > horizon)
+					rise = JD;
+			}
+			else if (isnan (rise))
+			{
+				if (a_p <= horizon && a > horizon)
+					rise = findCrossing (t_p, a_p, t[i], a, horizon);
+			}
+			else
+			{
+				if (isnan (transit) && !isnan (a_pp) && a_p > horizon && a_p >= a_pp && a_p > a)
+					transit = findCulmination (t_pp, t[i]);
+				if (a_p > horizon && a <= horizon)
+				{
+					set = findCrossing (t_p, a_p, t[i], a, horizon);
+					// pass started before JD, after its culmination
+					if (isnan (transit))
+						transit = findPastCulmination (JD, step);
+					return 0;
+				}
+			}
+			t_pp = t_p;
+			a_pp = a_p;
+			t_p = t[i];
+			a_p = a;
+		}
+	}
+
+	rise = transit = set = NAN;
+	return bellow ? -1 : 1;
+}
+
+double SatPropagator::findPastCulmination (double JD, double step)
+{
+	// walk back while altitude increases, for at most about half of the orbit
+	double a_c = getAltitude (JD);
+	for (int i = 1; i < 45; i++)
+	{
+		double t = JD - i * step;
+		double a = getAltitude (t);
+		if (isnan (a) || a < a_c)
+			return findCulmination (t, t + 2 * step);
+		a_c = a;
+	}
+	return JD - 44 * step;
+}
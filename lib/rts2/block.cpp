@@ -37,6 +37,10 @@
 #include "command.h"
 #include "client.h"
 
+#ifdef RTS2_HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
 #include "imghdr.h"
 #include "centralstate.h"
 
@@ -51,6 +55,9 @@ const char *type_names[] =
 //* Size of pollfd descriptors allocated
 #define POLLS_SIZE    200
 
+//* Maximal number of events returned from single epoll_wait call
+#define EPOLL_EVENTS  256
+
 using namespace rts2core;
 
 Block::Block (int in_argc, char **in_argv):App (in_argc, in_argv)
@@ -61,6 +68,17 @@ Block::Block (int in_argc, char **in_argv):App (in_argc, in_argv)
 	fds = new struct pollfd[pollsize];
 	npolls = 0;
 
+	pollGeneration = 1;
+
+	useEpoll = false;
+	epollfd = -1;
+	epollTag = 0;
+
+	writeQueued = 0;
+	writeDropped = 0;
+	writeStall = 0;
+	writeBufferLimit = WRITEBUFFER_LIMIT;
+
 	signal (SIGPIPE, SIG_IGN);
 
 	masterState = SERVERD_HARD_OFF;
@@ -91,6 +109,8 @@ Block::~Block (void)
 	for (std::list <ConnUser *>::iterator iu = blockUsers.begin (); iu != blockUsers.end (); iu++)
 		delete *iu;
 	delete[] fds;
+	if (epollfd >= 0)
+		close (epollfd);
 	blockUsers.clear ();
 }
 
@@ -108,6 +128,10 @@ void Block::addPollSocks ()
 {
 	connections_t::iterator iter;
 	npolls = 0;
+	pollGeneration++;
+	// generation 0 marks descriptors which were never added
+	if (pollGeneration == 0)
+		pollGeneration = 1;
 	for (iter = connections.begin (); iter != connections.end (); iter++)
 		(*iter)->add (this);
 	for (iter = centraldConns.begin (); iter != centraldConns.end (); iter++)
@@ -407,8 +431,15 @@ void Block::oneRunLoop ()
 	}
 
 	addPollSocks ();
-	if (ppoll (fds, npolls, &read_tout, NULL) > 0)
+	if (useEpoll)
+	{
+		if (epollWait (&read_tout) > 0)
+			pollSuccess ();
+	}
+	else if (ppoll (fds, npolls, &read_tout, NULL) > 0)
+	{
 		pollSuccess ();
+	}
 	ret = idle ();
 	if (ret == -1)
 		endRunLoop ();
@@ -504,30 +535,204 @@ std::map <Connection *, std::vector <Value *> > Block::failedValues ()
 
 void Block::addPollFD (int fd, short events)
 {
-	if (npolls == pollsize)
+	if (fd < 0)
+		return;
+	if ((size_t) fd >= pollRegs.size ())
+	{
+		PollRegistration empty = {0, 0, 0, 0};
+		pollRegs.resize (fd + POLLS_SIZE, empty);
+	}
+	PollRegistration &reg = pollRegs[fd];
+	// descriptor was already added in this run - merge events
+	if (reg.generation == pollGeneration)
+	{
+		fds[reg.slot].events |= events;
+		events = fds[reg.slot].events;
+	}
+	else
+	{
+		if (npolls == pollsize)
+		{
+			struct pollfd *npollfds;
+			pollsize = npolls + POLLS_SIZE;
+			npollfds = new struct pollfd[pollsize];
+			memcpy ((void *) npollfds, (void *) fds, sizeof (struct pollfd) * npolls);
+			delete[] fds;
+			fds = npollfds;
+		}
+		fds[npolls].fd = fd;
+		fds[npolls].events = events;
+		fds[npolls].revents = 0;
+		reg.generation = pollGeneration;
+		reg.slot = npolls;
+		npolls++;
+	}
+
+#ifdef RTS2_HAVE_SYS_EPOLL_H
+	if (epollfd < 0 || (reg.tag != 0 && reg.events == events))
+		return;
+
+	struct epoll_event ev;
+	ev.events = events;
+	if (reg.tag == 0)
+	{
+		epollTag++;
+		if (epollTag == 0)
+			epollTag = 1;
+		ev.data.u64 = ((uint64_t) epollTag << 32) | (uint32_t) fd;
+		if (epoll_ctl (epollfd, EPOLL_CTL_ADD, fd, &ev) == 0)
+		{
+			reg.tag = epollTag;
+			reg.events = events;
+			epollFds.push_back (fd);
+			return;
+		}
+		// descriptor was registered by someone else, but its registration was not removed
+		if (errno != EEXIST)
+		{
+			logStream (MESSAGE_ERROR) << "cannot add descriptor " << fd << " to epoll: " << strerror (errno) << sendLog;
+			return;
+		}
+		reg.tag = epollTag;
+		epollFds.push_back (fd);
+	}
+	ev.data.u64 = ((uint64_t) reg.tag << 32) | (uint32_t) fd;
+	if (epoll_ctl (epollfd, EPOLL_CTL_MOD, fd, &ev))
+	{
+		// descriptor was closed without removePollFD and its number reused,
+		// kernel dropped the old registration
+		if (errno != ENOENT || epoll_ctl (epollfd, EPOLL_CTL_ADD, fd, &ev))
+		{
+			logStream (MESSAGE_ERROR) << "cannot modify epoll events of descriptor " << fd << ": " << strerror (errno) << sendLog;
+			return;
+		}
+	}
+	reg.events = events;
+#endif
+}
+
+void Block::removePollFD (int fd)
+{
+	if (fd < 0 || (size_t) fd >= pollRegs.size ())
+		return;
+	PollRegistration &reg = pollRegs[fd];
+	if (reg.generation == pollGeneration)
+		fds[reg.slot].revents = 0;
+	reg.generation = 0;
+#ifdef RTS2_HAVE_SYS_EPOLL_H
+	if (reg.tag != 0)
 	{
-		struct pollfd *npollfds;
-		npollfds = new struct pollfd[npolls + POLLS_SIZE];
-		memcpy ((void *) npollfds, (void *) fds, sizeof (struct pollfd) * npolls);
-		delete[] fds;
-		fds = npollfds;
+		epoll_ctl (epollfd, EPOLL_CTL_DEL, fd, NULL);
+		reg.tag = 0;
+		// epollFds entry will be removed in next epollSync call
 	}
-	fds[npolls].fd = fd;
-	fds[npolls].events = events;
-	fds[npolls].revents = 0;
-	npolls++;
+#endif
 }
 
 short Block::getPollEvents (int fd)
 {
-	for (nfds_t i = 0; i < npolls; i++)
+	if (fd < 0 || (size_t) fd >= pollRegs.size () || pollRegs[fd].generation != pollGeneration)
+		return 0;
+	return fds[pollRegs[fd].slot].revents;
+}
+
+int Block::setUseEpoll (bool use)
+{
+#ifdef RTS2_HAVE_SYS_EPOLL_H
+	useEpoll = use;
+	return 0;
+#else
+	if (use)
 	{
-		if (fds[i].fd == fd)
-			return fds[i].revents;
+		logStream (MESSAGE_ERROR) << "epoll is not available on this system, ppoll will be used" << sendLog;
+		return -1;
 	}
+	useEpoll = false;
 	return 0;
+#endif
+}
+
+#ifdef RTS2_HAVE_SYS_EPOLL_H
+
+void Block::epollSync ()
+{
+	for (std::vector <int>::iterator iter = epollFds.begin (); iter != epollFds.end ();)
+	{
+		PollRegistration &reg = pollRegs[*iter];
+		if (reg.tag == 0)
+		{
+			iter = epollFds.erase (iter);
+		}
+		else if (reg.generation != pollGeneration)
+		{
+			// if descriptor was already closed, kernel removed it
+			epoll_ctl (epollfd, EPOLL_CTL_DEL, *iter, NULL);
+			reg.tag = 0;
+			iter = epollFds.erase (iter);
+		}
+		else
+		{
+			iter++;
+		}
+	}
+}
+
+int Block::epollWait (const struct timespec *tout)
+{
+	if (epollfd < 0)
+	{
+		epollfd = epoll_create1 (EPOLL_CLOEXEC);
+		if (epollfd < 0)
+		{
+			logStream (MESSAGE_ERROR) << "cannot create epoll descriptor, reverting to ppoll: " << strerror (errno) << sendLog;
+			useEpoll = false;
+			return ppoll (fds, npolls, tout, NULL);
+		}
+		// register descriptors collected in this run
+		for (nfds_t i = 0; i < npolls; i++)
+			addPollFD (fds[i].fd, fds[i].events);
+	}
+
+	epollSync ();
+
+	// round timeout up, so the loop does not spin before timer expires
+	int tout_ms = tout->tv_sec * 1000 + (tout->tv_nsec + 999999) / 1000000;
+
+	struct epoll_event events[EPOLL_EVENTS];
+	int ret = epoll_wait (epollfd, events, EPOLL_EVENTS, tout_ms);
+	if (ret <= 0)
+		return ret;
+
+	int active = 0;
+	for (int i = 0; i < ret; i++)
+	{
+		int fd = events[i].data.u64 & 0xffffffff;
+		uint32_t tag = events[i].data.u64 >> 32;
+		if ((size_t) fd >= pollRegs.size ())
+			continue;
+		PollRegistration &reg = pollRegs[fd];
+		// ignore events from stale registrations
+		if (reg.tag != tag || reg.generation != pollGeneration)
+			continue;
+		fds[reg.slot].revents = events[i].events;
+		active++;
+	}
+	return active;
+}
+
+#else
+
+void Block::epollSync ()
+{
 }
 
+int Block::epollWait (const struct timespec *tout)
+{
+	return ppoll (fds, npolls, tout, NULL);
+}
+
+#endif
+
 bool Block::centralServerInState (rts2_status_t state)
 {
 	for (connections_t::iterator iter = centraldConns.begin (); iter != centraldConns.end (); iter++)
@@ -27,6 +27,8 @@
 #include <fcntl.h>
 #include <time.h>
 #include <errno.h>
+#include <unistd.h>
+#include <algorithm>
 #include <iomanip>
 
 #include "camd.h"
@@ -165,8 +167,6 @@ long Camera::isExposing ()
 
 int Camera::endExposure (int ret)
 {
-	if (modeCount)
-		memset (modeCount, 0, modeCountSize * sizeof (uint32_t));
 	if (exposureConn)
 	{
 		logStream (MESSAGE_INFO) << "end exposure for " << exposureConn->getName () << sendLog;
@@ -226,6 +226,14 @@ int Camera::deleteConnection (rts2core::Connection * conn)
 
 int Camera::endReadout ()
 {
+	// send data remaining in readout pipeline
+	publishPipeline (PIPELINE_WAIT_ALL);
+
+	sendValueAll (stageReadout);
+	sendValueAll (stageProcess);
+	sendValueAll (stageSend);
+	sendValueAll (stageWait);
+
 	// that will do anything only if the end was not marked
 	updateReadoutSpeed (readoutPixels);
 
@@ -327,6 +335,9 @@ void Camera::startImageData (rts2core::Connection * conn)
 
 int Camera::sendFirstLine (int chan, int pchan)
 {
+	// statistics of the previous image must be finished before they are reset
+	publishPipeline (PIPELINE_WAIT_ALL);
+
 	if (currentImageTransfer == SHARED)
 	{
 		focusingHeader = (struct imghdr*) (sharedData->getChannelData (chan));
@@ -358,6 +369,7 @@ int Camera::sendFirstLine (int chan, int pchan)
 	max->setValueDouble (-LONG_MAX);
 	min->setValueDouble (LONG_MAX);
 	computedPix->setValueLong (0);
+	imageStatistics.reset (calculateStatistics->getValueInteger () != STATISTIC_NOMODE);
 
 	switch (currentImageTransfer)
 	{
@@ -429,6 +441,26 @@ Camera::Camera (int in_argc, char **in_argv, rounding_t binning_rounding):rts2co
 	dataBuffers = NULL;
 	dataWritten = NULL;
 
+	pipelineRunning = false;
+	pthread_mutex_init (&pipelineMutex, NULL);
+	pthread_cond_init (&pipelineCond, NULL);
+	pthread_cond_init (&pipelineDoneCond, NULL);
+	pipelineNotify[0] = pipelineNotify[1] = -1;
+	pipelineBytes = 0;
+	pipelineInFlight = 0;
+	pipelinePending = NULL;
+	pipelinePendingTotal = 0;
+	pipelineError = false;
+	sendReadoutDuration = 0;
+
+	sepRunning = false;
+	pthread_mutex_init (&sepMutex, NULL);
+	pthread_cond_init (&sepCond, NULL);
+	sepNotify[0] = sepNotify[1] = -1;
+	sepQueued = NULL;
+	sepDone = NULL;
+	sepPool = NULL;
+
 	histories = 0;
 	comments = 0;
 
@@ -468,10 +500,7 @@ Camera::Camera (int in_argc, char **in_argv, rounding_t binning_rounding):rts2co
 	createValue (min, "min", "minimal pixel value", false);
 	createValue (sum, "sum", "sum of pixels readed out", false);
 	createValue (image_mode, "image_mode", "mode (most often pixel value)", false);
-
-	// mode histogram
-	modeCount = NULL;
-	modeCountSize = 0;
+	createValue (image_stdev, "image_stdev", "standard deviation of pixel values", false);
 
 	createValue (computedPix, "computed", "number of pixels so far computed", false);
 
@@ -485,6 +514,10 @@ Camera::Camera (int in_argc, char **in_argv, rounding_t binning_rounding):rts2co
 	createValue (sepX, "sep_X", "X positions of stars", false);
 	createValue (sepY, "sep_Y", "Y positions of stars", false);
 	createValue (sepFluxes, "sep_fluxes", "star fluxes", false);
+	createValue (sepThreads, "sep_threads", "number of threads used for SEP processing", false, RTS2_VALUE_WRITABLE);
+	long ncpu = sysconf (_SC_NPROCESSORS_ONLN);
+	sepThreads->setValueInteger (ncpu > 4 ? 4 : (ncpu < 1 ? 1 : ncpu));
+	createValue (sepDuration, "sep_duration", "[s] time spend on SEP processing of the last frame", false, RTS2_DT_TIMEINTERVAL);
 
 	sepFind->setValueBool (false);
 
@@ -550,6 +583,16 @@ Camera::Camera (int in_argc, char **in_argv, rounding_t binning_rounding):rts2co
 	createValue (readoutTime, "readout_time", "[s] data readout time", false, RTS2_DT_TIMEINTERVAL);
 	createValue (transferTime, "transfer_time", "[s] data transfer time, including overhead", false, RTS2_DT_TIMEINTERVAL);
 
+	createValue (readoutPipeline, "readout_pipeline", "calculate statistics and send data in parallel with readout", false, RTS2_VALUE_WRITABLE | RTS2_DT_ONOFF, CAM_WORKING);
+	readoutPipeline->setValueBool (false);
+	createValue (readoutPipelineSize, "readout_pipeline_size", "[bytes] maximal size of data waiting in readout pipeline", false, RTS2_VALUE_WRITABLE | RTS2_DT_BYTESIZE);
+	readoutPipelineSize->setValueLong (64 * 1024 * 1024);
+
+	createValue (stageReadout, "stage_readout", "[s] time spend reading data from the camera", false, RTS2_DT_TIMEINTERVAL);
+	createValue (stageProcess, "stage_process", "[s] time spend calculating statistics", false, RTS2_DT_TIMEINTERVAL);
+	createValue (stageSend, "stage_send", "[s] time spend sending data to client", false, RTS2_DT_TIMEINTERVAL);
+	createValue (stageWait, "stage_wait", "[s] time readout waited for free pipeline buffer", false, RTS2_DT_TIMEINTERVAL);
+
 	createValue (camFocVal, "focpos", "position of focuser", false, RTS2_VALUE_WRITABLE, CAM_EXPOSING);
 
 	camFilterVal = NULL;
@@ -592,10 +635,53 @@ Camera::~Camera ()
 	delete sharedData;
 	delete fhd;
 
+	if (pipelineRunning)
+	{
+		pthread_mutex_lock (&pipelineMutex);
+		pipelineRunning = false;
+		pthread_cond_signal (&pipelineCond);
+		pthread_mutex_unlock (&pipelineMutex);
+		pthread_join (pipelineThread, NULL);
+
+		close (pipelineNotify[0]);
+		close (pipelineNotify[1]);
+	}
+
+	pipelineFree.insert (pipelineFree.end (), pipelineQueue.begin (), pipelineQueue.end ());
+	pipelineFree.insert (pipelineFree.end (), pipelineDone.begin (), pipelineDone.end ());
+	for (std::list <ReadoutChunk *>::iterator iter = pipelineFree.begin (); iter != pipelineFree.end (); iter++)
+	{
+		delete[] (*iter)->data;
+		delete *iter;
+	}
+
+	pthread_cond_destroy (&pipelineDoneCond);
+	pthread_cond_destroy (&pipelineCond);
+	pthread_mutex_destroy (&pipelineMutex);
+
+	if (sepRunning)
+	{
+		pthread_mutex_lock (&sepMutex);
+		sepRunning = false;
+		pthread_cond_signal (&sepCond);
+		pthread_mutex_unlock (&sepMutex);
+		pthread_join (sepThread, NULL);
+
+		close (sepNotify[0]);
+		close (sepNotify[1]);
+	}
+
+	delete sepQueued;
+	delete sepDone;
+	for (std::list <SepFrame *>::iterator iter = sepFree.begin (); iter != sepFree.end (); iter++)
+		delete *iter;
+
+	pthread_cond_destroy (&sepCond);
+	pthread_mutex_destroy (&sepMutex);
+
 	delete[] dataBuffers;
 	delete[] dataWritten;
-	
-	delete[] modeCount;
+	delete[] pipelinePending;
 }
 
 int Camera::willConnect (rts2core::NetworkAddress * in_addr)
@@ -971,121 +1057,434 @@ int Camera::sendImage (char *data, size_t dataSize)
 int Camera::sendReadoutData (char *data, size_t dataSize, int chan)
 {
 	std::cerr << "Camera::sendReadoutData " << dataSize << " chan " << chan << " exposureConn " << exposureConn << std::endl;
-	// calculated..
-	if (calculateStatistics->getValueInteger () != STATISTIC_NO)
+	double t_start = getNow ();
+	int ret;
+
+	if (calculateStatistics->getValueInteger () == STATISTIC_ONLY)
+		calculateDataSize -= dataSize;
+
+	dataWritten[chan] += dataSize;
+
+	if (readoutPipeline->getValueBool () && startPipeline () == 0)
 	{
-		int totPix;
-		// update sum. min and max
-		switch (getDataType ())
+		ret = queueReadoutData (data, dataSize, chan);
+	}
+	else
+	{
+		ReadoutChunk chunk;
+		chunk.data = data;
+		fillChunk (&chunk, dataSize, chan);
+		processChunk (&chunk);
+		ret = publishChunk (&chunk);
+	}
+
+	sendReadoutDuration += getNow () - t_start;
+	return ret;
+}
+
+void Camera::fillChunk (ReadoutChunk *chunk, size_t dataSize, int chan)
+{
+	chunk->size = dataSize;
+	chunk->chan = chan;
+	chunk->dataType = getDataType ();
+	chunk->pixels = dataSize / usedPixelByteSize ();
+	chunk->statistics = calculateStatistics->getValueInteger () != STATISTIC_NO;
+	chunk->center = calculateCenter->getValueBool () && getCenterBox (chunk->cen) == 0;
+	chunk->processTime = 0;
+}
+
+void Camera::processChunk (ReadoutChunk *chunk)
+{
+	if (!(chunk->statistics || chunk->center))
+		return;
+
+	double t_start = getNow ();
+
+	if (chunk->statistics)
+	{
+		// update sum, min, max and mode
+		switch (chunk->dataType)
 		{
 			case RTS2_DATA_BYTE:
-				totPix = updateStatistics ((uint8_t *) data, dataSize);
+				imageStatistics.update ((uint8_t *) chunk->data, chunk->pixels);
 				break;
 			case RTS2_DATA_SHORT:
-				totPix = updateStatistics ((int16_t *) data, dataSize);
+				imageStatistics.update ((int16_t *) chunk->data, chunk->pixels);
 				break;
 			case RTS2_DATA_LONG:
-				totPix = updateStatistics ((int32_t *) data, dataSize);
+				imageStatistics.update ((int32_t *) chunk->data, chunk->pixels);
 				break;
 			case RTS2_DATA_LONGLONG:
-				totPix = updateStatistics ((int64_t *) data, dataSize);
+				imageStatistics.update ((int64_t *) chunk->data, chunk->pixels);
 				break;
 			case RTS2_DATA_FLOAT:
-				totPix = updateStatistics ((float *) data, dataSize);
+				imageStatistics.update ((float *) chunk->data, chunk->pixels);
 				break;
 			case RTS2_DATA_DOUBLE:
-				totPix = updateStatistics ((double *) data, dataSize);
+				imageStatistics.update ((double *) chunk->data, chunk->pixels);
 				break;
 			case RTS2_DATA_SBYTE:
-				totPix = updateStatistics ((int8_t *) data, dataSize);
+				imageStatistics.update ((int8_t *) chunk->data, chunk->pixels);
 				break;
 			case RTS2_DATA_USHORT:
-				totPix = updateStatistics ((uint16_t *) data, dataSize);
+				imageStatistics.update ((uint16_t *) chunk->data, chunk->pixels);
 				break;
 			case RTS2_DATA_ULONG:
-				totPix = updateStatistics ((uint32_t *) data, dataSize);
+				imageStatistics.update ((uint32_t *) chunk->data, chunk->pixels);
 				break;
 		}
-		computedPix->setValueLong (computedPix->getValueLong () + totPix);
-		average->setValueDouble (sum->getValueDouble () / computedPix->getValueLong ());
-
-		// find maximal mode value
-		if (modeCount != NULL)
-		{
-			uint32_t modeNum = 0;
-			for (unsigned int i = 0; i < modeCountSize; i++)
-			{
-				if (modeCount[i] > modeNum)
-				{
-					image_mode->setValueInteger (i);
-					modeNum = modeCount[i];
-				}
-			}
-			sendValueAll (image_mode);
-		}
-
-		sendValueAll (average);
-		sendValueAll (max);
-		sendValueAll (min);
-		sendValueAll (sum);
-		sendValueAll (computedPix);
-	}
-	else
-	{
-		computedPix->setValueLong (computedPix->getValueLong () + dataSize / usedPixelByteSize ());
-		sendValueAll (computedPix);
+		chunk->sum = imageStatistics.getSum ();
+		chunk->min = imageStatistics.getMin ();
+		chunk->max = imageStatistics.getMax ();
+		chunk->average = imageStatistics.getAverage ();
+		chunk->stdev = imageStatistics.getStDev ();
+		chunk->mode = imageStatistics.getMode ();
 	}
 
-	// will update only if some data still need to be transfered
-	updateReadoutSpeed (computedPix->getValueLong ());
-
-	if (calculateStatistics->getValueInteger () == STATISTIC_ONLY)
-		calculateDataSize -= dataSize;
-
-	if (calculateCenter->getValueBool ())
+	if (chunk->center)
 	{
-		switch (getDataType ())
+		switch (chunk->dataType)
 		{
 			case RTS2_DATA_BYTE:
-				updateCenter ((uint8_t *) data, dataSize);
+				computeCenter ((uint8_t *) chunk->data, chunk->cen);
 				break;
 			case RTS2_DATA_SHORT:
-				updateCenter ((int16_t *) data, dataSize);
+				computeCenter ((int16_t *) chunk->data, chunk->cen);
 				break;
 			case RTS2_DATA_LONG:
-				updateCenter ((int32_t *) data, dataSize);
+				computeCenter ((int32_t *) chunk->data, chunk->cen);
 				break;
 			case RTS2_DATA_LONGLONG:
-				updateCenter ((int64_t *) data, dataSize);
+				computeCenter ((int64_t *) chunk->data, chunk->cen);
 				break;
 			case RTS2_DATA_FLOAT:
-				updateCenter ((float *) data, dataSize);
+				computeCenter ((float *) chunk->data, chunk->cen);
 				break;
 			case RTS2_DATA_DOUBLE:
-				updateCenter ((double *) data, dataSize);
+				computeCenter ((double *) chunk->data, chunk->cen);
 				break;
 			case RTS2_DATA_SBYTE:
-				updateCenter ((int8_t *) data, dataSize);
+				computeCenter ((int8_t *) chunk->data, chunk->cen);
 				break;
 			case RTS2_DATA_USHORT:
-				updateCenter ((uint16_t *) data, dataSize);
+				computeCenter ((uint16_t *) chunk->data, chunk->cen);
 				break;
 			case RTS2_DATA_ULONG:
-				updateCenter ((uint32_t *) data, dataSize);
+				computeCenter ((uint32_t *) chunk->data, chunk->cen);
 				break;
 		}
 	}
 
+	chunk->processTime = getNow () - t_start;
+}
+
+int Camera::publishChunk (ReadoutChunk *chunk)
+{
+	double t_start = getNow ();
+
+	stageProcess->setValueDouble (stageProcess->getValueDouble () + chunk->processTime);
+
+	computedPix->setValueLong (computedPix->getValueLong () + chunk->pixels);
+
+	if (chunk->statistics)
+	{
+		sum->setValueDouble (chunk->sum);
+		min->setValueDouble (chunk->min);
+		max->setValueDouble (chunk->max);
+		average->setValueDouble (chunk->average);
+		image_stdev->setValueDouble (chunk->stdev);
+
+		if (calculateStatistics->getValueInteger () != STATISTIC_NOMODE)
+		{
+			image_mode->setValueDouble (chunk->mode);
+			sendValueAll (image_mode);
+		}
+
+		sendValueAll (average);
+		sendValueAll (max);
+		sendValueAll (min);
+		sendValueAll (sum);
+		sendValueAll (image_stdev);
+	}
+	sendValueAll (computedPix);
+
+	// will update only if some data still need to be transfered
+	updateReadoutSpeed (computedPix->getValueLong ());
+
+	if (chunk->center)
+		publishCenter (chunk->cen);
+
+	int ret = 0;
+
 	if (currentImageTransfer == SHARED)
-		sharedData->dataWritten (chan, dataSize);
-	
-	dataWritten[chan] += dataSize;
+		sharedData->dataWritten (chunk->chan, chunk->size);
 
 	if (exposureConn && currentImageTransfer == TCPIP)
-		return exposureConn->sendBinaryData (currentImageData, chan, data, dataSize);
+		ret = exposureConn->sendBinaryData (currentImageData, chunk->chan, chunk->data, chunk->size);
+
+	stageSend->setValueDouble (stageSend->getValueDouble () + getNow () - t_start);
+	return ret;
+}
+
+int Camera::getCenterBox (ReadoutCenter &cen)
+{
+	// check if box is inside window
+	int x = centerBox->getXInt ();
+	if (x < 0)
+		x = getUsedX ();
+	int y = centerBox->getYInt ();
+	if (y < 0)
+		y = getUsedY ();
+	int w = centerBox->getWidthInt () / binningHorizontal ();
+	if (w < 0)
+		w = (getUsedWidth () - (x - getUsedX ())) / binningHorizontal ();
+	int h = centerBox->getHeightInt () / binningVertical ();
+	if (h < 0)
+		h = (getUsedHeight () - (y - getUsedY ())) / binningVertical ();
+
+	x -= getUsedX ();
+	y -= getUsedY ();
+
+	if (x < 0 || y < 0 || (w + ceil ((double) x / binningHorizontal ())) > getUsedWidthBinned () || (h + ceil ((double) y / binningVertical ())) > getUsedHeightBinned ())
+		return -1;
+
+	cen.x = x;
+	cen.y = y;
+	cen.w = w;
+	cen.h = h;
+	cen.rowWidth = getUsedWidthBinned ();
+	cen.cutLevel = centerCutLevel->getValueDouble ();
 	return 0;
 }
 
+void Camera::publishCenter (ReadoutCenter &cen)
+{
+	sumsX->clear ();
+	for (std::vector <double>::iterator iter = cen.sumsX.begin (); iter != cen.sumsX.end (); iter++)
+		sumsX->addValue (*iter);
+
+	sumsY->clear ();
+	for (std::vector <double>::iterator iter = cen.sumsY.begin (); iter != cen.sumsY.end (); iter++)
+		sumsY->addValue (*iter);
+
+	sendValueAll (sumsX);
+	sendValueAll (sumsY);
+
+	centerX->setValueDouble (sumsX->calculateMedianIndex ());
+	centerY->setValueDouble (sumsY->calculateMedianIndex ());
+
+	centerMax->setValueDouble (cen.max);
+
+	centerStat->addValue (cen.max, centerSums->getValueInteger ());
+
+	if (cen.npix > 0)
+	{
+		centerAvg->setValueDouble (cen.avg / cen.npix);
+		centerAvgStat->addValue (cen.avg / cen.npix, centerSums->getValueInteger ());
+	}
+	else
+	{
+		centerAvg->setValueDouble (0);
+		centerAvgStat->addValue (0, centerSums->getValueInteger ());
+	}
+
+	sendValueAll (centerX);
+	sendValueAll (centerY);
+
+	sendValueAll (centerMax);
+
+	centerStat->calculate ();
+	sendValueAll (centerStat);
+
+	sendValueAll (centerAvg);
+	centerAvgStat->calculate ();
+	sendValueAll (centerAvgStat);
+}
+
+int Camera::startPipeline ()
+{
+	if (pipelineRunning)
+		return 0;
+	if (pipe (pipelineNotify))
+	{
+		logStream (MESSAGE_ERROR) << "cannot create readout pipeline notification pipe: " << strerror (errno) << sendLog;
+		return -1;
+	}
+	fcntl (pipelineNotify[0], F_SETFL, O_NONBLOCK);
+	fcntl (pipelineNotify[1], F_SETFL, O_NONBLOCK);
+
+	pipelineRunning = true;
+	int ret = pthread_create (&pipelineThread, NULL, pipelineWorker, this);
+	if (ret)
+	{
+		logStream (MESSAGE_ERROR) << "cannot start readout pipeline thread: " << strerror (ret) << sendLog;
+		pipelineRunning = false;
+		close (pipelineNotify[0]);
+		close (pipelineNotify[1]);
+		pipelineNotify[0] = pipelineNotify[1] = -1;
+		return -1;
+	}
+	return 0;
+}
+
+int Camera::queueReadoutData (char *data, size_t dataSize, int chan)
+{
+	ReadoutChunk *chunk = getPipelineChunk (dataSize);
+	memcpy (chunk->data, data, dataSize);
+	fillChunk (chunk, dataSize, chan);
+
+	pipelinePending[chan] += dataSize;
+	pipelinePendingTotal += dataSize;
+	pipelineInFlight++;
+
+	pthread_mutex_lock (&pipelineMutex);
+	pipelineQueue.push_back (chunk);
+	pthread_cond_signal (&pipelineCond);
+	pthread_mutex_unlock (&pipelineMutex);
+
+	// report errors from sending previous chunks
+	if (pipelineError)
+	{
+		pipelineError = false;
+		return -1;
+	}
+	return 0;
+}
+
+ReadoutChunk *Camera::getPipelineChunk (size_t size)
+{
+	double t_start = getNow ();
+	size_t limit = readoutPipelineSize->getValueLong ();
+	ReadoutChunk *ret = NULL;
+	while (ret == NULL)
+	{
+		for (std::list <ReadoutChunk *>::iterator iter = pipelineFree.begin (); iter != pipelineFree.end (); iter++)
+		{
+			if ((*iter)->capacity >= size)
+			{
+				ret = *iter;
+				pipelineFree.erase (iter);
+				break;
+			}
+		}
+		if (ret)
+			break;
+		// free chunks are too small, release them if they block allocation of the new chunk
+		if (pipelineBytes + size > limit && !pipelineFree.empty ())
+		{
+			pipelineBytes -= pipelineFree.front ()->capacity;
+			delete[] pipelineFree.front ()->data;
+			delete pipelineFree.front ();
+			pipelineFree.pop_front ();
+			continue;
+		}
+		// allocate new chunk; single chunk can be larger than the limit
+		if (pipelineBytes + size <= limit || pipelineInFlight == 0)
+		{
+			ret = new ReadoutChunk;
+			ret->data = new char[size];
+			ret->capacity = size;
+			pipelineBytes += size;
+			break;
+		}
+		// wait for chunk to be processed and send
+		if (publishPipeline (PIPELINE_WAIT_ONE))
+			pipelineError = true;
+	}
+	stageWait->setValueDouble (stageWait->getValueDouble () + getNow () - t_start);
+	return ret;
+}
+
+int Camera::publishPipeline (int wait)
+{
+	int ret = 0;
+	int published = 0;
+	pthread_mutex_lock (&pipelineMutex);
+	while (pipelineInFlight > 0)
+	{
+		if (pipelineDone.empty ())
+		{
+			if (wait == PIPELINE_NOWAIT || (wait == PIPELINE_WAIT_ONE && published > 0))
+				break;
+			pthread_cond_wait (&pipelineDoneCond, &pipelineMutex);
+			continue;
+		}
+		ReadoutChunk *chunk = pipelineDone.front ();
+		pipelineDone.pop_front ();
+		pthread_mutex_unlock (&pipelineMutex);
+
+		pipelinePending[chunk->chan] -= chunk->size;
+		pipelinePendingTotal -= chunk->size;
+		pipelineInFlight--;
+		published++;
+
+		if (publishChunk (chunk))
+			ret = -1;
+
+		pipelineFree.push_back (chunk);
+		pthread_mutex_lock (&pipelineMutex);
+	}
+	pthread_mutex_unlock (&pipelineMutex);
+	return ret;
+}
+
+void *Camera::pipelineWorker (void *arg)
+{
+	Camera *cam = (Camera *) arg;
+	pthread_mutex_lock (&cam->pipelineMutex);
+	while (true)
+	{
+		while (cam->pipelineQueue.empty () && cam->pipelineRunning)
+			pthread_cond_wait (&cam->pipelineCond, &cam->pipelineMutex);
+		if (!cam->pipelineRunning)
+			break;
+		ReadoutChunk *chunk = cam->pipelineQueue.front ();
+		cam->pipelineQueue.pop_front ();
+		pthread_mutex_unlock (&cam->pipelineMutex);
+
+		cam->processChunk (chunk);
+
+		pthread_mutex_lock (&cam->pipelineMutex);
+		cam->pipelineDone.push_back (chunk);
+		pthread_cond_signal (&cam->pipelineDoneCond);
+		// wake up main loop, which will send the chunk
+		char c = 0;
+		if (write (cam->pipelineNotify[1], &c, 1) < 0 && errno != EAGAIN)
+			break;
+	}
+	pthread_mutex_unlock (&cam->pipelineMutex);
+	return NULL;
+}
+
+void Camera::addPollSocks ()
+{
+	rts2core::ScriptDevice::addPollSocks ();
+	if (pipelineNotify[0] >= 0)
+		addPollFD (pipelineNotify[0], POLLIN);
+	if (sepNotify[0] >= 0)
+		addPollFD (sepNotify[0], POLLIN);
+}
+
+void Camera::pollSuccess ()
+{
+	if (pipelineNotify[0] >= 0 && isForRead (pipelineNotify[0]))
+	{
+		char buf[100];
+		while (read (pipelineNotify[0], buf, sizeof (buf)) > 0)
+			;
+		if (publishPipeline (PIPELINE_NOWAIT))
+			pipelineError = true;
+	}
+	if (sepNotify[0] >= 0 && isForRead (sepNotify[0]))
+	{
+		char buf[100];
+		while (read (sepNotify[0], buf, sizeof (buf)) > 0)
+			;
+		publishSep ();
+	}
+	rts2core::ScriptDevice::pollSuccess ();
+}
+
 void Camera::addBinning2D (int bin_v, int bin_h)
 {
 	Binning2D *bin = new Binning2D (bin_v, bin_h);
@@ -1269,6 +1668,9 @@ int Camera::initValues ()
 	dataWritten = new size_t[getNumChannels ()];
 	memset (dataWritten, 0, getNumChannels () * sizeof (size_t));
 
+	pipelinePending = new size_t[getNumChannels ()];
+	memset (pipelinePending, 0, getNumChannels () * sizeof (size_t));
+
 	return rts2core::ScriptDevice::initValues ();
 }
 
@@ -1372,7 +1774,11 @@ void Camera::checkReadouts ()
 	int ret;
 	if ((getStateChip (0) & CAM_MASK_READING) != CAM_READING)
 		return;
+	double t_start = getNow ();
+	sendReadoutDuration = 0;
 	ret = doReadout ();
+	// time spend in sendReadoutData is accounted in other stages
+	stageReadout->setValueDouble (stageReadout->getValueDouble () + getNow () - t_start - sendReadoutDuration);
 	if (ret >= 0)
 	{
 		setTimeout (ret);
@@ -1439,6 +1845,15 @@ int Camera::setValue (rts2core::Value * old_value, rts2core::Value * new_value)
 		setExposure (new_value->getValueDouble ());
 		return 0;
 	}
+	if (old_value == sepThreads)
+	{
+		if (new_value->getValueInteger () < 1)
+		{
+			logStream (MESSAGE_ERROR) << "number of SEP threads must be at least 1, " << new_value->getValueInteger () << " was requested" << sendLog;
+			return -2;
+		}
+		return 0;
+	}
 	return rts2core::ScriptDevice::setValue (old_value, new_value);
 }
 
@@ -1558,60 +1973,307 @@ void Camera::findSepStars (uint16_t *data)
 	if (sepFind->getValueBool () == false)
 		return;
 
-	sepX->clear ();
-	sepY->clear ();
-	sepFluxes->clear ();
+	if (startSep ())
+		return;
 
-	sep_image im = {data, NULL, NULL, SEP_TUINT16, 0, 0, getUsedWidthBinned (), getUsedHeightBinned (), 0.0, SEP_NOISE_NONE, 1.0, 0.0};
-	sep_bkg *bkg = NULL;
-	int status = sep_background (&im, 64, 64, 3, 3, 0.0, &bkg);
-	if (status)
+	pthread_mutex_lock (&sepMutex);
+	SepFrame *frame;
+	if (sepFree.empty ())
 	{
-		logStream (MESSAGE_ERROR) << "SEP: unable to estimate background:" << status << sendLog;
-		return;
+		frame = new SepFrame ();
 	}
+	else
+	{
+		frame = sepFree.front ();
+		sepFree.pop_front ();
+	}
+	pthread_mutex_unlock (&sepMutex);
+
+	frame->w = getUsedWidthBinned ();
+	frame->h = getUsedHeightBinned ();
+	frame->threads = sepThreads->getValueInteger ();
+	frame->raw.assign (data, data + frame->w * frame->h);
 
-	uint16_t *imback = (uint16_t *) malloc (getUsedWidthBinned () * getUsedHeightBinned () * sizeof (uint16_t));
-	status = sep_bkg_array (bkg, imback, SEP_TUINT16);
-	if (status)
+	pthread_mutex_lock (&sepMutex);
+	// SEP thread is still busy with older frame, drop frame waiting for processing
+	if (sepQueued)
 	{
-		logStream (MESSAGE_ERROR) << "SEP: cannot construct background array:" << status << sendLog;
-		return;
+		sepFree.push_back (sepQueued);
+		logStream (MESSAGE_DEBUG) << "SEP is busy, skipping older frame" << sendLog;
 	}
+	sepQueued = frame;
+	pthread_cond_signal (&sepCond);
+	pthread_mutex_unlock (&sepMutex);
+}
 
-	status = sep_bkg_subarray (bkg, im.data, im.dtype);
-	if (status)
+int Camera::startSep ()
+{
+	if (sepRunning)
+		return 0;
+	if (pipe (sepNotify))
 	{
-		logStream (MESSAGE_ERROR) << "SEP: cannot subtract background:" << status << sendLog;
-		return;
+		logStream (MESSAGE_ERROR) << "cannot create SEP notification pipe: " << strerror (errno) << sendLog;
+		return -1;
 	}
+	fcntl (sepNotify[0], F_SETFL, O_NONBLOCK);
+	fcntl (sepNotify[1], F_SETFL, O_NONBLOCK);
 
-	float conv[] = {1,2,1, 2,4,2, 1,2,1};
-	sep_catalog *catalog = NULL;
+	sepRunning = true;
+	int ret = pthread_create (&sepThread, NULL, sepWorker, this);
+	if (ret)
+	{
+		logStream (MESSAGE_ERROR) << "cannot start SEP thread: " << strerror (ret) << sendLog;
+		sepRunning = false;
+		close (sepNotify[0]);
+		close (sepNotify[1]);
+		sepNotify[0] = sepNotify[1] = -1;
+		return -1;
+	}
+	return 0;
+}
+
+// background mesh size
+#define SEP_MESH             64
+// number of mesh rows added above and below background strip, so median filter of the strip meshes sees the same neighbours as for the full frame
+#define SEP_STRIP_OVERLAP    2
+// number of objects processed in single aperture task
+#define SEP_APERTURE_BLOCK   64
+
+/**
+ * Frame is divided to horizontal strips of background meshes, which are
+ * processed in parallel.
+ */
+struct SepStrips
+{
+	SepFrame *frame;
+	int ny;
+	int meshRows;
+	std::vector <sep_bkg *> bkg;
+	std::vector <int> status;
+
+	// first and last (exclusive) mesh rows of strip, without overlap
+	int coreStart (size_t i) { return i * meshRows; }
+	int coreEnd (size_t i) { return std::min ((int) (i + 1) * meshRows, ny); }
+	// first and last (exclusive) mesh rows, including overlap
+	int extStart (size_t i) { return std::max (coreStart (i) - SEP_STRIP_OVERLAP, 0); }
+	int extEnd (size_t i) { return std::min (coreEnd (i) + SEP_STRIP_OVERLAP, ny); }
+	// pixel row
+	int row (int mesh) { return std::min (mesh * SEP_MESH, frame->h); }
+};
+
+static void sepConvert (void *arg, size_t i)
+{
+	SepStrips *strips = (SepStrips *) arg;
+	SepFrame *frame = strips->frame;
+	size_t start = (size_t) strips->row (strips->coreStart (i)) * frame->w;
+	size_t end = (size_t) strips->row (strips->coreEnd (i)) * frame->w;
+	for (size_t p = start; p < end; p++)
+		frame->image[p] = frame->raw[p];
+}
 
-	im.noise = &(bkg->globalrms);  /* set image noise level */
+static void sepBackground (void *arg, size_t i)
+{
+	SepStrips *strips = (SepStrips *) arg;
+	SepFrame *frame = strips->frame;
+	int y0 = strips->row (strips->extStart (i));
+	int y1 = strips->row (strips->extEnd (i));
+	sep_image im = {&(frame->image[(size_t) y0 * frame->w]), NULL, NULL, SEP_TFLOAT, 0, 0, frame->w, y1 - y0, 0.0, SEP_NOISE_NONE, 1.0, 0.0};
+	strips->status[i] = sep_background (&im, SEP_MESH, SEP_MESH, 3, 3, 0.0, &(strips->bkg[i]));
+}
 
-	status = sep_extract(&im, 1.5*bkg->globalrms, SEP_THRESH_REL, 5, conv, 3, 3, SEP_FILTER_CONV, 32, 0.005, 1, 1.0, &catalog);
-	if (status)
+static void sepSubtract (void *arg, size_t i)
+{
+	SepStrips *strips = (SepStrips *) arg;
+	SepFrame *frame = strips->frame;
+	int y0 = strips->row (strips->extStart (i));
+	int ye = strips->row (strips->coreEnd (i));
+	for (int y = strips->row (strips->coreStart (i)); y < ye; y++)
 	{
-		logStream (MESSAGE_ERROR) << "SEP: cannot extract sources:" << status << sendLog;
-		return;
+		int ret = sep_bkg_subline (strips->bkg[i], y - y0, &(frame->image[(size_t) y * frame->w]), SEP_TFLOAT);
+		if (ret)
+		{
+			strips->status[i] = ret;
+			return;
+		}
+	}
+}
+
+struct SepAperture
+{
+	SepFrame *frame;
+	sep_image *im;
+};
+
+static void sepSumCircle (void *arg, size_t i)
+{
+	SepAperture *ap = (SepAperture *) arg;
+	SepFrame *frame = ap->frame;
+	size_t end = std::min ((i + 1) * SEP_APERTURE_BLOCK, frame->x.size ());
+	for (size_t o = i * SEP_APERTURE_BLOCK; o < end; o++)
+		sep_sum_circle (ap->im, frame->x[o], frame->y[o], 5.0, 5, 0, &(frame->flux[o]), &(frame->fluxerr[o]), &(frame->area[o]), &(frame->flag[o]));
+}
+
+void Camera::processSepFrame (SepFrame *frame)
+{
+	if (sepPool == NULL || sepPool->getThreads () != frame->threads)
+	{
+		delete sepPool;
+		sepPool = new rts2core::WorkerPool (frame->threads);
+	}
+
+	frame->status = 0;
+	frame->x.clear ();
+	frame->y.clear ();
+	frame->image.resize (frame->raw.size ());
+
+	SepStrips strips;
+	strips.frame = frame;
+	strips.ny = (frame->h - 1) / SEP_MESH + 1;
+	int nstrips = std::min (sepPool->getThreads (), strips.ny);
+	strips.meshRows = (strips.ny + nstrips - 1) / nstrips;
+	nstrips = (strips.ny + strips.meshRows - 1) / strips.meshRows;
+	strips.bkg.assign (nstrips, NULL);
+	strips.status.assign (nstrips, 0);
+
+	sepPool->parallelFor (nstrips, sepConvert, &strips);
+	sepPool->parallelFor (nstrips, sepBackground, &strips);
+
+	// global noise is median of meshes noise
+	std::vector <float> sigmas;
+	for (int i = 0; i < nstrips && frame->status == 0; i++)
+	{
+		frame->status = strips.status[i];
+		if (frame->status)
+			break;
+		sep_bkg *bkg = strips.bkg[i];
+		for (int j = strips.coreStart (i) - strips.extStart (i); j < strips.coreEnd (i) - strips.extStart (i); j++)
+			sigmas.insert (sigmas.end (), bkg->sigma + j * bkg->nx, bkg->sigma + (j + 1) * bkg->nx);
+	}
+
+	char errmsg[100];
+
+	if (frame->status)
+	{
+		sep_get_errmsg (frame->status, errmsg);
+		frame->error = std::string ("unable to estimate background: ") + errmsg;
+	}
+	else
+	{
+		std::sort (sigmas.begin (), sigmas.end ());
+		size_t n = sigmas.size ();
+		float globalrms = (n & 1) ? sigmas[n / 2] : (sigmas[n / 2 - 1] + sigmas[n / 2]) / 2.0;
+		if (globalrms <= 0)
+			globalrms = 1.0;
+
+		sepPool->parallelFor (nstrips, sepSubtract, &strips);
+		for (int i = 0; i < nstrips && frame->status == 0; i++)
+			frame->status = strips.status[i];
+
+		if (frame->status)
+		{
+			sep_get_errmsg (frame->status, errmsg);
+			frame->error = std::string ("cannot subtract background: ") + errmsg;
+		}
+		else
+		{
+			float conv[] = {1,2,1, 2,4,2, 1,2,1};
+			sep_catalog *catalog = NULL;
+
+			sep_image im = {&(frame->image[0]), NULL, NULL, SEP_TFLOAT, 0, 0, frame->w, frame->h, globalrms, SEP_NOISE_STDDEV, 1.0, 0.0};
+
+			// extraction uses static variables, so it cannot run in parallel
+			frame->status = sep_extract (&im, 1.5, SEP_THRESH_REL, 5, conv, 3, 3, SEP_FILTER_CONV, 32, 0.005, 1, 1.0, &catalog);
+			if (frame->status)
+			{
+				sep_get_errmsg (frame->status, errmsg);
+				frame->error = std::string ("cannot extract sources: ") + errmsg;
+			}
+			else
+			{
+				frame->x.assign (catalog->x, catalog->x + catalog->nobj);
+				frame->y.assign (catalog->y, catalog->y + catalog->nobj);
+				frame->flux.resize (catalog->nobj);
+				frame->fluxerr.resize (catalog->nobj);
+				frame->area.resize (catalog->nobj);
+				frame->flag.resize (catalog->nobj);
+
+				// aperture photometry
+				SepAperture ap;
+				ap.frame = frame;
+				ap.im = &im;
+				sepPool->parallelFor ((catalog->nobj + SEP_APERTURE_BLOCK - 1) / SEP_APERTURE_BLOCK, sepSumCircle, &ap);
+			}
+			sep_catalog_free (catalog);
+		}
 	}
 
-	/* aperture photometry */
-	double *flux, *fluxerr, *fluxt, *fluxerrt, *area, *areat;
-	short *flag, *flagt;
+	for (std::vector <sep_bkg *>::iterator iter = strips.bkg.begin (); iter != strips.bkg.end (); iter++)
+		sep_bkg_free (*iter);
+}
 
-	im.noise = &(bkg->globalrms);  /* set image noise level */
-	im.ndtype = SEP_TUINT16;
-	fluxt = flux = (double *)malloc(catalog->nobj * sizeof(double));
-	fluxerrt = fluxerr = (double *)malloc(catalog->nobj * sizeof(double));
-	areat = area = (double *)malloc(catalog->nobj * sizeof(double));
-	flagt = flag = (short *)malloc(catalog->nobj * sizeof(short));
-	for (int i=0; i<catalog->nobj; i++, fluxt++, fluxerrt++, flagt++, areat++)
-		sep_sum_circle(&im, catalog->x[i], catalog->y[i], 5.0, 5, 0, fluxt, fluxerrt, areat, flagt);
+void Camera::publishSep ()
+{
+	pthread_mutex_lock (&sepMutex);
+	SepFrame *frame = sepDone;
+	sepDone = NULL;
+	pthread_mutex_unlock (&sepMutex);
+
+	if (frame == NULL)
+		return;
+
+	if (frame->status)
+	{
+		logStream (MESSAGE_ERROR) << "SEP: " << frame->error << sendLog;
+	}
+	else
+	{
+		sepX->setValueArray (frame->x);
+		sepY->setValueArray (frame->y);
+		sepFluxes->setValueArray (frame->flux);
+		sendValueAll (sepX);
+		sendValueAll (sepY);
+		sendValueAll (sepFluxes);
+	}
+	sepDuration->setValueDouble (frame->processTime);
+	sendValueAll (sepDuration);
 
+	pthread_mutex_lock (&sepMutex);
+	sepFree.push_back (frame);
+	pthread_mutex_unlock (&sepMutex);
+}
 
+void *Camera::sepWorker (void *arg)
+{
+	Camera *cam = (Camera *) arg;
+	pthread_mutex_lock (&cam->sepMutex);
+	while (true)
+	{
+		while (cam->sepQueued == NULL && cam->sepRunning)
+			pthread_cond_wait (&cam->sepCond, &cam->sepMutex);
+		if (!cam->sepRunning)
+			break;
+		SepFrame *frame = cam->sepQueued;
+		cam->sepQueued = NULL;
+		pthread_mutex_unlock (&cam->sepMutex);
+
+		double t_start = getNow ();
+		cam->processSepFrame (frame);
+		frame->processTime = getNow () - t_start;
+
+		pthread_mutex_lock (&cam->sepMutex);
+		// results of the previous frame were not published
+		if (cam->sepDone)
+			cam->sepFree.push_back (cam->sepDone);
+		cam->sepDone = frame;
+		// wake up main loop, which will publish the results
+		char c = 0;
+		if (write (cam->sepNotify[1], &c, 1) < 0 && errno != EAGAIN)
+			break;
+	}
+	pthread_mutex_unlock (&cam->sepMutex);
+	delete cam->sepPool;
+	cam->sepPool = NULL;
+	return NULL;
 }
 
 int Camera::camStartExposure (bool careBlock)
@@ -1810,6 +2472,12 @@ int Camera::readoutStart ()
 int Camera::camReadout (rts2core::Connection * conn)
 {
 	timeTransferStart = getNow ();
+
+	stageReadout->setValueDouble (0);
+	stageProcess->setValueDouble (0);
+	stageSend->setValueDouble (0);
+	stageWait->setValueDouble (0);
+	pipelineError = false;
 	// if we can do exposure, do it..
 	if (quedExpNumber->getValueInteger () > 0 && exposureConn && supportFrameTransfer ())
 	{
@@ -18,14 +18,165 @@
  */
 
 #include "catd.h"
+#include "utilsfunc.h"
 
 using namespace rts2catd;
 
 Catd::Catd (int argc, char **argv, const char *cn):rts2core::Device (argc, argv, DEVICE_TYPE_CAT, cn)
 {
+	createValue (corner1, "corner1", "first corner (or centre) of the last search", false);
+	createValue (corner2, "corner2", "second corner of the last box search", false);
+	createValue (coneRadius, "radius", "[deg] radius of the last cone search", false, RTS2_DT_DEG_DIST);
+	createValue (maxRadius, "max_radius", "[deg] maximal radius of cone search", false, RTS2_VALUE_WRITABLE | RTS2_DT_DEG_DIST);
+	maxRadius->setValueDouble (10);
+	createValue (magnitudeLimit, "mag_limit", "faintest magnitude of returned stars", false, RTS2_VALUE_WRITABLE);
+	magnitudeLimit->setValueDouble (99);
+	createValue (starsLimit, "max_stars", "maximal number of stars returned for a field", false, RTS2_VALUE_WRITABLE);
+	starsLimit->setValueInteger (1000);
+	createValue (numStars, "num_stars", "number of stars found by the last search", false);
+	createValue (searchDuration, "search_duration", "[s] duration of the last search", false);
 
+	createValue (starsField, "stars_field", "index of field centre of found star", false);
+	createValue (starsId, "stars_id", "catalogue ID of found star", false);
+	createValue (starsRa, "stars_ra", "[deg] RA of found star", false, RTS2_DT_RA);
+	createValue (starsDec, "stars_dec", "[deg] DEC of found star", false, RTS2_DT_DEC);
+	createValue (starsMag, "stars_mag", "magnitude of found star", false);
+	createValue (starsDistance, "stars_dist", "[deg] distance of found star from field centre", false, RTS2_DT_DEG_DIST);
 }
 
 Catd::~Catd ()
 {
 }
+
+int Catd::commandAuthorized (rts2core::Connection * conn)
+{
+	struct ln_equ_posn c1, c2;
+	double r;
+	int ret;
+
+	if (conn->isCommand ("cone"))
+	{
+		if (conn->paramNextHMS (&c1.ra) || conn->paramNextDMS (&c1.dec) || conn->paramNextDouble (&r) || !conn->paramEnd ())
+			return DEVDEM_E_PARAMSNUM;
+		if (r <= 0 || r > maxRadius->getValueDouble ())
+			return DEVDEM_E_PARAMSVAL;
+
+		double start = getNow ();
+		std::vector <CatalogueStar> stars;
+		ret = searchCone (&c1, r, magnitudeLimit->getValueDouble (), starsLimit->getValueInteger (), stars);
+		if (ret)
+			return DEVDEM_E_SYSTEM;
+
+		clearStars ();
+		corner1->setValueRaDec (c1.ra, c1.dec);
+		coneRadius->setValueDouble (r);
+		addStars (0, stars);
+		sendStars (start);
+		return 0;
+	}
+	else if (conn->isCommand ("box"))
+	{
+		if (conn->paramNextHMS (&c1.ra) || conn->paramNextDMS (&c1.dec) || conn->paramNextHMS (&c2.ra) || conn->paramNextDMS (&c2.dec) || !conn->paramEnd ())
+			return DEVDEM_E_PARAMSNUM;
+		if (c1.dec > c2.dec)
+			return DEVDEM_E_PARAMSVAL;
+
+		double start = getNow ();
+		std::vector <CatalogueStar> stars;
+		ret = searchBox (&c1, &c2, magnitudeLimit->getValueDouble (), starsLimit->getValueInteger (), stars);
+		if (ret)
+			return DEVDEM_E_SYSTEM;
+
+		clearStars ();
+		corner1->setValueRaDec (c1.ra, c1.dec);
+		corner2->setValueRaDec (c2.ra, c2.dec);
+		coneRadius->setValueDouble (NAN);
+		addStars (0, stars);
+		sendStars (start);
+		return 0;
+	}
+	else if (conn->isCommand ("cones"))
+	{
+		if (conn->paramNextDouble (&r))
+			return DEVDEM_E_PARAMSNUM;
+		if (r <= 0 || r > maxRadius->getValueDouble ())
+			return DEVDEM_E_PARAMSVAL;
+		std::vector <struct ln_equ_posn> centres;
+		while (!conn->paramEnd ())
+		{
+			if (conn->paramNextHMS (&c1.ra) || conn->paramNextDMS (&c1.dec))
+				return DEVDEM_E_PARAMSNUM;
+			centres.push_back (c1);
+		}
+		if (centres.empty ())
+			return DEVDEM_E_PARAMSNUM;
+
+		double start = getNow ();
+		std::vector <std::vector <CatalogueStar> > stars;
+		ret = searchCones (centres, r, magnitudeLimit->getValueDouble (), starsLimit->getValueInteger (), stars);
+		if (ret)
+			return DEVDEM_E_SYSTEM;
+
+		clearStars ();
+		corner1->setValueRaDec (centres[0].ra, centres[0].dec);
+		coneRadius->setValueDouble (r);
+		for (size_t i = 0; i < stars.size (); i++)
+			addStars (i, stars[i]);
+		sendStars (start);
+		return 0;
+	}
+	return rts2core::Device::commandAuthorized (conn);
+}
+
+int Catd::searchCones (std::vector <struct ln_equ_posn> &centres, double r, double _magLimit, int _maxStars, std::vector <std::vector <CatalogueStar> > &stars)
+{
+	stars.resize (centres.size ());
+	for (size_t i = 0; i < centres.size (); i++)
+	{
+		int ret = searchCone (&(centres[i]), r, _magLimit, _maxStars, stars[i]);
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
+
+void Catd::clearStars ()
+{
+	starsField->clear ();
+	starsId->clear ();
+	starsRa->clear ();
+	starsDec->clear ();
+	starsMag->clear ();
+	starsDistance->clear ();
+}
+
+void Catd::addStars (int field, std::vector <CatalogueStar> &stars)
+{
+	for (std::vector <CatalogueStar>::iterator iter = stars.begin (); iter != stars.end (); iter++)
+	{
+		starsField->addValue (field);
+		starsId->addValue (iter->id);
+		starsRa->addValue (iter->ra);
+		starsDec->addValue (iter->dec);
+		starsMag->addValue (iter->mag);
+		starsDistance->addValue (iter->distance);
+	}
+}
+
+void Catd::sendStars (double start)
+{
+	numStars->setValueInteger (starsField->size ());
+	searchDuration->setValueDouble (getNow () - start);
+
+	sendValueAll (corner1);
+	sendValueAll (corner2);
+	sendValueAll (coneRadius);
+	sendValueAll (numStars);
+	sendValueAll (searchDuration);
+	sendValueAll (starsField);
+	sendValueAll (starsId);
+	sendValueAll (starsRa);
+	sendValueAll (starsDec);
+	sendValueAll (starsMag);
+	sendValueAll (starsDistance);
+}
@@ -32,6 +32,7 @@
 #include <iostream>
 
 #include <errno.h>
+#include <fcntl.h>
 #include <syslog.h>
 #include <unistd.h>
 
@@ -39,6 +40,7 @@
 #include <sys/shm.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 
@@ -96,6 +98,23 @@ Connection::Connection (Block * in_master):Object ()
 	dataConn = 0;
 
 	sharedReadMemory = NULL;
+
+	if (master)
+		writeBuffer.setLimit (master->getWriteBufferLimit ());
+
+	bytesQueued = 0;
+	bytesFlushed = 0;
+	bytesDropped = 0;
+	stallTime = 0;
+	stallStart = NAN;
+
+	writeCalls = 0;
+
+	batchValues = false;
+	batchOpen = false;
+	batchLines = 0;
+	batchRemaining = 0;
+	batchApplying = false;
 }
 
 Connection::Connection (int in_sock, Block * in_master):Object ()
@@ -138,12 +157,29 @@ Connection::Connection (int in_sock, Block * in_master):Object ()
 	dataConn = 0;
 
 	sharedReadMemory = NULL;
+
+	if (master)
+		writeBuffer.setLimit (master->getWriteBufferLimit ());
+
+	bytesQueued = 0;
+	bytesFlushed = 0;
+	bytesDropped = 0;
+	stallTime = 0;
+	stallStart = NAN;
+
+	writeCalls = 0;
+
+	batchValues = false;
+	batchOpen = false;
+	batchLines = 0;
+	batchRemaining = 0;
+	batchApplying = false;
 }
 
 Connection::~Connection (void)
 {
-	if (sock >= 0)
-		close (sock);
+	dropWriteBuffer ();
+	closeSocket ();
 	delete serverState;
 	delete bopState;
 	queClear ();
@@ -152,12 +188,23 @@ Connection::~Connection (void)
 	delete otherDevice;
 }
 
+int Connection::closeFD (int &fd)
+{
+	if (fd < 0)
+		return 0;
+	if (master)
+		master->removePollFD (fd);
+	int ret = close (fd);
+	fd = -1;
+	return ret;
+}
+
 int Connection::add (Block *block)
 {
 	if (sock >= 0)
 	{
 		short events = POLLIN | POLLPRI;
-		if (isConnState (CONN_INPROGRESS))
+		if (isConnState (CONN_INPROGRESS) || !writeBuffer.empty ())
 			events |= POLLOUT;
 		block->addPollFD (sock, events);
 	}
@@ -609,7 +656,7 @@ int Connection::acceptConn ()
 	}
 	else
 	{
-		close (sock);
+		closeSocket ();
 		sock = new_sock;
 		#ifdef DEBUG_EXTRA
 		logStream (MESSAGE_DEBUG) << "Connection::acceptConn connection accepted" << sendLog;
@@ -685,253 +732,280 @@ void Connection::processLine ()
 		*command_buf_top = '\0';
 		command_buf_top++;
 	}
-	// status combined with progress
-	if (isCommand (PROTO_STATUS_PROGRESS))
-	{
-		ret = statusProgress ();
-	}
-	// status
-	else if (isCommand (PROTO_STATUS))
-	{
-		ret = status ();
-	}
-	// bop status update
-	else if (isCommand (PROTO_BOP_STATE))
-	{
-		ret = bopStatus ();
-	}
-	// message from application
-	else if (isCommand (PROTO_MESSAGE))
-	{
-		ret = message ();
-	}
-	// technical - to keep connection working
-	else if (isCommand (PROTO_TECHNICAL))
-	{
-		char *msg;
-		if (paramNextString (&msg) || !paramEnd ())
-		{
-			ret = -2;
-		}
-		else if (!strcmp (msg, "ready"))
-		{
-			#ifdef DEBUG_EXTRA
-			std::cout << "Send T OK" << std::endl;
-			#endif
-			sendMsg (PROTO_TECHNICAL " OK");
-			ret = -1;
-		}
-		else if (!strcmp (msg, "OK"))
-		{
-			ret = -1;
-		}
-		else
-		{
-			ret = -2;
-		}
-	}
-	// metainfo with values
-	else if (isCommand (PROTO_METAINFO))
-	{
-		int m_type;
-		char *m_name;
-		char *m_descr;
-		if (paramNextInteger (&m_type)
-			|| paramNextString (&m_name)
-			|| paramNextString (&m_descr) || !paramEnd ())
-		{
-		 	ret = -2;
-		}
-		else
-		{
-			ret = metaInfo (m_type, std::string (m_name), std::string (m_descr));
-		}
-	}
-	else if (isCommand (PROTO_VALUE))
-	{
-		char *m_name;
-		if (paramNextString (&m_name))
-		{
-			logStream (MESSAGE_DEBUG) << "Cannot get parameter for SET_VALUE on connection " << getCentraldId () << sendLog;
-			ret = -1;
-		}
-		else
-		{
-			commandValue (m_name);
-			ret = -1;
-		}
-	}
-	else if (isCommand (PROTO_SELMETAINFO))
+	// protocol commands are single characters, dispatch them without string compares
+	switch (getCommand ()[0] != '\0' && getCommand ()[1] == '\0' ? getCommand ()[0] : '\0')
 	{
-		char *m_name;
-		char *sel_name;
-		if (paramNextString (&m_name))
-		{
-		  	ret = -2;
-		}
-		else if (paramEnd ())
-		{
-			ret = selMetaClear (m_name);
-		}
-		else if (paramNextString (&sel_name) || !paramEnd ())
+		// status combined with progress
+		case PROTO_STATUS_PROGRESS[0]:
+			ret = statusProgress ();
+			break;
+		// status
+		case PROTO_STATUS[0]:
+			ret = status ();
+			break;
+		// bop status update
+		case PROTO_BOP_STATE[0]:
+			ret = bopStatus ();
+			break;
+		// message from application
+		case PROTO_MESSAGE[0]:
+			ret = message ();
+			break;
+		// technical - to keep connection working
+		case PROTO_TECHNICAL[0]:
 		{
-			ret = -2;
+			char *msg;
+			if (paramNextString (&msg) || !paramEnd ())
+			{
+				ret = -2;
+			}
+			else if (!strcmp (msg, "ready"))
+			{
+				#ifdef DEBUG_EXTRA
+				std::cout << "Send T OK" << std::endl;
+				#endif
+				sendMsg (PROTO_TECHNICAL " OK");
+				ret = -1;
+			}
+			else if (!strcmp (msg, "OK"))
+			{
+				ret = -1;
+			}
+			else
+			{
+				ret = -2;
+			}
+			break;
 		}
-		else
+		// metainfo with values
+		case PROTO_METAINFO[0]:
 		{
-			ret = selMetaInfo (m_name, sel_name);
+			int m_type;
+			char *m_name;
+			char *m_descr;
+			if (paramNextInteger (&m_type)
+				|| paramNextString (&m_name)
+				|| paramNextString (&m_descr) || !paramEnd ())
+			{
+			 	ret = -2;
+			}
+			else
+			{
+				ret = metaInfo (m_type, std::string (m_name), std::string (m_descr));
+			}
+			break;
 		}
-	}
-	else if (isCommand (PROTO_SET_VALUE))
-	{
-		ret = master->setValue (this);
-	}
-	else if (isCommand (PROTO_BINARY))
-	{
-		int data_conn;
-		// we expect binary data
-		if (paramNextInteger (&data_conn))
+		case PROTO_VALUE[0]:
 		{
-			// end connection - we cannot process this command
-			activeReadData = -1;
-			connectionError (-2);
-			ret = -2;
+			char *m_name;
+			if (paramNextString (&m_name))
+			{
+				logStream (MESSAGE_DEBUG) << "Cannot get parameter for SET_VALUE on connection " << getCentraldId () << sendLog;
+				ret = -1;
+			}
+			else
+			{
+				commandValue (m_name);
+				ret = -1;
+			}
+			break;
 		}
-		else
+		case PROTO_VALUE_BATCH[0]:
 		{
-			DataChannels * chann = new DataChannels ();
-			chann->initFromConnection (this);
-			readChannels[data_conn] = chann;
-			newDataConn (data_conn);
-			ret = -1;
+			int lines;
+			if (paramNextInteger (&lines) || !paramEnd () || lines < 0)
+			{
+				connectionError (-2);
+				ret = -2;
+			}
+			else
+			{
+				batchRemaining = lines;
+				batchReceived.clear ();
+				ret = -1;
+			}
+			break;
 		}
-	}
-	else if (isCommand (PROTO_DATA))
-	{
-		if (paramNextInteger (&activeReadData) || paramNextInteger (&activeReadChannel)
-			|| readChannels[activeReadData]->readChannel (activeReadChannel, this)
-			|| !paramEnd ())
+		case PROTO_SELMETAINFO[0]:
 		{
-			// end connection - bad binary data header
-			activeReadData = -1;
-			connectionError (-2);
-			ret = -2;
+			char *m_name;
+			char *sel_name;
+			if (paramNextString (&m_name))
+			{
+			  	ret = -2;
+			}
+			else if (paramEnd ())
+			{
+				ret = selMetaClear (m_name);
+			}
+			else if (paramNextString (&sel_name) || !paramEnd ())
+			{
+				ret = -2;
+			}
+			else
+			{
+				ret = selMetaInfo (m_name, sel_name);
+			}
+			break;
 		}
-		else
+		case PROTO_SET_VALUE[0]:
+			ret = master->setValue (this);
+			break;
+		case PROTO_BINARY[0]:
 		{
-			ret = -1;
+			int data_conn;
+			// we expect binary data
+			if (paramNextInteger (&data_conn))
+			{
+				// end connection - we cannot process this command
+				activeReadData = -1;
+				connectionError (-2);
+				ret = -2;
+			}
+			else
+			{
+				DataChannels * chann = new DataChannels ();
+				chann->initFromConnection (this);
+				readChannels[data_conn] = chann;
+				newDataConn (data_conn);
+				ret = -1;
+			}
+			break;
 		}
-	}
-	else if (isCommand (PROTO_BINARY_KILLED))
-	{
-		int dC;
-		if (paramNextInteger (&dC))
+		case PROTO_DATA[0]:
 		{
-			connectionError (-2);
-			ret = -2;
+			if (paramNextInteger (&activeReadData) || paramNextInteger (&activeReadChannel)
+				|| readChannels[activeReadData]->readChannel (activeReadChannel, this)
+				|| !paramEnd ())
+			{
+				// end connection - bad binary data header
+				activeReadData = -1;
+				connectionError (-2);
+				ret = -2;
+			}
+			else
+			{
+				ret = -1;
+			}
+			break;
 		}
-		else
+		case PROTO_BINARY_KILLED[0]:
 		{
-			std::map <int, DataChannels *>::iterator iter = readChannels.find (dC);
-			if (iter != readChannels.end ())
+			int dC;
+			if (paramNextInteger (&dC))
+			{
+				connectionError (-2);
+				ret = -2;
+			}
+			else
 			{
-				if (otherDevice)
+				std::map <int, DataChannels *>::iterator iter = readChannels.find (dC);
+				if (iter != readChannels.end ())
 				{
-					otherDevice->fullDataReceived (dC, iter->second);
+					if (otherDevice)
+					{
+						otherDevice->fullDataReceived (dC, iter->second);
+					}
+					delete iter->second;
+					readChannels.erase (iter);
 				}
-				delete iter->second;
-				readChannels.erase (iter);
+				ret = -1;
 			}
-			ret = -1;
+			break;
 		}
-	}
-	else if (isCommand (PROTO_SHARED))
-	{
-		int dC;
-		int sharedMem;
-		if (paramNextInteger (&dC) || paramNextInteger (&sharedMem))
+		case PROTO_SHARED[0]:
 		{
-			connectionError (-2);
-			ret = -2;
-		}
-		else
-		{
-			ret = -1;
-			if (sharedReadMemory && sharedMem != sharedReadMemory->getShmId ())
+			int dC;
+			int sharedMem;
+			if (paramNextInteger (&dC) || paramNextInteger (&sharedMem))
 			{
-				// unmap existing IPC, map new one
-				delete sharedReadMemory;
-				sharedReadMemory = NULL;
+				connectionError (-2);
+				ret = -2;
 			}
-
-			if (sharedReadMemory == NULL)
+			else
 			{
-				sharedReadMemory = new DataSharedRead ();
-				if (sharedReadMemory->attach (sharedMem))
+				ret = -1;
+				if (sharedReadMemory && sharedMem != sharedReadMemory->getShmId ())
 				{
-					connectionError (-2);
-					ret = -2;
+					// unmap existing IPC, map new one
+					delete sharedReadMemory;
+					sharedReadMemory = NULL;
+				}
+
+				if (sharedReadMemory == NULL)
+				{
+					sharedReadMemory = new DataSharedRead ();
+					if (sharedReadMemory->attach (sharedMem))
+					{
+						connectionError (-2);
+						ret = -2;
+					}
+				}
+				if (ret == -1)
+				{
+					DataChannels * chann = new DataChannels ();
+					chann->initSharedFromConnection (this, sharedReadMemory);
+					readChannels[dC] = chann;
+					newDataConn (dC);
 				}
 			}
-			if (ret == -1)
-			{
-				DataChannels * chann = new DataChannels ();
-				chann->initSharedFromConnection (this, sharedReadMemory);
-				readChannels[dC] = chann;
-				newDataConn (dC);
-			}
+			break;
 		}
-	}
-	else if (isCommand (PROTO_SHARED_FULL) || isCommand (PROTO_SHARED_KILLED))
-	{
-		int dC;
-		if (paramNextInteger (&dC) || !paramEnd ())
+		case PROTO_SHARED_FULL[0]:
+		case PROTO_SHARED_KILLED[0]:
 		{
-			connectionError (-2);
-			ret = -2;
+			int dC;
+			if (paramNextInteger (&dC) || !paramEnd ())
+			{
+				connectionError (-2);
+				ret = -2;
+			}
+			else
+			{
+				std::map <int, DataChannels *>::iterator iter = readChannels.find (dC);
+				if (iter != readChannels.end ())
+				{
+					if (otherDevice)
+					{
+						otherDevice->fullDataReceived (dC, iter->second);
+					}
+					for (DataChannels::iterator dch_iter = iter->second->begin (); dch_iter != iter->second->end (); dch_iter++)
+					{
+						((DataSharedRead *) (*dch_iter))->removeActiveClient (getMaster ()->getSingleCentralConn ()->getCentraldId ());
+					}
+					delete iter->second;
+					readChannels.erase (iter);
+				}
+				ret = -1;
+			}
+			break;
 		}
-		else
-		{
-			std::map <int, DataChannels *>::iterator iter = readChannels.find (dC);
-			if (iter != readChannels.end ())
+		default:
+			if (isCommand (COMMAND_DATA_IN_FITS))
 			{
-				if (otherDevice)
+				char *fn;
+				if (paramNextString (&fn) || !paramEnd ())
 				{
-					otherDevice->fullDataReceived (dC, iter->second);
+					connectionError (-2);
+					ret = -2;
 				}
-				for (DataChannels::iterator dch_iter = iter->second->begin (); dch_iter != iter->second->end (); dch_iter++)
+				else
 				{
-					((DataSharedRead *) (*dch_iter))->removeActiveClient (getMaster ()->getSingleCentralConn ()->getCentraldId ());
+					if (otherDevice)
+						otherDevice->fitsData (fn);
+					ret = 0;
 				}
-				delete iter->second;
-				readChannels.erase (iter);
 			}
-			ret = -1;
-		}
-	}
-	else if (isCommand (COMMAND_DATA_IN_FITS))
-	{
-		char *fn;
-		if (paramNextString (&fn) || !paramEnd ())
-		{
-			connectionError (-2);
-			ret = -2;
-		}
-		else
-		{
-			if (otherDevice)
-				otherDevice->fitsData (fn);
-			ret = 0;
-		}
-	}
-	else if (isCommandReturn ())
-	{
-		ret = commandReturn ();
-	}
-	else
-	{
-		setCommandInProgress (true);
-		ret = command ();
+			else if (isCommandReturn ())
+			{
+				ret = commandReturn ();
+			}
+			else
+			{
+				setCommandInProgress (true);
+				ret = command ();
+			}
+			break;
 	}
 	#ifdef DEBUG_ALL
 	std::cout << "Connection::processLine [" << getCentraldId ()
@@ -974,8 +1048,7 @@ void Connection::processBuffer ()
 			buf_top++;
 		command_start = buf_top;
 		// find command end..
-		while (*buf_top && *buf_top != '\n' && *buf_top != '\r')
-			buf_top++;
+		buf_top += strcspn (buf_top, "\r\n");
 
 		if (*buf_top == '\r' && *(buf_top + 1) == '\n')
 		{
@@ -996,9 +1069,33 @@ void Connection::processBuffer ()
 			*buf_top = '\0';
 			buf_top++;
 
+			// lines of value batch are kept until the whole batch is received
+			if (batchRemaining > 0)
+			{
+				batchReceived.push_back (std::string (command_start));
+				int lineSock = sock;
+				if (--batchRemaining == 0)
+					applyValueBatch ();
+				command_start = buf_top;
+				// invalid batch closed the connection
+				if (lineSock >= 0 && sock < 0)
+				{
+					command_start = buf_top = full_data_end;
+					break;
+				}
+				continue;
+			}
+
 			command_buf_top = command_start;
 
+			int lineSock = sock;
 			processLine ();
+			// connection was closed on protocol error, ignore rest of data
+			if (lineSock >= 0 && sock < 0)
+			{
+				command_start = buf_top = full_data_end;
+				break;
+			}
 			// binary read just started
 			if (activeReadData >= 0)
 			{
@@ -1021,6 +1118,49 @@ void Connection::processBuffer ()
 	full_data_end = NULL;
 }
 
+void Connection::applyValueBatch ()
+{
+	std::vector <std::string> lines;
+	lines.swap (batchReceived);
+
+	std::vector <std::string>::iterator iter;
+	for (iter = lines.begin (); iter != lines.end (); iter++)
+	{
+		const char *l = iter->c_str ();
+		if (l[0] != PROTO_VALUE[0] || l[1] != ' ' || getValue (std::string (l + 2, strcspn (l + 2, " \t")).c_str ()) == NULL)
+		{
+			logStream (MESSAGE_ERROR) << "invalid line in value batch from connection '" << getName () << "': " << *iter << sendLog;
+			connectionError (-2);
+			return;
+		}
+	}
+
+	char *saved_start = command_start;
+	char *saved_top = command_buf_top;
+
+	batchApplying = true;
+	batchChanged.clear ();
+	for (iter = lines.begin (); iter != lines.end (); iter++)
+	{
+		std::vector <char> line (iter->begin (), iter->end ());
+		line.push_back ('\0');
+		command_start = command_buf_top = &(line[0]);
+		processLine ();
+	}
+	batchApplying = false;
+
+	command_start = saved_start;
+	command_buf_top = saved_top;
+
+	// batch was applied, notify about changed values
+	if (getOtherDevClient ())
+	{
+		for (std::vector <Value *>::iterator viter = batchChanged.begin (); viter != batchChanged.end (); viter++)
+			getOtherDevClient ()->valueChanged (*viter);
+	}
+	batchChanged.clear ();
+}
+
 int Connection::receive (Block *block)
 {
 	int data_size = 0;
@@ -1078,6 +1218,8 @@ int Connection::receive (Block *block)
 
 int Connection::writable (Block *block)
 {
+	if (sock >= 0 && !writeBuffer.empty () && (block->getPollEvents (sock) & POLLOUT) && !isConnState (CONN_INPROGRESS))
+		return flushWriteBuffer ();
 	if (sock >=0 && (block->getPollEvents (sock) & POLLOUT) && isConnState (CONN_INPROGRESS))
 	{
 		int err = 0;
@@ -1296,6 +1438,13 @@ int Connection::command ()
 			return -2;
 		return master->statusInfo (this);
 	}
+	else if (isCommand ("batch_values"))
+	{
+		if (!paramEnd ())
+			return -2;
+		setBatchValues (true);
+		return 0;
+	}
 	else if (isCommand (PROTO_PROGRESS))
 	{
 		if (paramNextDouble (&statusStart)
@@ -1497,8 +1646,6 @@ int Connection::commandReturn ()
 
 int Connection::sendMsg (const char *msg)
 {
-	int len;
-	int ret;
 	if (sock == -1)
 	{
 		#ifdef DEBUG_ALL
@@ -1506,42 +1653,29 @@ int Connection::sendMsg (const char *msg)
 		#endif
 		return -1;
 	}
-	len = strlen (msg) + 1;
-	char *mbuf = new char[len + 1];
-	strcpy (mbuf, msg);
-	#ifdef DEBUG_ALL
-	std::cout << "Connection::sendMsg will send " << msg << std::endl;
-	#endif
-	strcat (mbuf, "\n");
-	// ignore EINTR
-	do
-	{
-		ret = write (sock, mbuf, len);
-	} while (ret == -1 && errno == EINTR);
-
-	if (ret != len)
-	{
-		syslog (LOG_ERR, "Cannot send msg: %s to sock %i with len %i, ret %i errno %i message %m",
-			msg, sock, len, ret, errno);
-		#ifdef DEBUG_EXTRA
-		logStream (MESSAGE_ERROR)
-			<< "Connection::sendMsg [" << getCentraldId () << ":" << conn_state << "] error "
-			<< sock << " state: " << ret << " sending " << msg << ":" << strerror (errno)
-			<< sendLog;
-		#endif
-		connectionError (ret);
-		delete[] mbuf;
-		return -1;
-	}
 	#ifdef DEBUG_ALL
 	std::cout << "Connection::sendMsg " << getName ()
-		<< " [" << getCentraldId () << ":" << sock << "] send " << ret << ": " << msg
+		<< " [" << getCentraldId () << ":" << sock << "] send: " << msg
 		<< std::endl;
 	#endif
-
-	delete[] mbuf;
-	successfullSend ();
-	return 0;
+	if (batchOpen)
+	{
+		if (msg[0] == PROTO_VALUE[0] && msg[1] == ' ')
+		{
+			batchBuf.append (msg);
+			batchBuf.append ("\n");
+			batchLines++;
+			return 0;
+		}
+		if (flushValueBatch ())
+			return -1;
+	}
+	struct iovec iov[2];
+	iov[0].iov_base = (void *) msg;
+	iov[0].iov_len = strlen (msg);
+	iov[1].iov_base = (void *) "\n";
+	iov[1].iov_len = 1;
+	return sendVector (iov, 2);
 }
 
 int Connection::sendMsg (std::string msg)
@@ -1554,6 +1688,45 @@ int Connection::sendMsg (std::ostringstream &_os)
 	return sendMsg (_os.str ().c_str ());
 }
 
+void Connection::startValueBatch ()
+{
+	if (!batchValues || sock == -1)
+		return;
+	batchOpen = true;
+	batchBuf.clear ();
+	batchLines = 0;
+}
+
+int Connection::endValueBatch ()
+{
+	if (!batchOpen)
+		return 0;
+	int ret = flushValueBatch ();
+	batchOpen = false;
+	return ret;
+}
+
+int Connection::flushValueBatch ()
+{
+	if (batchLines == 0)
+		return 0;
+	std::ostringstream _os;
+	// single update does not need batch header
+	if (batchLines > 1)
+		_os << PROTO_VALUE_BATCH " " << batchLines << "\n";
+	std::string header = _os.str ();
+
+	struct iovec iov[2];
+	iov[0].iov_base = (void *) header.c_str ();
+	iov[0].iov_len = header.length ();
+	iov[1].iov_base = (void *) batchBuf.c_str ();
+	iov[1].iov_len = batchBuf.length ();
+	int ret = sendVector (iov, 2);
+	batchBuf.clear ();
+	batchLines = 0;
+	return ret;
+}
+
 int Connection::startBinaryData (int dataType, int channum, size_t *chansize)
 {
 	std::ostringstream _os;
@@ -1571,53 +1744,198 @@ int Connection::startBinaryData (int dataType, int channum, size_t *chansize)
 
 int Connection::sendBinaryData (int data_conn, int chan, char *data, size_t dataSize)
 {
-	char *binaryWriteTop, *binaryWriteBuff;
-	binaryWriteTop = binaryWriteBuff = data;
-	char *binaryEnd = data + dataSize;
+	if (sock == -1)
+		return -1;
+
+	// value updates collected before data were sent must not follow them
+	if (batchOpen && flushValueBatch ())
+		return -1;
+
+	if (dataSize > getWriteBinaryDataSize (data_conn))
+	{
+		logStream (MESSAGE_ERROR) << "Attemp to send too much data on channel " << chan << " - "
+			<< dataSize << " bytes, but there are only " << getWriteBinaryDataSize (data_conn) << " bytes remain to be send" << sendLog;
+		dataSize = getWriteBinaryDataSize (data_conn);
+	}
 
 	std::ostringstream _os;
-	_os << PROTO_DATA " " << data_conn << " " << chan << " " << dataSize;
-	int ret;
-	ret = sendMsg (_os);
+	_os << PROTO_DATA " " << data_conn << " " << chan << " " << dataSize << "\n";
+	std::string header = _os.str ();
+
+	// header and data are written in a single call
+	struct iovec iov[2];
+	iov[0].iov_base = (void *) header.c_str ();
+	iov[0].iov_len = header.length ();
+	iov[1].iov_base = data;
+	iov[1].iov_len = dataSize;
+
+	int ret = sendVector (iov, 2);
 	if (ret)
 		return ret;
 
-	while (binaryWriteTop < binaryEnd)
+	// data are either sent or queued
+	std::map <int, DataAbstractWrite *>::iterator iter = writeChannels.find (data_conn);
+	if (iter != writeChannels.end ())
 	{
-		if (dataSize > getWriteBinaryDataSize (data_conn))
+		((*iter).second)->dataWritten (chan, dataSize);
+		if (((*iter).second)->getDataSize () <= 0)
 		{
-			logStream (MESSAGE_ERROR) << "Attemp to send too much data on channel " << chan << " - "
-				<< dataSize << " bytes, but there are only " << getWriteBinaryDataSize (data_conn) << " bytes remain to be send" << sendLog;
-			dataSize = getWriteBinaryDataSize (data_conn);
+			delete ((*iter).second);
+			writeChannels.erase (iter);
 		}
-		ret = send (sock, binaryWriteTop, dataSize, 0);
+	}
+	return 0;
+}
+
+double Connection::getWriteStallTime ()
+{
+	if (isnan (stallStart))
+		return stallTime;
+	return stallTime + getNow () - stallStart;
+}
+
+ssize_t Connection::writeVector (struct iovec *iov, int iovcnt)
+{
+	struct msghdr msg;
+	memset (&msg, 0, sizeof (msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iovcnt;
+
+	ssize_t ret;
+	writeCalls++;
+	// ignore EINTR
+	do
+	{
+		ret = sendmsg (sock, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+	} while (ret == -1 && errno == EINTR);
+
+	// not a socket (pipe,..), MSG_DONTWAIT cannot be used, switch descriptor to non-blocking mode
+	if (ret == -1 && errno == ENOTSOCK)
+	{
+		int flags = fcntl (sock, F_GETFL);
+		if (flags == -1 || (!(flags & O_NONBLOCK) && fcntl (sock, F_SETFL, flags | O_NONBLOCK) == -1))
+			return -1;
+		do
+		{
+			ret = writev (sock, iov, iovcnt);
+		} while (ret == -1 && errno == EINTR);
+	}
+	return ret;
+}
+
+int Connection::sendVector (struct iovec *iov, int iovcnt)
+{
+	size_t len = 0;
+	for (int i = 0; i < iovcnt; i++)
+		len += iov[i].iov_len;
+
+	size_t sent = 0;
+	// queue data if there are some data waiting, so the order is preserved
+	if (writeBuffer.empty ())
+	{
+		ssize_t ret = writeVector (iov, iovcnt);
 		if (ret == -1)
 		{
-			if (errno != EINTR)
+			if (errno != EAGAIN && errno != EWOULDBLOCK)
 			{
-				connectionError (ret);
+				syslog (LOG_ERR, "Cannot send msg to sock %i with len %zu, errno %i message %m", sock, len, errno);
+				#ifdef DEBUG_EXTRA
+				logStream (MESSAGE_ERROR)
+					<< "Connection::sendVector [" << getCentraldId () << ":" << conn_state << "] error "
+					<< sock << " sending " << len << " bytes: " << strerror (errno)
+					<< sendLog;
+				#endif
+				connectionError (-1);
 				return -1;
 			}
 		}
 		else
 		{
-			binaryWriteTop += ret;
-			dataSize -= ret;
-			std::map <int, DataAbstractWrite *>::iterator iter = writeChannels.find (data_conn);
-			if (iter != writeChannels.end ())
-			{
-				((*iter).second)->dataWritten (chan, ret);
-				if (((*iter).second)->getDataSize () <= 0)
-				{
-					delete ((*iter).second);
-					writeChannels.erase (iter);
-				}
-			}
+			sent = ret;
+			successfullSend ();
+			if (sent == len)
+				return 0;
 		}
 	}
+
+	if (writeBuffer.size () + len - sent > writeBuffer.getLimit ())
+	{
+		logStream (MESSAGE_ERROR) << "connection " << getName () << " does not read data fast enough, "
+			<< writeBuffer.size () << " bytes are waiting to be send, closing it" << sendLog;
+		dropWriteBuffer ();
+		connectionError (-1);
+		return -1;
+	}
+
+	// queue what was not sent, limit was checked above, so push cannot fail
+	for (int i = 0; i < iovcnt; i++)
+	{
+		if (sent >= iov[i].iov_len)
+		{
+			sent -= iov[i].iov_len;
+			continue;
+		}
+		writeBuffer.push ((char *) iov[i].iov_base + sent, iov[i].iov_len - sent);
+		bytesQueued += iov[i].iov_len - sent;
+		if (master)
+			master->addWriteStats (iov[i].iov_len - sent, 0, 0);
+		sent = 0;
+	}
+
+	if (isnan (stallStart))
+		stallStart = getNow ();
+
 	return 0;
 }
 
+int Connection::flushWriteBuffer ()
+{
+	while (!writeBuffer.empty ())
+	{
+		struct iovec iov[2];
+		int iovcnt = writeBuffer.getIovec (iov);
+		ssize_t ret = writeVector (iov, iovcnt);
+		if (ret == -1)
+		{
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return 0;
+			logStream (MESSAGE_ERROR) << "cannot write buffered data to " << getName () << ": " << strerror (errno) << sendLog;
+			dropWriteBuffer ();
+			connectionError (-1);
+			return -1;
+		}
+		writeBuffer.consume (ret);
+		bytesFlushed += ret;
+		successfullSend ();
+	}
+	endWriteStall ();
+	return 0;
+}
+
+void Connection::endWriteStall ()
+{
+	if (isnan (stallStart))
+		return;
+	double stall = getNow () - stallStart;
+	stallTime += stall;
+	stallStart = NAN;
+	if (master)
+		master->addWriteStats (0, 0, stall);
+}
+
+void Connection::dropWriteBuffer ()
+{
+	if (!writeBuffer.empty ())
+	{
+		logStream (MESSAGE_WARNING) << "dropping " << writeBuffer.size () << " bytes waiting to be send to connection " << getName () << sendLog;
+		bytesDropped += writeBuffer.size ();
+		if (master)
+			master->addWriteStats (0, writeBuffer.size (), 0);
+		writeBuffer.clear ();
+	}
+	endWriteStall ();
+}
+
 void Connection::endBinaryData (int data_conn)
 {
 	std::ostringstream _os;
@@ -1703,9 +2021,16 @@ void Connection::connectionError (int last_data_size)
 		setConnState (CONN_DELETE);
 	else
 		setConnState (CONN_BROKEN);
-	if (sock >= 0)
-		close (sock);
-	sock = -1;
+	closeSocket ();
+	dropWriteBuffer ();
+	// new connection must negotiate batches again
+	batchValues = false;
+	batchOpen = false;
+	batchBuf.clear ();
+	batchLines = 0;
+	batchRemaining = 0;
+	batchReceived.clear ();
+	batchChanged.clear ();
 	if (strlen (getName ()) && master)
 		master->deleteAddress (getCentraldNum (), getName ());
 }
@@ -1955,7 +2280,6 @@ int Connection::paramNextSSizeT (ssize_t * num)
 int Connection::paramNextDouble (double *num)
 {
 	char *str_num;
-	int ret;
 	if (paramNextString (&str_num, ","))
 		return -1;
 	if (!strcasecmp (str_num, "nan"))
@@ -1963,9 +2287,12 @@ int Connection::paramNextDouble (double *num)
 		*num = NAN;
 		return 0;
 	}
-	ret = sscanf (str_num, "%lf", num);
-	if (ret != 1)
+	char *num_end;
+	// do not touch num if it cannot be parsed
+	double n = strtod (str_num, &num_end);
+	if (num_end == str_num)
 		return -1;
+	*num = n;
 	return 0;
 }
 
@@ -2044,12 +2371,13 @@ int Connection::paramNextDoubleTime (double *num)
 int Connection::paramNextFloat (float *num)
 {
 	char *str_num;
-	int ret;
 	if (paramNextString (&str_num, ","))
 		return -1;
-	ret = sscanf (str_num, "%f", num);
-	if (ret != 1)
+	char *num_end;
+	float n = strtof (str_num, &num_end);
+	if (num_end == str_num)
 		return -1;
+	*num = n;
 	return 0;
 }
 
@@ -2290,9 +2618,16 @@ int Connection::commandValue (const char *v_name)
 	{
 		int ret;
 		ret = value->setValue (this);
-		// notice other type..
-		if (getOtherDevClient ())
+		// notice other type, values from batch are reported after the whole batch is received
+		if (batchApplying)
+		{
+			if (std::find (batchChanged.begin (), batchChanged.end (), value) == batchChanged.end ())
+				batchChanged.push_back (value);
+		}
+		else if (getOtherDevClient ())
+		{
 			getOtherDevClient ()->valueChanged (value);
+		}
 		return ret;
 	}
 	logStream (MESSAGE_ERROR)
@@ -2331,6 +2666,14 @@ DataAbstractRead* Connection::lastDataChannel (int chan)
 	return (--readChannels.end ())->second->at (chan);
 }
 
+DataChannels* Connection::getDataChannels (int data_conn)
+{
+	std::map <int, DataChannels *>::iterator iter = readChannels.find (data_conn);
+	if (iter == readChannels.end ())
+		return NULL;
+	return iter->second;
+}
+
 double Connection::getInfoTime ()
 {
 	if (info_time)
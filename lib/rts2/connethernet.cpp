@@ -26,12 +26,15 @@ ConnEthernet::ConnEthernet (rts2core::Block *_master, const char *_ethLocal, con
 {
 	strcpy (ethLocal, _ethLocal);
 	memcpy (macRemote, _macRemote, 6);
+	sockE = -1;
+	ethInBuffer = NULL;
+	ethOutBuffer = NULL;
 	debug = false;
 }
 
 ConnEthernet::~ConnEthernet ()
 {
-	close (sockE);
+	closeFD (sockE);
 	free (ethInBuffer);
 	free (ethOutBuffer);
 }
@@ -57,7 +60,7 @@ int ConnEthernet::init ()
 	// bind socket to just our network adapter
 	if (setsockopt(sockE, SOL_SOCKET, SO_BINDTODEVICE, ethLocal, strlen(ethLocal)) == -1)	{
 		logStream (MESSAGE_ERROR) << "ConnEthernet::writeRead setsockopt: " << strerror (errno) << sendLog;
-		close (sockE);
+		closeFD (sockE);
 		return -1;
 	}
 
@@ -52,9 +52,9 @@ ConnFork::~ConnFork ()
 	if (childPid > 0)
 		kill (-childPid, SIGINT);
 	if (sockerr > 0)
-		close (sockerr);
+		closeFD (sockerr);
 	if (sockwrite > 0)
-		close (sockwrite);
+		closeFD (sockwrite);
 	delete[]exePath;
 }
 
@@ -133,8 +133,7 @@ int ConnFork::receive (Block *block)
 			}
 			else if (data_size == 0)
 			{
-				close (sockerr);
-				sockerr = -1;
+				closeFD (sockerr);
 				connectionError (0);
 				return -1;
 			}
@@ -166,8 +165,7 @@ int ConnFork::writable (Block *block)
 				if (errno == EINTR)
 				{
 					logStream (MESSAGE_ERROR) << "rts2core::ConnFork while writing to sockwrite: " << strerror (errno) << sendLog;
-					close (sockwrite);
-					sockwrite = -1;
+					closeFD (sockwrite);
 					return -1;
 				}
 				logStream (MESSAGE_WARNING) << "rts2core::ConnFork cannot write to process, will try again: " << strerror (errno) << sendLog;
@@ -176,10 +174,9 @@ int ConnFork::writable (Block *block)
 			input = input.substr (write_size);
 			if (input.length () == 0)
 			{
-				write_size = close (sockwrite);
+				write_size = closeFD (sockwrite);
 				if (write_size < 0)
 					logStream (MESSAGE_ERROR) << "rts2core::ConnFork error while closing write descriptor: " << strerror (errno) << sendLog;
-				sockwrite = -1;
 			}
 		}
 	}
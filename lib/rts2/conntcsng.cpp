@@ -38,8 +38,7 @@ const char * ConnTCSNG::runCommand (const char *cmd, const char *req)
 	sendData (wbuf, wlen, false);
 	receiveTillEnd (ngbuf, NGMAXSIZE, 3);
 
-	close (sock);
-	sock = -1;
+	closeSocket ();
 
 	wlen = snprintf (wbuf, 200, "%s %s %d ", obsID, subID, reqCount);
 
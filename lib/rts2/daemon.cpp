@@ -49,6 +49,8 @@
 #endif
 
 #define OPT_AUTORESTART         OPT_LOCAL + 623
+#define OPT_EPOLL               OPT_LOCAL + 624
+#define OPT_WRITEBUFFER         OPT_LOCAL + 625
 
 using namespace rts2core;
 
@@ -94,6 +96,11 @@ Daemon::Daemon (int _argc, char **_argv, int _init_state):rts2core::Block (_argc
 	uptime = new ValueTime ("uptime", "daemon uptime", false);
 	uptime->setNow ();
 
+	write_pending = NULL;
+	write_queued = NULL;
+	write_dropped = NULL;
+	write_stall = NULL;
+
 	idleInfoInterval = -1;
 
 	addOption ('i', NULL, 0, "run in interactive mode, don't loose console");
@@ -105,6 +112,8 @@ Daemon::Daemon (int _argc, char **_argv, int _init_state):rts2core::Block (_argc
 	addOption (OPT_MODEFILE, "modefile", 1, "file holding device modes");
 	addOption (OPT_AUTOSAVE, "autosave", 1, "autosave file");
 	addOption (OPT_DEFAULTS, "defaults", 1, "file with default values");
+	addOption (OPT_EPOLL, "epoll", 0, "use epoll instead of ppoll in the event loop");
+	addOption (OPT_WRITEBUFFER, "write-buffer", 1, "limit (in bytes) of data waiting to be send to a connection; also shows write buffers statistics");
 }
 
 Daemon::~Daemon (void)
@@ -150,6 +159,28 @@ int Daemon::processOption (int in_opt)
 		case OPT_VALUEFILE:
 			valueFile = optarg;
 			break;
+		case OPT_EPOLL:
+			setUseEpoll (true);
+			break;
+		case OPT_WRITEBUFFER:
+			{
+				char *endp;
+				long long limit = strtoll (optarg, &endp, 10);
+				if (*endp != '\0' || limit <= 0)
+				{
+					std::cerr << "invalid write buffer limit: " << optarg << std::endl;
+					return -1;
+				}
+				setWriteBufferLimit (limit);
+				if (write_pending == NULL)
+				{
+					createValue (write_pending, "write_pending", "[bytes] data waiting in connections write buffers", false);
+					createValue (write_queued, "write_queued", "[bytes] data which were not written directly to connections", false);
+					createValue (write_dropped, "write_dropped", "[bytes] data dropped as connections were closed", false);
+					createValue (write_stall, "write_stall", "[s] total time data were waiting in write buffers", false);
+				}
+			}
+			break;
 		default:
 			return rts2core::Block::processOption (in_opt);
 	}
@@ -689,14 +720,10 @@ Value * Daemon::getOwnValue (const char *v_name)
 
 CondValue * Daemon::getCondValue (const char *v_name)
 {
-	CondValueVector::iterator iter;
-	for (iter = values.begin (); iter != values.end (); iter++)
-	{
-		CondValue *val = *iter;
-		if (val->getValue ()->isValue (v_name))
-			return val;
-	}
-	return NULL;
+	int i = values.findValue (v_name);
+	if (i < 0)
+		return NULL;
+	return values[i];
 }
 
 CondValue * Daemon::getCondValue (const Value *val)
@@ -971,9 +998,26 @@ int Daemon::sendBaseInfo (Connection * conn)
 int Daemon::info ()
 {
 	updateInfoTime ();
+	updateWriteStats ();
 	return 0;
 }
 
+void Daemon::updateWriteStats ()
+{
+	if (write_pending == NULL)
+		return;
+	long pending = 0;
+	connections_t::iterator iter;
+	for (iter = getConnections ()->begin (); iter != getConnections ()->end (); iter++)
+		pending += (*iter)->getWriteBufferSize ();
+	for (iter = getCentraldConns ()->begin (); iter != getCentraldConns ()->end (); iter++)
+		pending += (*iter)->getWriteBufferSize ();
+	write_pending->setValueLong (pending);
+	write_queued->setValueLong (getWriteQueued ());
+	write_dropped->setValueLong (getWriteDropped ());
+	write_stall->setValueDouble (getWriteStall ());
+}
+
 int Daemon::info (Connection * conn)
 {
 	int ret;
@@ -1038,6 +1082,8 @@ int Daemon::sendInfo (Connection * conn, bool forceSend)
 {
 	if (!isRunning (conn))
 		return -1;
+	// collect all updates to single write
+	conn->startValueBatch ();
 	for (CondValueVector::iterator iter = values.begin (); iter != values.end (); iter++)
 	{
 		Value *val = (*iter)->getValue ();
@@ -1050,7 +1096,7 @@ int Daemon::sendInfo (Connection * conn, bool forceSend)
 		info_time->send (conn);
 	if (uptime->needSend ())
 		uptime->send (conn);
-	return 0;
+	return conn->endValueBatch ();
 }
 
 void Daemon::sendValueAll (Value * value)
@@ -30,7 +30,25 @@ using namespace rts2core;
 
 int DataRead::readDataSize (Connection *conn)
 {
-	return conn->paramNextSSizeT (&binaryReadChunkSize);
+	int ret = conn->paramNextSSizeT (&binaryReadChunkSize);
+	if (ret == 0)
+		allocateBuffer ();
+	return ret;
+}
+
+void DataRead::allocateBuffer ()
+{
+	size_t used = binaryReadTop - binaryReadBuff;
+	size_t need = streaming ? used + binaryReadChunkSize : used + binaryReadDataSize;
+	if (need <= binaryReadBuffSize)
+		return;
+	char *newBuff = new char[need];
+	if (used > 0)
+		memcpy (newBuff, binaryReadBuff, used);
+	delete[] binaryReadBuff;
+	binaryReadBuff = newBuff;
+	binaryReadBuffSize = need;
+	binaryReadTop = binaryReadBuff + used;
 }
 
 int DataAbstractShared::removeClient (int segnum, int client_id, bool verbose)
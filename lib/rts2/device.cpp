@@ -281,11 +281,7 @@ void DevConnectionMaster::connConnected ()
 
 void DevConnectionMaster::connectionError (int last_data_size)
 {
-	if (sock > 0)
-	{
-		close (sock);
-		sock = -1;
-	}
+	closeSocket ();
 	if (!isConnState (CONN_BROKEN))
 	{
 		setConnState (CONN_BROKEN);
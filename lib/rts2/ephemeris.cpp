@@ -0,0 +1,157 @@
+/*
+ * Precomputed target ephemeris for a night.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "ephemeris.h"
+
+#include <math.h>
+
+using namespace rts2core;
+
+/**
+ * Interpolate angle, taking care of wrap around 360 degrees.
+ */
+static double interpolateAngle (double a, double b, double frac)
+{
+	double d = b - a;
+	if (d > 180)
+		d -= 360;
+	else if (d < -180)
+		d += 360;
+	return a + d * frac;
+}
+
+NightEphemeris::NightEphemeris (struct ln_lnlat_posn *_observer, double _from, double _to, double _step)
+{
+	observer = _observer;
+	from = _from;
+	to = _to;
+	step = _step / 86400.0;
+
+	// at least two samples, so there is always something to interpolate
+	size_t n = 2;
+	if (to - from > step)
+		n += ceil ((to - from) / step) - 1;
+
+	gmst.resize (n);
+	moon.resize (n);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		double JD = getJD (i);
+		gmst[i] = ln_get_mean_sidereal_time (JD);
+		ln_get_lunar_equ_coords (JD, &(moon[i]));
+	}
+}
+
+void TargetEphemeris::getPosition (struct ln_equ_posn *pos, double JD)
+{
+	double frac;
+	size_t i = locate (JD, frac);
+	pos->ra = ln_range_degrees (interpolateAngle (samples[i].ra, samples[i + 1].ra, frac));
+	pos->dec = samples[i].dec + (samples[i + 1].dec - samples[i].dec) * frac;
+}
+
+void TargetEphemeris::getAltAz (struct ln_hrz_posn *hrz, double JD)
+{
+	double frac;
+	size_t i = locate (JD, frac);
+	hrz->alt = samples[i].alt + (samples[i + 1].alt - samples[i].alt) * frac;
+	hrz->az = ln_range_degrees (interpolateAngle (samples[i].az, samples[i + 1].az, frac));
+}
+
+double TargetEphemeris::getAlt (double JD)
+{
+	double frac;
+	size_t i = locate (JD, frac);
+	return samples[i].alt + (samples[i + 1].alt - samples[i].alt) * frac;
+}
+
+double TargetEphemeris::getHourAngle (double JD)
+{
+	double frac;
+	size_t i = locate (JD, frac);
+	double ha = interpolateAngle (samples[i].ha, samples[i + 1].ha, frac);
+	if (ha > 180)
+		ha -= 360;
+	else if (ha <= -180)
+		ha += 360;
+	return ha;
+}
+
+double TargetEphemeris::getLunarDistance (double JD)
+{
+	double frac;
+	size_t i = locate (JD, frac);
+	return samples[i].lunarDistance + (samples[i + 1].lunarDistance - samples[i].lunarDistance) * frac;
+}
+
+void TargetEphemeris::getMinMaxAlt (double _start, double _end, double &_min, double &_max)
+{
+	double a = getAlt (_start);
+	double b = getAlt (_end);
+	_min = (a < b) ? a : b;
+	_max = (a > b) ? a : b;
+
+	// samples strictly inside the interval
+	size_t i = (_start > night->getFrom ()) ? ceil ((_start - night->getFrom ()) / night->getStep ()) : 0;
+	for (; i < samples.size () && night->getJD (i) < _end; i++)
+	{
+		if (samples[i].alt < _min)
+			_min = samples[i].alt;
+		if (samples[i].alt > _max)
+			_max = samples[i].alt;
+	}
+}
+
+void TargetEphemeris::setSample (size_t i, struct ln_equ_posn *pos)
+{
+	EphemerisSample *s = &(samples[i]);
+	s->ra = pos->ra;
+	s->dec = pos->dec;
+	if (isnan (pos->ra) || isnan (pos->dec))
+	{
+		s->alt = s->az = s->ha = s->lunarDistance = NAN;
+		return;
+	}
+
+	struct ln_lnlat_posn *obs = night->getObserver ();
+	struct ln_hrz_posn hrz;
+	double gmst = night->getSiderealTime (i);
+
+	ln_get_hrz_from_equ_sidereal_time (pos, obs, gmst, &hrz);
+	s->alt = hrz.alt;
+	s->az = hrz.az;
+
+	double ha = ln_range_degrees (gmst * 15.0 + obs->lng - pos->ra);
+	if (ha > 180)
+		ha -= 360;
+	s->ha = ha;
+
+	s->lunarDistance = ln_get_angular_separation (pos, night->getMoon (i));
+}
+
+size_t TargetEphemeris::locate (double JD, double &frac)
+{
+	double t = (JD - night->getFrom ()) / night->getStep ();
+	size_t i = (t > 0) ? floor (t) : 0;
+	if (i > samples.size () - 2)
+		i = samples.size () - 2;
+	frac = t - i;
+	return i;
+}
@@ -0,0 +1,270 @@
+/*
+ * Pixel by pixel combination of image frames.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "imgcombine.h"
+#include "imghdr.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace rts2core;
+
+/**
+ * Median of values in v, which are reordered.
+ */
+static float medianScalar (float *v, int n)
+{
+	int k = n / 2;
+	std::nth_element (v, v + k, v + n);
+	if (n % 2)
+		return v[k];
+	// lower central value is the largest value below k
+	return (*std::max_element (v, v + k) + v[k]) / 2.0f;
+}
+
+static float sigmaClipScalar (float *v, int n, float sigma, int iterations)
+{
+	float c = medianScalar (v, n);
+	float limit = INFINITY;
+	for (int it = 0; it < iterations; it++)
+	{
+		float ss = 0;
+		int cnt = 0;
+		for (int i = 0; i < n; i++)
+		{
+			float d = v[i] - c;
+			if (fabsf (d) <= limit)
+			{
+				ss += d * d;
+				cnt++;
+			}
+		}
+		if (cnt == 0)
+			break;
+		limit = sigma * sqrtf (ss / cnt);
+
+		float sum = 0;
+		cnt = 0;
+		for (int i = 0; i < n; i++)
+		{
+			if (fabsf (v[i] - c) <= limit)
+			{
+				sum += v[i];
+				cnt++;
+			}
+		}
+		if (cnt == 0)
+			break;
+		c = sum / cnt;
+	}
+	return c;
+}
+
+#if defined(__SSE2__)
+/**
+ * Median of four pixels. v holds n vectors, which are partially sorted -
+ * after the call, v[0] to v[n/2] hold the smallest values in ascending order.
+ */
+static __m128 medianSSE (__m128 *v, int n)
+{
+	int k = n / 2;
+	for (int i = 0; i <= k; i++)
+	{
+		__m128 m = v[i];
+		for (int j = i + 1; j < n; j++)
+		{
+			__m128 o = v[j];
+			v[j] = _mm_max_ps (m, o);
+			m = _mm_min_ps (m, o);
+		}
+		v[i] = m;
+	}
+	if (n % 2)
+		return v[k];
+	return _mm_mul_ps (_mm_add_ps (v[k - 1], v[k]), _mm_set1_ps (0.5f));
+}
+#endif
+
+void rts2core::combineMedian (const float * const *frames, int nframes, size_t npix, float *out)
+{
+	size_t p = 0;
+#if defined(__SSE2__)
+	__m128 *v = (__m128 *) _mm_malloc (nframes * sizeof (__m128), 16);
+	for (; p + 4 <= npix; p += 4)
+	{
+		for (int f = 0; f < nframes; f++)
+			v[f] = _mm_loadu_ps (frames[f] + p);
+		_mm_storeu_ps (out + p, medianSSE (v, nframes));
+	}
+	_mm_free (v);
+#endif
+	std::vector <float> s (nframes);
+	for (; p < npix; p++)
+	{
+		for (int f = 0; f < nframes; f++)
+			s[f] = frames[f][p];
+		out[p] = medianScalar (&s[0], nframes);
+	}
+}
+
+void rts2core::combineSigmaClip (const float * const *frames, int nframes, size_t npix, float sigma, int iterations, float *out)
+{
+	size_t p = 0;
+#if defined(__SSE2__)
+	__m128 *v = (__m128 *) _mm_malloc (nframes * sizeof (__m128), 16);
+	const __m128 absMask = _mm_castsi128_ps (_mm_set1_epi32 (0x7fffffff));
+	const __m128 zero = _mm_setzero_ps ();
+	const __m128 vsigma = _mm_set1_ps (sigma);
+	for (; p + 4 <= npix; p += 4)
+	{
+		for (int f = 0; f < nframes; f++)
+			v[f] = _mm_loadu_ps (frames[f] + p);
+		__m128 c = medianSSE (v, nframes);
+		__m128 limit = _mm_set1_ps (INFINITY);
+		// lanes where clipping already finished (no value was accepted)
+		__m128 done = _mm_setzero_ps ();
+		for (int it = 0; it < iterations; it++)
+		{
+			__m128 ss = zero;
+			__m128 cnt = zero;
+			for (int f = 0; f < nframes; f++)
+			{
+				__m128 d = _mm_sub_ps (v[f], c);
+				__m128 acc = _mm_cmple_ps (_mm_and_ps (d, absMask), limit);
+				ss = _mm_add_ps (ss, _mm_and_ps (acc, _mm_mul_ps (d, d)));
+				cnt = _mm_add_ps (cnt, _mm_and_ps (acc, _mm_set1_ps (1.0f)));
+			}
+			done = _mm_or_ps (done, _mm_cmpeq_ps (cnt, zero));
+			__m128 nlimit = _mm_mul_ps (vsigma, _mm_sqrt_ps (_mm_div_ps (ss, cnt)));
+			limit = _mm_or_ps (_mm_and_ps (done, limit), _mm_andnot_ps (done, nlimit));
+
+			__m128 sum = zero;
+			cnt = zero;
+			for (int f = 0; f < nframes; f++)
+			{
+				__m128 acc = _mm_cmple_ps (_mm_and_ps (_mm_sub_ps (v[f], c), absMask), limit);
+				sum = _mm_add_ps (sum, _mm_and_ps (acc, v[f]));
+				cnt = _mm_add_ps (cnt, _mm_and_ps (acc, _mm_set1_ps (1.0f)));
+			}
+			done = _mm_or_ps (done, _mm_cmpeq_ps (cnt, zero));
+			c = _mm_or_ps (_mm_and_ps (done, c), _mm_andnot_ps (done, _mm_div_ps (sum, cnt)));
+		}
+		_mm_storeu_ps (out + p, c);
+	}
+	_mm_free (v);
+#endif
+	std::vector <float> s (nframes);
+	for (; p < npix; p++)
+	{
+		for (int f = 0; f < nframes; f++)
+			s[f] = frames[f][p];
+		out[p] = sigmaClipScalar (&s[0], nframes, sigma, iterations);
+	}
+}
+
+template <typename pixel_type> static void calibrateScalar (const pixel_type *raw, size_t p, size_t npix, const float *offset, const float *dark, float darkScale, const float *gain, float *out)
+{
+	for (; p < npix; p++)
+	{
+		float v = raw[p];
+		if (offset)
+			v -= offset[p];
+		if (dark)
+			v -= darkScale * dark[p];
+		if (gain)
+			v *= gain[p];
+		out[p] = v;
+	}
+}
+
+#if defined(__SSE2__)
+static inline void calibrateSSE (__m128 v, size_t p, const float *offset, const float *dark, float darkScale, const float *gain, float *out)
+{
+	if (offset)
+		v = _mm_sub_ps (v, _mm_loadu_ps (offset + p));
+	if (dark)
+		v = _mm_sub_ps (v, _mm_mul_ps (_mm_set1_ps (darkScale), _mm_loadu_ps (dark + p)));
+	if (gain)
+		v = _mm_mul_ps (v, _mm_loadu_ps (gain + p));
+	_mm_storeu_ps (out + p, v);
+}
+#endif
+
+int rts2core::calibratePixels (int dataType, const void *raw, size_t npix, const float *offset, const float *dark, float darkScale, const float *gain, float *out)
+{
+	size_t p = 0;
+	switch (dataType)
+	{
+		case RTS2_DATA_USHORT:
+#if defined(__SSE2__)
+			{
+				const __m128i zero = _mm_setzero_si128 ();
+				for (; p + 4 <= npix; p += 4)
+				{
+					__m128i r = _mm_loadl_epi64 ((const __m128i *) ((const uint16_t *) raw + p));
+					calibrateSSE (_mm_cvtepi32_ps (_mm_unpacklo_epi16 (r, zero)), p, offset, dark, darkScale, gain, out);
+				}
+			}
+#endif
+			calibrateScalar ((const uint16_t *) raw, p, npix, offset, dark, darkScale, gain, out);
+			break;
+		case RTS2_DATA_SHORT:
+#if defined(__SSE2__)
+			for (; p + 4 <= npix; p += 4)
+			{
+				__m128i r = _mm_loadl_epi64 ((const __m128i *) ((const int16_t *) raw + p));
+				// sign extend by arithmetic shift of value placed to upper half
+				calibrateSSE (_mm_cvtepi32_ps (_mm_srai_epi32 (_mm_unpacklo_epi16 (r, r), 16)), p, offset, dark, darkScale, gain, out);
+			}
+#endif
+			calibrateScalar ((const int16_t *) raw, p, npix, offset, dark, darkScale, gain, out);
+			break;
+		case RTS2_DATA_FLOAT:
+#if defined(__SSE2__)
+			for (; p + 4 <= npix; p += 4)
+				calibrateSSE (_mm_loadu_ps ((const float *) raw + p), p, offset, dark, darkScale, gain, out);
+#endif
+			calibrateScalar ((const float *) raw, p, npix, offset, dark, darkScale, gain, out);
+			break;
+		case RTS2_DATA_BYTE:
+			calibrateScalar ((const unsigned char *) raw, p, npix, offset, dark, darkScale, gain, out);
+			break;
+		case RTS2_DATA_SBYTE:
+			calibrateScalar ((const signed char *) raw, p, npix, offset, dark, darkScale, gain, out);
+			break;
+		case RTS2_DATA_LONG:
+			calibrateScalar ((const int32_t *) raw, p, npix, offset, dark, darkScale, gain, out);
+			break;
+		case RTS2_DATA_ULONG:
+			calibrateScalar ((const uint32_t *) raw, p, npix, offset, dark, darkScale, gain, out);
+			break;
+		case RTS2_DATA_DOUBLE:
+			calibrateScalar ((const double *) raw, p, npix, offset, dark, darkScale, gain, out);
+			break;
+		default:
+			return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,279 @@
+/*
+ * Single pass image statistics.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "imgstat.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// number of histogram copies, filled by successive pixels, so increments of the same bin do not wait for each other
+#define IMGSTAT_HISTOGRAM_LANES   4
+
+// number of vectors summed in 32bit integers before they are added to 64bit sum
+#define IMGSTAT_BLOCK   16384
+
+using namespace rts2core;
+
+ImageStatistics::ImageStatistics (bool _computeMode)
+{
+	histogramBuffer = NULL;
+	histogram = NULL;
+	reset (_computeMode);
+}
+
+ImageStatistics::~ImageStatistics ()
+{
+	delete[] histogramBuffer;
+}
+
+void ImageStatistics::reset (bool _computeMode)
+{
+	sum = 0;
+	sumSquares = 0;
+	min = INFINITY;
+	max = -INFINITY;
+	pixels = 0;
+	histogramOffset = 0;
+	histogram = NULL;
+	if (_computeMode)
+	{
+		// histogram is allocated only when mode is computed
+		if (histogramBuffer == NULL)
+			histogramBuffer = new uint32_t[IMGSTAT_HISTOGRAM_SIZE * IMGSTAT_HISTOGRAM_LANES];
+		histogram = histogramBuffer;
+		memset (histogram, 0, IMGSTAT_HISTOGRAM_SIZE * IMGSTAT_HISTOGRAM_LANES * sizeof (uint32_t));
+	}
+}
+
+double ImageStatistics::getAverage ()
+{
+	if (pixels == 0)
+		return NAN;
+	return sum / pixels;
+}
+
+double ImageStatistics::getStDev ()
+{
+	if (pixels == 0)
+		return NAN;
+	long double avg = sum / pixels;
+	long double var = sumSquares / pixels - avg * avg;
+	return var > 0 ? sqrtl (var) : 0;
+}
+
+double ImageStatistics::getMode ()
+{
+	if (histogram == NULL || pixels == 0)
+		return NAN;
+	uint32_t modeNum = 0;
+	long mode = 0;
+	for (long i = 0; i < IMGSTAT_HISTOGRAM_SIZE; i++)
+	{
+		uint32_t n = 0;
+		for (int l = 0; l < IMGSTAT_HISTOGRAM_LANES; l++)
+			n += histogram[l * IMGSTAT_HISTOGRAM_SIZE + i];
+		if (n > modeNum)
+		{
+			mode = i;
+			modeNum = n;
+		}
+	}
+	return mode - histogramOffset;
+}
+
+void ImageStatistics::addChunk (long double _sum, long double _sumSquares, double _min, double _max, size_t _npix, long _offset)
+{
+	sum += _sum;
+	sumSquares += _sumSquares;
+	if (_min < min)
+		min = _min;
+	if (_max > max)
+		max = _max;
+	pixels += _npix;
+	histogramOffset = _offset;
+}
+
+namespace rts2core
+{
+
+template <> void ImageStatistics::update (const uint16_t *data, size_t npix)
+{
+	update16 (data, npix, false);
+}
+
+template <> void ImageStatistics::update (const int16_t *data, size_t npix)
+{
+	update16 ((const uint16_t *) data, npix, true);
+}
+
+}
+
+/**
+ * 16 bit data are processed as signed values. Unsigned values are
+ * shifted by 32768 (their highest bit is flipped), and the shift is
+ * removed from the results.
+ */
+void ImageStatistics::update16 (const uint16_t *data, size_t npix, bool is_signed)
+{
+	const uint16_t flip = is_signed ? 0 : 0x8000;
+	// histogram index of signed values is shifted
+	const uint16_t hflip = is_signed ? 0x8000 : 0;
+
+	int64_t tSum = 0;
+	uint64_t tSumSquares = 0;
+	int tMin = 0x7fff;
+	int tMax = -0x8000;
+
+	size_t i = 0;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#if defined(__AVX2__)
+	typedef __m256i vec_t;
+	#define VEC_LEN                 16
+	#define VEC_LOAD(p)             _mm256_loadu_si256 ((const __m256i *) (p))
+	#define VEC_STORE(p, v)         _mm256_storeu_si256 ((__m256i *) (p), v)
+	#define VEC_SET1_16(x)          _mm256_set1_epi16 (x)
+	#define VEC_ZERO()              _mm256_setzero_si256 ()
+	#define VEC_XOR(a, b)           _mm256_xor_si256 (a, b)
+	#define VEC_MADD16(a, b)        _mm256_madd_epi16 (a, b)
+	#define VEC_ADD32(a, b)         _mm256_add_epi32 (a, b)
+	#define VEC_ADD64(a, b)         _mm256_add_epi64 (a, b)
+	#define VEC_UNPACKLO32(a, b)    _mm256_unpacklo_epi32 (a, b)
+	#define VEC_UNPACKHI32(a, b)    _mm256_unpackhi_epi32 (a, b)
+	#define VEC_MIN16(a, b)         _mm256_min_epi16 (a, b)
+	#define VEC_MAX16(a, b)         _mm256_max_epi16 (a, b)
+#else
+	typedef __m128i vec_t;
+	#define VEC_LEN                 8
+	#define VEC_LOAD(p)             _mm_loadu_si128 ((const __m128i *) (p))
+	#define VEC_STORE(p, v)         _mm_storeu_si128 ((__m128i *) (p), v)
+	#define VEC_SET1_16(x)          _mm_set1_epi16 (x)
+	#define VEC_ZERO()              _mm_setzero_si128 ()
+	#define VEC_XOR(a, b)           _mm_xor_si128 (a, b)
+	#define VEC_MADD16(a, b)        _mm_madd_epi16 (a, b)
+	#define VEC_ADD32(a, b)         _mm_add_epi32 (a, b)
+	#define VEC_ADD64(a, b)         _mm_add_epi64 (a, b)
+	#define VEC_UNPACKLO32(a, b)    _mm_unpacklo_epi32 (a, b)
+	#define VEC_UNPACKHI32(a, b)    _mm_unpackhi_epi32 (a, b)
+	#define VEC_MIN16(a, b)         _mm_min_epi16 (a, b)
+	#define VEC_MAX16(a, b)         _mm_max_epi16 (a, b)
+#endif
+	const vec_t vflip = VEC_SET1_16 ((short) flip);
+	const vec_t ones = VEC_SET1_16 (1);
+	const vec_t zero = VEC_ZERO ();
+	vec_t vmin = VEC_SET1_16 (0x7fff);
+	vec_t vmax = VEC_SET1_16 ((short) 0x8000);
+	vec_t vsq = zero;
+
+	size_t vend = npix - npix % VEC_LEN;
+	while (i < vend)
+	{
+		size_t bend = i + IMGSTAT_BLOCK * VEC_LEN;
+		if (bend > vend)
+			bend = vend;
+		// sums of pairs of 16 bit values, cannot overflow inside block
+		vec_t vsum = zero;
+		for (; i < bend; i += VEC_LEN)
+		{
+			vec_t v = VEC_XOR (VEC_LOAD (data + i), vflip);
+			vsum = VEC_ADD32 (vsum, VEC_MADD16 (v, ones));
+			// sum of two squares can be 2^31, so it is added as unsigned number
+			vec_t q = VEC_MADD16 (v, v);
+			vsq = VEC_ADD64 (vsq, VEC_UNPACKLO32 (q, zero));
+			vsq = VEC_ADD64 (vsq, VEC_UNPACKHI32 (q, zero));
+			vmin = VEC_MIN16 (vmin, v);
+			vmax = VEC_MAX16 (vmax, v);
+			if (histogram)
+			{
+				for (int j = 0; j < VEC_LEN; j++)
+					histogram[(j % IMGSTAT_HISTOGRAM_LANES) * IMGSTAT_HISTOGRAM_SIZE + (data[i + j] ^ hflip)]++;
+			}
+		}
+		int32_t s32[VEC_LEN / 2];
+		VEC_STORE (s32, vsum);
+		for (int j = 0; j < VEC_LEN / 2; j++)
+			tSum += s32[j];
+	}
+
+	uint64_t q64[VEC_LEN / 4];
+	VEC_STORE (q64, vsq);
+	for (int j = 0; j < VEC_LEN / 4; j++)
+		tSumSquares += q64[j];
+
+	int16_t m16[VEC_LEN];
+	VEC_STORE (m16, vmin);
+	for (int j = 0; j < VEC_LEN; j++)
+		if (m16[j] < tMin)
+			tMin = m16[j];
+	VEC_STORE (m16, vmax);
+	for (int j = 0; j < VEC_LEN; j++)
+		if (m16[j] > tMax)
+			tMax = m16[j];
+
+	#undef VEC_LEN
+	#undef VEC_LOAD
+	#undef VEC_STORE
+	#undef VEC_SET1_16
+	#undef VEC_ZERO
+	#undef VEC_XOR
+	#undef VEC_MADD16
+	#undef VEC_ADD32
+	#undef VEC_ADD64
+	#undef VEC_UNPACKLO32
+	#undef VEC_UNPACKHI32
+	#undef VEC_MIN16
+	#undef VEC_MAX16
+#endif
+
+	// scalar code for the rest of data (or for all data, if SIMD is not available)
+	for (; i < npix; i++)
+	{
+		int16_t v = (int16_t) (data[i] ^ flip);
+		tSum += v;
+		tSumSquares += (int32_t) v * v;
+		if (v < tMin)
+			tMin = v;
+		if (v > tMax)
+			tMax = v;
+		if (histogram)
+			histogram[data[i] ^ hflip]++;
+	}
+
+	if (npix == 0)
+		return;
+
+	// remove shift of unsigned data
+	long double lSum = tSum;
+	long double lSumSquares = tSumSquares;
+	if (!is_signed)
+	{
+		lSumSquares += 2 * 32768.0L * lSum + 32768.0L * 32768.0L * npix;
+		lSum += 32768.0L * npix;
+		tMin += 32768;
+		tMax += 32768;
+	}
+
+	addChunk (lSum, lSumSquares, tMin, tMax, npix, is_signed ? 32768 : 0);
+}
@@ -305,6 +305,7 @@ int IniParser::loadFile (const char *filename, bool parseFullLine)
 	if (!filename)
 		// default
 		filename = RTS2_CONFDIR "/rts2/rts2.ini";
+	loadedFile = filename;
 	std::ifstream *configStream = new std::ifstream ();
 	configStream->open (filename);
 	if (configStream->fail ())
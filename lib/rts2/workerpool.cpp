@@ -0,0 +1,113 @@
+/*
+ * Pool of worker threads.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "workerpool.h"
+
+using namespace rts2core;
+
+WorkerPool::WorkerPool (int nthreads)
+{
+	pthread_mutex_init (&mutex, NULL);
+	pthread_cond_init (&taskCond, NULL);
+	pthread_cond_init (&doneCond, NULL);
+
+	running = true;
+	taskFunc = NULL;
+	taskArg = NULL;
+	taskCount = taskNext = taskRemaining = 0;
+	generation = 0;
+
+	for (int i = 1; i < nthreads; i++)
+	{
+		pthread_t th;
+		if (pthread_create (&th, NULL, worker, this))
+			break;
+		threads.push_back (th);
+	}
+}
+
+WorkerPool::~WorkerPool ()
+{
+	pthread_mutex_lock (&mutex);
+	running = false;
+	pthread_cond_broadcast (&taskCond);
+	pthread_mutex_unlock (&mutex);
+
+	for (std::vector <pthread_t>::iterator iter = threads.begin (); iter != threads.end (); iter++)
+		pthread_join (*iter, NULL);
+
+	pthread_cond_destroy (&doneCond);
+	pthread_cond_destroy (&taskCond);
+	pthread_mutex_destroy (&mutex);
+}
+
+void WorkerPool::parallelFor (size_t n, void (*func) (void *arg, size_t i), void *arg)
+{
+	if (n == 0)
+		return;
+
+	pthread_mutex_lock (&mutex);
+	taskFunc = func;
+	taskArg = arg;
+	taskCount = n;
+	taskNext = 0;
+	taskRemaining = n;
+	generation++;
+	pthread_cond_broadcast (&taskCond);
+
+	runTasks ();
+
+	while (taskRemaining > 0)
+		pthread_cond_wait (&doneCond, &mutex);
+	pthread_mutex_unlock (&mutex);
+}
+
+void WorkerPool::runTasks ()
+{
+	while (taskNext < taskCount)
+	{
+		size_t i = taskNext++;
+		pthread_mutex_unlock (&mutex);
+
+		taskFunc (taskArg, i);
+
+		pthread_mutex_lock (&mutex);
+		taskRemaining--;
+		if (taskRemaining == 0)
+			pthread_cond_signal (&doneCond);
+	}
+}
+
+void *WorkerPool::worker (void *arg)
+{
+	WorkerPool *pool = (WorkerPool *) arg;
+	unsigned long seen = 0;
+	pthread_mutex_lock (&pool->mutex);
+	while (true)
+	{
+		while (pool->running && pool->generation == seen)
+			pthread_cond_wait (&pool->taskCond, &pool->mutex);
+		if (!pool->running)
+			break;
+		seen = pool->generation;
+		pool->runTasks ();
+	}
+	pthread_mutex_unlock (&pool->mutex);
+	return NULL;
+}
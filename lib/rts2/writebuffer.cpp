@@ -0,0 +1,124 @@
+/*
+ * Ring buffer for outgoing connection data.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "writebuffer.h"
+
+#include <string.h>
+
+// initial buffer capacity
+#define WRITEBUFFER_INITIAL   16384
+
+using namespace rts2core;
+
+WriteBuffer::WriteBuffer (size_t _limit)
+{
+	buf = NULL;
+	capacity = 0;
+	head = 0;
+	used = 0;
+	limit = _limit;
+}
+
+WriteBuffer::~WriteBuffer ()
+{
+	delete[] buf;
+}
+
+int WriteBuffer::push (const char *data, size_t len)
+{
+	if (used + len > limit)
+		return -1;
+	if (used + len > capacity)
+	{
+		size_t new_capacity = capacity > 0 ? capacity : WRITEBUFFER_INITIAL;
+		while (new_capacity < used + len)
+			new_capacity *= 2;
+		// never allocate more than the limit
+		if (new_capacity > limit)
+			new_capacity = limit;
+		resize (new_capacity);
+	}
+	// copy to the end of data, possibly wrapping around the end of buffer
+	size_t tail = (head + used) % capacity;
+	size_t first = capacity - tail;
+	if (first > len)
+		first = len;
+	memcpy (buf + tail, data, first);
+	if (first < len)
+		memcpy (buf, data + first, len - first);
+	used += len;
+	return 0;
+}
+
+int WriteBuffer::getIovec (struct iovec *iov)
+{
+	if (used == 0)
+		return 0;
+	iov[0].iov_base = buf + head;
+	if (head + used <= capacity)
+	{
+		iov[0].iov_len = used;
+		return 1;
+	}
+	iov[0].iov_len = capacity - head;
+	iov[1].iov_base = buf;
+	iov[1].iov_len = used - iov[0].iov_len;
+	return 2;
+}
+
+void WriteBuffer::consume (size_t len)
+{
+	if (len >= used)
+	{
+		clear ();
+		return;
+	}
+	head = (head + len) % capacity;
+	used -= len;
+}
+
+void WriteBuffer::clear ()
+{
+	head = 0;
+	used = 0;
+	// release memory allocated for large transfers
+	if (capacity > WRITEBUFFER_INITIAL * 4)
+	{
+		delete[] buf;
+		buf = NULL;
+		capacity = 0;
+	}
+}
+
+void WriteBuffer::resize (size_t new_capacity)
+{
+	char *new_buf = new char[new_capacity];
+	struct iovec iov[2];
+	int n = getIovec (iov);
+	size_t off = 0;
+	for (int i = 0; i < n; i++)
+	{
+		memcpy (new_buf + off, iov[i].iov_base, iov[i].iov_len);
+		off += iov[i].iov_len;
+	}
+	delete[] buf;
+	buf = new_buf;
+	capacity = new_capacity;
+	head = 0;
+}
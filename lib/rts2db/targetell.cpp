@@ -33,6 +33,17 @@ EllTarget::EllTarget (int in_tar_id, struct ln_lnlat_posn *in_obs, double in_alt
 void EllTarget::load ()
 {
 	Target::load ();
+	parseOrbit ();
+}
+
+void EllTarget::loadRow (const TargetRow &row)
+{
+	loadTarget (row);
+	parseOrbit ();
+}
+
+void EllTarget::parseOrbit ()
+{
 	// try to parse MPC string..
 	int ret = LibnovaEllFromMPC (&orbit, designation, getTargetInfo ());
 	if (ret)
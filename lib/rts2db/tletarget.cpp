@@ -23,13 +23,13 @@
 #include "libnova_cpp.h"
 #include "rts2fits/image.h"
 
-#include "pluto/norad.h"
-#include "pluto/observe.h"
+#include <math.h>
 
 using namespace rts2db;
 
 TLETarget::TLETarget (int in_tar_id, struct ln_lnlat_posn *in_obs, double in_altitude):Target (in_tar_id, in_obs, in_altitude)
 {
+	prop_lng = prop_lat = prop_alt = NAN;
 }
 
 void TLETarget::load ()
@@ -40,6 +40,12 @@ void TLETarget::load ()
 	orbitFromTLE (tarInfo);
 }
 
+void TLETarget::loadRow (const TargetRow &row)
+{
+	loadTarget (row);
+	orbitFromTLE (row.tar_info);
+}
+
 void TLETarget::orbitFromTLE (std::string target_tle)
 {
 	size_t sub = target_tle.find ('|');
@@ -48,18 +54,12 @@ void TLETarget::orbitFromTLE (std::string target_tle)
 		tle1 = target_tle.substr (0, sub);
 		tle2 = target_tle.substr (sub + 1);
 
-		int ret = parse_elements (tle1.c_str (), tle2.c_str (), &tle);
+		// model parameters are initialized once, here
+		int ret = propagator.setTLE (tle1.c_str (), tle2.c_str ());
 		if (ret != 0)
 			throw rts2core::Error ("cannot parse TLE " + tle1 + " " + tle2 + " for target " + getTargetName ());
 
-		ephem = 1;
-		is_deep = select_ephemeris (&tle);
-
-		if (is_deep && (ephem == 1 || ephem == 2))
-			ephem += 2;	/* switch to an SDx */
-		if (!is_deep && (ephem == 3 || ephem == 4))
-			ephem -= 2;	/* switch to an SGx */
-		setTargetName (tle.intl_desig);
+		setTargetName (propagator.getTLE ()->intl_desig);
 		setTargetInfo (target_tle.c_str ());
 		setTargetType (TYPE_TLE);
 		return;
@@ -69,52 +69,33 @@ void TLETarget::orbitFromTLE (std::string target_tle)
 
 void TLETarget::getPosition (struct ln_equ_posn *pos, double JD)
 {
-	double sat_params[N_SAT_PARAMS], observer_loc[3];
-	double t_since;
-	double sat_pos[3]; /* Satellite position vector */
-	double dist_to_satellite;
-
-	double r_s, r_c;
-
-	lat_alt_to_parallax (ln_deg_to_rad (observer->lat), obs_altitude * 1000, &r_c, &r_s);
-
-	observer_cartesian_coords (JD, ln_deg_to_rad (observer->lng), r_c, r_s, observer_loc);
+	checkObserver ();
+	// decayed or stale TLE, callers handle NAN position
+	if (propagator.getPosition (JD, &(pos->ra), &(pos->dec)))
+		pos->ra = pos->dec = NAN;
+}
 
-	t_since = (JD - tle.epoch) * 1440.;
-	switch (ephem)
+size_t TLETarget::getPositions (const double *JD, size_t n, struct ln_equ_posn *pos, double *alt)
+{
+	size_t failed = 0;
+	checkObserver ();
+	for (size_t i = 0; i < n; i++)
 	{
-		case 0:
-			SGP_init (sat_params, &tle);
-			SGP (t_since, &tle, sat_params, sat_pos, NULL);
-			break;
-		case 1:
-			SGP4_init (sat_params, &tle);
-			SGP4 (t_since, &tle, sat_params, sat_pos, NULL);
-			break;
-		case 2:
-			SGP8_init (sat_params, &tle);
-			SGP8 (t_since, &tle, sat_params, sat_pos, NULL);
-			break;
-		case 3:
-			SDP4_init (sat_params, &tle);
-			SDP4 (t_since, &tle, sat_params, sat_pos, NULL);
-			break;
-		case 4:
-			SDP8_init (sat_params, &tle);
-			SDP8 (t_since, &tle, sat_params, sat_pos, NULL);
-			break;
-		default:
-			throw rts2core::Error ("invalid ephem");
+		if (propagator.getPosition (JD[i], &(pos[i].ra), &(pos[i].dec), NULL, alt ? alt + i : NULL))
+		{
+			pos[i].ra = pos[i].dec = NAN;
+			if (alt)
+				alt[i] = NAN;
+			failed++;
+		}
 	}
-
-	get_satellite_ra_dec_delta (observer_loc, sat_pos, &(pos->ra), &(pos->dec), &dist_to_satellite);
-	pos->ra = ln_rad_to_deg (pos->ra);
-	pos->dec = ln_rad_to_deg (pos->dec);
+	return failed;
 }
 
 int TLETarget::getRST (struct ln_rst_time *rst, double JD, double horizon)
 {
-	return 0;
+	checkObserver ();
+	return propagator.getRST (JD, horizon, rst->rise, rst->transit, rst->set);
 }
 
 moveType TLETarget::startSlew (struct ln_equ_posn *position, std::string &p1, std::string &p2, bool update_position, int plan_id)
@@ -156,3 +137,16 @@ double TLETarget::getSolarDistance (double JD)
 {
 	return 0;
 }
+
+void TLETarget::checkObserver ()
+{
+	if (observer == NULL)
+		throw rts2core::Error ("observer position is not known");
+	// parallax is recalculated only if observer changes
+	if (observer->lng == prop_lng && observer->lat == prop_lat && obs_altitude == prop_alt)
+		return;
+	prop_lng = observer->lng;
+	prop_lat = observer->lat;
+	prop_alt = obs_altitude;
+	propagator.setObserver (prop_lng, prop_lat, prop_alt);
+}
@@ -0,0 +1,466 @@
+/*
+ * Library of master calibration frames.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "rts2fits/calibframes.h"
+#include "rts2fits/mastercal.h"
+#include "utilsfunc.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <strings.h>
+#include <sstream>
+#include <sys/stat.h>
+
+using namespace rts2image;
+
+MasterFrame::MasterFrame (const char *_filename, time_t _mtime)
+{
+	filename = std::string (_filename);
+	mtime = _mtime;
+
+	type = CALIBRATION_DARK;
+	binx = -1;
+	biny = -1;
+	exposure = NAN;
+	temperature = NAN;
+	darkSubtracted = false;
+}
+
+MasterFrame::~MasterFrame ()
+{
+	for (std::vector <float *>::iterator iter = data.begin (); iter != data.end (); iter++)
+		delete[] *iter;
+}
+
+int MasterFrame::readHeaders ()
+{
+	FitsFile ff;
+	try
+	{
+		ff.openFile (filename.c_str (), true, false);
+
+		char buf[FLEN_VALUE];
+
+		ff.getValue ("CCD_NAME", buf, FLEN_VALUE, "", true);
+		camera = std::string (buf);
+		if (camera == "UNK")
+			camera = "";
+
+		ff.getValue ("FILTER", buf, FLEN_VALUE, "", true);
+		filter = std::string (buf);
+		if (filter == "UNK")
+			filter = "";
+
+		ff.getValue ("BINX", binx, false);
+		ff.getValue ("BINY", biny, false);
+		ff.getValue ("CCD_TEMP", temperature, false);
+
+		ff.getValue ("EXPTIME", exposure, false);
+		if (std::isnan (exposure))
+			ff.getValue ("EXPOSURE", exposure, true);
+
+		ff.getValue ("DARKSUB", buf, FLEN_VALUE, "", true);
+		darkSubtracted = buf[0] != '\0';
+
+		bool normalized = false;
+		ff.getValue ("NORMALIZ", normalized, false);
+
+		ff.getValue ("IMAGETYP", buf, FLEN_VALUE, "", true);
+		if (strcasestr (buf, "bias") || strcasestr (buf, "zero"))
+			type = CALIBRATION_BIAS;
+		else if (strcasestr (buf, "dark"))
+			type = CALIBRATION_DARK;
+		else if (strcasestr (buf, "flat"))
+			type = CALIBRATION_FLAT;
+		else if (normalized)
+			type = CALIBRATION_FLAT;
+		else if (exposure == 0)
+			type = CALIBRATION_BIAS;
+		else
+			type = CALIBRATION_DARK;
+
+		if (MasterCalibration::findChannels (&ff, hdus))
+		{
+			logStream (MESSAGE_ERROR) << "master " << filename << " does not contain any image" << sendLog;
+			return -1;
+		}
+
+		int status = 0;
+		for (std::vector <int>::iterator iter = hdus.begin (); iter != hdus.end (); iter++)
+		{
+			long sizes[2];
+			fits_movabs_hdu (ff.getFitsFile (), *iter, NULL, &status);
+			fits_get_img_size (ff.getFitsFile (), 2, sizes, &status);
+			if (status)
+			{
+				logStream (MESSAGE_ERROR) << "cannot get size of master " << filename << " HDU " << *iter << sendLog;
+				return -1;
+			}
+			widths.push_back (sizes[0]);
+			heights.push_back (sizes[1]);
+			data.push_back (NULL);
+		}
+	}
+	catch (rts2core::Error &er)
+	{
+		logStream (MESSAGE_ERROR) << "cannot read master " << filename << ": " << er << sendLog;
+		return -1;
+	}
+	return 0;
+}
+
+int MasterFrame::load ()
+{
+	if (data.empty () || data[0] != NULL)
+		return 0;
+
+	FitsFile ff;
+	try
+	{
+		ff.openFile (filename.c_str (), true, false);
+	}
+	catch (rts2core::Error &er)
+	{
+		logStream (MESSAGE_ERROR) << "cannot open master " << filename << ": " << er << sendLog;
+		return -1;
+	}
+
+	int status = 0;
+	for (size_t c = 0; c < hdus.size () && status == 0; c++)
+	{
+		long npix = widths[c] * heights[c];
+		data[c] = new float[npix];
+		fits_movabs_hdu (ff.getFitsFile (), hdus[c], NULL, &status);
+		fits_read_img_flt (ff.getFitsFile (), 0, 1, npix, NAN, data[c], NULL, &status);
+	}
+	if (status)
+	{
+		char errtext[FLEN_ERRMSG];
+		fits_get_errstatus (status, errtext);
+		logStream (MESSAGE_ERROR) << "cannot read data of master " << filename << ": " << errtext << sendLog;
+		for (std::vector <float *>::iterator iter = data.begin (); iter != data.end (); iter++)
+		{
+			delete[] *iter;
+			*iter = NULL;
+		}
+		return -1;
+	}
+	logStream (MESSAGE_DEBUG) << "loaded master " << filename << sendLog;
+	return 0;
+}
+
+CalibrationSet::CalibrationSet ()
+{
+	darkExposure = NAN;
+	refs = 0;
+}
+
+CalibrationSet::~CalibrationSet ()
+{
+	for (std::vector <float *>::iterator iter = offsets.begin (); iter != offsets.end (); iter++)
+		delete[] *iter;
+	for (std::vector <float *>::iterator iter = darks.begin (); iter != darks.end (); iter++)
+		delete[] *iter;
+	for (std::vector <float *>::iterator iter = gains.begin (); iter != gains.end (); iter++)
+		delete[] *iter;
+}
+
+CalibrationFrames::CalibrationFrames (const char *_directory, double _tolerance)
+{
+	directory = std::string (_directory);
+	tolerance = _tolerance;
+	last = NULL;
+}
+
+CalibrationFrames::~CalibrationFrames ()
+{
+	for (std::map <std::string, MasterFrame *>::iterator iter = masters.begin (); iter != masters.end (); iter++)
+		delete iter->second;
+	delete last;
+}
+
+CalibrationSet *CalibrationFrames::acquire (const char *camera, int binx, int biny, const char *filter, double exposure, double temperature)
+{
+	rescan ();
+
+	MasterFrame *bias;
+	MasterFrame *dark;
+	MasterFrame *flat;
+
+	selectMasters (camera, binx, biny, filter, exposure, temperature, bias, dark, flat);
+
+	if (bias == NULL && dark == NULL && flat == NULL)
+		return NULL;
+
+	// dark is scaled during calibration, so the set does not depend on exposure
+	std::ostringstream key;
+	if (bias)
+		key << bias->filename << " " << bias->mtime;
+	key << ";";
+	if (dark)
+		key << dark->filename << " " << dark->mtime;
+	key << ";";
+	if (flat)
+		key << flat->filename << " " << flat->mtime;
+
+	if (last && last->key == key.str ())
+	{
+		last->refs++;
+		return last;
+	}
+
+	CalibrationSet *set = createSet (bias, dark, flat);
+	if (set == NULL)
+		return NULL;
+	set->key = key.str ();
+
+	if (last && last->refs == 0)
+		delete last;
+	last = set;
+	last->refs++;
+	return last;
+}
+
+void CalibrationFrames::selectMasters (const char *camera, int binx, int biny, const char *filter, double exposure, double temperature, MasterFrame *&bias, MasterFrame *&dark, MasterFrame *&flat)
+{
+	bias = NULL;
+	dark = NULL;
+	flat = NULL;
+
+	for (std::map <std::string, MasterFrame *>::iterator iter = masters.begin (); iter != masters.end (); iter++)
+	{
+		MasterFrame *m = iter->second;
+		if (!matches (m, camera, binx, biny, temperature))
+			continue;
+		switch (m->type)
+		{
+			case CALIBRATION_BIAS:
+				// closest temperature, then the newest
+				if (bias == NULL || fabs (m->temperature - temperature) < fabs (bias->temperature - temperature) || (!(fabs (m->temperature - temperature) > fabs (bias->temperature - temperature)) && m->mtime > bias->mtime))
+					bias = m;
+				break;
+			case CALIBRATION_DARK:
+				// closest exposure, then the newest
+				if (dark == NULL || fabs (m->exposure - exposure) < fabs (dark->exposure - exposure) || (m->exposure == dark->exposure && m->mtime > dark->mtime))
+					dark = m;
+				break;
+			case CALIBRATION_FLAT:
+				if (m->filter == (filter ? filter : "") && (flat == NULL || m->mtime > flat->mtime))
+					flat = m;
+				break;
+		}
+	}
+
+	// dark is scaled to exposure time only if bias is available
+	if (dark && !(bias && dark->exposure > 0) && (dark->darkSubtracted || fabs (dark->exposure - exposure) > 0.01 * exposure + 0.001))
+		dark = NULL;
+}
+
+void CalibrationFrames::addMaster (MasterFrame *m)
+{
+	std::map <std::string, MasterFrame *>::iterator iter = masters.find (m->filename);
+	if (iter != masters.end ())
+	{
+		delete iter->second;
+		iter->second = m;
+	}
+	else
+	{
+		masters[m->filename] = m;
+	}
+}
+
+void CalibrationFrames::release (CalibrationSet *set)
+{
+	set->refs--;
+	if (set->refs <= 0 && set != last)
+		delete set;
+}
+
+void CalibrationFrames::rescan ()
+{
+	DIR *d = opendir (directory.c_str ());
+	if (d == NULL)
+	{
+		logStream (MESSAGE_ERROR) << "cannot open directory with master frames " << directory << ": " << strerror (errno) << sendLog;
+		return;
+	}
+
+	std::map <std::string, MasterFrame *> found;
+
+	struct dirent *de;
+	while ((de = readdir (d)) != NULL)
+	{
+		if (de->d_name[0] == '.' || strstr (de->d_name, ".fit") == NULL)
+			continue;
+		std::string fn = directory + "/" + de->d_name;
+		struct stat st;
+		if (stat (fn.c_str (), &st) || !S_ISREG (st.st_mode))
+			continue;
+
+		std::map <std::string, MasterFrame *>::iterator iter = masters.find (fn);
+		if (iter != masters.end ())
+		{
+			if (iter->second->mtime == st.st_mtime)
+			{
+				found[fn] = iter->second;
+				masters.erase (iter);
+				continue;
+			}
+			logStream (MESSAGE_INFO) << "master " << fn << " changed, reloading it" << sendLog;
+		}
+		else
+		{
+			std::map <std::string, time_t>::iterator fiter = failed.find (fn);
+			if (fiter != failed.end () && fiter->second == st.st_mtime)
+				continue;
+		}
+
+		MasterFrame *m = new MasterFrame (fn.c_str (), st.st_mtime);
+		if (m->readHeaders ())
+		{
+			failed[fn] = st.st_mtime;
+			delete m;
+			continue;
+		}
+		failed.erase (fn);
+		found[fn] = m;
+	}
+	closedir (d);
+
+	// remaining masters were removed or changed
+	for (std::map <std::string, MasterFrame *>::iterator iter = masters.begin (); iter != masters.end (); iter++)
+		delete iter->second;
+	masters = found;
+}
+
+bool CalibrationFrames::matches (MasterFrame *m, const char *camera, int binx, int biny, double temperature)
+{
+	if (!m->camera.empty () && camera && m->camera != camera)
+		return false;
+	if (m->binx > 0 && binx > 0 && m->binx != binx)
+		return false;
+	if (m->biny > 0 && biny > 0 && m->biny != biny)
+		return false;
+	// flats do not depend on temperature
+	if (m->type != CALIBRATION_FLAT && fabs (m->temperature - temperature) > tolerance)
+		return false;
+	return true;
+}
+
+CalibrationSet *CalibrationFrames::createSet (MasterFrame *bias, MasterFrame *dark, MasterFrame *flat)
+{
+	MasterFrame *frames[3] = {bias, dark, flat};
+	MasterFrame *first = NULL;
+	for (int i = 0; i < 3; i++)
+	{
+		if (frames[i] == NULL)
+			continue;
+		if (frames[i]->load ())
+			return NULL;
+		if (first == NULL)
+		{
+			first = frames[i];
+			continue;
+		}
+		if (frames[i]->getChannelSize () != first->getChannelSize ())
+		{
+			logStream (MESSAGE_ERROR) << "master " << frames[i]->filename << " has " << frames[i]->getChannelSize () << " channels, " << first->filename << " has " << first->getChannelSize () << sendLog;
+			return NULL;
+		}
+		for (size_t c = 0; c < first->getChannelSize (); c++)
+		{
+			if (frames[i]->getWidth (c) != first->getWidth (c) || frames[i]->getHeight (c) != first->getHeight (c))
+			{
+				logStream (MESSAGE_ERROR) << "size of master " << frames[i]->filename << " channel " << c + 1 << " differs from size of " << first->filename << sendLog;
+				return NULL;
+			}
+		}
+	}
+
+	CalibrationSet *set = new CalibrationSet ();
+	if (bias)
+		set->bias = bias->filename;
+	// dark without bias is used only with matching exposure, as part of the offset
+	bool scaleDark = dark && bias;
+	if (dark)
+		set->dark = dark->filename;
+	if (scaleDark)
+		set->darkExposure = dark->exposure;
+	if (flat)
+		set->flat = flat->filename;
+
+	for (size_t c = 0; c < first->getChannelSize (); c++)
+	{
+		long npix = first->getWidth (c) * first->getHeight (c);
+		set->widths.push_back (first->getWidth (c));
+		set->heights.push_back (first->getHeight (c));
+
+		float *offset = NULL;
+		if (bias)
+		{
+			offset = new float[npix];
+			memcpy (offset, bias->getData (c), npix * sizeof (float));
+		}
+		else if (dark)
+		{
+			offset = new float[npix];
+			memcpy (offset, dark->getData (c), npix * sizeof (float));
+		}
+		set->offsets.push_back (offset);
+
+		float *darkCurrent = NULL;
+		if (scaleDark)
+		{
+			darkCurrent = new float[npix];
+			const float *b = bias->getData (c);
+			const float *d = dark->getData (c);
+			// dark including bias is scaled only by its dark current part
+			for (long p = 0; p < npix; p++)
+				darkCurrent[p] = dark->darkSubtracted ? d[p] : d[p] - b[p];
+		}
+		set->darks.push_back (darkCurrent);
+
+		float *gain = NULL;
+		if (flat)
+		{
+			const float *f = flat->getData (c);
+			double sum = 0;
+			long cnt = 0;
+			for (long p = 0; p < npix; p++)
+			{
+				if (f[p] > 0)
+				{
+					sum += f[p];
+					cnt++;
+				}
+			}
+			float mean = cnt > 0 ? sum / cnt : 1;
+			gain = new float[npix];
+			for (long p = 0; p < npix; p++)
+				gain[p] = f[p] > 0 ? mean / f[p] : 0;
+		}
+		set->gains.push_back (gain);
+	}
+
+	logStream (MESSAGE_DEBUG) << "calibration set bias " << set->bias << " dark " << set->dark << " exposure " << set->darkExposure << " flat " << set->flat << sendLog;
+	return set;
+}
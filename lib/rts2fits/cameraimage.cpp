@@ -33,6 +33,8 @@ CameraImage::~CameraImage (void)
 	deviceWaits.clear ();
 	delete image;
 	image = NULL;
+	for (std::vector < char * >::iterator iter = dataBuffers.begin (); iter != dataBuffers.end (); iter++)
+		delete[] *iter;
 }
 
 void CameraImage::waitForDevice (rts2core::DevClient * devClient, double after)
@@ -88,6 +88,14 @@ Channel::~Channel ()
 	delete[] sizes;
 }
 
+void Channel::setData (char *_data)
+{
+	if (allocated)
+		delete[] data;
+	data = _data;
+	allocated = true;
+}
+
 template <typename pixel_type> void computeDataStatistics (pixel_type *data, long totalPixels, long double &pixelSum, double &average, double &stdev)
 {
 	// calculate average of all channels..
@@ -17,9 +17,11 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#include <algorithm>
 #include <ctype.h>
 
 #include "rts2fits/devcliimg.h"
+#include "imgcombine.h"
 #include "iniparser.h"
 #include "configuration.h"
 #include "valuerectangle.h"
@@ -31,9 +33,13 @@ DevClientCameraImage::DevClientCameraImage (rts2core::Connection * in_connection
 {
 	chipNumbers = 0;
 	saveImage = 1;
+	streamImage = false;
 
 	fitsTemplate = NULL;
 
+	calibration = NULL;
+	calibrationRaw = false;
+
 	rts2core::Configuration *config = rts2core::Configuration::instance ();
 
 	telescop[0] = '\0';
@@ -73,6 +79,11 @@ DevClientCameraImage::DevClientCameraImage (rts2core::Connection * in_connection
 		}
 	}
 
+	std::string calibrationDir;
+	config->getString (connection->getName (), "calibration", calibrationDir);
+	if (calibrationDir.length () > 0)
+		setCalibration (calibrationDir.c_str (), config->getDoubleDefault (connection->getName (), "calibration-temperature", 2.0), config->getBoolean (connection->getName (), "calibration-raw", false));
+
 	actualImage = NULL;
 
 	expNum = 0;
@@ -82,10 +93,21 @@ DevClientCameraImage::DevClientCameraImage (rts2core::Connection * in_connection
 
 DevClientCameraImage::~DevClientCameraImage (void)
 {
+	while (!streamedData.empty ())
+		eraseStreamedData (streamedData.begin ()->first);
+	delete calibration;
 	delete fitsTemplate;
 	delete actualImage;
 }
 
+void DevClientCameraImage::setCalibration (const char *directory, double tolerance, bool writeRaw)
+{
+	delete calibration;
+	calibration = new CalibrationFrames (directory, tolerance);
+	calibrationRaw = writeRaw;
+	logStream (MESSAGE_DEBUG) << "calibrating images with masters from " << directory << sendLog;
+}
+
 Image * DevClientCameraImage::setImage (Image * old_img, Image * new_image)
 {
 	for (CameraImages::iterator iter = images.begin (); iter != images.end (); iter++)
@@ -208,13 +230,19 @@ void DevClientCameraImage::fits2DataChannels (Image *img, rts2core::DataChannels
 	// add channels one by one
 	for (int i = 0; i < img->getChannelSize (); i++)
 	{
+		const void *chd = img->getChannelData (i);
+		if (chd == NULL)
+		{
+			logStream (MESSAGE_ERROR) << "data of channel " << i << " are not available" << sendLog;
+			break;
+		}
 		struct imghdr imgh;
 		img->getImgHeader (&imgh, i);
 		long ts = img->getChannelNPixels (i) * img->getPixelByteSize ();
 		rts2core::DataRead *dr = new rts2core::DataRead (ts + sizeof (struct imghdr), img->getDataType ());
 		dr->setChunkSizeFromData ();
 		dr->addData ((char *) (&imgh), sizeof (struct imghdr));
-		dr->addData ((char *) img->getChannelData (i), ts);
+		dr->addData ((char *) chd, ts);
 		data->push_back (dr);
 	}
 }
@@ -228,6 +256,121 @@ void DevClientCameraImage::writeFilter (Image *img)
 	img->setFilter (imageFilter);
 }
 
+CalibrationSet * DevClientCameraImage::getCalibration (Image *img, struct imghdr *imgh)
+{
+	if (calibration == NULL)
+		return NULL;
+
+	// filter is truncated to the same length as in the image header
+	char filter[5];
+	strncpy (filter, getConnection ()->getValueSelection ("filter", ntohs (imgh->filter)), 4);
+	filter[4] = '\0';
+
+	CalibrationSet *set = calibration->acquire (getName (), getConnection ()->getValueInteger ("BINX"), getConnection ()->getValueInteger ("BINY"), filter, img->getExposureLength (), getConnection ()->getValueDouble ("CCD_TEMP"));
+	if (set == NULL)
+		return NULL;
+
+	size_t chan = ntohs (imgh->channel) - 1;
+	if (chan >= set->getChannelSize () || set->getWidth (chan) != (long) ntohl (imgh->sizes[0]) || set->getHeight (chan) != (long) ntohl (imgh->sizes[1]))
+	{
+		logStream (MESSAGE_WARNING) << "size of channel " << chan + 1 << " of image " << img->getAbsoluteFileName () << " does not match size of master frames, the channel will not be calibrated" << sendLog;
+		calibration->release (set);
+		return NULL;
+	}
+	return set;
+}
+
+void DevClientCameraImage::writeCalibrationHeaders (Image *img, CalibrationSet *set)
+{
+	if (!img->getFitsFile ())
+		return;
+	try
+	{
+		img->setValue ("CALIBRAT", set != NULL, "data are calibrated");
+		if (set == NULL)
+			return;
+		if (!set->bias.empty ())
+			img->setValue ("CALBIAS", set->bias.c_str (), "master bias subtracted from data");
+		if (!set->dark.empty ())
+		{
+			img->setValue ("CALDARK", set->dark.c_str (), "master dark subtracted from data");
+			img->setValue ("CALDSCAL", set->getDarkScale (img->getExposureLength ()), "master dark scaling");
+		}
+		if (!set->flat.empty ())
+			img->setValue ("CALFLAT", set->flat.c_str (), "master flat data were divided by");
+	}
+	catch (rts2core::Error &er)
+	{
+		logStream (MESSAGE_ERROR) << "cannot write calibration headers to " << img->getAbsoluteFileName () << ": " << er << sendLog;
+	}
+}
+
+int DevClientCameraImage::startStreamedChannel (StreamedData &sdata)
+{
+	Image *img = sdata.image->image;
+	sdata.calibration = getCalibration (img, &(sdata.imgh));
+	sdata.rawchan = -1;
+
+	if (sdata.calibration == NULL)
+	{
+		sdata.schan = img->startStreamData (&(sdata.imgh), sdata.nchan);
+		return sdata.schan < 0 ? -1 : 0;
+	}
+
+	int nchan = calibrationRaw ? 2 * sdata.nchan : sdata.nchan;
+	if (calibrationRaw)
+	{
+		sdata.rawchan = img->startStreamData (&(sdata.imgh), nchan, true);
+		if (sdata.rawchan < 0)
+			return -1;
+		writeCalibrationHeaders (img, NULL);
+	}
+
+	struct imghdr calh = sdata.imgh;
+	calh.data_type = htons (RTS2_DATA_FLOAT);
+	sdata.schan = img->startStreamData (&calh, nchan);
+	if (sdata.schan < 0)
+		return -1;
+	writeCalibrationHeaders (img, sdata.calibration);
+	return 0;
+}
+
+void DevClientCameraImage::writeCalibratedData (CameraImage *ci, CalibrationSet *set, char *in_data, char *fullTop, int nchan)
+{
+	struct imghdr *imgh = (struct imghdr *) in_data;
+	size_t chan = ntohs (imgh->channel) - 1;
+	int dataType = ntohs (imgh->data_type);
+	long npix = (fullTop - in_data - sizeof (struct imghdr)) / (dataType == RTS2_DATA_ULONG ? 4 : abs (dataType) / 8);
+	if (npix > set->getWidth (chan) * set->getHeight (chan))
+		npix = set->getWidth (chan) * set->getHeight (chan);
+
+	if (calibrationRaw)
+	{
+		nchan *= 2;
+		ci->writeData (in_data, fullTop, nchan, true);
+		writeCalibrationHeaders (ci->image, NULL);
+	}
+
+	size_t size = sizeof (struct imghdr) + npix * sizeof (float);
+	char *buf = ci->allocateData (size);
+	memcpy (buf, in_data, sizeof (struct imghdr));
+	((struct imghdr *) buf)->data_type = htons (RTS2_DATA_FLOAT);
+	rts2core::calibratePixels (dataType, in_data + sizeof (struct imghdr), npix, set->getOffset (chan), set->getDark (chan), set->getDarkScale (ci->image->getExposureLength ()), set->getGain (chan), (float *) (buf + sizeof (struct imghdr)));
+
+	ci->writeData (buf, buf + size, nchan);
+	writeCalibrationHeaders (ci->image, set);
+}
+
+void DevClientCameraImage::eraseStreamedData (rts2core::DataAbstractRead *data)
+{
+	std::map <rts2core::DataAbstractRead *, StreamedData>::iterator sd = streamedData.find (data);
+	if (sd == streamedData.end ())
+		return;
+	if (sd->second.calibration)
+		calibration->release (sd->second.calibration);
+	streamedData.erase (sd);
+}
+
 void DevClientCameraImage::newDataConn (int data_conn)
 {
 	if (!actualImage)
@@ -270,9 +413,112 @@ void DevClientCameraImage::newDataConn (int data_conn)
 		connection->postMaster (new rts2core::Event (EVENT_WRITE_TO_IMAGE, actualImage));
 	}
 	images[data_conn] = actualImage;
+
+	if (streamImage && !actualImage->image->hasKeepImage ())
+	{
+		rts2core::DataChannels *chann = getConnection ()->getDataChannels (data_conn);
+		if (chann)
+		{
+			for (rts2core::DataChannels::iterator iter = chann->begin (); iter != chann->end (); iter++)
+			{
+				(*iter)->setStreaming ();
+				// remove entry left by data connection which was not finished
+				eraseStreamedData (*iter);
+			}
+		}
+	}
+
 	actualImage = NULL;
 }
 
+void DevClientCameraImage::dataReceived (rts2core::DataAbstractRead *data)
+{
+	rts2core::DevClientCamera::dataReceived (data);
+	if (!streamImage)
+		return;
+
+	std::map <rts2core::DataAbstractRead *, StreamedData>::iterator sd = streamedData.find (data);
+	if (sd == streamedData.end ())
+	{
+		// find image and number of channels
+		for (CameraImages::iterator iter = images.begin (); iter != images.end (); iter++)
+		{
+			rts2core::DataChannels *chann = getConnection ()->getDataChannels (iter->first);
+			if (chann == NULL || std::find (chann->begin (), chann->end (), data) == chann->end ())
+				continue;
+			if (iter->second->image->hasKeepImage ())
+				return;
+			StreamedData nsd;
+			nsd.image = iter->second;
+			nsd.nchan = chann->size ();
+			nsd.schan = -1;
+			nsd.written = 0;
+			nsd.calibration = NULL;
+			nsd.rawchan = -1;
+			sd = streamedData.insert (std::pair <rts2core::DataAbstractRead *, StreamedData> (data, nsd)).first;
+			break;
+		}
+		if (sd == streamedData.end ())
+			return;
+	}
+
+	StreamedData &sdata = sd->second;
+	if (sdata.schan == -2)
+		return;
+
+	if (sdata.schan == -1)
+	{
+		if (data->getDataTop () - data->getDataBuff () < (ssize_t) sizeof (struct imghdr))
+			return;
+		memcpy (&(sdata.imgh), data->getDataBuff (), sizeof (struct imghdr));
+		if (startStreamedChannel (sdata))
+		{
+			logStream (MESSAGE_ERROR) << "cannot start streaming of image " << sdata.image->image->getAbsoluteFileName () << sendLog;
+			sdata.schan = -2;
+			return;
+		}
+		sdata.written = sizeof (struct imghdr);
+	}
+
+	// image data type is float for calibrated data
+	int dataType = ntohs (sdata.imgh.data_type);
+	int pixelByteSize = dataType == RTS2_DATA_ULONG ? 4 : abs (dataType) / 8;
+	char *start = data->getDataBuff () + (sdata.written - data->getDataOffset ());
+	long npix = (data->getDataTop () - start) / pixelByteSize;
+	if (npix <= 0)
+		return;
+
+	Image *img = sdata.image->image;
+	long firstpix = (sdata.written - sizeof (struct imghdr)) / pixelByteSize;
+	if (sdata.calibration)
+	{
+		if (sdata.rawchan >= 0 && img->writeStreamData (sdata.rawchan, firstpix, start, npix))
+			logStream (MESSAGE_ERROR) << "cannot write raw data to image " << img->getAbsoluteFileName () << sendLog;
+
+		// pixels beyond the channel size cannot be calibrated
+		size_t chan = ntohs (sdata.imgh.channel) - 1;
+		long cpix = sdata.calibration->getWidth (chan) * sdata.calibration->getHeight (chan) - firstpix;
+		if (cpix > npix)
+			cpix = npix;
+		const float *offset = sdata.calibration->getOffset (chan);
+		const float *dark = sdata.calibration->getDark (chan);
+		const float *gain = sdata.calibration->getGain (chan);
+		if (sdata.calibrated.size () < (size_t) npix)
+			sdata.calibrated.resize (npix);
+		if (cpix > 0)
+			rts2core::calibratePixels (dataType, start, cpix, offset ? offset + firstpix : NULL, dark ? dark + firstpix : NULL, sdata.calibration->getDarkScale (img->getExposureLength ()), gain ? gain + firstpix : NULL, &(sdata.calibrated[0]));
+		if (cpix > 0 && img->writeStreamData (sdata.schan, firstpix, (char *) &(sdata.calibrated[0]), cpix))
+			logStream (MESSAGE_ERROR) << "cannot write data to image " << img->getAbsoluteFileName () << sendLog;
+	}
+	else if (img->writeStreamData (sdata.schan, firstpix, start, npix))
+	{
+		logStream (MESSAGE_ERROR) << "cannot write data to image " << img->getAbsoluteFileName () << sendLog;
+	}
+
+	sdata.written += npix * pixelByteSize;
+	data->discardData (sdata.written - data->getDataOffset ());
+}
+
 void DevClientCameraImage::allImageDataReceived (int data_conn, rts2core::DataChannels *data, bool data2fits)
 {
 	CameraImages::iterator iter = images.find (data_conn);
@@ -288,7 +534,12 @@ void DevClientCameraImage::allImageDataReceived (int data_conn, rts2core::DataCh
 	{
 		CameraImage *ci = (*iter).second;
 
-		ci->writeMetaData ((struct imghdr *) ((*(data->begin ()))->getDataBuff ()));
+		// header of streamed data is not in the data buffer
+		std::map <rts2core::DataAbstractRead *, StreamedData>::iterator sd = streamedData.find (*(data->begin ()));
+		if (sd != streamedData.end () && sd->second.schan >= 0)
+			ci->writeMetaData (&(sd->second.imgh));
+		else
+			ci->writeMetaData ((struct imghdr *) ((*(data->begin ()))->getDataBuff ()));
 
 		// detector coordinates,..
 		rts2core::ValueRectangle *detsize = getRectangle ("DETSIZE");
@@ -306,9 +557,31 @@ void DevClientCameraImage::allImageDataReceived (int data_conn, rts2core::DataCh
 
 		for (rts2core::DataChannels::iterator di = data->begin (); di != data->end (); di++)
 		{
-			ci->writeData ((*di)->getDataBuff (), (*di)->getDataTop (), data2fits ? data->size () : -data->size ());
+			struct imghdr *imgh;
 
-			struct imghdr *imgh = (struct imghdr *) ((*di)->getDataBuff ());
+			sd = streamedData.find (*di);
+			if (sd != streamedData.end () && sd->second.schan >= 0)
+			{
+				// raw data first, so calibrated channel HDU is the current one
+				if (sd->second.rawchan >= 0)
+					ci->endStreamData (sd->second.rawchan);
+				ci->endStreamData (sd->second.schan);
+				imgh = &(sd->second.imgh);
+			}
+			else
+			{
+				imgh = (struct imghdr *) ((*di)->getDataBuff ());
+				CalibrationSet *cs = data2fits ? getCalibration (ci->image, imgh) : NULL;
+				if (cs)
+				{
+					writeCalibratedData (ci, cs, (*di)->getDataBuff (), (*di)->getDataTop (), data->size ());
+					calibration->release (cs);
+				}
+				else
+				{
+					ci->writeData ((*di)->getDataBuff (), (*di)->getDataTop (), data2fits ? data->size () : -data->size ());
+				}
+			}
 
 			uint16_t chan = ntohs (imgh->channel) - 1;
 
@@ -435,6 +708,9 @@ void DevClientCameraImage::allImageDataReceived (int data_conn, rts2core::DataCh
 			}
 		}
 
+		for (rts2core::DataChannels::iterator di = data->begin (); di != data->end (); di++)
+			eraseStreamedData (*di);
+
 		ci->image->moveHDU (1);
 
 		cameraImageReady (ci->image);
@@ -288,6 +288,9 @@ Image::~Image (void)
 		arrayGroups.erase (iter++);
 	}
 
+	for (std::vector <StreamChannel>::iterator iter = streamChannels.begin (); iter != streamChannels.end (); iter++)
+		delete iter->statistics;
+
 	delete[]templateDeviceName;
 	delete[]targetName;
 	delete[]cameraName;
@@ -922,136 +925,333 @@ void Image::writeWCS (double mods[NUM_WCS_VALUES])
 	}
 }
 
-int Image::writeData (char *in_data, char *fullTop, int nchan)
+/**
+ * Update statistics with pixels of given type.
+ */
+static void updateStatistics (rts2core::ImageStatistics *statistics, int pixelType, const char *data, long npix)
+{
+	switch (pixelType)
+	{
+		case RTS2_DATA_BYTE:
+			statistics->update ((const unsigned char *) data, npix);
+			break;
+		case RTS2_DATA_SHORT:
+			statistics->update ((const int16_t *) data, npix);
+			break;
+		case RTS2_DATA_LONG:
+			statistics->update ((const int32_t *) data, npix);
+			break;
+		case RTS2_DATA_LONGLONG:
+			statistics->update ((const int64_t *) data, npix);
+			break;
+		case RTS2_DATA_FLOAT:
+			statistics->update ((const float *) data, npix);
+			break;
+		case RTS2_DATA_DOUBLE:
+			statistics->update ((const double *) data, npix);
+			break;
+		case RTS2_DATA_SBYTE:
+			statistics->update ((const signed char *) data, npix);
+			break;
+		case RTS2_DATA_USHORT:
+			statistics->update ((const uint16_t *) data, npix);
+			break;
+		case RTS2_DATA_ULONG:
+			statistics->update ((const uint32_t *) data, npix);
+			break;
+	}
+}
+
+/**
+ * Read pixels of the current HDU.
+ *
+ * @return -1 on unknown data type, otherwise 0; check fits_status for errors
+ */
+static int readPixels (fitsfile *ff, int dataType, long npix, char *data, int *fits_status)
+{
+	int anyNull = 0;
+	switch (dataType)
+	{
+		case RTS2_DATA_BYTE:
+			fits_read_img_byt (ff, 0, 1, npix, 0, (unsigned char *) data, &anyNull, fits_status);
+			break;
+		case RTS2_DATA_SHORT:
+			fits_read_img_sht (ff, 0, 1, npix, 0, (int16_t *) data, &anyNull, fits_status);
+			break;
+		case RTS2_DATA_LONG:
+			fits_read_img_int (ff, 0, 1, npix, 0, (int *) data, &anyNull, fits_status);
+			break;
+		case RTS2_DATA_LONGLONG:
+			fits_read_img_lnglng (ff, 0, 1, npix, 0, (LONGLONG *) data, &anyNull, fits_status);
+			break;
+		case RTS2_DATA_FLOAT:
+			fits_read_img_flt (ff, 0, 1, npix, 0, (float *) data, &anyNull, fits_status);
+			break;
+		case RTS2_DATA_DOUBLE:
+			fits_read_img_dbl (ff, 0, 1, npix, 0, (double *) data, &anyNull, fits_status);
+			break;
+		case RTS2_DATA_SBYTE:
+			fits_read_img_sbyt (ff, 0, 1, npix, 0, (signed char *) data, &anyNull, fits_status);
+			break;
+		case RTS2_DATA_USHORT:
+			fits_read_img_usht (ff, 0, 1, npix, 0, (short unsigned int *) data, &anyNull, fits_status);
+			break;
+		case RTS2_DATA_ULONG:
+			fits_read_img_uint (ff, 0, 1, npix, 0, (unsigned int *) data, &anyNull, fits_status);
+			break;
+		default:
+			return -1;
+	}
+	return 0;
+}
+
+int Image::writeData (char *in_data, char *fullTop, int nchan, bool raw)
 {
 	struct imghdr *im_h = (struct imghdr *) in_data;
 	int ret;
 
-	average = 0;
-	avg_stdev = 0;
+	if (!raw)
+	{
+		average = 0;
+		avg_stdev = 0;
+	}
+
+	long dataSize = (fullTop - in_data) - sizeof (struct imghdr);
+	char *pixelData = in_data + sizeof (struct imghdr);
 
 	// we have to copy data to FITS anyway, so let's do it right now..
+	ret = createChannelHDU (im_h, pixelData, dataSize, nchan, raw);
+	if (ret < 0)
+		return -1;
+	if (ret == 1)
+		return 0;
+
+	int headerRet = writeImgHeader (im_h, abs (nchan));
+
+	int pixelType = ntohs (im_h->data_type);
+	long pixelSize = dataSize / (pixelType == RTS2_DATA_ULONG ? 4 : abs (pixelType) / 8);
+
+	if (nchan > 0)
+	{
+		ret = writePixels (pixelType, 0, pixelData, pixelSize);
+		if (ret)
+			return ret;
+	}
+
+	if (writeRTS2Values)
+	{
+		if (raw)
+		{
+			rts2core::ImageStatistics statistics (false);
+			updateStatistics (&statistics, pixelType, pixelData, pixelSize);
+			setValue ("AVERAGE", statistics.getAverage (), "average value of image");
+			setValue ("STDEV", statistics.getStDev (), "standard deviation value of image");
+			return headerRet;
+		}
+
+		Channel *ch = channels.back ();
+		ch->computeStatistics (0, pixelSize);
+
+		setValue ("AVERAGE", ch->getAverage (), "average value of image");
+		setValue ("STDEV", ch->getStDev (), "standard deviation value of image");
+	}
+	return headerRet;
+}
+
+int Image::startStreamData (struct imghdr *im_h, int nchan, bool raw)
+{
+	int ret = createChannelHDU (im_h, NULL, 0, nchan, raw);
+	if (ret < 0)
+		return -1;
+
+	StreamChannel sc;
+	sc.hdu = -1;
+	sc.dataType = ntohs (im_h->data_type);
+	sc.raw = raw;
+	if (ret == 0)
+	{
+		if (writeImgHeader (im_h, abs (nchan)))
+			return -1;
+		fits_get_hdu_num (getFitsFile (), &(sc.hdu));
+	}
+	sc.statistics = new rts2core::ImageStatistics (false);
+	streamChannels.push_back (sc);
+	return streamChannels.size () - 1;
+}
+
+int Image::writeStreamData (int schan, long firstpix, char *data, long npix)
+{
+	StreamChannel &sc = streamChannels[schan];
+	updateStatistics (sc.statistics, sc.dataType, data, npix);
+
+	// image is not saved
+	if (sc.hdu < 0)
+		return 0;
+
+	int hdu;
+	fits_get_hdu_num (getFitsFile (), &hdu);
+	if (hdu != sc.hdu)
+	{
+		fits_movabs_hdu (getFitsFile (), sc.hdu, NULL, &fits_status);
+		if (fits_status)
+		{
+			logStream (MESSAGE_ERROR) << "cannot move to HDU " << sc.hdu << ": " << getFitsErrors () << sendLog;
+			return -1;
+		}
+	}
+	return writePixels (sc.dataType, firstpix, data, npix);
+}
+
+int Image::endStreamData (int schan)
+{
+	StreamChannel &sc = streamChannels[schan];
+
+	double chAverage = sc.statistics->getAverage ();
+	double chStdev = sc.statistics->getStDev ();
+
+	delete sc.statistics;
+	sc.statistics = NULL;
+
+	// raw data do not change image statistics
+	if (!sc.raw)
+	{
+		average = chAverage;
+		avg_stdev = chStdev;
+	}
+
+	if (sc.hdu < 0)
+		return 0;
+
+	fits_movabs_hdu (getFitsFile (), sc.hdu, NULL, &fits_status);
+	if (fits_status)
+	{
+		logStream (MESSAGE_ERROR) << "cannot move to HDU " << sc.hdu << ": " << getFitsErrors () << sendLog;
+		return -1;
+	}
+
+	if (writeRTS2Values)
+	{
+		setValue ("AVERAGE", chAverage, "average value of image");
+		setValue ("STDEV", chStdev, "standard deviation value of image");
+	}
+	return 0;
+}
+
+int Image::createChannelHDU (struct imghdr *im_h, char *pixelData, long dataSize, int nchan, bool raw)
+{
 	if (im_h->naxes != 2)
 	{
 		logStream (MESSAGE_ERROR) << "Image::writeDate not 2D image " << im_h->naxes << sendLog;
 		return -1;
 	}
 	flags |= IMAGE_SAVE;
-	dataType = ntohs (im_h->data_type);
+	int pixelType = ntohs (im_h->data_type);
 
 	long sizes[2];
 	sizes[0] = ntohl (im_h->sizes[0]);
 	sizes[1] = ntohl (im_h->sizes[1]);
 
-	long dataSize = (fullTop - in_data) - sizeof (struct imghdr);
-	char *pixelData = in_data + sizeof (struct imghdr);
+	if (!raw)
+	{
+		dataType = pixelType;
 
-	Channel *ch;
+		Channel *ch;
 
-	if (flags & IMAGE_KEEP_DATA)
-	{
-		ch = new Channel (ntohs (im_h->channel), pixelData, dataSize, 2, sizes, dataType);
-	}
-	else
-	{
-		ch = new Channel (ntohs (im_h->channel), pixelData, 2, sizes, dataType, false);
-	}
+		if (pixelData != NULL && (flags & IMAGE_KEEP_DATA))
+		{
+			ch = new Channel (ntohs (im_h->channel), pixelData, dataSize, 2, sizes, dataType);
+		}
+		else
+		{
+			ch = new Channel (ntohs (im_h->channel), pixelData, 2, sizes, dataType, false);
+		}
 
-	channels.push_back (ch);
+		channels.push_back (ch);
+	}
 
 	if (!getFitsFile () || !(flags & IMAGE_SAVE))
 	{
 		#ifdef DEBUG_EXTRA
 		logStream (MESSAGE_DEBUG) << "not saving data " << getFitsFile () << " " << (flags & IMAGE_SAVE) << sendLog;
 		#endif					 /* DEBUG_EXTRA */
-		return 0;
+		return 1;
 	}
 
 	// either put it as a new extension, or keep it in primary..
 
 	if (nchan == 1)
 	{
-		if (dataType == RTS2_DATA_SBYTE)
+		if (pixelType == RTS2_DATA_SBYTE)
 			fits_resize_img (getFitsFile (), RTS2_DATA_BYTE, 2, sizes, &fits_status);
 		else
-			fits_resize_img (getFitsFile (), dataType, 2, sizes, &fits_status);
+			fits_resize_img (getFitsFile (), pixelType, 2, sizes, &fits_status);
 		if (fits_status)
 		{
-			logStream (MESSAGE_ERROR) << "cannot resize image: " << getFitsErrors () << "dataType " << dataType << sendLog;
+			logStream (MESSAGE_ERROR) << "cannot resize image: " << getFitsErrors () << "dataType " << pixelType << sendLog;
 			return -1;
 		}
 	}
 	else if (nchan > 1)
 	{
-		if (dataType == RTS2_DATA_SBYTE)
+		if (pixelType == RTS2_DATA_SBYTE)
 		{
 			fits_create_img (getFitsFile (), RTS2_DATA_BYTE, 2, sizes, &fits_status);
 		}
 		else
 		{
-			fits_create_img (getFitsFile (), dataType, 2, sizes, &fits_status);
+			fits_create_img (getFitsFile (), pixelType, 2, sizes, &fits_status);
 		}
 		if (fits_status)
 		{
-			logStream (MESSAGE_ERROR) << "cannot create image: " << getFitsErrors () << "dataType " << dataType << sendLog;
+			logStream (MESSAGE_ERROR) << "cannot create image: " << getFitsErrors () << "dataType " << pixelType << sendLog;
 			return -1;
 		}
 	}
 
-	ret = writeImgHeader (im_h, abs (nchan));
-
-	long pixelSize = dataSize / getPixelByteSize ();
+	return 0;
+}
 
-	if (nchan > 0)
+int Image::writePixels (int pixelType, long firstpix, char *pixelData, long npix)
+{
+	switch (pixelType)
 	{
-		switch (dataType)
-		{
-			case RTS2_DATA_BYTE:
-				fits_write_img_byt (getFitsFile (), 0, 1, pixelSize, (unsigned char *) pixelData, &fits_status);
-				break;
-			case RTS2_DATA_SHORT:
-				fits_write_img_sht (getFitsFile (), 0, 1, pixelSize, (int16_t *) pixelData, &fits_status);
-				break;
-			case RTS2_DATA_LONG:
-				fits_write_img_int (getFitsFile (), 0, 1, pixelSize, (int *) pixelData, &fits_status);
-				break;
-			case RTS2_DATA_LONGLONG:
-				fits_write_img_lnglng (getFitsFile (), 0, 1, pixelSize, (LONGLONG *) pixelData, &fits_status);
-				break;
-			case RTS2_DATA_FLOAT:
-				fits_write_img_flt (getFitsFile (), 0, 1, pixelSize, (float *) pixelData, &fits_status);
-				break;
-			case RTS2_DATA_DOUBLE:
-				fits_write_img_dbl (getFitsFile (), 0, 1, pixelSize, (double *) pixelData, &fits_status);
-				break;
-			case RTS2_DATA_SBYTE:
-				fits_write_img_sbyt (getFitsFile (), 0, 1, pixelSize, (signed char *) pixelData, &fits_status);
-				break;
-			case RTS2_DATA_USHORT:
-				fits_write_img_usht (getFitsFile (), 0, 1, pixelSize, (short unsigned int *) pixelData, &fits_status);
-				break;
-			case RTS2_DATA_ULONG:
-				fits_write_img_uint (getFitsFile (), 0, 1, pixelSize, (unsigned int *) pixelData, &fits_status);
-				break;
-			default:
-				logStream (MESSAGE_ERROR) << "Unknow dataType " << dataType << sendLog;
-				return -1;
-		}
-		if (fits_status)
-		{
-			logStream (MESSAGE_ERROR) << "cannot write data: " << getFitsErrors () << sendLog;
+		case RTS2_DATA_BYTE:
+			fits_write_img_byt (getFitsFile (), 0, firstpix + 1, npix, (unsigned char *) pixelData, &fits_status);
+			break;
+		case RTS2_DATA_SHORT:
+			fits_write_img_sht (getFitsFile (), 0, firstpix + 1, npix, (int16_t *) pixelData, &fits_status);
+			break;
+		case RTS2_DATA_LONG:
+			fits_write_img_int (getFitsFile (), 0, firstpix + 1, npix, (int *) pixelData, &fits_status);
+			break;
+		case RTS2_DATA_LONGLONG:
+			fits_write_img_lnglng (getFitsFile (), 0, firstpix + 1, npix, (LONGLONG *) pixelData, &fits_status);
+			break;
+		case RTS2_DATA_FLOAT:
+			fits_write_img_flt (getFitsFile (), 0, firstpix + 1, npix, (float *) pixelData, &fits_status);
+			break;
+		case RTS2_DATA_DOUBLE:
+			fits_write_img_dbl (getFitsFile (), 0, firstpix + 1, npix, (double *) pixelData, &fits_status);
+			break;
+		case RTS2_DATA_SBYTE:
+			fits_write_img_sbyt (getFitsFile (), 0, firstpix + 1, npix, (signed char *) pixelData, &fits_status);
+			break;
+		case RTS2_DATA_USHORT:
+			fits_write_img_usht (getFitsFile (), 0, firstpix + 1, npix, (short unsigned int *) pixelData, &fits_status);
+			break;
+		case RTS2_DATA_ULONG:
+			fits_write_img_uint (getFitsFile (), 0, firstpix + 1, npix, (unsigned int *) pixelData, &fits_status);
+			break;
+		default:
+			logStream (MESSAGE_ERROR) << "Unknow dataType " << pixelType << sendLog;
 			return -1;
-		}
 	}
-
-	if (writeRTS2Values)
+	if (fits_status)
 	{
-		ch->computeStatistics (0, pixelSize);
-
-		setValue ("AVERAGE", ch->getAverage (), "average value of image");
-		setValue ("STDEV", ch->getStDev (), "standard deviation value of image");
+		logStream (MESSAGE_ERROR) << "cannot write data: " << getFitsErrors () << sendLog;
+		return -1;
 	}
-	return ret;
+	return 0;
 }
 
 void Image::getImgHeader (struct imghdr *im_h, int chan)
@@ -1104,8 +1304,7 @@ void Image::getHistogram (long *histogram, long nbins)
 {
 	memset (histogram, 0, nbins * sizeof(int));
 	int bins;
-	if (channels.size () == 0)
-		loadChannels ();
+	loadChannelData ();
 
 	switch (dataType)
 	{
@@ -1138,8 +1337,7 @@ void Image::getChannelHistogram (int chan, long *histogram, long nbins)
 {
 	memset (histogram, 0, nbins * sizeof(int));
 	int bins;
-	if (channels.size () == 0)
-		loadChannels ();
+	loadChannelData ();
 
 	switch (dataType)
 	{
@@ -1539,8 +1737,7 @@ Magick::Image *Image::getMagickImage (const char *label, float quantiles, int ch
 
 	  	if (chan >= 0)
 		{
-			if (channels.size () == 0)
-				loadChannels ();
+			loadChannelData ();
 			if ((size_t) chan >= channels.size ())
 				throw rts2core::Error ("invalid channel specified");
 
@@ -1555,8 +1752,7 @@ Magick::Image *Image::getMagickImage (const char *label, float quantiles, int ch
 		}
 		else
 		{
-		  	if (channels.size () == 0)
-			  	loadChannels ();
+			loadChannelData ();
 			// all channels
 			int w = floor (sqrt (channels.size ()));
 			if (w <= 0)
@@ -1860,8 +2056,7 @@ void Image::setFilter (const char *in_filter)
 
 void Image::computeStatistics (size_t _from, size_t _dataSize)
 {
-	if (channels.size () == 0)
-		loadChannels ();
+	loadChannelData ();
 
 	pixelSum = 0;
 	long totalSize = 0;
@@ -1887,7 +2082,6 @@ void Image::computeStatistics (size_t _from, size_t _dataSize)
 void Image::loadChannels ()
 {
 	// try to load data..
-	int anyNull = 0;
 	if (!getFitsFile ())
 		openFile (NULL, false, true);
 
@@ -1959,40 +2153,12 @@ void Image::loadChannels ()
 			pixelSize *= sizes[i];
 
 		char *imageData = new char[pixelSize * getPixelByteSize ()];
-		switch (dataType)
+		if (readPixels (getFitsFile (), dataType, pixelSize, imageData, &fits_status))
 		{
-			case RTS2_DATA_BYTE:
-				fits_read_img_byt (getFitsFile (), 0, 1, pixelSize, 0, (unsigned char *) imageData, &anyNull, &fits_status);
-				break;
-			case RTS2_DATA_SHORT:
-				fits_read_img_sht (getFitsFile (), 0, 1, pixelSize, 0, (int16_t *) imageData, &anyNull, &fits_status);
-				break;
-			case RTS2_DATA_LONG:
-				fits_read_img_int (getFitsFile (), 0, 1, pixelSize, 0, (int *) imageData, &anyNull, &fits_status);
-				break;
-			case RTS2_DATA_LONGLONG:
-				fits_read_img_lnglng (getFitsFile (), 0, 1, pixelSize, 0, (LONGLONG *) imageData, &anyNull, &fits_status);
-				break;
-			case RTS2_DATA_FLOAT:
-				fits_read_img_flt (getFitsFile (), 0, 1, pixelSize, 0, (float *) imageData, &anyNull, &fits_status);
-				break;
-			case RTS2_DATA_DOUBLE:
-				fits_read_img_dbl (getFitsFile (), 0, 1, pixelSize, 0, (double *) imageData, &anyNull, &fits_status);
-				break;
-			case RTS2_DATA_SBYTE:
-				fits_read_img_sbyt (getFitsFile (), 0, 1, pixelSize, 0, (signed char *) imageData, &anyNull, &fits_status);
-				break;
-			case RTS2_DATA_USHORT:
-				fits_read_img_usht (getFitsFile (), 0, 1, pixelSize, 0,(short unsigned int *) imageData, &anyNull, &fits_status);
-				break;
-			case RTS2_DATA_ULONG:
-				fits_read_img_uint (getFitsFile (), 0, 1, pixelSize, 0, (unsigned int *) imageData, &anyNull, &fits_status);
-				break;
-			default:
-				logStream (MESSAGE_ERROR) << "Unknow dataType " << dataType << sendLog;
-				delete[] imageData;
-				dataType = 0;
-				throw ErrorOpeningFitsFile (getFileName ());
+			logStream (MESSAGE_ERROR) << "Unknow dataType " << dataType << sendLog;
+			delete[] imageData;
+			dataType = 0;
+			throw ErrorOpeningFitsFile (getFileName ());
 		}
 		if (fits_status)
 		{
@@ -2037,13 +2203,45 @@ void Image::loadChannels ()
 	moveHDU (1);
 }
 
-const void* Image::getChannelData (int chan)
+void Image::loadChannelData ()
 {
 	if (channels.size () == 0)
+	{
+		loadChannels ();
+		return;
+	}
+
+	// channels of streamed image do not hold data, read them back from the file
+	Channels::iterator ch = channels.begin ();
+	for (std::vector <StreamChannel>::iterator iter = streamChannels.begin (); iter != streamChannels.end () && ch != channels.end (); iter++)
+	{
+		if (iter->raw)
+			continue;
+		if ((*ch)->getData () == NULL)
+		{
+			if (iter->hdu < 0)
+				throw rts2core::Error ("streamed image was not saved, channel data are not available");
+			fits_movabs_hdu (getFitsFile (), iter->hdu, NULL, &fits_status);
+			long npix = (*ch)->getNPixels ();
+			char *imageData = new char[npix * getPixelByteSize ()];
+			if (fits_status || readPixels (getFitsFile (), (*ch)->getDataType (), npix, imageData, &fits_status) || fits_status)
+			{
+				delete[] imageData;
+				throw rts2core::Error (std::string ("cannot read streamed channel data: ") + getFitsErrors ());
+			}
+			(*ch)->setData (imageData);
+		}
+		ch++;
+	}
+}
+
+const void* Image::getChannelData (int chan)
+{
+	if (channels.size () == 0 || channels[chan]->getData () == NULL)
 	{
 		try
 		{
-			loadChannels ();
+			loadChannelData ();
 		}
 		catch (rts2core::Error er)
 		{
@@ -0,0 +1,445 @@
+/*
+ * Master calibration frames builder.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "rts2fits/mastercal.h"
+#include "imgcombine.h"
+
+#include <math.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+// size of the central region used to compute normalisation level
+#define MASTERCAL_LEVEL_SIZE   512
+
+using namespace rts2image;
+
+MasterCalibration::MasterCalibration ()
+{
+	method = COMBINE_MEDIAN;
+	sigma = 3.0;
+	iterations = 3;
+	normalize = false;
+	threads = 1;
+	tileMemory = 16 * 1024 * 1024;
+
+	pool = NULL;
+	fitsParallel = false;
+	outBuffer = NULL;
+}
+
+MasterCalibration::~MasterCalibration ()
+{
+	closeInputs ();
+}
+
+int MasterCalibration::build (const char *output, bool overwrite)
+{
+	if (inputs.empty ())
+	{
+		logStream (MESSAGE_ERROR) << "no input frames for master " << output << sendLog;
+		return -1;
+	}
+
+	if (openInputs ())
+	{
+		closeInputs ();
+		return -1;
+	}
+
+	Image *first = images[0];
+	for (size_t i = 1; i < inputs.size (); i++)
+	{
+		if (!normalize && images[i]->getExposureLength () != first->getExposureLength ())
+			logStream (MESSAGE_WARNING) << "exposure length of " << inputs[i] << " (" << images[i]->getExposureLength () << ") differs from exposure length of " << inputs[0] << " (" << first->getExposureLength () << ")" << sendLog;
+	}
+
+	struct timeval tv;
+	tv.tv_sec = first->getExposureSec ();
+	tv.tv_usec = first->getExposureUsec ();
+
+	Image *master = new Image (output, &tv, overwrite, false, true);
+	if (master->getFitsFile () == NULL)
+	{
+		logStream (MESSAGE_ERROR) << "cannot create master " << output << sendLog;
+		delete master;
+		closeInputs ();
+		return -1;
+	}
+
+	pool = new rts2core::WorkerPool (threads);
+	fitsParallel = fits_is_reentrant ();
+	if (!fitsParallel && threads > 1)
+		logStream (MESSAGE_DEBUG) << "cfitsio is not reentrant, input frames will be read serially" << sendLog;
+
+	int ret = 0;
+	int nchan = channelHDUs[0].size ();
+	for (channel = 0; channel < nchan && ret == 0; channel++)
+		ret = processChannel (master, nchan);
+
+	delete pool;
+	pool = NULL;
+
+	if (ret == 0)
+	{
+		try
+		{
+			master->moveHDU (1);
+			master->setValue ("EXPOSURE", first->getExposureLength (), "exposure length of the first combined frame");
+			// values used to select master for calibration
+			first->moveHDU (1);
+			double ccdTemp = NAN;
+			first->getValue ("CCD_TEMP", ccdTemp, false);
+			if (!std::isnan (ccdTemp))
+				master->setValue ("CCD_TEMP", ccdTemp, "CCD temperature of the first combined frame");
+			int bin = -1;
+			first->getValue ("BINX", bin, false);
+			if (bin > 0)
+				master->setValue ("BINX", bin, "binning along X axis");
+			bin = -1;
+			first->getValue ("BINY", bin, false);
+			if (bin > 0)
+				master->setValue ("BINY", bin, "binning along Y axis");
+			if (first->getFilter () && strcmp (first->getFilter (), "UNK"))
+				master->setValue ("FILTER", first->getFilter (), "filter of combined frames");
+			if (first->getCameraName () && strcmp (first->getCameraName (), "UNK"))
+				master->setValue ("CCD_NAME", first->getCameraName (), "camera of combined frames");
+			master->setValue ("NCOMBINE", (int) inputs.size (), "number of combined frames");
+			master->setValue ("COMBINE", method == COMBINE_MEDIAN ? "median" : "sigma-clip", "combination method");
+			if (method == COMBINE_SIGMA_CLIP)
+			{
+				master->setValue ("CLIPSIG", sigma, "sigma clipping limit");
+				master->setValue ("CLIPITER", iterations, "number of sigma clipping iterations");
+			}
+			if (!dark.empty ())
+				master->setValue ("DARKSUB", dark.c_str (), "dark subtracted from combined frames");
+			master->setValue ("NORMALIZ", normalize, "frames were normalised by their central region mean");
+			for (std::vector <std::string>::iterator iter = inputs.begin (); iter != inputs.end (); iter++)
+				master->writeHistory ((std::string ("combined ") + *iter).c_str ());
+		}
+		catch (rts2core::Error &er)
+		{
+			logStream (MESSAGE_ERROR) << "cannot write master headers: " << er << sendLog;
+			ret = -1;
+		}
+	}
+
+	if (ret)
+		master->deleteImage ();
+	else
+		ret = master->saveImage ();
+	delete master;
+
+	closeInputs ();
+	return ret;
+}
+
+int MasterCalibration::openInputs ()
+{
+	std::vector <std::string> names = inputs;
+	if (!dark.empty ())
+		names.push_back (dark);
+
+	for (std::vector <std::string>::iterator iter = names.begin (); iter != names.end (); iter++)
+	{
+		Image *image = new Image ();
+		try
+		{
+			image->openFile (iter->c_str (), true, false);
+		}
+		catch (rts2core::Error &er)
+		{
+			logStream (MESSAGE_ERROR) << "cannot open " << *iter << ": " << er << sendLog;
+			delete image;
+			return -1;
+		}
+		images.push_back (image);
+
+		std::vector <int> hdus;
+		if (findChannels (image, hdus))
+		{
+			logStream (MESSAGE_ERROR) << *iter << " does not contain any image" << sendLog;
+			return -1;
+		}
+		if (!channelHDUs.empty () && channelHDUs[0].size () != hdus.size ())
+		{
+			logStream (MESSAGE_ERROR) << *iter << " has " << hdus.size () << " channels, " << names[0] << " has " << channelHDUs[0].size () << sendLog;
+			return -1;
+		}
+		channelHDUs.push_back (hdus);
+	}
+
+	levels.resize (images.size ());
+	scales.resize (images.size ());
+	readStatus.resize (images.size ());
+	buffers.resize (images.size ());
+	return 0;
+}
+
+void MasterCalibration::closeInputs ()
+{
+	for (std::vector <Image *>::iterator iter = images.begin (); iter != images.end (); iter++)
+	{
+		(*iter)->closeFile ();
+		delete *iter;
+	}
+	images.clear ();
+	channelHDUs.clear ();
+
+	for (std::vector <float *>::iterator iter = buffers.begin (); iter != buffers.end (); iter++)
+		delete[] *iter;
+	buffers.clear ();
+	delete[] outBuffer;
+	outBuffer = NULL;
+}
+
+int MasterCalibration::findChannels (FitsFile *image, std::vector <int> &hdus)
+{
+	fitsfile *ff = image->getFitsFile ();
+	int status = 0;
+	int nhdus = 0;
+	fits_get_num_hdus (ff, &nhdus, &status);
+	for (int h = 1; h <= nhdus && status == 0; h++)
+	{
+		int hdutype;
+		int naxis = 0;
+		long sizes[2];
+		fits_movabs_hdu (ff, h, &hdutype, &status);
+		if (status || hdutype != IMAGE_HDU)
+			continue;
+		fits_get_img_dim (ff, &naxis, &status);
+		if (status || naxis != 2)
+			continue;
+		fits_get_img_size (ff, 2, sizes, &status);
+		if (status == 0 && sizes[0] > 0 && sizes[1] > 0)
+			hdus.push_back (h);
+	}
+	return hdus.empty () ? -1 : 0;
+}
+
+int MasterCalibration::processChannel (Image *master, int nchan)
+{
+	size_t nimages = images.size ();
+	size_t ninputs = inputs.size ();
+
+	long sizes[2];
+	for (size_t i = 0; i < nimages; i++)
+	{
+		long s[2];
+		int status = 0;
+		fits_movabs_hdu (images[i]->getFitsFile (), channelHDUs[i][channel], NULL, &status);
+		fits_get_img_size (images[i]->getFitsFile (), 2, s, &status);
+		if (i == 0)
+		{
+			sizes[0] = s[0];
+			sizes[1] = s[1];
+		}
+		else if (s[0] != sizes[0] || s[1] != sizes[1])
+		{
+			logStream (MESSAGE_ERROR) << images[i]->getFileName () << " channel " << channel + 1 << " size " << s[0] << "x" << s[1] << " differs from size of the first frame " << sizes[0] << "x" << sizes[1] << sendLog;
+			return -1;
+		}
+	}
+	width = sizes[0];
+	height = sizes[1];
+
+	for (size_t i = 0; i < nimages; i++)
+		scales[i] = 1;
+
+	if (normalize)
+	{
+		fitsFor (levelTask);
+		for (size_t i = 0; i < ninputs; i++)
+		{
+			double level = levels[i];
+			if (!dark.empty ())
+				level -= levels[ninputs];
+			if (!(level > 0))
+			{
+				logStream (MESSAGE_ERROR) << "invalid level " << level << " of " << inputs[i] << ", cannot normalise it" << sendLog;
+				return -1;
+			}
+			scales[i] = 1 / level;
+		}
+	}
+
+	// input buffers of all images, and output buffer
+	tileRows = tileMemory / ((nimages + 1) * width * sizeof (float));
+	if (tileRows < 1)
+		tileRows = 1;
+	if (tileRows > height)
+		tileRows = height;
+
+	long maxRows = tileRows * pool->getThreads ();
+	if (maxRows > height)
+		maxRows = height;
+
+	for (size_t i = 0; i < nimages; i++)
+	{
+		delete[] buffers[i];
+		buffers[i] = new float[maxRows * width];
+	}
+	delete[] outBuffer;
+	outBuffer = new float[maxRows * width];
+
+	struct imghdr im_h;
+	memset (&im_h, 0, sizeof (im_h));
+	im_h.data_type = htons (RTS2_DATA_FLOAT);
+	im_h.naxes = 2;
+	im_h.sizes[0] = htonl (width);
+	im_h.sizes[1] = htonl (height);
+	im_h.binnings[0] = htons (1);
+	im_h.binnings[1] = htons (1);
+	im_h.channel = htons (channel + 1);
+
+	int schan = master->startStreamData (&im_h, nchan);
+	if (schan < 0)
+		return -1;
+
+	for (batchFirstRow = 0; batchFirstRow < height; batchFirstRow += batchRows)
+	{
+		batchRows = maxRows;
+		if (batchFirstRow + batchRows > height)
+			batchRows = height - batchFirstRow;
+
+		fitsFor (readTask);
+		for (size_t i = 0; i < nimages; i++)
+		{
+			if (readStatus[i])
+			{
+				char errtext[FLEN_ERRMSG];
+				fits_get_errstatus (readStatus[i], errtext);
+				logStream (MESSAGE_ERROR) << "cannot read rows " << batchFirstRow << " to " << batchFirstRow + batchRows << " of " << images[i]->getFileName () << ": " << errtext << sendLog;
+				return -1;
+			}
+		}
+
+		pool->parallelFor ((batchRows + tileRows - 1) / tileRows, combineTask, this);
+
+		if (master->writeStreamData (schan, batchFirstRow * width, (char *) outBuffer, batchRows * width))
+			return -1;
+	}
+
+	return master->endStreamData (schan);
+}
+
+void MasterCalibration::fitsFor (void (*func) (void *arg, size_t i))
+{
+	if (fitsParallel)
+	{
+		pool->parallelFor (images.size (), func, this);
+		return;
+	}
+	for (size_t i = 0; i < images.size (); i++)
+		func (this, i);
+}
+
+void MasterCalibration::computeLevel (size_t i)
+{
+	fitsfile *ff = images[i]->getFitsFile ();
+	long fpixel[2];
+	long lpixel[2];
+	long inc[2] = {1, 1};
+	long naxes[2] = {width, height};
+	long s[2];
+
+	s[0] = width < MASTERCAL_LEVEL_SIZE ? width : MASTERCAL_LEVEL_SIZE;
+	s[1] = height < MASTERCAL_LEVEL_SIZE ? height : MASTERCAL_LEVEL_SIZE;
+	fpixel[0] = (width - s[0]) / 2 + 1;
+	fpixel[1] = (height - s[1]) / 2 + 1;
+	lpixel[0] = fpixel[0] + s[0] - 1;
+	lpixel[1] = fpixel[1] + s[1] - 1;
+
+	std::vector <float> data (s[0] * s[1]);
+	int anynul = 0;
+	int status = 0;
+	fits_movabs_hdu (ff, channelHDUs[i][channel], NULL, &status);
+	fits_read_subset_flt (ff, 0, 2, naxes, fpixel, lpixel, inc, 0, &data[0], &anynul, &status);
+	if (status)
+	{
+		levels[i] = NAN;
+		return;
+	}
+
+	double sum = 0;
+	for (std::vector <float>::iterator iter = data.begin (); iter != data.end (); iter++)
+		sum += *iter;
+	levels[i] = sum / data.size ();
+}
+
+void MasterCalibration::readInput (size_t i)
+{
+	fitsfile *ff = images[i]->getFitsFile ();
+	int anynul = 0;
+	int status = 0;
+	fits_movabs_hdu (ff, channelHDUs[i][channel], NULL, &status);
+	fits_read_img_flt (ff, 0, batchFirstRow * width + 1, batchRows * width, 0, buffers[i], &anynul, &status);
+	readStatus[i] = status;
+}
+
+void MasterCalibration::combineTile (size_t t)
+{
+	size_t ninputs = inputs.size ();
+
+	long firstRow = t * tileRows;
+	long rows = tileRows;
+	if (firstRow + rows > batchRows)
+		rows = batchRows - firstRow;
+
+	size_t off = firstRow * width;
+	size_t npix = rows * width;
+
+	std::vector <const float *> frames (ninputs);
+	for (size_t i = 0; i < ninputs; i++)
+	{
+		float *f = buffers[i] + off;
+		if (!dark.empty ())
+		{
+			float *d = buffers[ninputs] + off;
+			for (size_t p = 0; p < npix; p++)
+				f[p] -= d[p];
+		}
+		if (scales[i] != 1)
+		{
+			float s = scales[i];
+			for (size_t p = 0; p < npix; p++)
+				f[p] *= s;
+		}
+		frames[i] = f;
+	}
+
+	if (method == COMBINE_MEDIAN)
+		rts2core::combineMedian (&frames[0], ninputs, npix, outBuffer + off);
+	else
+		rts2core::combineSigmaClip (&frames[0], ninputs, npix, sigma, iterations, outBuffer + off);
+}
+
+void MasterCalibration::levelTask (void *arg, size_t i)
+{
+	((MasterCalibration *) arg)->computeLevel (i);
+}
+
+void MasterCalibration::readTask (void *arg, size_t i)
+{
+	((MasterCalibration *) arg)->readInput (i);
+}
+
+void MasterCalibration::combineTask (void *arg, size_t t)
+{
+	((MasterCalibration *) arg)->combineTile (t);
+}
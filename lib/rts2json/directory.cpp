@@ -61,19 +61,7 @@ void Directory::authorizedExecute (XmlRpc::XmlRpcSource *source, std::string pat
 			}
 		}
 
-		struct stat st;
-		if (fstat (f, &st) == -1)
-			throw XmlRpcException ("Cannot get file properties");
-
-		response_length = st.st_size;
-		response = new char[response_length];
-		ssize_t ret = read (f, response, response_length);
-		if (ret != (ssize_t) response_length)
-		{
-			delete[] response;
-			throw XmlRpcException ("Cannot read file");
-		}
-		close (f);
+		sendFile (f);
 		// try to find type based on file extension
 		if (extp != std::string::npos)
 		{
@@ -229,12 +229,105 @@ void Previewer::pageLink (std::ostringstream& _os, int i, int pagesiz, int prevs
 #include <Magick++.h>
 using namespace Magick;
 
+JpegRenderer::JpegRenderer (const char *_path, char _kind, int _prevsize, const char *_label, float _quantiles, int _chan, int _colourVariant)
+{
+	path = _path;
+	kind = _kind;
+	prevsize = _prevsize;
+	label = _label ? _label : "";
+	quantiles = _quantiles;
+	chan = _chan;
+	colourVariant = _colourVariant;
+
+	image = NULL;
+	mimage = NULL;
+}
+
+JpegRenderer::~JpegRenderer ()
+{
+	delete mimage;
+	delete image;
+}
+
+void JpegRenderer::load ()
+{
+	image = new rts2image::Image ();
+	image->openFile (path.c_str (), true, false);
+	image->loadChannelData ();
+}
+
+void JpegRenderer::scale ()
+{
+	// label is drawn by drawLabel, as its expansion reads FITS header
+	mimage = image->getMagickImage (NULL, quantiles, chan, colourVariant);
+	if (kind != PREVIEW_FULL && prevsize > 0)
+		mimage->zoom (Magick::Geometry (prevsize, prevsize));
+}
+
+void JpegRenderer::drawLabel ()
+{
+	if (kind == PREVIEW_FULL)
+	{
+		if (label.empty ())
+			return;
+		mimage->font ("helvetica");
+		mimage->strokeColor (Magick::Color (MaxRGB, MaxRGB, MaxRGB));
+		mimage->fillColor (Magick::Color (MaxRGB, MaxRGB, MaxRGB));
+		image->writeLabel (mimage, 2, mimage->size ().height () - 2, 20, label.c_str ());
+	}
+	else if (prevsize > 0)
+	{
+		image->writeLabel (mimage, 0, mimage->size ().height (), 10, label.c_str ());
+	}
+	else
+	{
+		image->writeLabel (mimage, 1, mimage->rows () - 2, 10, label.c_str ());
+	}
+}
+
+void JpegRenderer::compress (char* &response, size_t &response_length)
+{
+	Blob blob;
+	mimage->write (&blob, "jpeg");
+
+	response_length = blob.length();
+	response = new char[response_length];
+	memcpy (response, blob.data(), response_length);
+}
+
+void rts2json::renderJpeg (const char *path, char kind, int prevsize, const char *label, float quantiles, int chan, int colourVariant, char* &response, size_t &response_length)
+{
+	JpegRenderer renderer (path, kind, prevsize, label, quantiles, chan, colourVariant);
+	renderer.load ();
+	renderer.scale ();
+	renderer.drawLabel ();
+	renderer.compress (response, response_length);
+}
+
+/**
+ * Returns preview from cache, or render it and put it to cache.
+ *
+ * @return opened disk cache file with the preview in its first response_length bytes, -1 if preview is in response
+ */
+static int cachedJpeg (PreviewCache *cache, const char *path, char kind, int prevsize, const char *label, float quantiles, int chan, int colourVariant, char* &response, size_t &response_length)
+{
+	std::string key;
+	if (cache == NULL || PreviewCache::getKey (key, path, kind, prevsize, label, quantiles, chan, colourVariant))
+	{
+		renderJpeg (path, kind, prevsize, label, quantiles, chan, colourVariant, response, response_length);
+		return -1;
+	}
+	int fd;
+	if (cache->get (key, response, response_length, fd))
+		return fd;
+	renderJpeg (path, kind, prevsize, label, quantiles, chan, colourVariant, response, response_length);
+	cache->put (key, response, response_length);
+	return -1;
+}
+
 void JpegImageRequest::authorizedExecute (XmlRpc::XmlRpcSource *source, std::string path, XmlRpc::HttpParams *params, const char* &response_type, char* &response, size_t &response_length)
 {
 	response_type = "image/jpeg";
-	rts2image::Image image;
-	image.openFile (path.c_str (), true, false);
-	Blob blob;
 
 	const char * label = params->getString ("lb", getServer ()->getDefaultImageLabel ());
 
@@ -242,16 +335,11 @@ void JpegImageRequest::authorizedExecute (XmlRpc::XmlRpcSource *source, std::str
 	int chan = params->getInteger ("chan", getServer ()->getDefaultChannel ());
 	int colourVariant = params->getInteger ("cv", DEFAULT_COLOURVARIANT);
 
-	Magick::Image *mimage = image.getMagickImage (label, quantiles, chan, colourVariant);
+	int fd = cachedJpeg (getServer ()->getPreviewCache (), path.c_str (), PREVIEW_FULL, 0, label, quantiles, chan, colourVariant, response, response_length);
+	if (fd >= 0)
+		sendFile (fd, response_length);
 
 	cacheMaxAge (CACHE_MAX_STATIC);
-
-	mimage->write (&blob, "jpeg");
-	response_length = blob.length();
-	response = new char[response_length];
-	memcpy (response, blob.data(), response_length);
-
-	delete mimage;
 }
 
 void JpegPreview::authorizedExecute (XmlRpc::XmlRpcSource *source, std::string path, XmlRpc::HttpParams *params, const char* &response_type, char* &response, size_t &response_length)
@@ -279,29 +367,11 @@ void JpegPreview::authorizedExecute (XmlRpc::XmlRpcSource *source, std::string p
 	{
 		response_type = "image/jpeg";
 
-		rts2image::Image image;
-		image.openFile (absPath, true, false);
-		Blob blob;
-
-		Magick::Image *mimage = image.getMagickImage (NULL, quantiles, chan, colourVariant);
-		if (prevsize > 0)
-		{
-			mimage->zoom (Magick::Geometry (prevsize, prevsize));
-			image.writeLabel (mimage, 0, mimage->size ().height (), 10, label);
-		}
-		else
-		{
-			image.writeLabel (mimage, 1, mimage->rows () - 2, 10, label);
-		}
+		int fd = cachedJpeg (getServer ()->getPreviewCache (), absPath, PREVIEW_ZOOM, prevsize, label, quantiles, chan, colourVariant, response, response_length);
+		if (fd >= 0)
+			sendFile (fd, response_length);
 
 		cacheMaxAge (CACHE_MAX_STATIC);
-
-		mimage->write (&blob, "jpeg");
-		response_length = blob.length();
-		response = new char[response_length];
-		memcpy (response, blob.data(), response_length);
-
-		delete mimage;
 		return;
 	}
 
@@ -418,25 +488,7 @@ void JpegPreview::authorizedExecute (XmlRpc::XmlRpcSource *source, std::string p
 void FitsImageRequest::authorizedExecute (XmlRpc::XmlRpcSource *source, std::string path, XmlRpc::HttpParams *params, const char* &response_type, char* &response, size_t &response_length)
 {
 	response_type = "image/fits";
-	int f = open (path.c_str (), O_RDONLY);
-	if (f == -1)
-	{
-		throw XmlRpc::XmlRpcException ("Cannot open file");
-	}
-	struct stat st;
-	if (fstat (f, &st) == -1)
-		throw XmlRpc::XmlRpcException ("Cannot get file properties");
-	
-	response_length = st.st_size;
-	response = new char[response_length];
-	ssize_t ret;
-	ret = read (f, response, response_length);
-	if (ret != (ssize_t) response_length)
-	{
-		delete[] response;
-		throw XmlRpc::XmlRpcException ("Cannot read data");
-	}
-	close (f);
+	sendFile (path.c_str ());
 }
 
 void DownloadRequest::authorizedExecute (XmlRpc::XmlRpcSource *source, std::string path, XmlRpc::HttpParams *params, const char* &response_type, char* &response, size_t &response_length)
@@ -0,0 +1,534 @@
+/*
+ * Cache of rendered image previews.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "rts2json/previewcache.h"
+#include "rts2json/imgpreview.h"
+#include "workerpool.h"
+#include "logstream.h"
+#include "app.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+// maximal number of queued rendering requests
+#define PREVIEW_WARM_QUEUE    1000
+
+// maximal number of previews waiting for disk write
+#define PREVIEW_DISK_QUEUE    100
+
+// disk cache is pruned to this fraction of its limit
+#define PREVIEW_DISK_PRUNE    0.9
+
+using namespace rts2json;
+
+static void *previewThread (void *arg)
+{
+	((PreviewCache *) arg)->run ();
+	return NULL;
+}
+
+#ifdef RTS2_HAVE_LIBJPEG
+// queued preview rendered by renderWarm
+struct WarmRender
+{
+	std::string path;
+	std::string key;
+	JpegRenderer *renderer;
+	char *data;
+	size_t len;
+	// empty if rendering succeeded
+	std::string error;
+};
+
+static void scaleTask (void *arg, size_t i)
+{
+	WarmRender &w = (*((std::vector <WarmRender> *) arg))[i];
+	try
+	{
+		w.renderer->scale ();
+	}
+	catch (std::exception &ex)
+	{
+		w.error = ex.what ();
+	}
+}
+
+static void compressTask (void *arg, size_t i)
+{
+	WarmRender &w = (*((std::vector <WarmRender> *) arg))[i];
+	if (!w.error.empty ())
+		return;
+	try
+	{
+		w.renderer->compress (w.data, w.len);
+	}
+	catch (std::exception &ex)
+	{
+		w.error = ex.what ();
+	}
+}
+#endif
+
+PreviewCache::PreviewCache ()
+{
+	memoryLimit = 64 * 1024 * 1024;
+	diskLimit = 1024 * 1024 * 1024;
+	threads = 1;
+
+	pool = NULL;
+
+	pthread_mutex_init (&mutex, NULL);
+	pthread_cond_init (&cond, NULL);
+	running = false;
+
+	memorySize = 0;
+	diskSize = 0;
+	hits = 0;
+	misses = 0;
+}
+
+PreviewCache::~PreviewCache ()
+{
+	stop ();
+
+	pthread_mutex_destroy (&mutex);
+	pthread_cond_destroy (&cond);
+}
+
+void PreviewCache::setParameters (size_t _memoryLimit, const char *_cacheDir, size_t _diskLimit, int _threads)
+{
+	memoryLimit = _memoryLimit;
+	cacheDir = _cacheDir ? _cacheDir : "";
+	diskLimit = _diskLimit;
+	threads = _threads < 1 ? 1 : _threads;
+}
+
+int PreviewCache::start ()
+{
+#ifdef RTS2_HAVE_LIBJPEG
+	if (pool == NULL)
+		pool = new rts2core::WorkerPool (threads);
+#endif
+
+	if (!cacheDir.empty ())
+	{
+		if (mkdir (cacheDir.c_str (), 0755) && errno != EEXIST)
+		{
+			logStream (MESSAGE_ERROR) << "cannot create preview cache directory " << cacheDir << ": " << strerror (errno) << sendLog;
+			cacheDir = "";
+		}
+		else
+		{
+			// find size of the existing cache
+			DIR *d = opendir (cacheDir.c_str ());
+			struct dirent *de;
+			while (d && (de = readdir (d)) != NULL)
+			{
+				struct stat st;
+				if (de->d_name[0] != '.' && stat ((cacheDir + "/" + de->d_name).c_str (), &st) == 0)
+					diskSize += st.st_size;
+			}
+			if (d)
+				closedir (d);
+		}
+	}
+
+	if (cacheDir.empty ())
+		return 0;
+
+	running = true;
+	int ret = pthread_create (&thread, NULL, previewThread, (void *) this);
+	if (ret)
+	{
+		running = false;
+		logStream (MESSAGE_ERROR) << "cannot start preview cache thread, disk cache disabled: " << strerror (ret) << sendLog;
+		cacheDir = "";
+		return -1;
+	}
+	return 0;
+}
+
+void PreviewCache::stop ()
+{
+	warmQueue.clear ();
+
+	delete pool;
+	pool = NULL;
+
+	pthread_mutex_lock (&mutex);
+	if (running == false)
+	{
+		pthread_mutex_unlock (&mutex);
+		return;
+	}
+	running = false;
+	pthread_cond_signal (&cond);
+	pthread_mutex_unlock (&mutex);
+
+	pthread_join (thread, NULL);
+}
+
+int PreviewCache::getKey (std::string &key, const char *path, char kind, int prevsize, const char *label, float quantiles, int chan, int colourVariant)
+{
+	// the same file can be requested through various paths
+	char rpath[PATH_MAX];
+	if (realpath (path, rpath) == NULL)
+		return -1;
+
+	struct stat st;
+	if (stat (rpath, &st))
+		return -1;
+
+	std::ostringstream os;
+	os << rpath << " " << st.st_mtime << " " << st.st_size << " " << kind << " " << prevsize << " " << quantiles << " " << chan << " " << colourVariant << " " << (label ? label : "");
+	key = os.str ();
+	return 0;
+}
+
+bool PreviewCache::get (const std::string &key, char* &response, size_t &response_length, int &fd)
+{
+	response = NULL;
+	fd = -1;
+
+	pthread_mutex_lock (&mutex);
+	std::map <std::string, MemoryEntry>::iterator iter = memory.find (key);
+	if (iter != memory.end ())
+	{
+		lru.splice (lru.begin (), lru, iter->second.lruIter);
+		response_length = iter->second.data.size ();
+		response = new char[response_length];
+		memcpy (response, &(iter->second.data[0]), response_length);
+		hits++;
+		pthread_mutex_unlock (&mutex);
+		return true;
+	}
+	pthread_mutex_unlock (&mutex);
+
+	// disk hits are streamed from the file, and are not put to memory
+	fd = getDisk (key, response_length);
+	if (fd >= 0)
+	{
+		pthread_mutex_lock (&mutex);
+		hits++;
+		pthread_mutex_unlock (&mutex);
+		return true;
+	}
+
+	pthread_mutex_lock (&mutex);
+	misses++;
+	pthread_mutex_unlock (&mutex);
+	return false;
+}
+
+void PreviewCache::put (const std::string &key, const char *data, size_t len)
+{
+	pthread_mutex_lock (&mutex);
+	putMemory (key, data, len);
+	// preview is kept only in memory if disk writes cannot keep up
+	if (running && len > 0 && diskQueue.size () < PREVIEW_DISK_QUEUE)
+	{
+		diskQueue.push_back (DiskRequest ());
+		diskQueue.back ().key = key;
+		diskQueue.back ().data.assign (data, data + len);
+		pthread_cond_signal (&cond);
+	}
+	pthread_mutex_unlock (&mutex);
+}
+
+void PreviewCache::warm (const char *path, int prevsize, const char *label, float quantiles, int chan, int colourVariant)
+{
+	WarmRequest req;
+	req.path = path;
+	req.prevsize = prevsize;
+	req.label = label ? label : "";
+	req.quantiles = quantiles;
+	req.chan = chan;
+	req.colourVariant = colourVariant;
+
+#ifdef RTS2_HAVE_LIBJPEG
+	if (warmQueue.size () < PREVIEW_WARM_QUEUE)
+		warmQueue.push_back (req);
+#endif
+}
+
+void PreviewCache::renderWarm ()
+{
+#ifdef RTS2_HAVE_LIBJPEG
+	if (pool == NULL)
+		return;
+
+	// single preview for each pool thread
+	std::vector <WarmRender> batch;
+	while (!warmQueue.empty () && batch.size () < (size_t) pool->getThreads ())
+	{
+		WarmRequest req = warmQueue.front ();
+		warmQueue.pop_front ();
+
+		std::string key;
+		if (getKey (key, req.path.c_str (), PREVIEW_ZOOM, req.prevsize, req.label.c_str (), req.quantiles, req.chan, req.colourVariant))
+			continue;
+
+		pthread_mutex_lock (&mutex);
+		bool cached = memory.find (key) != memory.end ();
+		pthread_mutex_unlock (&mutex);
+
+		struct stat st;
+		if (cached || (!cacheDir.empty () && stat (diskPath (key).c_str (), &st) == 0))
+			continue;
+
+		WarmRender w;
+		w.path = req.path;
+		w.key = key;
+		w.renderer = new JpegRenderer (req.path.c_str (), PREVIEW_ZOOM, req.prevsize, req.label.c_str (), req.quantiles, req.chan, req.colourVariant);
+		w.data = NULL;
+		w.len = 0;
+		try
+		{
+			w.renderer->load ();
+		}
+		catch (std::exception &ex)
+		{
+			logStream (MESSAGE_WARNING) << "cannot render preview of " << req.path << ": " << ex.what () << sendLog;
+			delete w.renderer;
+			continue;
+		}
+		batch.push_back (w);
+	}
+
+	if (batch.empty ())
+		return;
+
+	std::vector <WarmRender>::iterator iter;
+
+	pool->parallelFor (batch.size (), scaleTask, &batch);
+
+	for (iter = batch.begin (); iter != batch.end (); iter++)
+	{
+		if (!iter->error.empty ())
+			continue;
+		try
+		{
+			iter->renderer->drawLabel ();
+		}
+		catch (std::exception &ex)
+		{
+			iter->error = ex.what ();
+		}
+	}
+
+	pool->parallelFor (batch.size (), compressTask, &batch);
+
+	for (iter = batch.begin (); iter != batch.end (); iter++)
+	{
+		if (iter->error.empty ())
+			put (iter->key, iter->data, iter->len);
+		else
+			logStream (MESSAGE_WARNING) << "cannot render preview of " << iter->path << ": " << iter->error << sendLog;
+		delete[] iter->data;
+		delete iter->renderer;
+	}
+#endif
+}
+
+void PreviewCache::run ()
+{
+	pthread_mutex_lock (&mutex);
+	while (true)
+	{
+		while (running && diskQueue.empty ())
+			pthread_cond_wait (&cond, &mutex);
+		// queued previews are written before the thread ends
+		if (diskQueue.empty ())
+			break;
+
+		DiskRequest req;
+		req.key.swap (diskQueue.front ().key);
+		req.data.swap (diskQueue.front ().data);
+		diskQueue.pop_front ();
+		pthread_mutex_unlock (&mutex);
+
+		putDisk (req.key, &req.data[0], req.data.size ());
+
+		pthread_mutex_lock (&mutex);
+	}
+	pthread_mutex_unlock (&mutex);
+}
+
+void PreviewCache::putMemory (const std::string &key, const char *data, size_t len)
+{
+	if (len > memoryLimit)
+		return;
+
+	std::map <std::string, MemoryEntry>::iterator iter = memory.find (key);
+	if (iter != memory.end ())
+	{
+		lru.splice (lru.begin (), lru, iter->second.lruIter);
+		return;
+	}
+
+	while (!lru.empty () && memorySize + len > memoryLimit)
+	{
+		std::map <std::string, MemoryEntry>::iterator last = memory.find (lru.back ());
+		memorySize -= last->second.data.size ();
+		memory.erase (last);
+		lru.pop_back ();
+	}
+
+	lru.push_front (key);
+	MemoryEntry &entry = memory[key];
+	entry.data.assign (data, data + len);
+	entry.lruIter = lru.begin ();
+	memorySize += len;
+}
+
+std::string PreviewCache::diskPath (const std::string &key)
+{
+	// FNV-1a hash of the key
+	uint64_t h = 14695981039346656037ULL;
+	for (std::string::const_iterator iter = key.begin (); iter != key.end (); iter++)
+	{
+		h ^= (unsigned char) *iter;
+		h *= 1099511628211ULL;
+	}
+	char buf[20];
+	snprintf (buf, 20, "%016llx", (unsigned long long) h);
+	return cacheDir + "/" + buf + ".jpg";
+}
+
+int PreviewCache::getDisk (const std::string &key, size_t &len)
+{
+	if (cacheDir.empty ())
+		return -1;
+
+	std::string fn = diskPath (key);
+	int fd = open (fn.c_str (), O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	struct stat st;
+	if (fstat (fd, &st) || (size_t) st.st_size <= key.length () + 1)
+	{
+		close (fd);
+		return -1;
+	}
+
+	// file ends with the key, which is verified to protect against hash collisions
+	len = st.st_size - key.length () - 1;
+	std::vector <char> k (key.length () + 1);
+	if (pread (fd, &k[0], k.size (), len) != (ssize_t) k.size () || key.compare (0, key.length (), &k[0], key.length ()) != 0 || k[key.length ()] != '\n')
+	{
+		close (fd);
+		return -1;
+	}
+
+	// modification time is used for pruning
+	utime (fn.c_str (), NULL);
+	return fd;
+}
+
+void PreviewCache::putDisk (const std::string &key, const char *data, size_t len)
+{
+	if (cacheDir.empty ())
+		return;
+
+	std::string fn = diskPath (key);
+	std::ostringstream tmpn;
+	tmpn << fn << "." << getpid () << "." << pthread_self () << ".tmp";
+
+	FILE *f = fopen (tmpn.str ().c_str (), "w");
+	if (f == NULL)
+	{
+		logStream (MESSAGE_WARNING) << "cannot write preview to " << tmpn.str () << ": " << strerror (errno) << sendLog;
+		return;
+	}
+	// preview is written first, so the file can be streamed to the client
+	bool ok = fwrite (data, len, 1, f) == 1 && fwrite (key.c_str (), key.length (), 1, f) == 1 && fputc ('\n', f) != EOF;
+	if (fclose (f) || !ok || rename (tmpn.str ().c_str (), fn.c_str ()))
+	{
+		unlink (tmpn.str ().c_str ());
+		return;
+	}
+
+	pthread_mutex_lock (&mutex);
+	diskSize += key.length () + 1 + len;
+	bool prune = diskSize > diskLimit;
+	pthread_mutex_unlock (&mutex);
+
+	if (prune)
+		pruneDisk ();
+}
+
+struct DiskEntry
+{
+	time_t mtime;
+	off_t size;
+	std::string name;
+
+	bool operator < (const DiskEntry &other) const { return mtime < other.mtime; }
+};
+
+void PreviewCache::pruneDisk ()
+{
+	std::vector <DiskEntry> entries;
+	size_t total = 0;
+
+	DIR *d = opendir (cacheDir.c_str ());
+	if (d == NULL)
+		return;
+	struct dirent *de;
+	while ((de = readdir (d)) != NULL)
+	{
+		struct stat st;
+		DiskEntry e;
+		if (de->d_name[0] == '.')
+			continue;
+		e.name = cacheDir + "/" + de->d_name;
+		if (stat (e.name.c_str (), &st))
+			continue;
+		e.mtime = st.st_mtime;
+		e.size = st.st_size;
+		total += st.st_size;
+		entries.push_back (e);
+	}
+	closedir (d);
+
+	std::sort (entries.begin (), entries.end ());
+
+	for (std::vector <DiskEntry>::iterator iter = entries.begin (); iter != entries.end () && total > diskLimit * PREVIEW_DISK_PRUNE; iter++)
+	{
+		if (unlink (iter->name.c_str ()) == 0)
+			total -= iter->size;
+	}
+
+	pthread_mutex_lock (&mutex);
+	diskSize = total;
+	pthread_mutex_unlock (&mutex);
+}
@@ -123,6 +123,8 @@ void Rts2SchedBag::mutateDelete (Rts2Schedule * sched)
 
 void Rts2SchedBag::mutate (Rts2Schedule * sched)
 {
+	sched->invalidateMerits ();
+
 	int rn = randomNumber (0, 100);
 	if (rn < mutateDurationRatio * 100 || sched->size () == 1)
 	{
@@ -144,8 +146,10 @@ void Rts2SchedBag::cross (Rts2Schedule *parent1, Rts2Schedule *parent2)
 	unsigned int crossPoint = randomNumber (minObsDuration, (JDend - JDstart) * 86400 - 2 * minObsDuration);
 
 	// have a sex
-	Rts2Schedule *child1 = new Rts2Schedule (parent1, parent2, crossPoint);
-	Rts2Schedule *child2 = new Rts2Schedule (parent2, parent1, crossPoint);
+	Rts2Schedule *child1 = newSchedule ();
+	child1->crossSchedules (parent1, parent2, crossPoint);
+	Rts2Schedule *child2 = newSchedule ();
+	child2->crossSchedules (parent2, parent1, crossPoint);
 
 	push_back (child1);
 	push_back (child2);
@@ -194,7 +198,7 @@ void Rts2SchedBag::pickElite (int _size, Rts2SchedBag::iterator _begin, Rts2Sche
 
 	// delete last members
 	for (Rts2SchedBag::iterator iter = _end - _size; iter != _end; iter++)
-		delete (*iter);
+		freeSchedule (*iter);
 
 	// remove deleted members..
 	erase (_end - _size, _end);
@@ -212,6 +216,12 @@ Rts2SchedBag::Rts2SchedBag (double _JDstart, double _JDend)
 
 	ticketSet = new rts2sched::TicketSet ();
 
+	ephemerisStep = 60;
+	ephemerisNight = NULL;
+	parallelEvaluation = false;
+
+	pool = new rts2core::WorkerPool (1);
+
 	mutationNum = -1;
 	popSize = 0;
 
@@ -244,8 +254,102 @@ Rts2SchedBag::~Rts2SchedBag (void)
 	}
 	clear ();
 
+	for (std::vector <Rts2Schedule *>::iterator iter = freeSchedules.begin (); iter != freeSchedules.end (); iter++)
+		delete *iter;
+
+	delete pool;
 	delete ticketSet;
 	delete tarSet;
+	delete ephemerisNight;
+}
+
+void Rts2SchedBag::setThreads (int _threads)
+{
+	delete pool;
+	pool = new rts2core::WorkerPool (_threads);
+}
+
+void Rts2SchedBag::evaluate ()
+{
+	// account set is loaded from the database on the first use, which cannot be done from pool threads
+	rts2db::AccountSet::instance ();
+
+	NSGAvalues.resize (size () * (constraints.size () + objectives.size ()));
+	if (parallelEvaluation)
+	{
+		pool->parallelFor (size (), evaluateSchedule, this);
+	}
+	else
+	{
+		for (size_t i = 0; i < size (); i++)
+			evaluateSchedule (this, i);
+	}
+}
+
+void Rts2SchedBag::evaluateSchedule (void *arg, size_t i)
+{
+	Rts2SchedBag *bag = (Rts2SchedBag *) arg;
+	Rts2Schedule *sched = (*bag)[i];
+	double *values = &(bag->NSGAvalues[i * (bag->constraints.size () + bag->objectives.size ())]);
+
+	for (std::list <constraintFunc>::iterator constIter = bag->constraints.begin (); constIter != bag->constraints.end (); constIter++, values++)
+		*values = sched->getConstraintFunction (*constIter);
+	for (std::list <objFunc>::iterator objIter = bag->objectives.begin (); objIter != bag->objectives.end (); objIter++, values++)
+		*values = sched->getObjectiveFunction (*objIter);
+
+	// used by simple GA
+	sched->singleOptimum ();
+}
+
+Rts2Schedule *Rts2SchedBag::newSchedule ()
+{
+	if (freeSchedules.empty ())
+		return new Rts2Schedule (JDstart, JDend, minObsDuration, rts2core::Configuration::instance ()->getObserver ());
+	Rts2Schedule *ret = freeSchedules.back ();
+	freeSchedules.pop_back ();
+	return ret;
+}
+
+void Rts2SchedBag::freeSchedule (Rts2Schedule *sched)
+{
+	sched->clearSchedule ();
+	freeSchedules.push_back (sched);
+}
+
+void Rts2SchedBag::cacheEphemeris ()
+{
+	parallelEvaluation = false;
+	if (ephemerisStep <= 0)
+		return;
+
+	struct ln_lnlat_posn *observer = rts2core::Configuration::instance ()->getObserver ();
+
+	// drop tables of the old night first - new night can be allocated at the same address
+	for (rts2db::TargetSet::iterator iter = tarSet->begin (); iter != tarSet->end (); iter++)
+		iter->second->setEphemeris (NULL);
+	for (rts2sched::TicketSet::iterator iter = ticketSet->begin (); iter != ticketSet->end (); iter++)
+		iter->second->getTarget ()->setEphemeris (NULL);
+
+	delete ephemerisNight;
+	ephemerisNight = new rts2core::NightEphemeris (observer, JDstart, JDend, ephemerisStep);
+
+	bool covered = true;
+
+	for (rts2sched::TicketSet::iterator iter = ticketSet->begin (); iter != ticketSet->end (); iter++)
+	{
+		rts2db::Target *tar = iter->second->getTarget ();
+		if (tar->getEphemeris () == NULL)
+			tar->setEphemeris (ephemerisNight);
+		// constraints are loaded lazily, load them before schedules are evaluated
+		tar->getConstraints ();
+
+		rts2core::TargetEphemeris *ephemeris = tar->getEphemeris ();
+		if (ephemeris == NULL || !ephemeris->contains (JDstart, observer) || !ephemeris->contains (JDend))
+			covered = false;
+	}
+
+	// pool threads may only read the tables
+	parallelEvaluation = covered;
 }
 
 int Rts2SchedBag::constructSchedules (int num)
@@ -259,6 +363,8 @@ int Rts2SchedBag::constructSchedules (int num)
 		return -1;
 	}
 
+	cacheEphemeris ();
+
 	for (int i = 0; i < num; i++)
 	{
 		Rts2Schedule *sched = new Rts2Schedule (JDstart, JDend, minObsDuration, observer);
@@ -273,6 +379,8 @@ int Rts2SchedBag::constructSchedules (int num)
 
 	reserve (popSize * 2);
 
+	evaluate ();
+
 	return 0;
 }
 
@@ -307,6 +415,8 @@ int Rts2SchedBag::constructSchedulesFromObsSet (int num, struct ln_date *obsNigh
 		return -1;
 	}
 
+	cacheEphemeris ();
+
 	for (int i = 0; i < num; i++)
 	{
 		Rts2Schedule *sched = new Rts2Schedule (JDstart, JDend, minObsDuration, observer);
@@ -321,6 +431,8 @@ int Rts2SchedBag::constructSchedulesFromObsSet (int num, struct ln_date *obsNigh
 
 	reserve (popSize * 2);
 
+	evaluate ();
+
 	return 0;
 }
 
@@ -451,17 +563,20 @@ void Rts2SchedBag::doGAStep ()
 	{
 		mutate ((*this)[randomNumber (0, size () - 1)]);
 	}
+
+	evaluate ();
 }
 
-int Rts2SchedBag::dominatesNSGA (Rts2Schedule *sched1, Rts2Schedule *sched2)
+int Rts2SchedBag::dominatesNSGA (const double *values_1, const double *values_2)
 {
 	// check for constraints
 	bool dom1 = false;
 	bool dom2 = false;
-	for (std::list <constraintFunc>::iterator constIter  = constraints.begin (); constIter != constraints.end (); constIter++)
+	size_t nc = constraints.size ();
+	for (size_t c = 0; c < nc; c++)
 	{
-		double cons1 = sched1->getConstraintFunction (*constIter);
-		double cons2 = sched2->getConstraintFunction (*constIter);
+		double cons1 = values_1[c];
+		double cons2 = values_2[c];
 		// if some schedule violate, prefer the one which does not violate..
 		if (cons1 == 0 && cons2 > 0)
 		  	return -1;
@@ -476,10 +591,10 @@ int Rts2SchedBag::dominatesNSGA (Rts2Schedule *sched1, Rts2Schedule *sched2)
 			  	dom2 = true;
 		}
 	}
-	for (std::list <objFunc>::iterator objIter = objectives.begin (); objIter != objectives.end (); objIter++)
+	for (size_t o = nc; o < nc + objectives.size (); o++)
 	{
-		double obj1 = sched1->getObjectiveFunction (*objIter);
-		double obj2 = sched2->getObjectiveFunction (*objIter);
+		double obj1 = values_1[o];
+		double obj2 = values_2[o];
 		if (obj1 > obj2)
 			dom1 = true;
 		else if (obj2 > obj1)
@@ -492,66 +607,76 @@ int Rts2SchedBag::dominatesNSGA (Rts2Schedule *sched1, Rts2Schedule *sched2)
 	return 0;
 }
 
+void Rts2SchedBag::dominanceRow (void *arg, size_t p)
+{
+	Rts2SchedBag *bag = (Rts2SchedBag *) arg;
+	size_t n = bag->size ();
+	size_t nv = bag->constraints.size () + bag->objectives.size ();
+	const double *values_p = &(bag->NSGAvalues[p * nv]);
+	signed char *dom = &(bag->NSGAdominance[0]);
+
+	// fill upper half of the row, and mirrored lower half of the column
+	dom[p * n + p] = 0;
+	for (size_t q = p + 1; q < n; q++)
+	{
+		int d = bag->dominatesNSGA (values_p, &(bag->NSGAvalues[q * nv]));
+		dom[p * n + q] = d;
+		dom[q * n + p] = -d;
+	}
+}
+
 void Rts2SchedBag::calculateNSGARanks ()
 {
-	// temporary structure which holds informations about ranks.
-	// Indexed by population (=schedule) number
-	struct {std::list <int> dominates; int dominated;} domStruct[size()];
-	// list of schedules in fronts
-	std::list <int> fronts[size ()];
+	size_t n = size ();
 
-	NSGAfronts.clear ();
-	NSGAfrontsSize.clear ();
+	NSGAdominance.resize (n * n);
+	pool->parallelFor (n, dominanceRow, this);
 
-	NSGAfronts.push_back (std::vector <Rts2Schedule *> ());
-	NSGAfrontsSize.push_back (0);
+	NSGAdominated.assign (n, 0);
+	NSGAcurrentFront.clear ();
 
-	for (unsigned int p = 0; p < size (); p++)
+	for (size_t p = 0; p < n; p++)
 	{
-		domStruct[p].dominated = 0;
-		Rts2Schedule *sched_p = (*this)[p];
-		for (unsigned int q = 0; q < size (); q++)
-		{
-		  	// do not calculate for ourselfs..
-			if (p == q)
-				continue;
-			Rts2Schedule *sched_q = (*this)[q];
-			int dom = dominatesNSGA (sched_p, sched_q);
-			if (dom == -1)
-				domStruct[p].dominates.push_back (q);
-			else if (dom == 1)
-			  	domStruct[p].dominated++;
-		}
-		if (domStruct[p].dominated == 0)
-		{
-			sched_p->setNSGARank (0);
-			fronts[0].push_back (p);
-			NSGAfronts[0].push_back (sched_p);
-			NSGAfrontsSize[0]++;
-		}
+		const signed char *row = &(NSGAdominance[p * n]);
+		int dominated = 0;
+		for (size_t q = 0; q < n; q++)
+			if (row[q] == 1)
+				dominated++;
+		NSGAdominated[p] = dominated;
+		if (dominated == 0)
+			NSGAcurrentFront.push_back (p);
 	}
-	int i = 0;
-	while (fronts[i].size () > 0)
+
+	size_t f = 0;
+	while (NSGAcurrentFront.size () > 0)
 	{
-		NSGAfronts.push_back (std::vector <Rts2Schedule *> ());
-		NSGAfrontsSize.push_back (0);
-		for (std::list <int>::iterator p = fronts[i].begin (); p != fronts[i].end (); p++)
+		if (f == NSGAfronts.size ())
+			NSGAfronts.push_back (std::vector <Rts2Schedule *> ());
+		NSGAfronts[f].clear ();
+		NSGAnextFront.clear ();
+
+		for (std::vector <int>::iterator p = NSGAcurrentFront.begin (); p != NSGAcurrentFront.end (); p++)
 		{
-			for (std::list <int>::iterator q = domStruct[*p].dominates.begin (); q != domStruct[*p].dominates.end (); q++)
+			Rts2Schedule *sched_p = (*this)[*p];
+			sched_p->setNSGARank (f);
+			NSGAfronts[f].push_back (sched_p);
+
+			// members dominated by p
+			const signed char *row = &(NSGAdominance[*p * n]);
+			for (size_t q = 0; q < n; q++)
 			{
-				domStruct[*q].dominated--;
-				if (domStruct[*q].dominated == 0)
-				{
-				 	Rts2Schedule *sched_q = (*this)[*q];
-					sched_q->setNSGARank (i + 1);
-					fronts[i + 1].push_back (*q);
-					NSGAfronts[i + 1].push_back (sched_q);
-					NSGAfrontsSize[i + 1]++;
-				}
+				if (row[q] == -1 && --NSGAdominated[q] == 0)
+					NSGAnextFront.push_back (q);
 			}
 		}
-		i++;
+		NSGAcurrentFront.swap (NSGAnextFront);
+		f++;
 	}
+
+	NSGAfronts.resize (f);
+	NSGAfrontsSize.resize (f);
+	for (f = 0; f < NSGAfronts.size (); f++)
+		NSGAfrontsSize[f] = NSGAfronts[f].size ();
 }
 
 // temporary operator for sorting based on crowding distance
@@ -622,63 +747,46 @@ void Rts2SchedBag::doNSGAIIStep ()
 	// we hold pointers to both parent and child population used/produced by previous step
 	calculateNSGARanks ();
 	// pick n members as parents of new population
-	Rts2Schedule *new_pop[popSize];
-	unsigned int n = 0;
-	unsigned int f;
+	NSGAnewPop.clear ();
 	unsigned int i;
-	for (f = 0; f < NSGAfronts.size (); f++)
+	for (unsigned int f = 0; f < NSGAfronts.size (); f++)
 	{
-		calculateNSGACrowdingDistance (f);
-		if (NSGAfronts[f].size () < (popSize - n))
-		{
-			// copy schedules..
-			std::vector <Rts2Schedule *>::iterator iter;
-			for (iter = NSGAfronts[f].begin (); iter != NSGAfronts[f].end(); iter++, n++)
-				new_pop[n] = (*iter);
-			
-			NSGAfronts[f].clear ();
-		}
-		else
+		std::vector <Rts2Schedule *> &front = NSGAfronts[f];
+		if (NSGAnewPop.size () < popSize)
 		{
-			// sort based on crowding distance
-			std::sort (NSGAfronts[f].begin (), NSGAfronts[f].end (), crowdingComp ());
-			// copy missing entries..
-			std::vector <Rts2Schedule *>::iterator iter = NSGAfronts[f].begin ();
-			for (i = 0; n < popSize; i++, n++)
+			calculateNSGACrowdingDistance (f);
+			if (front.size () < (popSize - NSGAnewPop.size ()))
 			{
-				new_pop[n] = (*iter);
-				iter = NSGAfronts[f].erase (iter);
+				// copy schedules..
+				NSGAnewPop.insert (NSGAnewPop.end (), front.begin (), front.end ());
+				front.clear ();
 			}
-			// delete rest of NSGAfronts..
-			while (iter != NSGAfronts[f].end ())
+			else
 			{
-				delete (*iter);
-				iter = NSGAfronts[f].erase (iter);
-			}
-			while (f < NSGAfronts.size ())
-			{
-				iter = NSGAfronts[f].begin ();
-				while (iter != NSGAfronts[f].end ())
-				{
-					delete (*iter);
-					iter = NSGAfronts[f].erase (iter);
-				}
-				f++;
+				// sort based on crowding distance
+				std::sort (front.begin (), front.end (), crowdingComp ());
+				// copy missing entries..
+				std::vector <Rts2Schedule *>::iterator last = front.begin () + (popSize - NSGAnewPop.size ());
+				NSGAnewPop.insert (NSGAnewPop.end (), front.begin (), last);
+				front.erase (front.begin (), last);
 			}
 		}
+		// schedules which were not selected
+		for (std::vector <Rts2Schedule *>::iterator iter = front.begin (); iter != front.end (); iter++)
+			freeSchedule (*iter);
+		front.clear ();
 	}
 	
-	// erase current population - its pointer are either in new_pop or deleted..
+	// erase current population - its pointer are either in NSGAnewPop or were freed..
 	clear ();
 	reserve (popSize * 2);
 
 	// put to bag remaining schedules..
-	for (i = 0; i < popSize; i++)
-		push_back (new_pop[i]);
+	insert (end (), NSGAnewPop.begin (), NSGAnewPop.end ());
 
-	// now new_pop holds members of new population ready for binary tournament..
+	// now NSGAnewPop holds members of new population ready for binary tournament..
 	// we need to calculate indices of population for tournament
-	unsigned int a1[popSize], a2[popSize];
+	std::vector <unsigned int> a1 (popSize), a2 (popSize);
 	for (i = 0; i < popSize; i++)
 		a1[i] = a2[i] = i;
 
@@ -698,12 +806,12 @@ void Rts2SchedBag::doNSGAIIStep ()
 	// do tournament
 	for (i = 0; i < popSize; i+=4)
 	{
-		Rts2Schedule *parent1 = tournamentNSGA (new_pop[a1[i]], new_pop[a1[i+1]]);
-		Rts2Schedule *parent2 = tournamentNSGA (new_pop[a1[i+2]], new_pop[a1[i+3]]);
+		Rts2Schedule *parent1 = tournamentNSGA (NSGAnewPop[a1[i]], NSGAnewPop[a1[i+1]]);
+		Rts2Schedule *parent2 = tournamentNSGA (NSGAnewPop[a1[i+2]], NSGAnewPop[a1[i+3]]);
 		cross (parent1, parent2);
 
-		parent1 = tournamentNSGA (new_pop[a2[i]], new_pop[a2[i+1]]);
-		parent2 = tournamentNSGA (new_pop[a2[i+2]], new_pop[a2[i+3]]);
+		parent1 = tournamentNSGA (NSGAnewPop[a2[i]], NSGAnewPop[a2[i+1]]);
+		parent2 = tournamentNSGA (NSGAnewPop[a2[i+2]], NSGAnewPop[a2[i+3]]);
 		cross (parent1, parent2);
 	}
 
@@ -711,6 +819,8 @@ void Rts2SchedBag::doNSGAIIStep ()
 	{
 		mutate ((*this)[randomNumber (popSize, popSize * 2 - 1)]);
 	}
+
+	evaluate ();
 }
 
 int Rts2SchedBag::getNSGARankSize (int _rank)
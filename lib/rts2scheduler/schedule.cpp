@@ -44,6 +44,18 @@ Rts2Schedule::Rts2Schedule (double _JDstart, double _JDend, double _minObsDurati
 
 Rts2Schedule::Rts2Schedule (Rts2Schedule *sched1, Rts2Schedule *sched2, unsigned int crossPoint)
 {
+	crossSchedules (sched1, sched2, crossPoint);
+}
+
+Rts2Schedule::~Rts2Schedule (void)
+{
+	clearSchedule ();
+}
+
+void Rts2Schedule::crossSchedules (Rts2Schedule *sched1, Rts2Schedule *sched2, unsigned int crossPoint)
+{
+	clearSchedule ();
+
 	// fill in parameters..
   	JDstart = sched1->JDstart;
 	JDend = sched1->JDend;
@@ -117,11 +129,12 @@ Rts2Schedule::Rts2Schedule (Rts2Schedule *sched1, Rts2Schedule *sched2, unsigned
 	}
 }
 
-Rts2Schedule::~Rts2Schedule (void)
+void Rts2Schedule::clearSchedule ()
 {
 	for (Rts2Schedule::iterator iter = begin (); iter != end (); iter++)
 		delete (*iter);
 	clear ();
+	nanLazyMerits ();
 }
 
 bool Rts2Schedule::isScheduled (Ticket *_ticket)
@@ -19,6 +19,7 @@
  */
 
 #include "rts2script/script.h"
+#include "rts2script/scriptcache.h"
 
 #include "elementexe.h"
 #include "elementhex.h"
@@ -233,8 +234,32 @@ void Script::parseScript (Rts2Target *target)
 
 int Script::setTarget (const char *cam_name, Rts2Target * target)
 {
+	std::vector <std::string> scriptLines;
 	std::string scriptText;
 
+	int ret = 1;
+	do
+	{
+		try
+		{
+			ret = target->getScript (cam_name, scriptText);
+		}
+		catch (rts2core::Error &er)
+		{
+			logStream (MESSAGE_ERROR) << "cannot load script for device " << cam_name << " and target " << target->getTargetName () << "(# " << target->getTargetID () << sendLog;
+			setTarget (cam_name, target, scriptLines);
+			return -1;
+		}
+		scriptLines.push_back (scriptText);
+		// ret == 0 if this was the last (or only) line of the script - see target->getScript call comments.
+	} while (ret == 1);
+
+	setTarget (cam_name, target, scriptLines);
+	return 0;
+}
+
+void Script::setTarget (const char *cam_name, Rts2Target *target, const std::vector <std::string> &scriptLines)
+{
 	target->getPosition (&target_pos);
 
 	strcpy (defaultDevice, cam_name);
@@ -249,27 +274,14 @@ int Script::setTarget (const char *cam_name, Rts2Target * target)
 	commentNumber = 1;
 	wholeScript = std::string ("");
 
-	int ret = 1;
-	do
+	for (std::vector <std::string>::const_iterator iter = scriptLines.begin (); iter != scriptLines.end (); iter++)
 	{
 		delete[] cmdBuf;
 
-		try
-		{
-			ret = target->getScript (cam_name, scriptText);
-		}
-		catch (rts2core::Error &er)
-		{
-			logStream (MESSAGE_ERROR) << "cannot load script for device " << cam_name << " and target " << target->getTargetName () << "(# " << target->getTargetID () << sendLog;
-			el_iter = begin ();
-			return -1;
-		}
-
-		cmdBuf = new char[scriptText.length () + 1];
-		strcpy (cmdBuf, scriptText.c_str ());
+		cmdBuf = new char[iter->length () + 1];
+		strcpy (cmdBuf, iter->c_str ());
 		parseScript (target);
-		// ret == 0 if this was the last (or only) line of the script - see target->getScript call comments.
-	} while (ret == 1);
+	}
 
 	executedCount = 0;
 	currElement = NULL;
@@ -278,7 +290,6 @@ int Script::setTarget (const char *cam_name, Rts2Target * target)
 		(*el_iter)->beforeExecuting ();
 	}
 	el_iter = begin ();
-	return 0;
 }
 
 void Script::postEvent (rts2core::Event * event)
@@ -990,13 +1001,11 @@ int Script::getExpectedImages ()
 double rts2script::getMaximalScriptDuration (Rts2Target *tar, rts2db::CamList &cameras, struct ln_equ_posn *tel, int runnum)
 {
   	double md = 0;
+	struct ln_equ_posn target_pos;
+	tar->getPosition (&target_pos);
 	for (rts2db::CamList::iterator cam = cameras.begin (); cam != cameras.end (); cam++)
 	{
-		std::string script_buf;
-		rts2script::Script script;
-		tar->getScript (cam->c_str(), script_buf);
-		script.setTarget (cam->c_str (), tar);
-		double d = script.getExpectedDuration (tel, runnum);
+		double d = ScriptCache::getScriptInfo (cam->c_str (), tar).getExpectedDuration (tel, &target_pos, runnum);
 		if (d > md)
 			md = d;  
 	}
@@ -0,0 +1,157 @@
+/*
+ * Cache of parsed target scripts.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "rts2script/scriptcache.h"
+#include "rts2script/script.h"
+#include "configuration.h"
+
+#include <cmath>
+#include <map>
+#include <sstream>
+
+#include <sys/stat.h>
+
+using namespace rts2script;
+
+// (target ID, camera name)->script informations
+static std::map <std::pair <int, std::string>, ScriptInfo> scriptCache;
+static rts2core::ConnNotify *watchConn = NULL;
+static int configWatch = -1;
+// modification time of the configuration file, used when it is not watched
+static time_t configMtime = 0;
+
+double ScriptInfo::getExpectedDuration (struct ln_equ_posn *tel, struct ln_equ_posn *target, int runnum)
+{
+	double ret = 0;
+	if (tel && target && !std::isnan (target->ra) && !std::isnan (target->dec))
+		ret += telescopeSettleTime + ln_get_angular_separation (tel, target) * telescopeSpeed;
+	return ret + duration[runnum == 0 ? 0 : 1];
+}
+
+// FNV-1a hash
+static void hashBytes (uint64_t &h, const char *data, size_t len)
+{
+	for (size_t i = 0; i < len; i++)
+	{
+		h ^= (unsigned char) data[i];
+		h *= 1099511628211ULL;
+	}
+}
+
+// flush cache if configuration file was modified
+static void checkConfiguration ()
+{
+	if (configWatch >= 0)
+		return;
+
+	const char *fn = rts2core::Configuration::instance ()->getFilename ();
+	if (watchConn != NULL)
+	{
+		configWatch = watchConn->addWatch (fn);
+		if (configWatch >= 0)
+			return;
+		logStream (MESSAGE_WARNING) << "cannot watch configuration file " << fn << ", its modification time will be checked instead" << sendLog;
+		watchConn = NULL;
+	}
+
+	struct stat st;
+	if (stat (fn, &st) == 0 && st.st_mtime != configMtime)
+	{
+		scriptCache.clear ();
+		configMtime = st.st_mtime;
+	}
+}
+
+ScriptInfo &ScriptCache::getScriptInfo (const char *cam_name, Rts2Target *target)
+{
+	std::vector <std::string> scriptLines;
+	std::string scriptText;
+
+	checkConfiguration ();
+
+	uint64_t h = 14695981039346656037ULL;
+
+	bool ret;
+	do
+	{
+		try
+		{
+			ret = target->getScript (cam_name, scriptText);
+		}
+		catch (rts2core::Error &er)
+		{
+			// same as Script::setTarget - lines retrieved so far are parsed
+			logStream (MESSAGE_ERROR) << "cannot load script for device " << cam_name << " and target " << target->getTargetName () << " (#" << target->getTargetID () << "): " << er << sendLog;
+			hashBytes (h, "", 1);
+			break;
+		}
+		scriptLines.push_back (scriptText);
+		// line separator, so different splits of the same text have different hash
+		hashBytes (h, scriptText.c_str (), scriptText.length () + 1);
+	} while (ret);
+
+	// acquired target is parsed without acquire command
+	char acquired = target->isAcquired ();
+	hashBytes (h, &acquired, 1);
+
+	std::pair <int, std::string> key (target->getTargetID (), std::string (cam_name));
+	std::map <std::pair <int, std::string>, ScriptInfo>::iterator iter = scriptCache.find (key);
+	if (iter != scriptCache.end () && iter->second.hash == h)
+		return iter->second;
+
+	Script script;
+	script.setTarget (cam_name, target, scriptLines);
+
+	ScriptInfo info;
+	info.hash = h;
+	for (Script::iterator se = script.begin (); se != script.end (); se++)
+	{
+		std::ostringstream os;
+		(*se)->printScript (os);
+		if (os.str ().find ("filter=") == 0)
+			info.filters.push_back (((ElementChangeValue *) (*se))->getOperands ());
+	}
+	info.duration[0] = script.getExpectedDuration (NULL, 0);
+	info.duration[1] = script.getExpectedDuration (NULL, 1);
+	info.lightTime = script.getExpectedLightTime ();
+	info.images = script.getExpectedImages ();
+	info.telescopeSettleTime = script.getTelescopeSettleTime ();
+	info.telescopeSpeed = script.getTelescopeSpeed ();
+
+	ScriptInfo &ent = scriptCache[key];
+	ent = info;
+	return ent;
+}
+
+void ScriptCache::clearCache ()
+{
+	scriptCache.clear ();
+}
+
+void ScriptCache::setNotifyConnection (rts2core::ConnNotify *_watchConn)
+{
+	watchConn = _watchConn;
+	configWatch = -1;
+}
+
+void ScriptCache::revalidate (int watch_id)
+{
+	if (configWatch >= 0 && watch_id == configWatch)
+		clearCache ();
+}
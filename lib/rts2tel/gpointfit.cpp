@@ -0,0 +1,548 @@
+/*
+ * Least-squares fitting of RTS2 telescope pointing model.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "gpointfit.h"
+#include "error.h"
+
+#include <math.h>
+#include <string.h>
+#include <sstream>
+
+using namespace rts2telmodel;
+
+// base parameter names, in order of GPointModel::params
+static const char *altazNames[] = {"ia", "tn", "te", "npae", "npoa", "ie", "tf", NULL};
+static const char *gemNames[] = {"id", "me", "ma", "tf", "ih", "ch", "np", "daf", "fo", NULL};
+
+/**
+ * Fitted column - either base parameter, or extra term.
+ */
+struct FitColumn
+{
+	// index of base parameter, -1 for extra term
+	int base;
+	// 0 for az/ha extra term, 1 for el/dec extra term
+	int axis;
+	CompiledTerm *term;
+	ExtraParam *extra;
+};
+
+static double normalizeDiff (double d)
+{
+	d = fmod (d, 360);
+	if (d > 180)
+		d -= 360;
+	else if (d < -180)
+		d += 360;
+	return d;
+}
+
+/**
+ * Values of base model functions. For each parameter, fills its
+ * contribution to the first (az/ha) and the second (alt/dec) axis.
+ * Inputs are in radians.
+ */
+static void baseBasis (bool altaz, double lat_r, double x, double y, double *b)
+{
+	double sin_x = sin (x);
+	double cos_x = cos (x);
+	double cos_y = cos (y);
+	double tan_y = tan (y);
+
+	if (altaz)
+	{
+		// x is azimuth, y is elevation
+		double b_altaz[] = {
+			-1, 0,
+			sin_x * tan_y, cos_x,
+			-cos_x * tan_y, sin_x,
+			-tan_y, 0,
+			1 / cos_y, 0,
+			0, -1,
+			0, cos_y
+		};
+		memcpy (b, b_altaz, sizeof (b_altaz));
+	}
+	else
+	{
+		// x is hour angle, y is declination
+		double sin_lat = sin (lat_r);
+		double cos_lat = cos (lat_r);
+		double sin_y = sin (y);
+		double b_gem[] = {
+			0, 1,
+			sin_x * tan_y, cos_x,
+			-cos_x * tan_y, sin_x,
+			cos_lat * sin_x / cos_y, cos_lat * sin_y * cos_x - sin_lat * cos_y,
+			1, 0,
+			1 / cos_y, 0,
+			tan_y, 0,
+			sin_lat * tan_y + cos_lat * cos_x, 0,
+			0, cos_x
+		};
+		memcpy (b, b_gem, sizeof (b_gem));
+	}
+}
+
+static void addColumns (std::vector <FitColumn> &columns, std::vector <std::string> &names, std::list <ExtraParam *> &extras, std::vector <CompiledTerm> &compiled, int axis, const char *axisName)
+{
+	std::list <ExtraParam *>::iterator it = extras.begin ();
+	for (size_t i = 0; i < compiled.size (); i++, it++)
+	{
+		if (compiled[i].linear == false)
+			continue;
+		FitColumn c;
+		c.base = -1;
+		c.axis = axis;
+		c.term = &(compiled[i]);
+		c.extra = *it;
+		columns.push_back (c);
+
+		std::ostringstream os;
+		os << axisName << "_" << ExtraParam::fns[(*it)->function];
+		for (int t = 0; t < MAX_TERMS && (*it)->terms[t] != GPOINT_LASTTERM; t++)
+			os << "_" << ExtraParam::pns[(*it)->terms[t]];
+		names.push_back (os.str ());
+	}
+}
+
+GPointFit::GPointFit ()
+{
+	altaz = false;
+	latitude = NAN;
+}
+
+void GPointFit::loadData (std::istream &is)
+{
+	bool manual = false;
+	std::string line;
+
+	while (std::getline (is, line))
+	{
+		std::istringstream ls (line);
+		std::string first;
+		ls >> first;
+		if (ls.fail ())
+			continue;
+
+		if (first[0] == '#')
+		{
+			std::string type = first.substr (1);
+			if (type.length () == 0)
+				ls >> type;
+			if (type == "observatory" || type == "gem")
+				altaz = false;
+			else if (type == "altaz")
+				altaz = true;
+			else if (type == "altaz-manual")
+				altaz = manual = true;
+			else
+				continue;
+
+			double lng, lat, alt;
+			ls >> lng >> lat >> alt;
+			if (ls.fail ())
+				throw rts2core::Error ("invalid observatory line " + line);
+			latitude = lat;
+			continue;
+		}
+
+		if (isnan (latitude))
+			throw rts2core::Error ("latitude must be specified before data lines");
+
+		// first column is observation name, which is not used
+		std::vector <double> vals;
+		vals.push_back (NAN);
+		double v;
+		while (ls >> v)
+			vals.push_back (v);
+
+		GPointMeasurement m;
+		if (manual)
+		{
+			// observation, MJD, RA, DEC, alt error, az error, alt, az
+			if (vals.size () < 8)
+				throw rts2core::Error ("invalid data line " + line);
+			m.az = vals[7];
+			m.alt = vals[6];
+			m.r_az = vals[7] + vals[5];
+			m.r_alt = vals[6] + vals[4];
+		}
+		else
+		{
+			// observation, MJD, LST, mount RA/AZ, mount DEC/ALT, axis counts, true RA/AZ, true DEC/ALT
+			if (vals.size () < 9)
+				throw rts2core::Error ("invalid data line " + line);
+			if (altaz)
+			{
+				m.az = vals[3];
+				m.alt = vals[4];
+				m.r_az = vals[7];
+				m.r_alt = vals[8];
+			}
+			else
+			{
+				double lst = vals[2];
+				double a_dec = vals[4];
+				m.ha = lst - vals[3];
+				m.dec = a_dec;
+				// data from flipped mount have DEC above 90
+				if (fabs (a_dec) > 90)
+				{
+					m.r_ha = lst - ln_range_degrees (vals[7] + 180);
+					m.r_dec = (a_dec > 90 ? 180 : -180) - vals[8];
+				}
+				else
+				{
+					m.r_ha = lst - vals[7];
+					m.r_dec = vals[8];
+				}
+			}
+		}
+		addMeasurement (m);
+	}
+}
+
+void GPointFit::addMeasurement (GPointMeasurement &m)
+{
+	completeMeasurement (m);
+	data.push_back (m);
+}
+
+int GPointFit::setFixed (const char *name)
+{
+	for (const char **n = getBaseNames (altaz); *n; n++)
+	{
+		if (!strcasecmp (*n, name))
+		{
+			fixed.push_back (*n);
+			return 0;
+		}
+	}
+	return -1;
+}
+
+int GPointFit::fit (GPointModel *model)
+{
+	model->altaz = altaz;
+	model->compile ();
+
+	const char **baseNames = getBaseNames (altaz);
+	int pn = altaz ? 7 : 9;
+
+	std::vector <FitColumn> columns;
+	paramNames.clear ();
+
+	for (int p = 0; p < pn; p++)
+	{
+		if (isFixed (baseNames[p]))
+			continue;
+		FitColumn c;
+		c.base = p;
+		c.axis = -1;
+		c.term = NULL;
+		c.extra = NULL;
+		columns.push_back (c);
+		paramNames.push_back (baseNames[p]);
+	}
+
+	if (altaz)
+	{
+		addColumns (columns, paramNames, model->extraParamsAz, model->getCompiledAz (), 0, "az");
+		addColumns (columns, paramNames, model->extraParamsEl, model->getCompiledEl (), 1, "el");
+	}
+	else
+	{
+		addColumns (columns, paramNames, model->extraParamsHa, model->getCompiledHa (), 0, "ha");
+		addColumns (columns, paramNames, model->extraParamsDec, model->getCompiledDec (), 1, "dec");
+	}
+
+	std::vector <CompiledTerm> &fixedTerms0 = altaz ? model->getCompiledAz () : model->getCompiledHa ();
+	std::vector <CompiledTerm> &fixedTerms1 = altaz ? model->getCompiledEl () : model->getCompiledDec ();
+
+	size_t M = columns.size ();
+	if (M == 0 || 2 * data.size () <= M)
+		return -1;
+
+	double lat_r = ln_deg_to_rad (latitude);
+
+	// normal equations
+	std::vector <double> N (M * M, 0);
+	std::vector <double> rhs (M, 0);
+	// design matrix and targets, kept for residuals
+	std::vector <double> A (2 * data.size () * M);
+	std::vector <double> target (2 * data.size ());
+
+	double b[18];
+	double args[GPOINT_ARGS];
+
+	for (size_t i = 0; i < data.size (); i++)
+	{
+		GPointMeasurement &m = data[i];
+		double x, y, w, t0, t1;
+		if (altaz)
+		{
+			x = ln_deg_to_rad (m.az);
+			y = ln_deg_to_rad (m.alt);
+			fillTermArgs (args, x, y, ln_deg_to_rad (m.ha), ln_deg_to_rad (m.dec));
+			w = cos (y);
+			t0 = ln_deg_to_rad (normalizeDiff (m.r_az - m.az));
+			t1 = ln_deg_to_rad (m.r_alt - m.alt);
+		}
+		else
+		{
+			x = ln_deg_to_rad (m.r_ha);
+			y = ln_deg_to_rad (m.r_dec);
+			fillTermArgs (args, ln_deg_to_rad (m.r_az), ln_deg_to_rad (m.r_alt), x, y);
+			w = cos (y);
+			t0 = ln_deg_to_rad (normalizeDiff (m.ha - m.r_ha));
+			t1 = ln_deg_to_rad (m.dec - m.r_dec);
+		}
+
+		baseBasis (altaz, lat_r, x, y, b);
+
+		// subtract fixed parameters and terms
+		for (int p = 0; p < pn; p++)
+		{
+			if (isFixed (baseNames[p]))
+			{
+				t0 -= model->params[p] * b[2 * p];
+				t1 -= model->params[p] * b[2 * p + 1];
+			}
+		}
+		for (std::vector <CompiledTerm>::iterator it = fixedTerms0.begin (); it != fixedTerms0.end (); it++)
+		{
+			if (it->linear == false)
+				t0 -= it->getValue (args);
+		}
+		for (std::vector <CompiledTerm>::iterator it = fixedTerms1.begin (); it != fixedTerms1.end (); it++)
+		{
+			if (it->linear == false)
+				t1 -= it->getValue (args);
+		}
+
+		double *r0 = &(A[2 * i * M]);
+		double *r1 = r0 + M;
+		for (size_t c = 0; c < M; c++)
+		{
+			FitColumn &col = columns[c];
+			if (col.base >= 0)
+			{
+				r0[c] = b[2 * col.base] * w;
+				r1[c] = b[2 * col.base + 1];
+			}
+			else
+			{
+				double v = col.term->fn (col.term->c0 * args[col.term->a0], col.term->c1 * args[col.term->a1]);
+				r0[c] = col.axis == 0 ? v * w : 0;
+				r1[c] = col.axis == 1 ? v : 0;
+			}
+		}
+		target[2 * i] = t0 * w;
+		target[2 * i + 1] = t1;
+
+		for (size_t j = 0; j < M; j++)
+		{
+			rhs[j] += r0[j] * target[2 * i] + r1[j] * target[2 * i + 1];
+			for (size_t k = 0; k <= j; k++)
+				N[j * M + k] += r0[j] * r0[k] + r1[j] * r1[k];
+		}
+	}
+
+	// Cholesky decomposition, lower triangle of N is replaced with L
+	for (size_t j = 0; j < M; j++)
+	{
+		double s = N[j * M + j];
+		for (size_t k = 0; k < j; k++)
+			s -= N[j * M + k] * N[j * M + k];
+		if (s <= 0)
+			return -1;
+		N[j * M + j] = sqrt (s);
+		for (size_t i = j + 1; i < M; i++)
+		{
+			double v = N[i * M + j];
+			for (size_t k = 0; k < j; k++)
+				v -= N[i * M + k] * N[j * M + k];
+			N[i * M + j] = v / N[j * M + j];
+		}
+	}
+
+	// solve L L^T x = rhs
+	paramValues.resize (M);
+	for (size_t i = 0; i < M; i++)
+	{
+		double v = rhs[i];
+		for (size_t k = 0; k < i; k++)
+			v -= N[i * M + k] * paramValues[k];
+		paramValues[i] = v / N[i * M + i];
+	}
+	for (size_t i = M; i-- > 0;)
+	{
+		double v = paramValues[i];
+		for (size_t k = i + 1; k < M; k++)
+			v -= N[k * M + i] * paramValues[k];
+		paramValues[i] = v / N[i * M + i];
+	}
+
+	// residuals for standard errors
+	double rss = 0;
+	for (size_t r = 0; r < 2 * data.size (); r++)
+	{
+		double v = target[r];
+		for (size_t c = 0; c < M; c++)
+			v -= A[r * M + c] * paramValues[c];
+		rss += v * v;
+	}
+	double s2 = rss / (2 * data.size () - M);
+
+	// diagonal of inverse of normal matrix, from L^-1
+	paramErrors.resize (M);
+	std::vector <double> e (M);
+	for (size_t c = 0; c < M; c++)
+	{
+		// solve L e = unit vector c, then (N^-1)_cc = sum of e^2
+		double sum = 0;
+		for (size_t i = 0; i < M; i++)
+		{
+			double v = (i == c) ? 1 : 0;
+			for (size_t k = c; k < i; k++)
+				v -= N[i * M + k] * e[k];
+			e[i] = (i < c) ? 0 : v / N[i * M + i];
+			sum += e[i] * e[i];
+		}
+		paramErrors[c] = sqrt (s2 * sum);
+	}
+
+	// propagate results to model
+	for (size_t c = 0; c < M; c++)
+	{
+		if (columns[c].base >= 0)
+			model->params[columns[c].base] = paramValues[c];
+		else
+			columns[c].extra->params[0] = paramValues[c];
+	}
+	model->compile ();
+
+	return 0;
+}
+
+double GPointFit::getRMS (GPointModel *model)
+{
+	size_t n = data.size ();
+	if (n == 0)
+		return NAN;
+
+	std::vector <double> x (n), y (n), u (n), v (n);
+	for (size_t i = 0; i < n; i++)
+	{
+		GPointMeasurement &m = data[i];
+		if (altaz)
+		{
+			x[i] = m.az;
+			y[i] = m.alt;
+			u[i] = m.ha;
+			v[i] = m.dec;
+		}
+		else
+		{
+			x[i] = m.r_ha;
+			y[i] = m.r_dec;
+			u[i] = m.r_az;
+			v[i] = m.r_alt;
+		}
+	}
+
+	std::vector <double> e0 (n), e1 (n);
+	if (altaz)
+		model->getErrAltAz (n, &(x[0]), &(y[0]), &(u[0]), &(v[0]), &(e0[0]), &(e1[0]));
+	else
+		model->reverse (n, &(x[0]), &(y[0]), &(u[0]), &(v[0]));
+
+	double sum = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		GPointMeasurement &m = data[i];
+		struct ln_equ_posn p1, p2;
+		if (altaz)
+		{
+			p1.ra = m.az + e0[i];
+			p1.dec = m.alt + e1[i];
+			p2.ra = m.r_az;
+			p2.dec = m.r_alt;
+		}
+		else
+		{
+			p1.ra = x[i];
+			p1.dec = y[i];
+			p2.ra = m.ha;
+			p2.dec = m.dec;
+		}
+		double d = ln_get_angular_separation (&p1, &p2);
+		sum += d * d;
+	}
+	return sqrt (sum / n);
+}
+
+const char **GPointFit::getBaseNames (bool _altaz)
+{
+	return _altaz ? altazNames : gemNames;
+}
+
+void GPointFit::completeMeasurement (GPointMeasurement &m)
+{
+	double lat_r = ln_deg_to_rad (latitude);
+	double sin_lat = sin (lat_r);
+	double cos_lat = cos (lat_r);
+
+	if (altaz)
+	{
+		// azimuth is 0 at south
+		double az_r = ln_deg_to_rad (m.az);
+		double alt_r = ln_deg_to_rad (m.alt);
+		m.dec = ln_rad_to_deg (asin (sin_lat * sin (alt_r) - cos_lat * cos (alt_r) * cos (az_r)));
+		m.ha = ln_rad_to_deg (atan2 (sin (az_r), cos (az_r) * sin_lat + tan (alt_r) * cos_lat));
+
+		az_r = ln_deg_to_rad (m.r_az);
+		alt_r = ln_deg_to_rad (m.r_alt);
+		m.r_dec = ln_rad_to_deg (asin (sin_lat * sin (alt_r) - cos_lat * cos (alt_r) * cos (az_r)));
+		m.r_ha = ln_rad_to_deg (atan2 (sin (az_r), cos (az_r) * sin_lat + tan (alt_r) * cos_lat));
+	}
+	else
+	{
+		double ha_r = ln_deg_to_rad (m.ha);
+		double dec_r = ln_deg_to_rad (m.dec);
+		m.alt = ln_rad_to_deg (asin (sin_lat * sin (dec_r) + cos_lat * cos (dec_r) * cos (ha_r)));
+		m.az = ln_range_degrees (ln_rad_to_deg (atan2 (cos (dec_r) * sin (ha_r), sin_lat * cos (dec_r) * cos (ha_r) - cos_lat * sin (dec_r))));
+
+		ha_r = ln_deg_to_rad (m.r_ha);
+		dec_r = ln_deg_to_rad (m.r_dec);
+		m.r_alt = ln_rad_to_deg (asin (sin_lat * sin (dec_r) + cos_lat * cos (dec_r) * cos (ha_r)));
+		m.r_az = ln_range_degrees (ln_rad_to_deg (atan2 (cos (dec_r) * sin (ha_r), sin_lat * cos (dec_r) * cos (ha_r) - cos_lat * sin (dec_r))));
+	}
+}
+
+bool GPointFit::isFixed (const char *name)
+{
+	for (std::vector <std::string>::iterator it = fixed.begin (); it != fixed.end (); it++)
+	{
+		if (*it == name)
+			return true;
+	}
+	return false;
+}
@@ -253,11 +253,73 @@ double ExtraParam::getValue (double az, double el, double ha, double dec)
 	}
 }
 
+static double term_offset (double a, double b) { return 1; }
+static double term_sin (double a, double b) { return sin (a); }
+static double term_cos (double a, double b) { return cos (a); }
+static double term_tan (double a, double b) { return tan (a); }
+static double term_sincos (double a, double b) { return sin (a) * cos (b); }
+static double term_coscos (double a, double b) { return cos (a) * cos (b); }
+static double term_sinsin (double a, double b) { return sin (a) * sin (b); }
+static double term_abssin (double a, double b) { return fabs (sin (a)); }
+static double term_abscos (double a, double b) { return fabs (cos (a)); }
+static double term_csc (double a, double b) { return 1 / cos (a); }
+static double term_sec (double a, double b) { return 1 / sin (a); }
+static double term_cot (double a, double b) { return 1 / tan (a); }
+static double term_sinh (double a, double b) { return sinh (a); }
+static double term_cosh (double a, double b) { return cosh (a); }
+static double term_tanh (double a, double b) { return tanh (a); }
+static double term_sech (double a, double b) { return 1 / sinh (a); }
+static double term_csch (double a, double b) { return 1 / cosh (a); }
+static double term_coth (double a, double b) { return 1 / tanh (a); }
+
+// functions indexed by function_t, evaluated the same way as in ExtraParam::getValue
+static const term_function_t term_functions[] = {term_offset, term_sin, term_cos, term_tan, term_sincos, term_coscos, term_sinsin, term_abssin, term_abscos, term_csc, term_sec, term_cot, term_sinh, term_cosh, term_tanh, term_sech, term_csch, term_coth};
+
+void ExtraParam::compile (CompiledTerm *term)
+{
+	term->fn = term_functions[function];
+	// sinsin does not use parameter
+	term->linear = function != GPOINT_SINSIN;
+	term->multi = term->linear ? params[0] : 1;
+	term->c0 = isnan (consts[0]) ? 0 : consts[0];
+	term->c1 = isnan (consts[1]) ? 0 : consts[1];
+	term->a0 = terms[0];
+	term->a1 = terms[1];
+}
+
+void rts2telmodel::fillTermArgs (double *args, double az, double el, double ha, double dec)
+{
+	args[GPOINT_AZ] = az;
+	args[GPOINT_EL] = el;
+	args[GPOINT_ZD] = M_PI / 2.0 - el;
+	args[GPOINT_HA] = ha;
+	args[GPOINT_DEC] = dec;
+	args[GPOINT_PD] = 0;
+	args[GPOINT_LASTTERM] = 0;
+}
+
+/**
+ * Sum values of compiled terms.
+ */
+static inline double sumTerms (std::vector <CompiledTerm> &terms, const double *args)
+{
+	double ret = 0;
+	for (std::vector <CompiledTerm>::iterator it = terms.begin (); it != terms.end (); it++)
+		ret += it->getValue (args);
+	return ret;
+}
+
 std::string ExtraParam::toString (char frmt)
 {
 	std::ostringstream os;
 	os.precision (20);
-	os << std::fixed << printDeg (params[0], frmt) << " " << consts[0];
+	os << std::fixed << printDeg (params[0], frmt) << " " << fns[function] << " ";
+	int t;
+	for (t = 0; t < MAX_TERMS && terms[t] != GPOINT_LASTTERM; t++)
+		os << (t > 0 ? ";" : "") << pns[terms[t]];
+	os << " ";
+	for (int i = 0; i < t; i++)
+		os << (i > 0 ? ";" : "") << consts[i];
 	return os.str ();
 }
 
@@ -309,6 +371,31 @@ int GPointModel::apply (struct ln_equ_posn *pos)
 	return 0;
 }
 
+void GPointModel::apply (size_t n, double *ra, double *dec)
+{
+	double lat_r = getLatitudeRadians ();
+	double sin_lat = sin (lat_r);
+	double cos_lat = cos (lat_r);
+
+	for (size_t i = 0; i < n; i++)
+	{
+		double ra_r = ln_deg_to_rad (ra[i]);
+		double dec_r = ln_deg_to_rad (dec[i]);
+
+		double sin_ra = sin (ra_r);
+		double cos_ra = cos (ra_r);
+		double sin_dec = sin (dec_r);
+		double cos_dec = cos (dec_r);
+		double tan_dec = sin_dec / cos_dec;
+
+		double d_tar = dec_r - params[0] - params[1] * cos_ra - params[2] * sin_ra - params[3] * (cos_lat * sin_dec * cos_ra - sin_lat * cos_dec) - params[8] * cos_ra;
+		double r_tar = ra_r - params[4] - params[5] / cos_dec - params[6] * tan_dec - (params[1] * sin_ra - params[2] * cos_ra) * tan_dec - params[3] * cos_lat * sin_ra / cos_dec - params[7] * (sin_lat * tan_dec + cos_lat * cos_ra);
+
+		ra[i] = ln_rad_to_deg (r_tar);
+		dec[i] = ln_rad_to_deg (d_tar);
+	}
+}
+
 int GPointModel::applyVerbose (struct ln_equ_posn *pos)
 {
 	logStream (MESSAGE_DEBUG) << "Before: " << pos->ra << " " << pos->dec << sendLog;
@@ -357,6 +444,51 @@ int GPointModel::reverse (struct ln_equ_posn *pos, struct ln_hrz_posn *hrz)
 	return 0;
 }
 
+void GPointModel::reverse (size_t n, double *ha, double *dec, const double *az, const double *alt)
+{
+	double lat_r = getLatitudeRadians ();
+	double sin_lat = sin (lat_r);
+	double cos_lat = cos (lat_r);
+	double args[GPOINT_ARGS];
+
+	for (size_t i = 0; i < n; i++)
+	{
+		double ha_r = ln_deg_to_rad (ha[i]);
+		double dec_r = ln_deg_to_rad (dec[i]);
+
+		double sin_ha = sin (ha_r);
+		double cos_ha = cos (ha_r);
+		double sin_dec = sin (dec_r);
+		double cos_dec = cos (dec_r);
+		double tan_dec = sin_dec / cos_dec;
+
+		double d_tar = dec_r
+			+ params[0]
+			+ params[1] * cos_ha
+			+ params[2] * sin_ha
+			+ params[3] * (cos_lat * sin_dec * cos_ha - sin_lat * cos_dec)
+			+ params[8] * cos_ha;
+
+		double r_tar = ha_r
+			+ params[4]
+			+ params[5] / cos_dec
+			+ params[6] * tan_dec
+			+ (params[1] * sin_ha - params[2] * cos_ha) * tan_dec
+			+ params[3] * cos_lat * sin_ha / cos_dec
+			+ params[7] * (sin_lat * tan_dec + cos_lat * cos_ha);
+
+		if (!(compiledHa.empty () && compiledDec.empty ()))
+		{
+			fillTermArgs (args, az ? ln_deg_to_rad (az[i]) : 0, alt ? ln_deg_to_rad (alt[i]) : 0, ha_r, dec_r);
+			r_tar += sumTerms (compiledHa, args);
+			d_tar += sumTerms (compiledDec, args);
+		}
+
+		ha[i] = ln_rad_to_deg (r_tar);
+		dec[i] = ln_rad_to_deg (d_tar);
+	}
+}
+
 int GPointModel::reverseVerbose (struct ln_equ_posn *pos, struct ln_hrz_posn *hrz)
 {
 	logStream (MESSAGE_DEBUG) << "Before: " << pos->ra << " " << pos->dec << sendLog;
@@ -405,6 +537,62 @@ void GPointModel::getErrAltAz (struct ln_hrz_posn *hrz, struct ln_equ_posn *equ,
 	hrz->alt += err->alt;
 }
 
+void GPointModel::getErrAltAz (size_t n, const double *az, const double *alt, const double *ha, const double *dec, double *errAz, double *errAlt)
+{
+	double args[GPOINT_ARGS];
+
+	for (size_t i = 0; i < n; i++)
+	{
+		double az_r = ln_deg_to_rad (az[i]);
+		double el_r = ln_deg_to_rad (alt[i]);
+
+		double sin_az = sin (az_r);
+		double cos_az = cos (az_r);
+		double cos_el = cos (el_r);
+		double tan_el = tan (el_r);
+
+		double e_az = - params[0]
+			+ params[1] * sin_az  * tan_el
+			- params[2] * cos_az * tan_el
+			- params[3] * tan_el
+			+ params[4] / cos_el;
+
+		double e_alt = - params[5]
+			+ params[1] * cos_az
+			+ params[2] * sin_az
+			+ params[6] * cos_el;
+
+		if (!(compiledAz.empty () && compiledEl.empty ()))
+		{
+			fillTermArgs (args, az_r, el_r, ha ? ln_deg_to_rad (ha[i]) : 0, dec ? ln_deg_to_rad (dec[i]) : 0);
+			e_az += sumTerms (compiledAz, args);
+			e_alt += sumTerms (compiledEl, args);
+		}
+
+		errAz[i] = ln_rad_to_deg (e_az);
+		errAlt[i] = ln_rad_to_deg (e_alt);
+	}
+}
+
+/**
+ * Compile list of extra parameters into vector.
+ */
+static void compileList (std::list <ExtraParam *> &extras, std::vector <CompiledTerm> &compiled)
+{
+	compiled.resize (extras.size ());
+	size_t i = 0;
+	for (std::list <ExtraParam *>::iterator it = extras.begin (); it != extras.end (); it++, i++)
+		(*it)->compile (&(compiled[i]));
+}
+
+void GPointModel::compile ()
+{
+	compileList (extraParamsAz, compiledAz);
+	compileList (extraParamsEl, compiledEl);
+	compileList (extraParamsHa, compiledHa);
+	compileList (extraParamsDec, compiledDec);
+}
+
 std::istream & GPointModel::load (std::istream & is)
 {
 	std::string line ("");
@@ -439,6 +627,7 @@ std::istream & GPointModel::load (std::istream & is)
 		catch (rts2core::Error &er)
 		{	
 			logStream (MESSAGE_ERROR) << "cannot read parameter " << i << sendLog;
+			compile ();
 			return is;
 		}
 		i++;
@@ -487,6 +676,7 @@ std::istream & GPointModel::load (std::istream & is)
 			{
 				logStream (MESSAGE_ERROR) << "invalid axis name " << axis << sendLog;
 				delete p;
+				compile ();
 				return is;
 			}
 		}
@@ -494,10 +684,12 @@ std::istream & GPointModel::load (std::istream & is)
 		{
 			logStream (MESSAGE_ERROR) << "parsing line " << line << ": " << er << sendLog;
 			delete p;
+			compile ();
 			return is;
 		}
 	}
 
+	compile ();
 	return is;
 }
 
@@ -523,6 +715,10 @@ std::ostream & GPointModel::print (std::ostream & os, char frmt)
 		os << "AZ " << (*it)->toString (frmt) << std::endl;
 	for (it = extraParamsEl.begin (); it != extraParamsEl.end (); it++)
 		os << "EL " << (*it)->toString (frmt) << std::endl;
+	for (it = extraParamsHa.begin (); it != extraParamsHa.end (); it++)
+		os << "HA " << (*it)->toString (frmt) << std::endl;
+	for (it = extraParamsDec.begin (); it != extraParamsDec.end (); it++)
+		os << "DEC " << (*it)->toString (frmt) << std::endl;
 	return os;
 }
 
@@ -20,6 +20,7 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/time.h>
 #include <time.h>
 #include <libnova/libnova.h>
@@ -95,6 +96,12 @@ Telescope::Telescope (int in_argc, char **in_argv, bool diffTrack, bool hasTrack
 	createValue (telDUT1, "DUT1", "[s] UT1 - UTC", true, RTS2_VALUE_WRITABLE | RTS2_VALUE_AUTOSAVE);
 	telDUT1->setValueDouble (0);
 
+#ifdef RTS2_LIBERFA
+	createValue (astromInterval, "astrometry_interval", "[s] interval for full recalculation of astrometry context", false, RTS2_VALUE_WRITABLE | RTS2_DT_TIMEINTERVAL);
+	astromInterval->setValueDouble (60);
+	astromUTC = NAN;
+#endif
+
 	createValue (pointingModel, "MOUNT", "mount pointing model (equ, alt-az, ...)", false, 0, 0);
 	pointingModel->addSelVal ("EQU");
 	pointingModel->addSelVal ("ALT-AZ");
@@ -183,6 +190,8 @@ Telescope::Telescope (int in_argc, char **in_argv, bool diffTrack, bool hasTrack
 		trackingWarning->setValueFloat (1);
 		trackingFSize->setValueInteger (20);
 
+		createValue (trackingTime, "tracking_time", "[s] time needed to compute tracking step", false);
+
 		createValue (skyVect, "SKYSPD", "[deg/hour] tracking speeds vector (in RA/DEC)", true, RTS2_DT_DEGREES);
 	}
 	else
@@ -191,6 +200,7 @@ Telescope::Telescope (int in_argc, char **in_argv, bool diffTrack, bool hasTrack
 		trackingInterval = NULL;
 		trackingFrequency = NULL;
 		trackingWarning = NULL;
+		trackingTime = NULL;
 		skyVect = NULL;
 	}
 
@@ -575,6 +585,8 @@ int Telescope::calculateTracking (const double utc1, const double utc2, double s
 	struct ln_hrz_posn hrz, t_hrz;
 	// refresh current target..
 
+	double startTime = getNow ();
+
 	int32_t c_ac = ac;
 	int32_t c_dc = dc;
 	int32_t t_ac = ac;
@@ -587,6 +599,12 @@ int Telescope::calculateTracking (const double utc1, const double utc2, double s
 	if (ret)
 		return ret;
 
+	if (trackingTime != NULL)
+	{
+		trackingTime->addValue (getNow () - startTime, trackingFSize->getValueInteger ());
+		trackingTime->calculate ();
+	}
+
 	//std::cout << "calculateTracking " << utc1 << " " << utc2 << " " << LibnovaRaDec (&eqpos) << " " << LibnovaRaDec (&t_eqpos) << " " << sec_step << " current " << c_ac << " " << c_dc << " target " << t_ac << " " << t_dc << " ac " << ac << " " << dc << std::endl;
 
 	// for speed vector calculation..
@@ -2058,25 +2076,24 @@ int Telescope::scriptEnds ()
 void Telescope::applyCorrections (struct ln_equ_posn *pos, double utc1, double utc2, struct ln_hrz_posn *hrz, bool writeValues)
 {
 #ifdef RTS2_LIBERFA
-	double aob, zob, hob, dob, rob, eo, ri, di;
+	double aob, zob, hob, dob, rob, ri, di;
 
 	double rc = ln_deg_to_rad (pos->ra);
 	double dc = ln_deg_to_rad (pos->dec);
 
-	eraASTROM astrom;
+	eraASTROM c_astrom;
 
-	int status = eraApco13 (utc1, utc2, telDUT1->getValueDouble (), ln_deg_to_rad (getLongitude ()), ln_deg_to_rad (getLatitude ()), getAltitude (), 0, 0, getPressure (), telAmbientTemperature->getValueFloat (), telHumidity->getValueFloat () / 100.0, telWavelength->getValueFloat () / 1000.0, &astrom, &eo);
-	if (status)
+	if (getAstrom (utc1, utc2, &c_astrom))
 	{
 		logStream (MESSAGE_ERROR) << "cannot apply corrections to " << pos->ra << " " << pos->dec << sendLog;
 		return;
 	}
 
 	// transform ICRS to CIRS
-	eraAtciq (rc, dc, ln_deg_to_rad (pmRaDec->getRa ()), ln_deg_to_rad (pmRaDec->getDec ()), 0, 0, &astrom, &ri, &di);
+	eraAtciq (rc, dc, ln_deg_to_rad (pmRaDec->getRa ()), ln_deg_to_rad (pmRaDec->getDec ()), 0, 0, &c_astrom, &ri, &di);
 
 	// transform CISC to observed
-	eraAtioq (ri, di, &astrom, &aob, &zob, &hob, &dob, &rob);
+	eraAtioq (ri, di, &c_astrom, &aob, &zob, &hob, &dob, &rob);
 
 	pos->ra = ln_rad_to_deg (rob);
 	pos->dec = ln_rad_to_deg (dob);
@@ -2112,6 +2129,43 @@ void Telescope::applyCorrections (struct ln_equ_posn *pos, double utc1, double u
 }
 
 #ifdef RTS2_LIBERFA
+int Telescope::getAstrom (double utc1, double utc2, eraASTROM *ret)
+{
+	double params[8] = {telDUT1->getValueDouble (), getLongitude (), getLatitude (), getAltitude (), getPressure (), telAmbientTemperature->getValueFloat (), telHumidity->getValueFloat (), telWavelength->getValueFloat ()};
+
+	bool recalculate = std::isnan (astromUTC) || fabs ((utc1 - astromUTC) + utc2) * 86400.0 > astromInterval->getValueDouble ();
+	for (int i = 0; i < 8 && recalculate == false; i++)
+	{
+		// unknown weather values are NAN, which does not compare equal to itself
+		if (params[i] != astromParams[i] && !(std::isnan (params[i]) && std::isnan (astromParams[i])))
+			recalculate = true;
+	}
+
+	if (recalculate)
+	{
+		double eo;
+		int status = eraApco13 (utc1, utc2, params[0], ln_deg_to_rad (params[1]), ln_deg_to_rad (params[2]), params[3], 0, 0, params[4], params[5], params[6] / 100.0, params[7] / 1000.0, &astrom, &eo);
+		if (status)
+		{
+			astromUTC = NAN;
+			return -1;
+		}
+		astromUTC = utc1 + utc2;
+		memcpy (astromParams, params, sizeof (params));
+	}
+	else
+	{
+		// only Earth rotation angle needs to be updated
+		double ut11, ut12;
+		if (eraUtcut1 (utc1, utc2, params[0], &ut11, &ut12))
+			return -1;
+		eraAper13 (ut11, ut12, &astrom);
+	}
+
+	*ret = astrom;
+	return 0;
+}
+
 void Telescope::getEraUTC (double &utc1, double &utc2)
 {
 	struct timeval tv;
@@ -0,0 +1,351 @@
+/*
+ * In-process UCAC5 catalogue.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "ucac5/UCAC5Catalogue.hpp"
+
+#include <erfa.h>
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// zone height and RA bin width (radians)
+#define ZONE_HEIGHT   (M_PI / UCAC5_ZONES)
+#define BIN_WIDTH     (2 * M_PI / UCAC5_RA_BINS)
+
+static bool brighter (const UCAC5Star &a, const UCAC5Star &b)
+{
+	return a.record->gmag < b.record->gmag;
+}
+
+/**
+ * Add star to heap of the brightest stars, faintest star being on top of
+ * the heap. Stars fainter than magLimit are ignored.
+ */
+static inline void addStar (const struct ucac5 *rec, double distance, double magLimit, size_t maxStars, std::vector <UCAC5Star> &stars)
+{
+	if (rec->gmag / 1000.0 > magLimit)
+		return;
+	if (stars.size () >= maxStars)
+	{
+		if (maxStars == 0 || rec->gmag >= stars.front ().record->gmag)
+			return;
+		std::pop_heap (stars.begin (), stars.end (), brighter);
+		stars.pop_back ();
+	}
+	UCAC5Star star;
+	star.record = rec;
+	star.distance = distance;
+	stars.push_back (star);
+	std::push_heap (stars.begin (), stars.end (), brighter);
+}
+
+static void *mapFile (const char *fn, int &fd, size_t &size)
+{
+	fd = ::open (fn, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	struct stat sb;
+	if (fstat (fd, &sb) || sb.st_size == 0)
+	{
+		close (fd);
+		fd = -1;
+		return NULL;
+	}
+	size = sb.st_size;
+	void *ret = mmap (NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (ret == MAP_FAILED)
+	{
+		close (fd);
+		fd = -1;
+		return NULL;
+	}
+	return ret;
+}
+
+UCAC5Catalogue::UCAC5Catalogue (): indexFd (-1), index (NULL), indexSize (0), simd (true)
+{
+	for (int z = 0; z < UCAC5_ZONES; z++)
+	{
+		zones[z].fd = -1;
+		zones[z].records = NULL;
+		zones[z].recordsSize = 0;
+		zones[z].xyzFd = -1;
+		zones[z].xyz = NULL;
+		zones[z].xyzSize = 0;
+		zones[z].count = 0;
+	}
+}
+
+UCAC5Catalogue::~UCAC5Catalogue ()
+{
+	for (int z = 0; z < UCAC5_ZONES; z++)
+		closeZone (zones + z);
+	if (index)
+		munmap (index, indexSize);
+	if (indexFd >= 0)
+		close (indexFd);
+}
+
+int UCAC5Catalogue::open (const char *_base)
+{
+	base = _base;
+	index = (uint32_t *) mapFile ((base + "/u5index.unf").c_str (), indexFd, indexSize);
+	if (index == NULL)
+		return -1;
+	// start and number of stars of every bin
+	if (indexSize != 2 * sizeof (uint32_t) * UCAC5_ZONES * UCAC5_RA_BINS)
+	{
+		munmap (index, indexSize);
+		index = NULL;
+		close (indexFd);
+		indexFd = -1;
+		return -1;
+	}
+	return 0;
+}
+
+UCAC5Catalogue::Zone *UCAC5Catalogue::getZone (int z)
+{
+	Zone *zone = zones + z;
+	if (zone->records)
+		return zone;
+
+	char fn[16];
+	snprintf (fn, sizeof (fn), "/z%03d", z + 1);
+	zone->records = (struct ucac5 *) mapFile ((base + fn).c_str (), zone->fd, zone->recordsSize);
+	zone->xyz = (Vector *) mapFile ((base + fn + ".xyz").c_str (), zone->xyzFd, zone->xyzSize);
+	zone->count = zone->recordsSize / sizeof (struct ucac5);
+	if (zone->records == NULL || zone->xyz == NULL || zone->xyzSize != zone->count * sizeof (Vector))
+	{
+		closeZone (zone);
+		return NULL;
+	}
+	return zone;
+}
+
+void UCAC5Catalogue::closeZone (Zone *zone)
+{
+	if (zone->records)
+		munmap (zone->records, zone->recordsSize);
+	if (zone->fd >= 0)
+		close (zone->fd);
+	if (zone->xyz)
+		munmap (zone->xyz, zone->xyzSize);
+	if (zone->xyzFd >= 0)
+		close (zone->xyzFd);
+	zone->fd = zone->xyzFd = -1;
+	zone->records = NULL;
+	zone->xyz = NULL;
+	zone->recordsSize = zone->xyzSize = zone->count = 0;
+}
+
+void UCAC5Catalogue::getRange (Zone *zone, int z, int b1, int b2, size_t &start, size_t &end)
+{
+	// index holds start offsets, followed by number of stars, for zone (varying fastest) and RA bin
+	size_t i1 = b1 * UCAC5_ZONES + z;
+	size_t i2 = b2 * UCAC5_ZONES + z;
+	// stars are sorted by RA in zone, so RA bins of the zone follow each other
+	start = std::min ((size_t) index[i1], zone->count);
+	end = std::min ((size_t) index[i2] + index[UCAC5_ZONES * UCAC5_RA_BINS + i2], zone->count);
+	if (end < start)
+		end = start;
+}
+
+/**
+ * Append ranges of RA bins from b1 to b2 (inclusive, bins can be negative
+ * or larger than number of bins to wrap around 0h). Adjacent bins are
+ * merged.
+ */
+static void addBins (int b1, int b2, std::vector <std::pair <int, int> > &bins)
+{
+	if (b2 - b1 + 1 >= UCAC5_RA_BINS)
+	{
+		bins.push_back (std::pair <int, int> (0, UCAC5_RA_BINS - 1));
+		return;
+	}
+	if (b1 < 0)
+	{
+		bins.push_back (std::pair <int, int> (b1 + UCAC5_RA_BINS, UCAC5_RA_BINS - 1));
+		b1 = 0;
+	}
+	if (b2 >= UCAC5_RA_BINS)
+	{
+		bins.push_back (std::pair <int, int> (0, b2 - UCAC5_RA_BINS));
+		b2 = UCAC5_RA_BINS - 1;
+	}
+	bins.push_back (std::pair <int, int> (b1, b2));
+}
+
+static int clampZone (double dec)
+{
+	int z = floor ((dec + M_PI / 2.0) / ZONE_HEIGHT);
+	if (z < 0)
+		return 0;
+	if (z >= UCAC5_ZONES)
+		return UCAC5_ZONES - 1;
+	return z;
+}
+
+int UCAC5Catalogue::cone (double ra, double dec, double minRadius, double maxRadius, double magLimit, size_t maxStars, std::vector <UCAC5Star> &stars)
+{
+	stars.clear ();
+
+	double t[3];
+	eraS2c (ra, dec, t);
+	ra = eraAnp (ra);
+
+	double cosMin = cos (minRadius);
+	double cosMax = cos (maxRadius);
+
+	std::vector <std::pair <int, int> > bins;
+
+	// circle contains pole, or is too large
+	double s = sin (maxRadius) / cos (dec);
+	if (dec + maxRadius >= M_PI / 2.0 || dec - maxRadius <= -M_PI / 2.0 || s >= 1)
+	{
+		addBins (0, UCAC5_RA_BINS - 1, bins);
+	}
+	else
+	{
+		double w = asin (s);
+		addBins (floor ((ra - w) / BIN_WIDTH), floor ((ra + w) / BIN_WIDTH), bins);
+	}
+
+	int z2 = clampZone (dec + maxRadius);
+	for (int z = clampZone (dec - maxRadius); z <= z2; z++)
+	{
+		Zone *zone = getZone (z);
+		if (zone == NULL)
+			return -1;
+		for (std::vector <std::pair <int, int> >::iterator iter = bins.begin (); iter != bins.end (); iter++)
+		{
+			size_t start, end;
+			getRange (zone, z, iter->first, iter->second, start, end);
+			matchCone (zone, start, end, t, cosMin, cosMax, magLimit, maxStars, stars);
+		}
+	}
+	std::sort_heap (stars.begin (), stars.end (), brighter);
+	return 0;
+}
+
+int UCAC5Catalogue::box (double ra1, double dec1, double ra2, double dec2, double magLimit, size_t maxStars, std::vector <UCAC5Star> &stars)
+{
+	stars.clear ();
+
+	std::vector <std::pair <int, int> > bins;
+	bool allRa = ra2 - ra1 >= 2 * M_PI;
+
+	ra1 = eraAnp (ra1);
+	ra2 = eraAnp (ra2);
+
+	if (allRa)
+		addBins (0, UCAC5_RA_BINS - 1, bins);
+	else if (ra1 <= ra2)
+		addBins (floor (ra1 / BIN_WIDTH), floor (ra2 / BIN_WIDTH), bins);
+	else
+		addBins (floor (ra1 / BIN_WIDTH), floor (ra2 / BIN_WIDTH) + UCAC5_RA_BINS, bins);
+
+	// records hold positions in mas
+	double r1 = ra1 * ERFA_DR2AS * 1000.0;
+	double r2 = ra2 * ERFA_DR2AS * 1000.0;
+	double d1 = dec1 * ERFA_DR2AS * 1000.0;
+	double d2 = dec2 * ERFA_DR2AS * 1000.0;
+
+	int z2 = clampZone (dec2);
+	for (int z = clampZone (dec1); z <= z2; z++)
+	{
+		Zone *zone = getZone (z);
+		if (zone == NULL)
+			return -1;
+		for (std::vector <std::pair <int, int> >::iterator iter = bins.begin (); iter != bins.end (); iter++)
+		{
+			size_t start, end;
+			getRange (zone, z, iter->first, iter->second, start, end);
+			for (size_t i = start; i < end; i++)
+			{
+				const struct ucac5 *rec = zone->records + i;
+				if (rec->idc < d1 || rec->idc > d2)
+					continue;
+				if (!allRa && (ra1 <= ra2 ? (rec->ira < r1 || rec->ira > r2) : (rec->ira < r1 && rec->ira > r2)))
+					continue;
+				addStar (rec, NAN, magLimit, maxStars, stars);
+			}
+		}
+	}
+	std::sort_heap (stars.begin (), stars.end (), brighter);
+	return 0;
+}
+
+static inline void addMatch (const struct ucac5 *rec, const Vector *v, const double t[3], double magLimit, size_t maxStars, std::vector <UCAC5Star> &stars)
+{
+	// distance from chord length, precise for small distances
+	double dx = v->data[0] - t[0];
+	double dy = v->data[1] - t[1];
+	double dz = v->data[2] - t[2];
+	addStar (rec, 2 * asin (sqrt (dx * dx + dy * dy + dz * dz) / 2.0), magLimit, maxStars, stars);
+}
+
+void UCAC5Catalogue::matchCone (Zone *zone, size_t start, size_t end, const double t[3], double cosMin, double cosMax, double magLimit, size_t maxStars, std::vector <UCAC5Star> &stars)
+{
+	size_t i = start;
+
+#if defined(__SSE2__)
+	// two vectors (six doubles) are loaded to three registers as (x0, y0), (z0, x1), (y1, z1)
+	const __m128d t01 = _mm_set_pd (t[1], t[0]);
+	const __m128d t20 = _mm_set_pd (t[0], t[2]);
+	const __m128d t12 = _mm_set_pd (t[2], t[1]);
+	const __m128d vmin = _mm_set1_pd (cosMin);
+	const __m128d vmax = _mm_set1_pd (cosMax);
+
+	for (; simd && i + 1 < end; i += 2)
+	{
+		const double *p = zone->xyz[i].data;
+		__m128d pa = _mm_mul_pd (_mm_loadu_pd (p), t01);
+		__m128d pb = _mm_mul_pd (_mm_loadu_pd (p + 2), t20);
+		__m128d pc = _mm_mul_pd (_mm_loadu_pd (p + 4), t12);
+		// (x0 * tx + y0 * ty) + z0 * tz, (x1 * tx + y1 * ty) + z1 * tz - same order as the scalar code
+		__m128d dot = _mm_add_pd (_mm_add_pd (_mm_shuffle_pd (pa, pb, 2), _mm_shuffle_pd (pa, pc, 1)), _mm_shuffle_pd (pb, pc, 2));
+		int m = _mm_movemask_pd (_mm_and_pd (_mm_cmpge_pd (dot, vmax), _mm_cmple_pd (dot, vmin)));
+		if (m == 0)
+			continue;
+		if (m & 1)
+			addMatch (zone->records + i, zone->xyz + i, t, magLimit, maxStars, stars);
+		if (m & 2)
+			addMatch (zone->records + i + 1, zone->xyz + i + 1, t, magLimit, maxStars, stars);
+	}
+#endif
+
+	for (; i < end; i++)
+	{
+		const double *p = zone->xyz[i].data;
+		double dot = p[0] * t[0] + p[1] * t[1] + p[2] * t[2];
+		if (dot >= cosMax && dot <= cosMin)
+			addMatch (zone->records + i, zone->xyz + i, t, magLimit, maxStars, stars);
+	}
+}
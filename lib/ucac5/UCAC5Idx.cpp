@@ -1,6 +1,7 @@
 #include "ucac5/UCAC5Idx.hpp"
 
 #include <erfa.h>
+#include <math.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -54,11 +55,15 @@ int UCAC5Idx::select (size_t offset, size_t length)
 
 int UCAC5Idx::nextMatched (Vector *fc, double minRad, double maxRad, double &d)
 {
+	// compare dot product with cosines of the radii, distance is calculated only for matched stars
+	double cosMin = cos(minRad);
+	double cosMax = cos(maxRad);
 	while (current < currentEnd)
 	{
-		d = eraSepp(fc->data, current->data);
-		if (d >= minRad && d <= maxRad)
+		double dot = fc->data[0] * current->data[0] + fc->data[1] * current->data[1] + fc->data[2] * current->data[2];
+		if (dot >= cosMax && dot <= cosMin)
 		{
+			d = eraSepp(fc->data, current->data);
 			int ret = current - data;
 			current++;
 			return ret;
@@ -1,5 +1,7 @@
 
+#include "rts2-config.h"
 #include "XmlRpcServerConnection.h"
+#include "XmlRpcServerGetRequest.h"
 
 #include "XmlRpcSocket.h"
 #include "XmlRpc.h"
@@ -18,12 +20,24 @@
 #include <winsock2.h>
 #else
 #include <errno.h>
+#include <unistd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #endif
 
+#ifdef RTS2_HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
+
 #include <time.h>
 
+// maximal number of file bytes written in a single call, so streaming of
+// large files does not block other connections
+#define FILE_WRITE_CHUNK   (1024 * 1024)
+
+// size of buffer used to stream files without sendfile
+#define FILE_BUFFER_SIZE   (64 * 1024)
+
 using namespace XmlRpc;
 
 // Static data
@@ -68,6 +82,11 @@ XmlRpcServerConnection::XmlRpcServerConnection(int fd, XmlRpcServer* server, boo
 	_get_response_length = 0;
 	_get_response = NULL;
 
+	_get_file = -1;
+	_get_file_offset = 0;
+	_get_file_length = 0;
+	_get_file_buf = NULL;
+
 	memcpy (&_saddr, saddr, addrlen);
 	_addrlen = addrlen;
 }
@@ -78,6 +97,8 @@ XmlRpcServerConnection::~XmlRpcServerConnection()
 	_server->removeConnection(this);
 
 	delete[] _get_response;
+	closeFileResponse ();
+	delete[] _get_file_buf;
 }
 
 // Handle input on the server socket by accepting the connection
@@ -134,6 +155,7 @@ bool XmlRpcServerConnection::readHeader()
 	char *lp = 0;				 // Start of content-length value
 	char *kp = 0;				 // Start of connection value
 	char *ap = 0;				 // Start of authorization header
+	char *rp = 0;				 // Start of range value
 
 	for (char *cp = hp; (bp == 0) && (cp < ep); ++cp)
 	{
@@ -147,6 +169,15 @@ bool XmlRpcServerConnection::readHeader()
 			kp = cp + 12;
 		else if ((ep - cp > 15) && (strncasecmp (cp, "Authorization: ", 15) == 0))
 			ap = cp + 15;
+		else if ((cp == hp || cp[-1] == '\n') && (ep - cp > 6) && (strncasecmp (cp, "Range", 5) == 0))
+		{
+			// header name is case insensitive, and can be followed by whitespace
+			char *np = cp + 5;
+			while (np < ep && (*np == ' ' || *np == '\t'))
+				np++;
+			if (np < ep && *np == ':')
+				rp = np + 1;
+		}
 		else if ((ep - cp >= 4) && (strncmp(cp, "\r\n\r\n", 4) == 0))
 			bp = cp + 4;
 		else if ((ep - cp >= 2) && (strncmp(cp, "\n\n", 2) == 0))
@@ -192,6 +223,14 @@ bool XmlRpcServerConnection::readHeader()
 		}
 	}
 
+	if (rp != 0)
+	{
+		char *rpe = rp;
+		while (rpe < ep && *rpe != '\r' && *rpe != '\n')
+			rpe++;
+		_range = _header.substr (rp - hp, rpe - rp);
+	}
+
 	// Parse out any interesting bits from the header (HTTP version, connection)
 	_keepAlive = true;
 	if (_header.find("HTTP/1.0") != std::string::npos)
@@ -338,7 +377,7 @@ bool XmlRpcServerConnection::handleGet()
 	}
 	if (_getHeaderWritten == _get_response_header.length () && _getWritten != _get_response_length)
 	{
-		if ( XmlRpcSocket::nbWriteBuf(this->getfd(), _get_response, _get_response_length, &_getWritten, false, false) != 0 )
+		if ( ! writeGetData())
 		{
 			XmlRpcUtil::error("XmlRpcServerConnection::handleGet: write error (%s).",XmlRpcSocket::getErrorMsg().c_str());
 			return false;
@@ -394,7 +433,7 @@ bool XmlRpcServerConnection::writeResponse()
 
 bool XmlRpcServerConnection::writeAsyncReponse()
 {
-	if ( XmlRpcSocket::nbWriteBuf(this->getfd(), _get_response, _get_response_length, &_getWritten, false, false) != 0 )
+	if ( ! writeGetData())
 	{
 		XmlRpcUtil::error("XmlRpcServerConnection::writeAsyncReponse %i: write error (%s).",this->getfd(), XmlRpcSocket::getErrorMsg().c_str());
 		return false;
@@ -409,6 +448,57 @@ bool XmlRpcServerConnection::writeAsyncReponse()
 	return true;
 }
 
+bool XmlRpcServerConnection::writeGetData()
+{
+	if (_get_file >= 0)
+		return writeFileData();
+	return XmlRpcSocket::nbWriteBuf(this->getfd(), _get_response, _get_response_length, &_getWritten, false, false) == 0;
+}
+
+bool XmlRpcServerConnection::writeFileData()
+{
+	size_t toWrite = _get_response_length - _getWritten;
+	if (toWrite > FILE_WRITE_CHUNK)
+		toWrite = FILE_WRITE_CHUNK;
+	off_t offset = _get_file_offset + _getWritten;
+	ssize_t n;
+
+#ifdef RTS2_HAVE_SYS_SENDFILE_H
+	if (_get_file_buf == NULL)
+	{
+		n = sendfile(this->getfd(), _get_file, &offset, toWrite);
+		if (n > 0)
+		{
+			_getWritten += n;
+			return true;
+		}
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+			return true;
+		// file system does not support sendfile, fall back to buffered copy
+		if (n < 0 && (errno == EINVAL || errno == ENOSYS))
+			_get_file_buf = new char[FILE_BUFFER_SIZE];
+		else
+			return false;
+	}
+#else
+	if (_get_file_buf == NULL)
+		_get_file_buf = new char[FILE_BUFFER_SIZE];
+#endif
+
+	if (toWrite > FILE_BUFFER_SIZE)
+		toWrite = FILE_BUFFER_SIZE;
+	n = pread(_get_file, _get_file_buf, toWrite, offset);
+	// file was truncated or cannot be read
+	if (n <= 0)
+		return false;
+	// data which will not be sent are read again on the next call
+	size_t sent = 0;
+	if (XmlRpcSocket::nbWriteBuf(this->getfd(), _get_file_buf, n, &sent, false, false) != 0)
+		return false;
+	_getWritten += sent;
+	return true;
+}
+
 // Run the method, generate _response string
 void XmlRpcServerConnection::executeRequest()
 {
@@ -515,9 +605,18 @@ void XmlRpcServerConnection::executeGet()
 				throw XmlRpcException ("Path contains !");
 
 			request->execute (this, &_saddr, path, &params, http_code, response_type, _get_response, _get_response_length);
+
+			if (_get_file >= 0)
+			{
+				if (http_code == HTTP_OK && _get_response == NULL)
+					http_code = selectFileRange ();
+				else
+					closeFileResponse ();
+			}
 		}
 		catch (const JSONException& fault)
 		{
+			closeFileResponse ();
 			XmlRpcUtil::log(2, "XmlRpcServerConnection::executeRequest: JSON fault %s.", fault.getMessage().c_str());
 			if (isChunked ())
 			{
@@ -536,6 +635,7 @@ void XmlRpcServerConnection::executeGet()
 		}
 		catch (const std::exception& ex)
 		{
+			closeFileResponse ();
 			_get_response = new char[501];
 			response_type = "text/html";
 			_get_response_length = snprintf (_get_response, 500, "<html><head><title>Error</title></head><body><p>Bad request %s</p></body></html>", ex.what());
@@ -549,6 +649,12 @@ void XmlRpcServerConnection::executeGet()
 		case HTTP_OK:
 			http_code_string = "OK";
 			break;
+		case HTTP_PARTIAL_CONTENT:
+			http_code_string = "Partial Content";
+			break;
+		case HTTP_RANGE_NOT_SATISFIABLE:
+			http_code_string = "Range Not Satisfiable";
+			break;
 		case HTTP_UNAUTHORIZED:
 			http_code_string = "Authorization Required";
 			addExtraHeader ("WWW-Authenticate", "Basic realm=\"Your RTS2 login\"");
@@ -693,6 +799,121 @@ void XmlRpcServerConnection::setSourceEvents(unsigned eventMask)
 	_server->setSourceEvents(this, eventMask);
 }
 
+void XmlRpcServerConnection::setFileResponse(int fd, size_t length)
+{
+	closeFileResponse ();
+	_get_file = fd;
+	_get_file_offset = 0;
+	_get_file_length = length;
+}
+
+int XmlRpcServerConnection::parseRange(const std::string &range, size_t length, size_t &first, size_t &last)
+{
+	first = 0;
+	last = length - 1;
+
+	std::string::size_type b = range.find_first_not_of (" \t");
+	std::string::size_type e = range.find_last_not_of (" \t");
+	if (b == std::string::npos)
+		return HTTP_OK;
+	std::string r = range.substr (b, e - b + 1);
+
+	// only single range is supported, other requests receive the whole file
+	if (r.length () < 6 || strncasecmp (r.c_str (), "bytes=", 6) != 0 || r.find (',') != std::string::npos)
+		return HTTP_OK;
+
+	std::string spec = r.substr (6);
+	std::string::size_type dash = spec.find ('-');
+	if (dash == std::string::npos)
+		return HTTP_OK;
+
+	char *end;
+	unsigned long long f, l;
+	if (dash == 0)
+	{
+		// suffix range - last N bytes
+		if (spec.length () == 1 || !isdigit (spec[1]))
+			return HTTP_OK;
+		unsigned long long suffix = strtoull (spec.c_str () + 1, &end, 10);
+		if (*end != '\0')
+			return HTTP_OK;
+		if (suffix == 0 || length == 0)
+			return HTTP_RANGE_NOT_SATISFIABLE;
+		f = suffix > length ? 0 : length - suffix;
+		l = length - 1;
+	}
+	else
+	{
+		if (!isdigit (spec[0]))
+			return HTTP_OK;
+		f = strtoull (spec.c_str (), &end, 10);
+		if (end != spec.c_str () + dash)
+			return HTTP_OK;
+		if (dash + 1 == spec.length ())
+		{
+			l = length - 1;
+		}
+		else
+		{
+			if (!isdigit (spec[dash + 1]))
+				return HTTP_OK;
+			l = strtoull (spec.c_str () + dash + 1, &end, 10);
+			if (*end != '\0' || l < f)
+				return HTTP_OK;
+			if (l >= length)
+				l = length - 1;
+		}
+		if (f >= length)
+			return HTTP_RANGE_NOT_SATISFIABLE;
+	}
+
+	first = f;
+	last = l;
+	return HTTP_PARTIAL_CONTENT;
+}
+
+int XmlRpcServerConnection::selectFileRange()
+{
+	_get_file_offset = 0;
+	_get_response_length = _get_file_length;
+	addExtraHeader ("Accept-Ranges", "bytes");
+
+	size_t first, last;
+	int ret = parseRange (_range, _get_file_length, first, last);
+	if (ret == HTTP_OK)
+		return HTTP_OK;
+
+	std::ostringstream os;
+	if (ret == HTTP_RANGE_NOT_SATISFIABLE)
+	{
+		closeFileResponse ();
+		os << "bytes */" << _get_file_length;
+		addExtraHeader ("Content-Range", os.str ());
+
+		const char *r = "<html><head><title>Range Not Satisfiable</title></head><body><p>Requested range is outside of the file</p></body></html>";
+		_get_response_length = strlen (r);
+		_get_response = new char[_get_response_length];
+		memcpy (_get_response, r, _get_response_length);
+		return HTTP_RANGE_NOT_SATISFIABLE;
+	}
+
+	os << "bytes " << first << "-" << last << "/" << _get_file_length;
+	addExtraHeader ("Content-Range", os.str ());
+
+	_get_file_offset = first;
+	_get_response_length = last - first + 1;
+	return HTTP_PARTIAL_CONTENT;
+}
+
+void XmlRpcServerConnection::closeFileResponse()
+{
+	if (_get_file >= 0)
+		::close (_get_file);
+	_get_file = -1;
+	_get_file_offset = 0;
+	_get_file_length = 0;
+}
+
 void XmlRpcServerConnection::setResponse(char *_set_response, size_t _response_length)
 {
 	_getWritten = 0;
@@ -787,6 +1008,8 @@ void XmlRpcServerConnection::prepareForNext ()
 	_get_response_length = 0;
 	delete[] _get_response;
 	_get_response = NULL;
+	closeFileResponse ();
+	_range = "";
 	_response = "";
 	_connectionState = READ_HEADER;
 }
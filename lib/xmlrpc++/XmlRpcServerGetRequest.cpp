@@ -3,6 +3,7 @@
 #include "urlencoding.h"
 #include "XmlRpcServerGetRequest.h"
 #include "XmlRpcServer.h"
+#include "XmlRpcException.h"
 #include "utilsfunc.h"
 
 #include "string.h"
@@ -10,6 +11,10 @@
 #include <algorithm>
 #include <iostream>
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
 using namespace XmlRpc;
 
 const char *HttpParams::getString (const char *_name, const char *def_val)
@@ -194,3 +199,27 @@ void XmlRpcServerGetRequest::sendAsyncDataHeader (size_t contentLength, XmlRpcSe
 	if (contentLength == 0)
 		source->goChunked ();
 }
+
+void XmlRpcServerGetRequest::sendFile (const char *path)
+{
+	int f = open (path, O_RDONLY);
+	if (f == -1)
+		throw XmlRpcException ("Cannot open file");
+	sendFile (f);
+}
+
+void XmlRpcServerGetRequest::sendFile (int f)
+{
+	struct stat st;
+	if (fstat (f, &st) == -1)
+	{
+		close (f);
+		throw XmlRpcException ("Cannot get file properties");
+	}
+	sendFile (f, st.st_size);
+}
+
+void XmlRpcServerGetRequest::sendFile (int f, size_t length)
+{
+	connection->setFileResponse (f, length);
+}
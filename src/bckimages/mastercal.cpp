@@ -0,0 +1,161 @@
+/*
+ * Build master dark and flat frames.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "cliapp.h"
+#include "rts2fits/mastercal.h"
+
+#include <iostream>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define OPT_ITERATIONS     OPT_LOCAL + 1
+#define OPT_TILE_MEMORY    OPT_LOCAL + 2
+#define OPT_OVERWRITE      OPT_LOCAL + 3
+
+/**
+ * Combine dark or flat frames to master frame.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class MasterCal:public rts2core::CliApp
+{
+	public:
+		MasterCal (int argc, char **argv);
+
+	protected:
+		virtual int processOption (int opt);
+		virtual int processArgs (const char *arg);
+		virtual int init ();
+		virtual void usage ();
+
+		virtual int doProcessing ();
+
+	private:
+		rts2image::MasterCalibration master;
+		const char *output;
+		bool overwrite;
+		int inputs;
+};
+
+MasterCal::MasterCal (int argc, char **argv):rts2core::CliApp (argc, argv)
+{
+	output = NULL;
+	overwrite = false;
+	inputs = 0;
+
+	long ncpu = sysconf (_SC_NPROCESSORS_ONLN);
+	master.setThreads (ncpu > 0 ? ncpu : 1);
+
+	addOption ('o', NULL, 1, "output (master) file");
+	addOption ('d', NULL, 1, "master dark (or bias) subtracted from input frames");
+	addOption ('f', NULL, 0, "normalise input frames by mean of their central region (for flats)");
+	addOption ('s', NULL, 1, "sigma clipping limit; frames are median combined if not specified");
+	addOption (OPT_ITERATIONS, "iterations", 1, "number of sigma clipping iterations (default 3)");
+	addOption ('j', NULL, 1, "number of threads (default number of CPUs)");
+	addOption (OPT_TILE_MEMORY, "tile-memory", 1, "memory (in MB) for input buffers of one tile (default 16)");
+	addOption (OPT_OVERWRITE, "overwrite", 0, "overwrite existing output file");
+}
+
+int MasterCal::processOption (int opt)
+{
+	switch (opt)
+	{
+		case 'o':
+			output = optarg;
+			break;
+		case 'd':
+			master.setDark (optarg);
+			break;
+		case 'f':
+			master.setNormalize (true);
+			break;
+		case 's':
+			master.setMethod (rts2image::COMBINE_SIGMA_CLIP, atof (optarg));
+			break;
+		case OPT_ITERATIONS:
+			master.setIterations (atoi (optarg));
+			break;
+		case 'j':
+			if (atoi (optarg) < 1)
+			{
+				std::cerr << "invalid number of threads: " << optarg << std::endl;
+				return -1;
+			}
+			master.setThreads (atoi (optarg));
+			break;
+		case OPT_TILE_MEMORY:
+			if (atof (optarg) <= 0)
+			{
+				std::cerr << "invalid tile memory: " << optarg << std::endl;
+				return -1;
+			}
+			master.setTileMemory (atof (optarg) * 1024 * 1024);
+			break;
+		case OPT_OVERWRITE:
+			overwrite = true;
+			break;
+		default:
+			return rts2core::CliApp::processOption (opt);
+	}
+	return 0;
+}
+
+int MasterCal::processArgs (const char *arg)
+{
+	master.addInput (arg);
+	inputs++;
+	return 0;
+}
+
+int MasterCal::init ()
+{
+	int ret = rts2core::CliApp::init ();
+	if (ret)
+		return ret;
+
+	if (output == NULL)
+	{
+		std::cerr << "output file must be specified with -o option" << std::endl;
+		return -1;
+	}
+	if (inputs == 0)
+	{
+		std::cerr << "no input frames specified" << std::endl;
+		return -1;
+	}
+	return 0;
+}
+
+void MasterCal::usage ()
+{
+	std::cout
+		<< "  rts2-mastercal -o dark.fits d*.fits                 .. median combine darks" << std::endl
+		<< "  rts2-mastercal -o flat.fits -d dark.fits -f -s 3 f*.fits  .. subtract dark from flats, normalise them and combine them with 3 sigma clipping" << std::endl;
+}
+
+int MasterCal::doProcessing ()
+{
+	return master.build (output, overwrite);
+}
+
+int main (int argc, char **argv)
+{
+	MasterCal app (argc, argv);
+	return app.run ();
+}
@@ -28,7 +28,8 @@ class GSC:public Catd
 		virtual ~GSC (void);
 
 	protected:
-		virtual int searchCataloge (struct ln_equ_posn *c1, struct ln_equ_posn *c2, int num);
+		virtual int searchCone (struct ln_equ_posn *c, double radius, double magLimit, int maxStars, std::vector <CatalogueStar> &stars);
+		virtual int searchBox (struct ln_equ_posn *c1, struct ln_equ_posn *c2, double magLimit, int maxStars, std::vector <CatalogueStar> &stars);
 };
 
 GSC::GSC (int argc, char **argv):Catd (argc, argv)
@@ -42,7 +43,12 @@ GSC::~GSC ()
 }
 
 
-int GSC::searchCataloge (struct ln_equ_posn *c1, struct ln_equ_posn *c2, int num)
+int GSC::searchCone (struct ln_equ_posn *c, double radius, double magLimit, int maxStars, std::vector <CatalogueStar> &stars)
+{
+	return 0;
+}
+
+int GSC::searchBox (struct ln_equ_posn *c1, struct ln_equ_posn *c2, double magLimit, int maxStars, std::vector <CatalogueStar> &stars)
 {
 	return 0;
 }
@@ -0,0 +1,313 @@
+/*
+ * Satellite catalogue daemon, screening images for satellites.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "device.h"
+#include "configuration.h"
+#include "valuearray.h"
+#include "utilsfunc.h"
+#include "libnova_cpp.h"
+#include "pluto/satcatalogue.h"
+
+#define OPT_THREADS    OPT_LOCAL + 1
+#define OPT_BUCKET     OPT_LOCAL + 2
+
+/**
+ * Serves catalogue of satellites. TLEs are loaded once, at startup and on
+ * reload command or HUP signal.
+ *
+ * screen JD RA DEC RADIUS DURATION searches for satellites which are
+ * within RADIUS (degrees) of J2000 RA DEC during exposure starting at JD,
+ * lasting DURATION seconds, seen from the observatory. screen_site JD RA
+ * DEC RADIUS DURATION LNG LAT ALT does the same for observer at the given
+ * longitude, latitude (degrees) and altitude (meters). Found satellites
+ * are returned in sats_ array values.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class TLECatd:public rts2core::Device
+{
+	public:
+		TLECatd (int argc, char **argv);
+		virtual ~TLECatd ();
+
+		virtual int commandAuthorized (rts2core::Connection * conn);
+
+	protected:
+		virtual int processOption (int opt);
+		virtual int initHardware ();
+
+		virtual int setValue (rts2core::Value * old_value, rts2core::Value * new_value);
+
+		virtual void signaledHUP ();
+
+	private:
+		const char *tleFile;
+		int threads;
+		double bucket;
+		rts2sat::SatCatalogue *catalogue;
+
+		rts2core::ValueString *catalogueFile;
+		rts2core::ValueInteger *numObjects;
+		rts2core::ValueInteger *numRejected;
+		rts2core::ValueInteger *numThreads;
+		rts2core::ValueDouble *bucketStep;
+
+		rts2core::ValueTime *queryTime;
+		rts2core::ValueRaDec *queryRaDec;
+		rts2core::ValueDouble *queryRadius;
+		rts2core::ValueDouble *queryDuration;
+		rts2core::ValueInteger *numCandidates;
+		rts2core::ValueInteger *numSats;
+		rts2core::ValueDouble *searchDuration;
+
+		rts2core::IntegerArray *satsNorad;
+		rts2core::StringArray *satsDesig;
+		rts2core::StringArray *satsName;
+		rts2core::TimeArray *satsTime;
+		rts2core::DoubleArray *satsRa;
+		rts2core::DoubleArray *satsDec;
+		rts2core::DoubleArray *satsSeparation;
+		rts2core::DoubleArray *satsRange;
+		rts2core::DoubleArray *satsMotion;
+		rts2core::DoubleArray *satsPA;
+
+		int loadCatalogue ();
+		int screen (double JD, struct ln_equ_posn *c, double radius, double duration, double lng, double lat, double alt);
+};
+
+TLECatd::TLECatd (int argc, char **argv):rts2core::Device (argc, argv, DEVICE_TYPE_CAT, "SAT1")
+{
+	tleFile = NULL;
+	threads = 1;
+	bucket = 10;
+	catalogue = NULL;
+
+	createValue (catalogueFile, "tle_file", "file with TLEs of satellites", false);
+	createValue (numObjects, "objects", "number of satellites in catalogue", false);
+	createValue (numRejected, "rejected", "number of TLEs which cannot be parsed", false);
+	createValue (numThreads, "threads", "number of threads used for searches", false);
+	createValue (bucketStep, "bucket_step", "[s] time step of satellites position index", false, RTS2_VALUE_WRITABLE);
+
+	createValue (queryTime, "query_time", "start of the last searched exposure", false);
+	createValue (queryRaDec, "query_radec", "centre of the last search", false);
+	createValue (queryRadius, "radius", "[deg] radius of the last search", false, RTS2_DT_DEG_DIST);
+	createValue (queryDuration, "duration", "[s] exposure length of the last search", false);
+	createValue (numCandidates, "candidates", "number of satellites propagated during the last search", false);
+	createValue (numSats, "num_sats", "number of satellites found by the last search", false);
+	createValue (searchDuration, "search_duration", "[s] duration of the last search", false);
+
+	createValue (satsNorad, "sats_norad", "NORAD number of found satellite", false);
+	createValue (satsDesig, "sats_desig", "international designation of found satellite", false);
+	createValue (satsName, "sats_name", "name of found satellite", false);
+	createValue (satsTime, "sats_time", "time of the closest approach", false);
+	createValue (satsRa, "sats_ra", "[deg] RA of the closest approach", false, RTS2_DT_RA);
+	createValue (satsDec, "sats_dec", "[deg] DEC of the closest approach", false, RTS2_DT_DEC);
+	createValue (satsSeparation, "sats_sep", "[deg] distance of found satellite from search centre", false, RTS2_DT_DEG_DIST);
+	createValue (satsRange, "sats_range", "[km] distance of found satellite from observer", false);
+	createValue (satsMotion, "sats_motion", "[deg/s] apparent motion of found satellite", false);
+	createValue (satsPA, "sats_pa", "[deg] position angle of apparent motion", false);
+
+	addOption ('t', NULL, 1, "file with TLEs (optionally preceded by satellite name line)");
+	addOption (OPT_THREADS, "threads", 1, "number of threads used for searches (default to 1)");
+	addOption (OPT_BUCKET, "bucket-step", 1, "time step of satellites position index in seconds (default to 10)");
+}
+
+TLECatd::~TLECatd ()
+{
+	delete catalogue;
+}
+
+int TLECatd::processOption (int opt)
+{
+	switch (opt)
+	{
+		case 't':
+			tleFile = optarg;
+			break;
+		case OPT_THREADS:
+			threads = atoi (optarg);
+			if (threads < 1)
+			{
+				std::cerr << "invalid number of threads: " << optarg << std::endl;
+				return -1;
+			}
+			break;
+		case OPT_BUCKET:
+			bucket = atof (optarg);
+			if (bucket < SAT_MIN_BUCKET_STEP)
+			{
+				std::cerr << "invalid bucket step: " << optarg << std::endl;
+				return -1;
+			}
+			break;
+		default:
+			return rts2core::Device::processOption (opt);
+	}
+	return 0;
+}
+
+int TLECatd::initHardware ()
+{
+	if (tleFile == NULL)
+	{
+		logStream (MESSAGE_ERROR) << "TLE file must be specified with -t option" << sendLog;
+		return -1;
+	}
+
+	catalogue = new rts2sat::SatCatalogue (threads);
+	catalogue->setBucketStep (bucket);
+	catalogueFile->setValueCharArr (tleFile);
+	numThreads->setValueInteger (catalogue->getThreads ());
+	bucketStep->setValueDouble (bucket);
+
+	return loadCatalogue ();
+}
+
+int TLECatd::setValue (rts2core::Value * old_value, rts2core::Value * new_value)
+{
+	if (old_value == bucketStep)
+	{
+		if (new_value->getValueDouble () < SAT_MIN_BUCKET_STEP)
+			return -2;
+		catalogue->setBucketStep (new_value->getValueDouble ());
+		return 0;
+	}
+	return rts2core::Device::setValue (old_value, new_value);
+}
+
+void TLECatd::signaledHUP ()
+{
+	if (catalogue)
+		loadCatalogue ();
+	rts2core::Device::signaledHUP ();
+}
+
+int TLECatd::commandAuthorized (rts2core::Connection * conn)
+{
+	double JD, radius, duration;
+	struct ln_equ_posn c;
+	if (conn->isCommand ("screen"))
+	{
+		if (conn->paramNextDouble (&JD) || conn->paramNextHMS (&c.ra) || conn->paramNextDMS (&c.dec) || conn->paramNextDouble (&radius) || conn->paramNextDouble (&duration) || !conn->paramEnd ())
+			return DEVDEM_E_PARAMSNUM;
+		if (radius <= 0 || radius > 90 || duration < 0 || duration > SAT_MAX_DURATION)
+			return DEVDEM_E_PARAMSVAL;
+		struct ln_lnlat_posn *obs = rts2core::Configuration::instance ()->getObserver ();
+		return screen (JD, &c, radius, duration, obs->lng, obs->lat, rts2core::Configuration::instance ()->getObservatoryAltitude ());
+	}
+	else if (conn->isCommand ("screen_site"))
+	{
+		double lng, lat, alt;
+		if (conn->paramNextDouble (&JD) || conn->paramNextHMS (&c.ra) || conn->paramNextDMS (&c.dec) || conn->paramNextDouble (&radius) || conn->paramNextDouble (&duration)
+			|| conn->paramNextDouble (&lng) || conn->paramNextDouble (&lat) || conn->paramNextDouble (&alt) || !conn->paramEnd ())
+			return DEVDEM_E_PARAMSNUM;
+		if (radius <= 0 || radius > 90 || duration < 0 || duration > SAT_MAX_DURATION || fabs (lat) > 90)
+			return DEVDEM_E_PARAMSVAL;
+		return screen (JD, &c, radius, duration, lng, lat, alt);
+	}
+	else if (conn->isCommand ("reload"))
+	{
+		if (!conn->paramEnd ())
+			return DEVDEM_E_PARAMSNUM;
+		return loadCatalogue () ? DEVDEM_E_SYSTEM : 0;
+	}
+	return rts2core::Device::commandAuthorized (conn);
+}
+
+int TLECatd::loadCatalogue ()
+{
+	double start = getNow ();
+	int ret = catalogue->load (catalogueFile->getValue ());
+	if (ret < 0)
+	{
+		logStream (MESSAGE_ERROR) << "cannot read TLE file " << catalogueFile->getValue () << sendLog;
+		return -1;
+	}
+	numObjects->setValueInteger (ret);
+	numRejected->setValueInteger (catalogue->getRejected ());
+	sendValueAll (numObjects);
+	sendValueAll (numRejected);
+	logStream (MESSAGE_INFO) << "loaded " << ret << " satellites from " << catalogueFile->getValue () << " in " << (getNow () - start) << " s, " << catalogue->getRejected () << " TLEs rejected" << sendLog;
+	return 0;
+}
+
+int TLECatd::screen (double JD, struct ln_equ_posn *c, double radius, double duration, double lng, double lat, double alt)
+{
+	double start = getNow ();
+	std::vector <rts2sat::SatMatch> matches;
+	size_t candidates = catalogue->query (JD, duration, lng, lat, alt, c->ra, c->dec, radius, matches);
+
+	satsNorad->clear ();
+	satsDesig->clear ();
+	satsName->clear ();
+	satsTime->clear ();
+	satsRa->clear ();
+	satsDec->clear ();
+	satsSeparation->clear ();
+	satsRange->clear ();
+	satsMotion->clear ();
+	satsPA->clear ();
+
+	for (std::vector <rts2sat::SatMatch>::iterator iter = matches.begin (); iter != matches.end (); iter++)
+	{
+		satsNorad->addValue (iter->norad);
+		satsDesig->addValue (std::string (catalogue->getIntlDesig (iter->index)));
+		satsName->addValue (catalogue->getName (iter->index));
+		satsTime->addValue (timetFromJD (iter->JD));
+		satsRa->addValue (iter->ra);
+		satsDec->addValue (iter->dec);
+		satsSeparation->addValue (iter->separation);
+		satsRange->addValue (iter->range);
+		satsMotion->addValue (iter->motion);
+		satsPA->addValue (iter->pa);
+	}
+
+	queryTime->setValueDouble (timetFromJD (JD));
+	queryRaDec->setValueRaDec (c->ra, c->dec);
+	queryRadius->setValueDouble (radius);
+	queryDuration->setValueDouble (duration);
+	numCandidates->setValueInteger (candidates);
+	numSats->setValueInteger (matches.size ());
+	searchDuration->setValueDouble (getNow () - start);
+
+	sendValueAll (queryTime);
+	sendValueAll (queryRaDec);
+	sendValueAll (queryRadius);
+	sendValueAll (queryDuration);
+	sendValueAll (numCandidates);
+	sendValueAll (numSats);
+	sendValueAll (searchDuration);
+	sendValueAll (satsNorad);
+	sendValueAll (satsDesig);
+	sendValueAll (satsName);
+	sendValueAll (satsTime);
+	sendValueAll (satsRa);
+	sendValueAll (satsDec);
+	sendValueAll (satsSeparation);
+	sendValueAll (satsRange);
+	sendValueAll (satsMotion);
+	sendValueAll (satsPA);
+	return 0;
+}
+
+int main (int argc, char **argv)
+{
+	TLECatd device (argc, argv);
+	return device.run ();
+}
@@ -0,0 +1,136 @@
+/*
+ * UCAC5 catalogue server.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "catd.h"
+#include "ucac5/UCAC5Catalogue.hpp"
+
+#include <sstream>
+
+using namespace rts2catd;
+
+/**
+ * Serves UCAC5 catalogue. Catalogue files stay mapped between searches.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class UCAC5:public Catd
+{
+	public:
+		UCAC5 (int argc, char **argv);
+		virtual ~UCAC5 (void);
+
+	protected:
+		virtual int processOption (int opt);
+		virtual int initHardware ();
+
+		virtual int searchCone (struct ln_equ_posn *c, double radius, double magLimit, int maxStars, std::vector <CatalogueStar> &stars);
+		virtual int searchBox (struct ln_equ_posn *c1, struct ln_equ_posn *c2, double magLimit, int maxStars, std::vector <CatalogueStar> &stars);
+
+	private:
+		const char *base;
+		UCAC5Catalogue catalogue;
+
+		void convertStars (std::vector <UCAC5Star> &found, std::vector <CatalogueStar> &stars);
+};
+
+UCAC5::UCAC5 (int argc, char **argv):Catd (argc, argv)
+{
+	base = NULL;
+
+	addOption ('b', NULL, 1, "UCAC5 base path (directory with u5index.unf, zone files and their xyz indices)");
+}
+
+UCAC5::~UCAC5 ()
+{
+}
+
+int UCAC5::processOption (int opt)
+{
+	switch (opt)
+	{
+		case 'b':
+			base = optarg;
+			break;
+		default:
+			return Catd::processOption (opt);
+	}
+	return 0;
+}
+
+int UCAC5::initHardware ()
+{
+	if (base == NULL)
+	{
+		logStream (MESSAGE_ERROR) << "UCAC5 base path must be specified with -b option" << sendLog;
+		return -1;
+	}
+	if (catalogue.open (base))
+	{
+		logStream (MESSAGE_ERROR) << "cannot open UCAC5 band index " << base << "/u5index.unf" << sendLog;
+		return -1;
+	}
+	return 0;
+}
+
+int UCAC5::searchCone (struct ln_equ_posn *c, double radius, double magLimit, int maxStars, std::vector <CatalogueStar> &stars)
+{
+	std::vector <UCAC5Star> found;
+	if (catalogue.cone (ln_deg_to_rad (c->ra), ln_deg_to_rad (c->dec), 0, ln_deg_to_rad (radius), magLimit, maxStars < 0 ? 0 : maxStars, found))
+	{
+		logStream (MESSAGE_ERROR) << "cannot open UCAC5 zone files in " << base << sendLog;
+		return -1;
+	}
+	convertStars (found, stars);
+	return 0;
+}
+
+int UCAC5::searchBox (struct ln_equ_posn *c1, struct ln_equ_posn *c2, double magLimit, int maxStars, std::vector <CatalogueStar> &stars)
+{
+	std::vector <UCAC5Star> found;
+	if (catalogue.box (ln_deg_to_rad (c1->ra), ln_deg_to_rad (c1->dec), ln_deg_to_rad (c2->ra), ln_deg_to_rad (c2->dec), magLimit, maxStars < 0 ? 0 : maxStars, found))
+	{
+		logStream (MESSAGE_ERROR) << "cannot open UCAC5 zone files in " << base << sendLog;
+		return -1;
+	}
+	convertStars (found, stars);
+	return 0;
+}
+
+void UCAC5::convertStars (std::vector <UCAC5Star> &found, std::vector <CatalogueStar> &stars)
+{
+	stars.reserve (found.size ());
+	for (std::vector <UCAC5Star>::iterator iter = found.begin (); iter != found.end (); iter++)
+	{
+		CatalogueStar star;
+		std::ostringstream os;
+		os << iter->record->srcid;
+		star.id = os.str ();
+		star.ra = iter->record->ira / (1000.0 * 3600.0);
+		star.dec = iter->record->idc / (1000.0 * 3600.0);
+		star.mag = iter->getMag ();
+		star.distance = ln_rad_to_deg (iter->distance);
+		stars.push_back (star);
+	}
+}
+
+int main (int argc, char **argv)
+{
+	UCAC5 device (argc, argv);
+	return device.run ();
+}
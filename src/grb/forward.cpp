@@ -228,11 +228,7 @@ int Rts2ConnFwGrb::init_listen ()
 {
 	int ret;
 
-	if (gcn_listen_sock >= 0)
-	{
-		close (gcn_listen_sock);
-		gcn_listen_sock = -1;
-	}
+	closeFD (gcn_listen_sock);
 
 	connectionError (-1);
 
@@ -291,11 +287,7 @@ int Rts2ConnFwGrb::add (rts2core::Block *block)
 void Rts2ConnFwGrb::connectionError (int last_data_size)
 {
 	logStream (MESSAGE_DEBUG) << "Rts2ConnFwGrb::connectionError" << sendLog;
-	if (sock > 0)
-	{
-		close (sock);
-		sock = -1;
-	}
+	closeSocket ();
 	if (!isConnState (CONN_BROKEN))
 	{
 		time (&nextTime);
@@ -311,8 +303,7 @@ int Rts2ConnFwGrb::receive (rts2core::Block *block)
 	if (gcn_listen_sock >= 0 && block->isForRead (gcn_listen_sock))
 	{
 		// try to accept connection..
-		close (sock);			 // close previous connections..we support only one GCN connection
-		sock = -1;
+		closeSocket ();			 // close previous connections..we support only one GCN connection
 		struct sockaddr_in other_side;
 		socklen_t addr_size = sizeof (struct sockaddr_in);
 		sock =
@@ -326,8 +317,7 @@ int Rts2ConnFwGrb::receive (rts2core::Block *block)
 			connectionError (-1);
 		}
 		// close listening socket..when we get connection
-		close (gcn_listen_sock);
-		gcn_listen_sock = -1;
+		closeFD (gcn_listen_sock);
 		setConnState (CONN_CONNECTED);
 		logStream (MESSAGE_INFO)
 			<< "Rts2ConnFwGrb::receive accept gcn_listen_sock from "
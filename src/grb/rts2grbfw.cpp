@@ -58,8 +58,7 @@ int Rts2GrbForwardConnection::init ()
 	{
 		logStream (MESSAGE_ERROR) << "Rts2GrbForwardConnection::init cannot listen: " << strerror (errno)
 			<< sendLog;
-		close (sock);
-		sock = -1;
+		closeSocket ();
 		return -1;
 	}
 	return 0;
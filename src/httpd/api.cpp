@@ -190,6 +190,10 @@ void API::executeJSON (XmlRpc::XmlRpcSource *source, std::string path, XmlRpc::H
 
 			response_length += sizeof (imghdr);
 
+			// data of streamed image, which was not saved, are not available
+			if (image->getChannelData (chan) == NULL)
+				throw JSONException ("image data are not available");
+
 			response = new char[response_length];
 
 			if (newType != 0)
@@ -20,11 +20,13 @@
 
 #include "rts2db/constraints.h"
 #include "rts2script/connexe.h"
+#include "rts2script/scriptcache.h"
 #include "httpd.h"
 
 #ifdef RTS2_HAVE_PGSQL
 #include "rts2db/user.h"
 #include "rts2db/messagedb.h"
+#include "rts2db/targetcache.h"
 #else
 #endif /* RTS2_HAVE_PGSQL */
 
@@ -447,13 +449,25 @@ rts2image::imageProceRes XmlDevCameraClient::processImage (rts2image::Image * im
 		}
 	}
 	previmage = image;
+
+	// image is already saved, render preview before it is requested
+	HttpD *master = (HttpD *) getMaster ();
+	master->getPreviewCache ()->warm (image->getAbsoluteFileName (), 128, master->getDefaultImageLabel (), DEFAULT_QUANTILES, master->getDefaultChannel (), DEFAULT_COLOURVARIANT);
+
 	return rts2image::IMAGE_KEEP_COPY;
 }
 
 int HttpD::info ()
 {
 	bbQueueSize->setValueInteger (events.bbServers.queueSize ());
+	previewHits->setValueLong (previewCache.getHits ());
+	previewMisses->setValueLong (previewCache.getMisses ());
 #ifdef RTS2_HAVE_PGSQL
+	recordQueue->setValueInteger (recorder.queueSize ());
+	recordRecorded->setValueLong (recorder.getRecorded ());
+	recordSpilled->setValueLong (recorder.getSpilled ());
+	recordDropped->setValueLong (recorder.getDropped ());
+	recordFlush->setValueDouble (recorder.getLastFlush ());
 	return DeviceDb::info ();
 #else
 	return rts2core::Device::info ();
@@ -463,6 +477,7 @@ int HttpD::info ()
 int HttpD::idle ()
 {
 	rts2json::HTTPServer::asyncIdle ();
+	previewCache.renderWarm ();
 #ifdef RTS2_HAVE_PGSQL
 	return DeviceDb::idle ();
 #else
@@ -541,6 +556,15 @@ int HttpD::init ()
 
 	addConnection (notifyConn);
 
+#ifdef RTS2_HAVE_PGSQL
+	// keep targets in memory, invalidate them on database notifications
+	rts2db::ConnTargetNotify *targetNotify = new rts2db::ConnTargetNotify (this);
+	if (targetNotify->init ())
+		delete targetNotify;
+	else
+		addConnection (targetNotify);
+#endif
+
 	if (printDebug ())
 		XmlRpc::setVerbosity (5);
 
@@ -618,9 +642,42 @@ int HttpD::init ()
 	// auth_localhost
 	auth_localhost = Configuration::instance ()->getBoolean ("xmlrpcd", "auth_localhost", auth_localhost);
 
+#ifdef RTS2_HAVE_PGSQL
+	if (!emptyConnectString ())
+	{
+		int queueSize, batchSize;
+		double flushInterval;
+		std::string spillFile;
+
+		Configuration::instance ()->getInteger ("xmlrpcd", "record_queue", queueSize, 100000);
+		Configuration::instance ()->getInteger ("xmlrpcd", "record_batch", batchSize, 1000);
+		Configuration::instance ()->getDouble ("xmlrpcd", "record_interval", flushInterval, 1);
+		Configuration::instance ()->getString ("xmlrpcd", "record_spill", spillFile, "/var/tmp/rts2-httpd-records.spill");
+
+		recorder.setParameters (queueSize, batchSize, flushInterval, spillFile.c_str ());
+		if (recorder.start (this, "recorder"))
+			return -1;
+	}
+#endif
+
 #ifdef RTS2_HAVE_LIBJPEG
 	Magick::InitializeMagick (".");
 #endif /* RTS2_HAVE_LIBJPEG */
+
+	int previewMemory, previewDisk, previewThreads;
+	std::string previewDir;
+
+	long ncpu = sysconf (_SC_NPROCESSORS_ONLN);
+
+	Configuration::instance ()->getInteger ("xmlrpcd", "preview_memory", previewMemory, 64);
+	Configuration::instance ()->getString ("xmlrpcd", "preview_dir", previewDir, "");
+	Configuration::instance ()->getInteger ("xmlrpcd", "preview_disk", previewDisk, 1024);
+	Configuration::instance ()->getInteger ("xmlrpcd", "preview_threads", previewThreads, ncpu > 4 ? 4 : (ncpu < 1 ? 1 : ncpu));
+
+	previewCache.setParameters ((size_t) previewMemory * 1024 * 1024, previewDir.c_str (), (size_t) previewDisk * 1024 * 1024, previewThreads);
+	if (previewCache.start ())
+		return -1;
+
 	return ret;
 }
 
@@ -781,6 +838,7 @@ HttpD::HttpD (int argc, char **argv): rts2core::Device (argc, argv, DEVICE_TYPE_
 #ifdef RTS2_HAVE_PGSQL
 	rts2db::MasterConstraints::setNotifyConnection (notifyConn);
 #endif
+	rts2script::ScriptCache::setNotifyConnection (notifyConn);
 
 	createValue (numRequests, "num_requests", "total pages served", false);
 	createValue (numberAsyncAPIs, "async_APIs", "number of active async APIs", false);
@@ -800,6 +858,17 @@ HttpD::HttpD (int argc, char **argv): rts2core::Device (argc, argv, DEVICE_TYPE_
 	createValue (messageBufferSize, "message_buffer_size", "number of last messages to kept in memory", false, RTS2_VALUE_WRITABLE);
 	messageBufferSize->setValueInteger (100);
 
+	createValue (previewHits, "preview_hits", "number of image previews served from cache", false);
+	createValue (previewMisses, "preview_misses", "number of image previews rendered on request", false);
+
+#ifdef RTS2_HAVE_PGSQL
+	createValue (recordQueue, "record_queue", "number of value records waiting for database write", false);
+	createValue (recordRecorded, "record_written", "number of value records written to database", false);
+	createValue (recordSpilled, "record_spilled", "number of value records written to spill file", false);
+	createValue (recordDropped, "record_dropped", "number of value records lost or skipped as duplicates", false);
+	createValue (recordFlush, "record_flush", "duration of the last value records database write", false);
+#endif
+
 	debugTestscript = false;
 
 	bbQueueName = NULL;
@@ -834,6 +903,10 @@ HttpD::~HttpD ()
 		delete (*iter).second;
 	}
 	sessions.clear ();
+	previewCache.stop ();
+#ifdef RTS2_HAVE_PGSQL
+	recorder.stop ();
+#endif
 #ifdef RTS2_HAVE_LIBJPEG
 	MagickLib::DestroyMagick ();
 #endif /* RTS2_HAVE_LIBJPEG */
@@ -1020,6 +1093,7 @@ void HttpD::fileModified (struct inotify_event *event)
 #ifdef RTS2_HAVE_PGSQL
 	rts2db::MasterConstraints::clearCache ();
 #endif
+	rts2script::ScriptCache::revalidate (event->wd);
 }
 
 std::string HttpD::addSession (std::string _username, time_t _timeout)
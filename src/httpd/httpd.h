@@ -30,6 +30,7 @@
 #include "rts2db/plan.h"
 #include "rts2json/addtargetreq.h"
 #include "bbapi.h"
+#include "recorder.h"
 #else
 #include "configuration.h"
 #include "device.h"
@@ -453,6 +454,8 @@ class HttpD:public rts2core::Device, XmlRpc::XmlRpcServer, rts2json::HTTPServer
 
 		virtual int getDefaultChannel () { return defchan; }
 
+		virtual rts2json::PreviewCache *getPreviewCache () { return &previewCache; }
+
 		rts2core::ConnNotify * getNotifyConnection () { return notifyConn; }
 
 		void scriptProgress (double start, double end);
@@ -483,6 +486,11 @@ class HttpD:public rts2core::Device, XmlRpc::XmlRpcServer, rts2json::HTTPServer
 
 #ifdef RTS2_HAVE_PGSQL
 		void confirmSchedule (rts2db::Plan &plan);
+
+		/**
+		 * Returns recorder used to write value changes to database.
+		 */
+		ValueRecorder *getRecorder () { return &recorder; }
 #endif
 
 	protected:
@@ -528,6 +536,21 @@ class HttpD:public rts2core::Device, XmlRpc::XmlRpcServer, rts2json::HTTPServer
 
 		rts2core::ValueInteger *messageBufferSize;
 
+		rts2json::PreviewCache previewCache;
+
+		rts2core::ValueLong *previewHits;
+		rts2core::ValueLong *previewMisses;
+
+#ifdef RTS2_HAVE_PGSQL
+		ValueRecorder recorder;
+
+		rts2core::ValueInteger *recordQueue;
+		rts2core::ValueLong *recordRecorded;
+		rts2core::ValueLong *recordSpilled;
+		rts2core::ValueLong *recordDropped;
+		rts2core::ValueDouble *recordFlush;
+#endif
+
 #ifndef RTS2_HAVE_PGSQL
 		const char *config_file;
 #endif
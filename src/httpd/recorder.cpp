@@ -0,0 +1,434 @@
+/*
+ * Batched recording of value changes to database.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "recorder.h"
+#include "logstream.h"
+#include "utilsfunc.h"
+
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// minimal time (in seconds) between attempts to write to database after failure
+#define RECORDER_RETRY     10
+
+using namespace rts2xmlrpc;
+
+void *recorderThread (void *arg)
+{
+	((ValueRecorder *) arg)->run ();
+	return NULL;
+}
+
+ValueRecorder::ValueRecorder ()
+{
+	maxQueue = 100000;
+	batchSize = 1000;
+	flushInterval = 1;
+	spillFile = "/var/tmp/rts2-httpd-records.spill";
+
+	db = NULL;
+
+	pthread_mutex_init (&mutex, NULL);
+	pthread_cond_init (&cond, NULL);
+	running = false;
+
+	spillF = NULL;
+	spillPending = false;
+	replayF = NULL;
+
+	recorded = 0;
+	spilled = 0;
+	dropped = 0;
+	lastFlush = NAN;
+
+	connected = false;
+	dbOk = false;
+	retryTime = 0;
+}
+
+ValueRecorder::~ValueRecorder ()
+{
+	stop ();
+
+	pthread_mutex_destroy (&mutex);
+	pthread_cond_destroy (&cond);
+}
+
+void ValueRecorder::setParameters (size_t _maxQueue, size_t _batchSize, double _flushInterval, const char *_spillFile)
+{
+	maxQueue = _maxQueue;
+	batchSize = _batchSize > 0 ? _batchSize : 1;
+	flushInterval = _flushInterval;
+	spillFile = _spillFile;
+}
+
+int ValueRecorder::start (rts2db::DeviceDb *_db, const char *conn_name)
+{
+	db = _db;
+	connName = conn_name;
+
+	// replay spill file left from previous run
+	struct stat st;
+	if (stat (spillFile.c_str (), &st) == 0 || stat ((spillFile + ".replay").c_str (), &st) == 0)
+		spillPending = true;
+
+	running = true;
+	int ret = pthread_create (&thread, NULL, recorderThread, (void *) this);
+	if (ret)
+	{
+		running = false;
+		logStream (MESSAGE_ERROR) << "cannot start value recorder thread: " << strerror (ret) << sendLog;
+		return -1;
+	}
+	return 0;
+}
+
+void ValueRecorder::stop ()
+{
+	pthread_mutex_lock (&mutex);
+	if (running == false)
+	{
+		pthread_mutex_unlock (&mutex);
+		return;
+	}
+	running = false;
+	pthread_cond_signal (&cond);
+	pthread_mutex_unlock (&mutex);
+
+	pthread_join (thread, NULL);
+
+	if (spillF)
+	{
+		fclose (spillF);
+		spillF = NULL;
+	}
+	if (replayF)
+	{
+		fclose (replayF);
+		replayF = NULL;
+	}
+}
+
+int ValueRecorder::getChannel (const char *deviceName, const char *valueName, int recvalType)
+{
+	pthread_mutex_lock (&mutex);
+	for (size_t i = 0; i < channels.size (); i++)
+	{
+		if (channels[i].deviceName == deviceName && channels[i].valueName == valueName && channels[i].recvalType == recvalType)
+		{
+			pthread_mutex_unlock (&mutex);
+			return i;
+		}
+	}
+	RecordChannel chan;
+	chan.deviceName = deviceName;
+	chan.valueName = valueName;
+	chan.recvalType = recvalType;
+	channels.push_back (chan);
+	int ret = channels.size () - 1;
+	pthread_mutex_unlock (&mutex);
+	return ret;
+}
+
+void ValueRecorder::push (int channel, double value, double rectime)
+{
+	RecordSample s;
+	s.channel = channel;
+	s.rectime = rectime;
+	s.value = value;
+
+	pthread_mutex_lock (&mutex);
+	if (running == false)
+	{
+		pthread_mutex_unlock (&mutex);
+		return;
+	}
+	if (samples.size () >= maxQueue)
+	{
+		// database is too slow, do not grow memory - background thread writes overflow to spill file
+		if (overflow.size () >= maxQueue)
+			dropped++;
+		else
+			overflow.push_back (s);
+		pthread_cond_signal (&cond);
+	}
+	else
+	{
+		samples.push_back (s);
+		if (samples.size () >= batchSize)
+			pthread_cond_signal (&cond);
+	}
+	pthread_mutex_unlock (&mutex);
+}
+
+size_t ValueRecorder::queueSize ()
+{
+	pthread_mutex_lock (&mutex);
+	size_t ret = samples.size ();
+	pthread_mutex_unlock (&mutex);
+	return ret;
+}
+
+long ValueRecorder::getRecorded ()
+{
+	pthread_mutex_lock (&mutex);
+	long ret = recorded;
+	pthread_mutex_unlock (&mutex);
+	return ret;
+}
+
+long ValueRecorder::getSpilled ()
+{
+	pthread_mutex_lock (&mutex);
+	long ret = spilled;
+	pthread_mutex_unlock (&mutex);
+	return ret;
+}
+
+long ValueRecorder::getDropped ()
+{
+	pthread_mutex_lock (&mutex);
+	long ret = dropped;
+	pthread_mutex_unlock (&mutex);
+	return ret;
+}
+
+double ValueRecorder::getLastFlush ()
+{
+	pthread_mutex_lock (&mutex);
+	double ret = lastFlush;
+	pthread_mutex_unlock (&mutex);
+	return ret;
+}
+
+void ValueRecorder::run ()
+{
+	dbOk = (connect () == 0);
+	if (!dbOk)
+		retryTime = getNow () + RECORDER_RETRY;
+
+	// replay file is processed without waiting for flush interval
+	bool replayMore = false;
+
+	pthread_mutex_lock (&mutex);
+	while (true)
+	{
+		if (running && samples.size () < batchSize && !replayMore)
+		{
+			struct timespec ts;
+			double tw = getNow () + flushInterval;
+			ts.tv_sec = (time_t) floor (tw);
+			ts.tv_nsec = (long) ((tw - ts.tv_sec) * 1e9);
+			while (running && samples.size () < batchSize && overflow.empty ())
+			{
+				if (pthread_cond_timedwait (&cond, &mutex, &ts) == ETIMEDOUT)
+					break;
+			}
+		}
+
+		size_t n = samples.size () < batchSize ? samples.size () : batchSize;
+		std::vector <RecordSample> batch (samples.begin (), samples.begin () + n);
+		samples.erase (samples.begin (), samples.begin () + n);
+
+		std::vector <RecordSample> overflowBatch;
+		overflowBatch.swap (overflow);
+
+		// copy channels added since last flush
+		if (threadChannels.size () < channels.size ())
+			threadChannels.insert (threadChannels.end (), channels.begin () + threadChannels.size (), channels.end ());
+
+		bool idle = samples.size () < batchSize;
+		bool finished = (running == false) && samples.empty ();
+		pthread_mutex_unlock (&mutex);
+
+		if (!overflowBatch.empty ())
+			spill (&overflowBatch[0], overflowBatch.size (), threadChannels);
+
+		if (!batch.empty ())
+			flush (batch);
+
+		replayMore = false;
+		if (idle && spillPending && !finished)
+			replayMore = replaySpill ();
+
+		if (spillF)
+			fflush (spillF);
+
+		pthread_mutex_lock (&mutex);
+		if (finished)
+			break;
+	}
+	pthread_mutex_unlock (&mutex);
+}
+
+void ValueRecorder::addCount (long &counter, long n)
+{
+	pthread_mutex_lock (&mutex);
+	counter += n;
+	pthread_mutex_unlock (&mutex);
+}
+
+void ValueRecorder::spill (const RecordSample *s, size_t n, const std::vector <RecordChannel> &chans)
+{
+	if (spillF == NULL)
+	{
+		spillF = fopen (spillFile.c_str (), "a");
+		if (spillF == NULL)
+		{
+			addCount (dropped, n);
+			logStream (MESSAGE_ERROR) << "cannot open spill file " << spillFile << ", dropping " << n << " records: " << strerror (errno) << sendLog;
+			return;
+		}
+	}
+	for (size_t i = 0; i < n; i++)
+	{
+		const RecordChannel &chan = chans[s[i].channel];
+		fprintf (spillF, "%s %s %d %.6f %.17g\n", chan.deviceName.c_str (), chan.valueName.c_str (), chan.recvalType, s[i].rectime, s[i].value);
+	}
+	addCount (spilled, n);
+	spillPending = true;
+}
+
+void ValueRecorder::flush (std::vector <RecordSample> &batch)
+{
+	if (!dbOk)
+	{
+		if (getNow () < retryTime)
+		{
+			spill (&batch[0], batch.size (), threadChannels);
+			return;
+		}
+		dbOk = (connect () == 0);
+	}
+
+	double t = getNow ();
+	if (dbOk && writeSamples (batch, threadChannels) == 0)
+	{
+		double duration = getNow () - t;
+		pthread_mutex_lock (&mutex);
+		recorded += batch.size ();
+		lastFlush = duration;
+		pthread_mutex_unlock (&mutex);
+		return;
+	}
+
+	logStream (MESSAGE_WARNING) << "cannot record " << batch.size () << " values to database, writing them to " << spillFile << sendLog;
+	dbOk = false;
+	retryTime = getNow () + RECORDER_RETRY;
+	spill (&batch[0], batch.size (), threadChannels);
+}
+
+bool ValueRecorder::replaySpill ()
+{
+	if (!dbOk)
+		return false;
+
+	if (replayF == NULL)
+	{
+		std::string replayFile = spillFile + ".replay";
+		struct stat st;
+
+		// replay file exists if replay was interrupted by restart
+		if (stat (replayFile.c_str (), &st))
+		{
+			if (spillF)
+			{
+				fclose (spillF);
+				spillF = NULL;
+			}
+			if (rename (spillFile.c_str (), replayFile.c_str ()))
+			{
+				spillPending = false;
+				if (errno != ENOENT)
+					logStream (MESSAGE_ERROR) << "cannot rename spill file " << spillFile << ": " << strerror (errno) << sendLog;
+				return false;
+			}
+		}
+
+		replayF = fopen (replayFile.c_str (), "r");
+		if (replayF == NULL)
+		{
+			logStream (MESSAGE_ERROR) << "cannot open spill file " << replayFile << ": " << strerror (errno) << sendLog;
+			spillPending = false;
+			return false;
+		}
+		replayChannels.clear ();
+		logStream (MESSAGE_INFO) << "replaying records from " << replayFile << sendLog;
+	}
+
+	// replay single batch, so the live samples are not delayed
+	std::vector <RecordSample> batch;
+	char dev[101];
+	char val[101];
+	RecordChannel chan;
+	RecordSample s;
+
+	while (batch.size () < batchSize && fscanf (replayF, "%100s %100s %d %lf %lf", dev, val, &(chan.recvalType), &(s.rectime), &(s.value)) == 5)
+	{
+		chan.deviceName = dev;
+		chan.valueName = val;
+		s.channel = -1;
+		for (size_t i = 0; i < replayChannels.size (); i++)
+		{
+			if (replayChannels[i].deviceName == chan.deviceName && replayChannels[i].valueName == chan.valueName && replayChannels[i].recvalType == chan.recvalType)
+			{
+				s.channel = i;
+				break;
+			}
+		}
+		if (s.channel < 0)
+		{
+			replayChannels.push_back (chan);
+			s.channel = replayChannels.size () - 1;
+		}
+		batch.push_back (s);
+	}
+
+	if (!batch.empty ())
+	{
+		if (writeSamples (batch, replayChannels) == 0)
+		{
+			addCount (recorded, batch.size ());
+		}
+		else
+		{
+			// put batch back, rest of the replay file is processed after database recovers
+			dbOk = false;
+			retryTime = getNow () + RECORDER_RETRY;
+			spill (&batch[0], batch.size (), replayChannels);
+			return false;
+		}
+	}
+
+	if (batch.size () < batchSize)
+	{
+		// end of replay file
+		fclose (replayF);
+		replayF = NULL;
+		unlink ((spillFile + ".replay").c_str ());
+
+		struct stat st;
+		spillPending = (stat (spillFile.c_str (), &st) == 0);
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,236 @@
+/*
+ * Batched recording of value changes to database.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2__RECORDER__
+#define __RTS2__RECORDER__
+
+#include "rts2db/devicedb.h"
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <stdio.h>
+#include <pthread.h>
+
+namespace rts2xmlrpc
+{
+
+/**
+ * Single recorded sample. Integer and boolean values are stored as double.
+ */
+struct RecordSample
+{
+	int channel;
+	double rectime;
+	double value;
+};
+
+/**
+ * Recorded channel - device name, value name (including RA/DEC/ALT/AZ
+ * suffix) and recval type.
+ */
+struct RecordChannel
+{
+	std::string deviceName;
+	std::string valueName;
+	int recvalType;
+};
+
+/**
+ * Records value changes to database from background thread.
+ *
+ * Samples are pushed to in-memory queue from the main (event) loop, so
+ * recording never waits for the database. Background thread holds its own
+ * database connection, and every flush interval (or when batch size is
+ * reached) writes queued samples with multi-row INSERTs in a single
+ * transaction.
+ *
+ * Queue size is bounded. When the queue is full, or when the database
+ * cannot be written, samples are appended to spill file. Spill file is
+ * written only from the background thread - samples which do not fit to
+ * the queue are passed to the thread in overflow buffer of the same size,
+ * and are dropped when that is full as well. Spill file is replayed once
+ * the database accepts writes again. Spill file stores names, not channel
+ * numbers, so it can be replayed after restart.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class ValueRecorder
+{
+	public:
+		ValueRecorder ();
+		~ValueRecorder ();
+
+		/**
+		 * Set recorder parameters. Must be called before start.
+		 *
+		 * @param _maxQueue       maximal number of samples kept in memory
+		 * @param _batchSize      maximal number of samples written in one transaction
+		 * @param _flushInterval  interval (in seconds) between flushes
+		 * @param _spillFile      path to spill file
+		 */
+		void setParameters (size_t _maxQueue, size_t _batchSize, double _flushInterval, const char *_spillFile);
+
+		/**
+		 * Start background thread. The thread opens new database connection.
+		 *
+		 * @param _db        device, used to create database connection
+		 * @param conn_name  database connection name
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int start (rts2db::DeviceDb *_db, const char *conn_name);
+
+		/**
+		 * Stop background thread, writing queued samples to database or spill file.
+		 */
+		void stop ();
+
+		/**
+		 * Returns channel number for given value. Channels are created on first request.
+		 */
+		int getChannel (const char *deviceName, const char *valueName, int recvalType);
+
+		/**
+		 * Queue sample for recording. Never blocks on database or spill file.
+		 */
+		void push (int channel, double value, double rectime);
+
+		size_t queueSize ();
+
+		/**
+		 * Number of samples written to database.
+		 */
+		long getRecorded ();
+
+		/**
+		 * Number of samples written to spill file.
+		 */
+		long getSpilled ();
+
+		/**
+		 * Number of samples dropped - neither database nor spill file was
+		 * writable, overflow buffer was full, or sample was a duplicate.
+		 */
+		long getDropped ();
+
+		/**
+		 * Duration (in seconds) of the last database flush.
+		 */
+		double getLastFlush ();
+
+		// thread routine
+		void run ();
+
+	private:
+		size_t maxQueue;
+		size_t batchSize;
+		double flushInterval;
+		std::string spillFile;
+
+		rts2db::DeviceDb *db;
+		std::string connName;
+
+		std::vector <RecordChannel> channels;
+		std::deque <RecordSample> samples;
+		// samples which did not fit to the queue, to be written to spill file
+		std::vector <RecordSample> overflow;
+
+		pthread_t thread;
+		pthread_mutex_t mutex;
+		pthread_cond_t cond;
+		bool running;
+
+		FILE *spillF;
+		bool spillPending;
+
+		// statistics, protected by mutex
+		long recorded;
+		long spilled;
+		long dropped;
+		double lastFlush;
+
+		// accessed only from background thread
+		std::vector <RecordChannel> threadChannels;
+		std::map <std::string, int> recvalIds;
+		bool connected;
+		bool dbOk;
+		double retryTime;
+
+		FILE *replayF;
+		std::vector <RecordChannel> replayChannels;
+
+		/**
+		 * Add to statistics counter.
+		 */
+		void addCount (long &counter, long n);
+
+		/**
+		 * Append samples to spill file. Called only from background thread.
+		 */
+		void spill (const RecordSample *s, size_t n, const std::vector <RecordChannel> &chans);
+
+		/**
+		 * Write batch to database. If it cannot be written, spill it.
+		 */
+		void flush (std::vector <RecordSample> &batch);
+
+		/**
+		 * Replay single batch from spill file to database.
+		 *
+		 * @return true if there are more records to replay
+		 */
+		bool replaySpill ();
+
+		/**
+		 * (Re)connect to database.
+		 *
+		 * @return -1 on error, 0 on success
+		 */
+		int connect ();
+
+		/**
+		 * Write samples to database in single transaction.
+		 *
+		 * @return -1 on database error, 0 on success
+		 */
+		int writeSamples (std::vector <RecordSample> &batch, std::vector <RecordChannel> &chans);
+
+		/**
+		 * Find or create recval_id for channel.
+		 *
+		 * @throw rts2db::SqlError
+		 */
+		int getRecvalId (const RecordChannel &chan);
+
+		/**
+		 * Insert rows to records_ table as single multi-row INSERT. If
+		 * the INSERT violates unique (recval_id, rectime) constraint, rows
+		 * are inserted one by one and duplicates are skipped.
+		 *
+		 * @throw rts2db::SqlError
+		 */
+		void insertRows (const char *table, int baseType, std::vector <std::pair <int, RecordSample> > &rows);
+};
+
+}
+
+#endif /* !__RTS2__RECORDER__ */
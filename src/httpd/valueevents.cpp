@@ -56,14 +56,64 @@ void ValueChange::postEvent (Event *event)
 	Object::postEvent (event);
 }
 
-#ifndef RTS2_HAVE_PGSQL
+#ifdef RTS2_HAVE_PGSQL
+
+int ValueChangeRecord::getChannel (const char *suffix, int recval_type)
+{
+	std::map <const char *, int>::iterator iter = channelIds.find (suffix);
+
+	if (iter != channelIds.end ())
+		return iter->second;
+
+	std::string vn (valueName.c_str ());
+	if (suffix != NULL)
+		vn += suffix;
+
+	int ch = master->getRecorder ()->getChannel (deviceName.c_str (), vn.c_str (), recval_type);
+	channelIds[suffix] = ch;
+	return ch;
+}
+
+void ValueChangeRecord::run (rts2core::Value *val, double validTime)
+{
+	ValueRecorder *recorder = master->getRecorder ();
+
+	std::ostringstream _os;
+
+	switch (val->getValueBaseType ())
+	{
+		case RTS2_VALUE_INTEGER:
+			recorder->push (getChannel (NULL, RTS2_VALUE_INTEGER | val->getValueDisplayType ()), val->getValueInteger (), validTime);
+			break;
+		case RTS2_VALUE_DOUBLE:
+		case RTS2_VALUE_FLOAT:
+			recorder->push (getChannel (NULL, RTS2_VALUE_DOUBLE | val->getValueDisplayType ()), val->getValueDouble (), validTime);
+			break;
+		case RTS2_VALUE_RADEC:
+			recorder->push (getChannel ("RA", RTS2_VALUE_DOUBLE | RTS2_DT_RA), ((rts2core::ValueRaDec *) val)->getRa (), validTime);
+			recorder->push (getChannel ("DEC", RTS2_VALUE_DOUBLE | RTS2_DT_DEC), ((rts2core::ValueRaDec *) val)->getDec (), validTime);
+			break;
+		case RTS2_VALUE_ALTAZ:
+			recorder->push (getChannel ("ALT", RTS2_VALUE_DOUBLE | RTS2_DT_DEGREES), ((rts2core::ValueAltAz *) val)->getAlt (), validTime);
+			recorder->push (getChannel ("AZ", RTS2_VALUE_DOUBLE | RTS2_DT_DEGREES), ((rts2core::ValueAltAz *) val)->getAz (), validTime);
+			break;
+		case RTS2_VALUE_BOOL:
+			recorder->push (getChannel (NULL, RTS2_VALUE_BOOL), ((rts2core::ValueBool *) val)->getValueBool (), validTime);
+			break;
+		default:
+			_os << "Cannot record value " << valueName.c_str ();
+			throw rts2core::Error (_os.str ());
+	}
+}
+
+#else
 
 void ValueChangeRecord::run (rts2core::Value *val, double validTime)
 {
 	std::cout << Timestamp (validTime) << " value: " << deviceName.c_str () << " " << valueName.c_str () << val->getDisplayValue () << std::endl;
 }
 
-#endif /* ! RTS2_HAVE_PGSQL */
+#endif /* RTS2_HAVE_PGSQL */
 
 void ValueChangeCommand::run (rts2core::Value *val, double validTime)
 {
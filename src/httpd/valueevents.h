@@ -87,7 +87,8 @@ class ValueChange:public rts2core::Object
 
 /**
  * Record value change, either to database (rts2-xmlrpcd is compiled with database support) or
- * to standard output (if rts2-xmlrpcd is compiled without database support).
+ * to standard output (if rts2-xmlrpcd is compiled without database support). Database records
+ * are queued to ValueRecorder, which writes them from background thread.
  *
  * @author Petr Kubanek <petr@kubanek.net>
  */
@@ -99,11 +100,8 @@ class ValueChangeRecord: public ValueChange
 		virtual void run (rts2core::Value *val, double validTime);
 #ifdef RTS2_HAVE_PGSQL
 	private:
-		std::map <const char *, int> dbValueIds;
-		int getRecvalId (const char *suffix, int recval_type);
-		void recordValueInteger (int recval_id, int val, double validTime);
-		void recordValueDouble (int recval_id, double val, double validTime);
-		void recordValueBoolean (int recval_id, bool val, double validTime);
+		std::map <const char *, int> channelIds;
+		int getChannel (const char *suffix, int recval_type);
 #endif /* RTS2_HAVE_PGSQL */
 };
 
@@ -0,0 +1,938 @@
+/*
+ * Binary log files.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "binlog.h"
+#include "displayvalue.h"
+#include "app.h"
+#include "error.h"
+#include "logstream.h"
+#include "utilsfunc.h"
+#include "value.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// buffered data are written when buffer reaches this size
+#define BINLOG_BUFFER_SIZE      65536
+
+using namespace rts2logd;
+
+std::map <std::string, BinLogWriter *> BinLogWriter::writers;
+
+static size_t pad8 (size_t len)
+{
+	return (len + 7) & ~((size_t) 7);
+}
+
+BinLogColumn::BinLogColumn (const char *_name, int32_t _type)
+{
+	name = _name;
+	type = _type;
+	switch (type & RTS2_BASE_TYPE)
+	{
+		case RTS2_VALUE_RADEC:
+		case RTS2_VALUE_ALTAZ:
+			slots = 2;
+			break;
+		default:
+			slots = 1;
+	}
+	first = 0;
+}
+
+void BinLogDevice::addColumn (BinLogColumn col)
+{
+	col.first = nslots;
+	nslots += col.slots;
+	columns.push_back (col);
+}
+
+int BinLogDevice::findSlot (const char *_name)
+{
+	std::string n (_name);
+	std::string suffix;
+	size_t dot = n.rfind ('.');
+	for (std::vector <BinLogColumn>::iterator iter = columns.begin (); iter != columns.end (); iter++)
+	{
+		if (iter->name == n)
+			return iter->first;
+		if (dot != std::string::npos && iter->slots == 2 && iter->name == n.substr (0, dot))
+		{
+			suffix = n.substr (dot + 1);
+			if (suffix == "RA" || suffix == "ALT")
+				return iter->first;
+			if (suffix == "DEC" || suffix == "AZ")
+				return iter->first + 1;
+		}
+	}
+	return -1;
+}
+
+BinLogWriter *BinLogWriter::open (const char *filename)
+{
+	std::map <std::string, BinLogWriter *>::iterator iter = writers.find (filename);
+	if (iter != writers.end ())
+	{
+		iter->second->refCount++;
+		return iter->second;
+	}
+
+	BinLogWriter *w = new BinLogWriter (filename);
+	if (w->openFile ())
+	{
+		delete w;
+		return NULL;
+	}
+	writers[filename] = w;
+	return w;
+}
+
+void BinLogWriter::release ()
+{
+	refCount--;
+	if (refCount > 0)
+		return;
+	writers.erase (filename);
+	delete this;
+}
+
+BinLogWriter::BinLogWriter (const char *_filename)
+{
+	filename = _filename;
+	fd = -1;
+	refCount = 1;
+	fileEnd = 0;
+	lastIndex = 0;
+}
+
+BinLogWriter::~BinLogWriter ()
+{
+	if (fd >= 0)
+	{
+		writeIndex ();
+		flush ();
+		::close (fd);
+	}
+}
+
+int BinLogWriter::openFile ()
+{
+	fd = ::open (filename.c_str (), O_RDWR | O_CREAT, 0644);
+	if (fd < 0)
+	{
+		logStream (MESSAGE_ERROR) << "cannot open binary log " << filename << ": " << strerror (errno) << sendLog;
+		return -1;
+	}
+
+	struct stat st;
+	if (fstat (fd, &st))
+		return -1;
+
+	if (st.st_size == 0)
+	{
+		BinLogFileHeader header;
+		header.version = BINLOG_VERSION;
+		header.flags = 0;
+		header.created = getNow ();
+		append (BINLOG_CHUNK_FILE, &header, sizeof (header));
+		return flush ();
+	}
+
+	// append to existing file
+	BinLogReader reader;
+	try
+	{
+		reader.open (filename.c_str ());
+	}
+	catch (rts2core::Error &er)
+	{
+		logStream (MESSAGE_ERROR) << "cannot append to " << filename << ": " << er << sendLog;
+		return -1;
+	}
+
+	fileEnd = reader.getValidSize ();
+	if (fileEnd < (uint64_t) st.st_size)
+	{
+		logStream (MESSAGE_WARNING) << "truncating incomplete data at the end of " << filename << sendLog;
+		if (ftruncate (fd, fileEnd))
+			return -1;
+	}
+	if (lseek (fd, fileEnd, SEEK_SET) < 0)
+		return -1;
+
+	lastIndex = reader.getLastIndex ();
+	indexDevices = reader.getTailDevices ();
+	indexRecords = reader.getTailRecords ();
+
+	devices = reader.getDevices ();
+
+	return 0;
+}
+
+void BinLogWriter::append (uint32_t type, const void *payload, size_t len)
+{
+	BinLogChunk chunk;
+	chunk.type = type;
+	chunk.length = sizeof (BinLogChunk) + pad8 (len) + sizeof (BinLogChunk);
+
+	const char *p = (const char *) &chunk;
+	buffer.insert (buffer.end (), p, p + sizeof (BinLogChunk));
+	p = (const char *) payload;
+	buffer.insert (buffer.end (), p, p + len);
+	buffer.insert (buffer.end (), pad8 (len) - len, '\0');
+	p = (const char *) &chunk;
+	buffer.insert (buffer.end (), p, p + sizeof (BinLogChunk));
+
+	fileEnd += chunk.length;
+
+	if (buffer.size () > BINLOG_BUFFER_SIZE)
+		flush ();
+}
+
+int BinLogWriter::addDevice (const char *name, std::vector <BinLogColumn> &columns)
+{
+	BinLogDevice dev;
+	dev.name = name;
+	dev.id = devices.size ();
+	for (std::vector <BinLogColumn>::iterator iter = columns.begin (); iter != columns.end (); iter++)
+		dev.addColumn (*iter);
+
+	// reuse device registered by previous run
+	for (std::vector <BinLogDevice>::iterator iter = devices.begin (); iter != devices.end (); iter++)
+	{
+		if (iter->name != dev.name || iter->columns.size () != dev.columns.size ())
+			continue;
+		size_t i;
+		for (i = 0; i < dev.columns.size (); i++)
+		{
+			if (iter->columns[i].name != dev.columns[i].name || iter->columns[i].type != dev.columns[i].type)
+				break;
+		}
+		if (i == dev.columns.size ())
+			return iter->id;
+	}
+
+	std::vector <char> payload (2 * sizeof (uint16_t) + sizeof (uint32_t));
+
+	uint16_t id = dev.id;
+	uint16_t ncols = dev.columns.size ();
+	uint32_t nslots = dev.nslots;
+
+	memcpy (&payload[0], &id, sizeof (uint16_t));
+	memcpy (&payload[2], &ncols, sizeof (uint16_t));
+	memcpy (&payload[4], &nslots, sizeof (uint32_t));
+	payload.insert (payload.end (), name, name + strlen (name) + 1);
+	for (std::vector <BinLogColumn>::iterator iter = columns.begin (); iter != columns.end (); iter++)
+	{
+		const char *t = (const char *) &(iter->type);
+		payload.insert (payload.end (), t, t + sizeof (int32_t));
+		payload.insert (payload.end (), iter->name.c_str (), iter->name.c_str () + iter->name.length () + 1);
+	}
+
+	indexDevices.push_back (fileEnd);
+	append (BINLOG_CHUNK_DEVICE, &payload[0], payload.size ());
+
+	devices.push_back (dev);
+	return id;
+}
+
+void BinLogWriter::writeRecord (int device, double time, const double *values, uint16_t flags)
+{
+	int nslots = devices[device].nslots;
+	std::vector <char> payload (sizeof (BinLogRecordHeader) + nslots * sizeof (double));
+
+	BinLogRecordHeader *rec = (BinLogRecordHeader *) &payload[0];
+	rec->device = device;
+	rec->flags = flags;
+	rec->reserved = 0;
+	rec->time = time;
+	double *slots = (double *) &payload[sizeof (BinLogRecordHeader)];
+	for (int i = 0; i < nslots; i++)
+		slots[i] = values ? values[i] : NAN;
+
+	BinLogIndexEntry entry;
+	entry.time = time;
+	entry.device = device;
+	entry.reserved = 0;
+	entry.offset = fileEnd;
+	indexRecords.push_back (entry);
+
+	append (BINLOG_CHUNK_RECORD, &payload[0], payload.size ());
+
+	if (indexRecords.size () >= BINLOG_INDEX_EVERY)
+		writeIndex ();
+}
+
+void BinLogWriter::writeIndex ()
+{
+	if (indexRecords.empty () && indexDevices.empty ())
+		return;
+
+	BinLogIndexHeader header;
+	header.prevIndex = lastIndex;
+	header.ndevices = indexDevices.size ();
+	header.nrecords = indexRecords.size ();
+	header.tmin = NAN;
+	header.tmax = NAN;
+	for (std::vector <BinLogIndexEntry>::iterator iter = indexRecords.begin (); iter != indexRecords.end (); iter++)
+	{
+		if (isnan (header.tmin) || iter->time < header.tmin)
+			header.tmin = iter->time;
+		if (isnan (header.tmax) || iter->time > header.tmax)
+			header.tmax = iter->time;
+	}
+
+	std::vector <char> payload;
+	const char *p = (const char *) &header;
+	payload.insert (payload.end (), p, p + sizeof (header));
+	if (!indexDevices.empty ())
+	{
+		p = (const char *) &indexDevices[0];
+		payload.insert (payload.end (), p, p + indexDevices.size () * sizeof (uint64_t));
+	}
+	if (!indexRecords.empty ())
+	{
+		p = (const char *) &indexRecords[0];
+		payload.insert (payload.end (), p, p + indexRecords.size () * sizeof (BinLogIndexEntry));
+	}
+
+	lastIndex = fileEnd;
+	append (BINLOG_CHUNK_INDEX, &payload[0], payload.size ());
+
+	indexDevices.clear ();
+	indexRecords.clear ();
+}
+
+int BinLogWriter::flush ()
+{
+	size_t written = 0;
+	while (written < buffer.size ())
+	{
+		ssize_t ret = write (fd, &buffer[written], buffer.size () - written);
+		if (ret < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			logStream (MESSAGE_ERROR) << "cannot write to binary log " << filename << ": " << strerror (errno) << sendLog;
+			buffer.clear ();
+			return -1;
+		}
+		written += ret;
+	}
+	buffer.clear ();
+	return 0;
+}
+
+BinLogReader::BinLogReader ()
+{
+	fd = -1;
+	data = NULL;
+	size = 0;
+	validSize = 0;
+	lastIndex = 0;
+	tmin = NAN;
+	tmax = NAN;
+	nrecords = 0;
+}
+
+BinLogReader::~BinLogReader ()
+{
+	close ();
+}
+
+void BinLogReader::close ()
+{
+	if (data)
+		munmap ((void *) data, size);
+	if (fd >= 0)
+		::close (fd);
+	data = NULL;
+	fd = -1;
+	size = 0;
+	validSize = 0;
+	blocks.clear ();
+	devices.clear ();
+	lastIndex = 0;
+	tailRecords.clear ();
+	tailDevices.clear ();
+	scanned.clear ();
+	tmin = NAN;
+	tmax = NAN;
+	nrecords = 0;
+}
+
+void BinLogReader::open (const char *filename)
+{
+	close ();
+
+	fd = ::open (filename, O_RDONLY);
+	if (fd < 0)
+		throw rts2core::Error (std::string ("cannot open ") + filename + ": " + strerror (errno));
+
+	struct stat st;
+	if (fstat (fd, &st))
+		throw rts2core::Error (std::string ("cannot stat ") + filename + ": " + strerror (errno));
+
+	size = st.st_size;
+	if (size < sizeof (BinLogChunk) * 2 + sizeof (BinLogFileHeader))
+		throw rts2core::Error (std::string (filename) + " is not RTS2 binary log");
+
+	data = (const char *) mmap (NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+	if (data == MAP_FAILED)
+	{
+		data = NULL;
+		throw rts2core::Error (std::string ("cannot map ") + filename + ": " + strerror (errno));
+	}
+
+	if (!validChunk (0, 0) || chunkAt (0)->type != BINLOG_CHUNK_FILE)
+		throw rts2core::Error (std::string (filename) + " is not RTS2 binary log");
+
+	const BinLogFileHeader *header = (const BinLogFileHeader *) (data + sizeof (BinLogChunk));
+	if (header->version != BINLOG_VERSION)
+		throw rts2core::Error (std::string (filename) + " has unsupported binary log version");
+
+	uint64_t fileChunk = chunkAt (0)->length;
+
+	// walk from the end to the last index chunk
+	std::vector <uint64_t> tail;
+	uint64_t pos = size;
+	while (pos > fileChunk)
+	{
+		if (pos % 8)
+		{
+			scanForward ();
+			return;
+		}
+		const BinLogChunk *trailer = (const BinLogChunk *) (data + pos - sizeof (BinLogChunk));
+		if (trailer->length > pos - fileChunk || !validChunk (pos - trailer->length, pos))
+		{
+			// incomplete write at the end of file
+			scanForward ();
+			return;
+		}
+		pos -= trailer->length;
+		if (trailer->type == BINLOG_CHUNK_INDEX)
+		{
+			lastIndex = pos;
+			break;
+		}
+		tail.push_back (pos);
+	}
+	validSize = size;
+
+	// follow chain of index chunks
+	std::vector <uint64_t> indexes;
+	for (uint64_t idx = lastIndex; idx > 0; idx = ((const BinLogIndexHeader *) (data + idx + sizeof (BinLogChunk)))->prevIndex)
+	{
+		if (idx >= size || !validChunk (idx, 0) || chunkAt (idx)->type != BINLOG_CHUNK_INDEX)
+			throw rts2core::Error (std::string (filename) + " has corrupted index");
+		indexes.push_back (idx);
+	}
+
+	for (std::vector <uint64_t>::reverse_iterator iter = indexes.rbegin (); iter != indexes.rend (); iter++)
+	{
+		const BinLogIndexHeader *ih = (const BinLogIndexHeader *) (data + *iter + sizeof (BinLogChunk));
+		const uint64_t *devs = (const uint64_t *) (ih + 1);
+		for (uint32_t i = 0; i < ih->ndevices; i++)
+			readDevice (devs[i]);
+
+		IndexBlock block;
+		block.tmin = ih->tmin;
+		block.tmax = ih->tmax;
+		block.nrecords = ih->nrecords;
+		block.entries = (const BinLogIndexEntry *) (devs + ih->ndevices);
+		blocks.push_back (block);
+	}
+
+	for (std::vector <uint64_t>::reverse_iterator iter = tail.rbegin (); iter != tail.rend (); iter++)
+		addTail (*iter);
+
+	if (!tailRecords.empty ())
+	{
+		IndexBlock block;
+		block.tmin = NAN;
+		block.tmax = NAN;
+		for (std::vector <BinLogIndexEntry>::iterator iter = tailRecords.begin (); iter != tailRecords.end (); iter++)
+		{
+			if (isnan (block.tmin) || iter->time < block.tmin)
+				block.tmin = iter->time;
+			if (isnan (block.tmax) || iter->time > block.tmax)
+				block.tmax = iter->time;
+		}
+		block.nrecords = tailRecords.size ();
+		block.entries = &tailRecords[0];
+		blocks.push_back (block);
+	}
+
+	for (std::vector <IndexBlock>::iterator iter = blocks.begin (); iter != blocks.end (); iter++)
+	{
+		nrecords += iter->nrecords;
+		if (isnan (tmin) || iter->tmin < tmin)
+			tmin = iter->tmin;
+		if (isnan (tmax) || iter->tmax > tmax)
+			tmax = iter->tmax;
+	}
+}
+
+BinLogDevice *BinLogReader::getDevice (const char *name)
+{
+	// return the last device with the name, as device can be registered multiple times
+	for (std::vector <BinLogDevice>::reverse_iterator iter = devices.rbegin (); iter != devices.rend (); iter++)
+	{
+		if (iter->name == name)
+			return &(*iter);
+	}
+	return NULL;
+}
+
+void BinLogReader::query (int device, double from, double to, std::vector <const BinLogRecordHeader *> &records)
+{
+	// records without time are returned only for unlimited queries
+	bool all = isinf (from) && from < 0 && isinf (to) && to > 0;
+	for (std::vector <IndexBlock>::iterator iter = blocks.begin (); iter != blocks.end (); iter++)
+	{
+		if (!all && !(iter->tmax >= from && iter->tmin <= to))
+			continue;
+		for (uint32_t i = 0; i < iter->nrecords; i++)
+		{
+			const BinLogIndexEntry &e = iter->entries[i];
+			if (device >= 0 && e.device != (uint32_t) device)
+				continue;
+			if (all || (e.time >= from && e.time <= to))
+				records.push_back ((const BinLogRecordHeader *) (data + e.offset + sizeof (BinLogChunk)));
+		}
+	}
+}
+
+void BinLogReader::downsample (int device, int slot, double from, double to, double step, std::vector <BinLogBin> &bins)
+{
+	std::vector <const BinLogRecordHeader *> records;
+	query (device, from, to, records);
+
+	std::map <long, BinLogBin> acc;
+	for (std::vector <const BinLogRecordHeader *>::iterator iter = records.begin (); iter != records.end (); iter++)
+	{
+		if ((*iter)->flags & BINLOG_INFO_FAILED)
+			continue;
+		double v = getValues (*iter)[slot];
+		if (isnan (v))
+			continue;
+		long b = (long) floor (((*iter)->time - from) / step);
+		std::map <long, BinLogBin>::iterator bi = acc.find (b);
+		if (bi == acc.end ())
+		{
+			BinLogBin bin;
+			bin.time = from + b * step;
+			bin.mean = v;
+			bin.min = v;
+			bin.max = v;
+			bin.count = 1;
+			acc[b] = bin;
+		}
+		else
+		{
+			bi->second.mean += v;
+			if (v < bi->second.min)
+				bi->second.min = v;
+			if (v > bi->second.max)
+				bi->second.max = v;
+			bi->second.count++;
+		}
+	}
+
+	for (std::map <long, BinLogBin>::iterator iter = acc.begin (); iter != acc.end (); iter++)
+	{
+		iter->second.mean /= iter->second.count;
+		bins.push_back (iter->second);
+	}
+}
+
+void BinLogReader::toText (std::ostream &os, double from, double to)
+{
+	std::vector <const BinLogRecordHeader *> records;
+	query (-1, from, to, records);
+
+	// values used to format output as DevClientLogger does
+	std::vector <std::vector <rts2core::Value *> > values (devices.size ());
+	for (size_t d = 0; d < devices.size (); d++)
+	{
+		for (std::vector <BinLogColumn>::iterator iter = devices[d].columns.begin (); iter != devices[d].columns.end (); iter++)
+			values[d].push_back (newValue (iter->type, iter->name, ""));
+	}
+
+	char buf[50];
+
+	for (std::vector <const BinLogRecordHeader *>::iterator iter = records.begin (); iter != records.end (); iter++)
+	{
+		if ((*iter)->flags & BINLOG_INFO_FAILED)
+		{
+			os << "info failed\n";
+			continue;
+		}
+		BinLogDevice &dev = devices[(*iter)->device];
+		const double *slots = getValues (*iter);
+		os << dev.name;
+		for (size_t c = 0; c < dev.columns.size (); c++)
+		{
+			rts2core::Value *val = values[(*iter)->device][c];
+			const double *s = slots + dev.columns[c].first;
+			os << " ";
+			if (val == NULL || isnan (s[0]))
+			{
+				// keep number of tokens of composite values
+				os << (dev.columns[c].slots == 2 ? "nan nan" : "nan");
+				continue;
+			}
+			switch (dev.columns[c].type & RTS2_BASE_TYPE)
+			{
+				case RTS2_VALUE_RADEC:
+					((rts2core::ValueRaDec *) val)->setValueRaDec (s[0], s[1]);
+					break;
+				case RTS2_VALUE_ALTAZ:
+					((rts2core::ValueAltAz *) val)->setValueAltAz (s[0], s[1]);
+					break;
+				case RTS2_VALUE_BOOL:
+					val->setValueCharArr (s[0] ? "true" : "false");
+					break;
+				case RTS2_VALUE_INTEGER:
+				case RTS2_VALUE_SELECTION:
+				case RTS2_VALUE_LONGINT:
+					snprintf (buf, 50, "%.0f", s[0]);
+					val->setValueCharArr (buf);
+					break;
+				default:
+					snprintf (buf, 50, "%.17g", s[0]);
+					val->setValueCharArr (buf);
+			}
+			os << rts2core::getDisplayValue (val);
+		}
+		os << "\n";
+	}
+
+	for (size_t d = 0; d < values.size (); d++)
+	{
+		for (std::vector <rts2core::Value *>::iterator iter = values[d].begin (); iter != values[d].end (); iter++)
+			delete *iter;
+	}
+}
+
+const BinLogChunk *BinLogReader::chunkAt (uint64_t offset)
+{
+	return (const BinLogChunk *) (data + offset);
+}
+
+bool BinLogReader::validChunk (uint64_t offset, uint64_t end)
+{
+	if (offset % 8 || offset + 2 * sizeof (BinLogChunk) > size)
+		return false;
+	const BinLogChunk *c = chunkAt (offset);
+	if (c->length < 2 * sizeof (BinLogChunk) || c->length % 8 || offset + c->length > size)
+		return false;
+	if (end > 0 && offset + c->length != end)
+		return false;
+	const BinLogChunk *trailer = chunkAt (offset + c->length - sizeof (BinLogChunk));
+	if (trailer->type != c->type || trailer->length != c->length)
+		return false;
+	switch (c->type)
+	{
+		case BINLOG_CHUNK_FILE:
+		case BINLOG_CHUNK_DEVICE:
+		case BINLOG_CHUNK_RECORD:
+		case BINLOG_CHUNK_INDEX:
+			return true;
+	}
+	return false;
+}
+
+void BinLogReader::readDevice (uint64_t offset)
+{
+	const BinLogChunk *c = chunkAt (offset);
+	const char *p = data + offset + sizeof (BinLogChunk);
+	const char *end = data + offset + c->length - sizeof (BinLogChunk);
+
+	uint16_t id;
+	uint16_t ncols;
+	memcpy (&id, p, sizeof (uint16_t));
+	memcpy (&ncols, p + 2, sizeof (uint16_t));
+	p += 2 * sizeof (uint16_t) + sizeof (uint32_t);
+
+	BinLogDevice dev;
+	dev.id = id;
+	dev.name = std::string (p, strnlen (p, end - p));
+	p += dev.name.length () + 1;
+
+	for (uint16_t i = 0; i < ncols && p + sizeof (int32_t) < end; i++)
+	{
+		int32_t type;
+		memcpy (&type, p, sizeof (int32_t));
+		p += sizeof (int32_t);
+		std::string name (p, strnlen (p, end - p));
+		p += name.length () + 1;
+		dev.addColumn (BinLogColumn (name.c_str (), type));
+	}
+
+	if (devices.size () <= id)
+		devices.resize (id + 1);
+	devices[id] = dev;
+}
+
+void BinLogReader::addTail (uint64_t offset)
+{
+	const BinLogChunk *c = chunkAt (offset);
+	switch (c->type)
+	{
+		case BINLOG_CHUNK_DEVICE:
+			readDevice (offset);
+			tailDevices.push_back (offset);
+			break;
+		case BINLOG_CHUNK_RECORD:
+			{
+				const BinLogRecordHeader *rec = (const BinLogRecordHeader *) (data + offset + sizeof (BinLogChunk));
+				BinLogIndexEntry e;
+				e.time = rec->time;
+				e.device = rec->device;
+				e.reserved = 0;
+				e.offset = offset;
+				tailRecords.push_back (e);
+			}
+			break;
+	}
+}
+
+void BinLogReader::scanForward ()
+{
+	uint64_t pos = chunkAt (0)->length;
+	std::vector <BinLogIndexEntry> entries;
+	lastIndex = 0;
+
+	while (validChunk (pos, 0))
+	{
+		const BinLogChunk *c = chunkAt (pos);
+		if (c->type == BINLOG_CHUNK_INDEX)
+		{
+			lastIndex = pos;
+			tailDevices.clear ();
+			entries.insert (entries.end (), tailRecords.begin (), tailRecords.end ());
+			tailRecords.clear ();
+		}
+		else
+		{
+			addTail (pos);
+		}
+		pos += c->length;
+	}
+	validSize = pos;
+
+	// all records are served from single block
+	scanned.swap (entries);
+	scanned.insert (scanned.end (), tailRecords.begin (), tailRecords.end ());
+
+	if (!scanned.empty ())
+	{
+		IndexBlock block;
+		block.tmin = NAN;
+		block.tmax = NAN;
+		for (std::vector <BinLogIndexEntry>::iterator iter = scanned.begin (); iter != scanned.end (); iter++)
+		{
+			if (isnan (block.tmin) || iter->time < block.tmin)
+				block.tmin = iter->time;
+			if (isnan (block.tmax) || iter->time > block.tmax)
+				block.tmax = iter->time;
+		}
+		block.nrecords = scanned.size ();
+		block.entries = &scanned[0];
+		blocks.push_back (block);
+		nrecords = scanned.size ();
+		tmin = block.tmin;
+		tmax = block.tmax;
+	}
+}
+
+/**
+ * Split text log line to value tokens. Time values are printed with
+ * time zone, which is dropped.
+ */
+static void splitLine (const std::string &line, std::vector <std::string> &tokens)
+{
+	std::istringstream is (line);
+	std::string t;
+	while (is >> t)
+	{
+		if (!tokens.empty () && (t == "UT" || t == *tzname) && (tokens.back ().find ('T') != std::string::npos || tokens.back () == "----" || tokens.back () == "infinite"))
+			continue;
+		tokens.push_back (t);
+	}
+}
+
+/**
+ * Guess value type from its text representation.
+ */
+static int32_t guessType (const std::string &token)
+{
+	if (token.length () > 10 && token[4] == '-' && token[7] == '-' && token[10] == 'T')
+		return RTS2_VALUE_TIME;
+	bool b;
+	if (charToBool (token.c_str (), b) == 0)
+		return RTS2_VALUE_BOOL;
+	return RTS2_VALUE_DOUBLE;
+}
+
+static double parseToken (const std::string &token, int32_t type)
+{
+	switch (type & RTS2_BASE_TYPE)
+	{
+		case RTS2_VALUE_TIME:
+			{
+				double JD;
+				if (parseDate (token.c_str (), JD, true))
+					return NAN;
+				return (JD - 2440587.5) * 86400.0;
+			}
+		case RTS2_VALUE_BOOL:
+			{
+				bool b;
+				if (charToBool (token.c_str (), b))
+					return NAN;
+				return b ? 1 : 0;
+			}
+	}
+	char *endp;
+	double v = strtod (token.c_str (), &endp);
+	if (endp == token.c_str ())
+		return NAN;
+	return v;
+}
+
+/**
+ * Returns type of RA/DEC or ALT/AZ value, marked in configuration by
+ * :radec or :altaz suffix, 0 for other values. Value name without
+ * the suffix is returned in valueName.
+ */
+static int32_t compositeType (const std::string &name, std::string &valueName)
+{
+	size_t colon = name.rfind (':');
+	if (colon != std::string::npos)
+	{
+		std::string suffix = name.substr (colon + 1);
+		valueName = name.substr (0, colon);
+		if (suffix == "radec")
+			return RTS2_VALUE_RADEC;
+		if (suffix == "altaz")
+			return RTS2_VALUE_ALTAZ;
+	}
+	valueName = name;
+	return 0;
+}
+
+int rts2logd::textToBinary (std::istream &is, std::map <std::string, std::vector <std::string> > &config, BinLogWriter *writer)
+{
+	std::map <std::string, std::pair <int, std::vector <int32_t> > > devs;
+	std::string line;
+	int lastDevice = -1;
+	int converted = 0;
+	int lineNum = 0;
+
+	while (std::getline (is, line))
+	{
+		lineNum++;
+		std::vector <std::string> tokens;
+		splitLine (line, tokens);
+		if (tokens.empty ())
+			continue;
+
+		if (line == "info failed")
+		{
+			if (lastDevice >= 0)
+			{
+				writer->writeRecord (lastDevice, NAN, NULL, BINLOG_INFO_FAILED);
+				converted++;
+			}
+			continue;
+		}
+
+		std::map <std::string, std::vector <std::string> >::iterator ci = config.find (tokens[0]);
+		if (ci == config.end ())
+		{
+			logStream (MESSAGE_WARNING) << "line " << lineNum << ": device " << tokens[0] << " is not in configuration" << sendLog;
+			continue;
+		}
+		// RA/DEC and ALT/AZ values are printed as two tokens
+		size_t expected = 0;
+		std::string name;
+		for (std::vector <std::string>::iterator iter = ci->second.begin (); iter != ci->second.end (); iter++)
+			expected += compositeType (*iter, name) ? 2 : 1;
+		if (tokens.size () != expected + 1)
+		{
+			logStream (MESSAGE_WARNING) << "line " << lineNum << ": expected " << expected << " values, found " << (tokens.size () - 1) << sendLog;
+			continue;
+		}
+
+		std::map <std::string, std::pair <int, std::vector <int32_t> > >::iterator di = devs.find (tokens[0]);
+		if (di == devs.end ())
+		{
+			std::vector <BinLogColumn> columns;
+			std::vector <int32_t> types;
+			size_t t = 1;
+			for (size_t i = 0; i < ci->second.size (); i++)
+			{
+				int32_t type = compositeType (ci->second[i], name);
+				if (type == 0)
+					type = guessType (tokens[t]);
+				columns.push_back (BinLogColumn (name.c_str (), type));
+				types.push_back (type);
+				t += columns.back ().slots;
+			}
+			int id = writer->addDevice (tokens[0].c_str (), columns);
+			di = devs.insert (std::pair <std::string, std::pair <int, std::vector <int32_t> > > (tokens[0], std::pair <int, std::vector <int32_t> > (id, types))).first;
+		}
+
+		std::vector <double> values;
+		double t = NAN;
+		size_t ti = 1;
+		for (size_t i = 0; i < di->second.second.size (); i++)
+		{
+			int32_t type = di->second.second[i];
+			values.push_back (parseToken (tokens[ti++], type));
+			switch (type & RTS2_BASE_TYPE)
+			{
+				case RTS2_VALUE_RADEC:
+				case RTS2_VALUE_ALTAZ:
+					values.push_back (parseToken (tokens[ti++], RTS2_VALUE_DOUBLE));
+					break;
+			}
+			// record time is taken from infotime value
+			if (ci->second[i] == "infotime")
+				t = values.back ();
+		}
+		lastDevice = di->second.first;
+		writer->writeRecord (lastDevice, t, values.empty () ? NULL : &values[0]);
+		converted++;
+	}
+	return converted;
+}
@@ -0,0 +1,346 @@
+/*
+ * Binary log files.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef __RTS2_BINLOG__
+#define __RTS2_BINLOG__
+
+#include <istream>
+#include <list>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+// chunk types
+#define BINLOG_CHUNK_FILE       0x4c325452    // RT2L
+#define BINLOG_CHUNK_DEVICE     0x56454444    // DDEV
+#define BINLOG_CHUNK_RECORD     0x43455252    // RREC
+#define BINLOG_CHUNK_INDEX      0x58444e49    // INDX
+
+#define BINLOG_VERSION          1
+
+// index block is written after that number of records
+#define BINLOG_INDEX_EVERY      256
+
+// record flags
+#define BINLOG_INFO_FAILED      0x0001
+
+namespace rts2logd
+{
+
+/**
+ * Binary log files consist of chunks. Every chunk starts with the
+ * header and ends with the trailer, which both hold chunk type and total
+ * chunk length. Trailers allow walking the file from its end. All chunks
+ * are 8 bytes aligned. Data are stored in the host byte order.
+ *
+ * The file starts with the file chunk. Device chunks describe names and
+ * types of the values logged for a device. Record chunks hold the record
+ * time and one double for every value slot of the device - records of the
+ * device have fixed width. Composite values (RA/DEC, ALT/AZ) occupy two
+ * slots, values which cannot be represented as number are stored as NaN.
+ *
+ * After every BINLOG_INDEX_EVERY records, an index chunk is written. It
+ * holds offset of the previous index chunk, offsets of device chunks and
+ * time and offset of every record written since the previous index.
+ * Readers locate all index chunks by walking from the file end, without
+ * touching records.
+ */
+struct BinLogChunk
+{
+	uint32_t type;
+	uint32_t length;
+};
+
+struct BinLogFileHeader
+{
+	uint32_t version;
+	uint32_t flags;
+	double created;
+};
+
+struct BinLogRecordHeader
+{
+	uint16_t device;
+	uint16_t flags;
+	uint32_t reserved;
+	double time;
+};
+
+struct BinLogIndexHeader
+{
+	uint64_t prevIndex;
+	uint32_t ndevices;
+	uint32_t nrecords;
+	double tmin;
+	double tmax;
+};
+
+struct BinLogIndexEntry
+{
+	double time;
+	uint32_t device;
+	uint32_t reserved;
+	uint64_t offset;
+};
+
+/**
+ * Logged value.
+ */
+struct BinLogColumn
+{
+	BinLogColumn () { type = 0; slots = 1; first = 0; }
+	BinLogColumn (const char *_name, int32_t _type);
+
+	std::string name;
+	// RTS2 value type, including display type
+	int32_t type;
+	// number of slots (doubles) used by the value
+	int slots;
+	// index of the first slot
+	int first;
+};
+
+/**
+ * Logged device.
+ */
+class BinLogDevice
+{
+	public:
+		BinLogDevice () { id = -1; nslots = 0; }
+
+		std::string name;
+		int id;
+		std::vector <BinLogColumn> columns;
+		int nslots;
+
+		/**
+		 * Add column. Its first slot is set from number of existing slots.
+		 */
+		void addColumn (BinLogColumn col);
+
+		/**
+		 * Find slot for given name. Composite values can be specified with
+		 * .RA, .DEC, .ALT or .AZ suffix; without suffix, the first slot is returned.
+		 *
+		 * @return slot index, -1 if value is not logged
+		 */
+		int findSlot (const char *_name);
+};
+
+/**
+ * Writer of binary log. Writers are shared between all loggers writing to
+ * the same file. Records are buffered and written in blocks.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class BinLogWriter
+{
+	public:
+		/**
+		 * Open writer for given file. If the file exists, new records are
+		 * appended to it.
+		 *
+		 * @return writer, NULL on error
+		 */
+		static BinLogWriter *open (const char *filename);
+
+		/**
+		 * Release writer. When the last user releases the writer, index is
+		 * written and the file is closed.
+		 */
+		void release ();
+
+		/**
+		 * Register device with given columns. If device with the same
+		 * name and columns was already registered in the file, its id is
+		 * returned.
+		 *
+		 * @return device id
+		 */
+		int addDevice (const char *name, std::vector <BinLogColumn> &columns);
+
+		/**
+		 * Write record. Values array must contain one value for each device slot, NULL values are stored as NaNs.
+		 */
+		void writeRecord (int device, double time, const double *values, uint16_t flags = 0);
+
+		/**
+		 * Write buffered data to file.
+		 */
+		int flush ();
+
+		const char *getFilename () { return filename.c_str (); }
+
+	private:
+		BinLogWriter (const char *_filename);
+		~BinLogWriter ();
+
+		int openFile ();
+		void append (uint32_t type, const void *payload, size_t len);
+		void writeIndex ();
+
+		std::string filename;
+		int fd;
+		int refCount;
+
+		std::vector <char> buffer;
+		// offset of the buffer end
+		uint64_t fileEnd;
+
+		uint64_t lastIndex;
+		std::vector <uint64_t> indexDevices;
+		std::vector <BinLogIndexEntry> indexRecords;
+
+		std::vector <BinLogDevice> devices;
+
+		static std::map <std::string, BinLogWriter *> writers;
+};
+
+/**
+ * Downsampled data.
+ */
+struct BinLogBin
+{
+	double time;
+	double mean;
+	double min;
+	double max;
+	int count;
+};
+
+/**
+ * Memory mapped reader of binary log files.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class BinLogReader
+{
+	public:
+		BinLogReader ();
+		~BinLogReader ();
+
+		/**
+		 * Open and map file, read index.
+		 *
+		 * @throw rts2core::Error when file cannot be opened or is not a binary log
+		 */
+		void open (const char *filename);
+
+		void close ();
+
+		std::vector <BinLogDevice> &getDevices () { return devices; }
+
+		/**
+		 * Find device by name.
+		 *
+		 * @return device, NULL if device is not in the log
+		 */
+		BinLogDevice *getDevice (const char *name);
+
+		double getStart () { return tmin; }
+		double getEnd () { return tmax; }
+		size_t getRecordCount () { return nrecords; }
+
+		/**
+		 * Size of the file up to the last valid chunk.
+		 */
+		uint64_t getValidSize () { return validSize; }
+
+		uint64_t getLastIndex () { return lastIndex; }
+
+		/**
+		 * Index entries of records written after the last index chunk.
+		 */
+		std::vector <BinLogIndexEntry> &getTailRecords () { return tailRecords; }
+
+		/**
+		 * Offsets of device chunks written after the last index chunk.
+		 */
+		std::vector <uint64_t> &getTailDevices () { return tailDevices; }
+
+		/**
+		 * Find records of the device in given time range. Records are
+		 * returned in file order. Negative device selects all devices.
+		 */
+		void query (int device, double from, double to, std::vector <const BinLogRecordHeader *> &records);
+
+		static const double *getValues (const BinLogRecordHeader *rec) { return (const double *) (rec + 1); }
+
+		/**
+		 * Downsample slot values to bins of given duration. Bins without data are not returned.
+		 */
+		void downsample (int device, int slot, double from, double to, double step, std::vector <BinLogBin> &bins);
+
+		/**
+		 * Write records in the text format of rts2-logger.
+		 */
+		void toText (std::ostream &os, double from, double to);
+
+	private:
+		int fd;
+		const char *data;
+		uint64_t size;
+		uint64_t validSize;
+
+		struct IndexBlock
+		{
+			double tmin;
+			double tmax;
+			uint32_t nrecords;
+			const BinLogIndexEntry *entries;
+		};
+
+		std::vector <IndexBlock> blocks;
+		std::vector <BinLogDevice> devices;
+
+		uint64_t lastIndex;
+		std::vector <BinLogIndexEntry> tailRecords;
+		std::vector <uint64_t> tailDevices;
+
+		// records found by scanning file with damaged end
+		std::vector <BinLogIndexEntry> scanned;
+
+		double tmin;
+		double tmax;
+		size_t nrecords;
+
+		const BinLogChunk *chunkAt (uint64_t offset);
+		bool validChunk (uint64_t offset, uint64_t end);
+		void readDevice (uint64_t offset);
+		void addTail (uint64_t offset);
+		void scanForward ();
+};
+
+/**
+ * Convert text log to binary log.
+ *
+ * @param is       text log input
+ * @param config   logged devices and their value names, as in rts2-logger configuration. RA/DEC and ALT/AZ values, printed as two tokens, must be marked with :radec or :altaz suffix
+ * @param writer   binary log writer
+ *
+ * @return number of converted records
+ */
+int textToBinary (std::istream &is, std::map <std::string, std::vector <std::string> > &config, BinLogWriter *writer);
+
+}
+
+#endif // !__RTS2_BINLOG__
@@ -0,0 +1,351 @@
+/*
+ * Query and convert binary log files.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "binlog.h"
+#include "cliapp.h"
+#include "error.h"
+#include "timestamp.h"
+#include "utilsfunc.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#define OPT_FROM           OPT_LOCAL + 860
+#define OPT_TO             OPT_LOCAL + 861
+#define OPT_STEP           OPT_LOCAL + 862
+#define OPT_TO_TEXT        OPT_LOCAL + 863
+#define OPT_FROM_TEXT      OPT_LOCAL + 864
+
+namespace rts2logd
+{
+
+/**
+ * Query, downsample and convert binary log files.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class LogBin:public rts2core::CliApp
+{
+	public:
+		LogBin (int in_argc, char **in_argv);
+
+	protected:
+		virtual void usage ();
+
+		virtual int processOption (int in_opt);
+		virtual int processArgs (const char *arg);
+
+		virtual int doProcessing ();
+
+	private:
+		const char *device;
+		std::vector <std::string> values;
+		double from;
+		double to;
+		double step;
+
+		enum {INFO, QUERY, TO_TEXT, FROM_TEXT} mode;
+
+		const char *configFile;
+		const char *outputFile;
+
+		std::vector <std::string> files;
+
+		int parseTime (const char *arg, double &t);
+
+		int printInfo (BinLogReader &reader);
+		int printQuery (BinLogReader &reader);
+		int fromText ();
+};
+
+}
+
+using namespace rts2logd;
+
+LogBin::LogBin (int in_argc, char **in_argv):rts2core::CliApp (in_argc, in_argv)
+{
+	device = NULL;
+	from = -INFINITY;
+	to = INFINITY;
+	step = NAN;
+
+	mode = INFO;
+
+	configFile = NULL;
+	outputFile = NULL;
+
+	addOption ('d', NULL, 1, "device which values will be printed");
+	addOption ('v', NULL, 1, "value which will be printed; can be specified multiple times");
+	addOption (OPT_FROM, "from", 1, "print records recorded after this date");
+	addOption (OPT_TO, "to", 1, "print records recorded before this date");
+	addOption (OPT_STEP, "step", 1, "downsample value to bins of given length (in seconds)");
+	addOption (OPT_TO_TEXT, "to-text", 0, "convert binary log to text log");
+	addOption (OPT_FROM_TEXT, "from-text", 0, "convert text logs (arguments) to binary log");
+	addOption ('c', NULL, 1, "logger configuration file, used for conversion from text log");
+	addOption ('o', NULL, 1, "output binary log file, used for conversion from text log");
+}
+
+void LogBin::usage ()
+{
+	std::cout << "To list devices and values recorded in binary log:" << std::endl
+		<< "\t" << getAppName () << " telescope.bin" << std::endl
+		<< "To print telescope position for a night:" << std::endl
+		<< "\t" << getAppName () << " -d T0 -v TEL.RA -v TEL.DEC --from 2026-06-01T20:00:00 --to 2026-06-02T05:00:00 telescope.bin" << std::endl
+		<< "To print 5 minutes averages, minimas and maximas of temperature:" << std::endl
+		<< "\t" << getAppName () << " -d W0 -v temperature --step 300 weather.bin" << std::endl
+		<< "To convert binary log to text log:" << std::endl
+		<< "\t" << getAppName () << " --to-text telescope.bin > telescope.log" << std::endl
+		<< "To convert text log to binary log:" << std::endl
+		<< "\t" << getAppName () << " --from-text -c logger.cfg -o telescope.bin telescope.log" << std::endl;
+}
+
+int LogBin::processOption (int in_opt)
+{
+	switch (in_opt)
+	{
+		case 'd':
+			device = optarg;
+			mode = QUERY;
+			break;
+		case 'v':
+			values.push_back (optarg);
+			break;
+		case OPT_FROM:
+			return parseTime (optarg, from);
+		case OPT_TO:
+			return parseTime (optarg, to);
+		case OPT_STEP:
+			step = atof (optarg);
+			if (step <= 0)
+			{
+				std::cerr << "invalid step " << optarg << std::endl;
+				return -1;
+			}
+			break;
+		case OPT_TO_TEXT:
+			mode = TO_TEXT;
+			break;
+		case OPT_FROM_TEXT:
+			mode = FROM_TEXT;
+			break;
+		case 'c':
+			configFile = optarg;
+			break;
+		case 'o':
+			outputFile = optarg;
+			break;
+		default:
+			return rts2core::CliApp::processOption (in_opt);
+	}
+	return 0;
+}
+
+int LogBin::processArgs (const char *arg)
+{
+	files.push_back (arg);
+	return 0;
+}
+
+int LogBin::parseTime (const char *arg, double &t)
+{
+	double JD;
+	if (parseDate (arg, JD, true))
+	{
+		std::cerr << "invalid date " << arg << std::endl;
+		return -1;
+	}
+	t = (JD - 2440587.5) * 86400.0;
+	return 0;
+}
+
+int LogBin::printInfo (BinLogReader &reader)
+{
+	std::cout << "records " << reader.getRecordCount () << std::endl
+		<< "start " << Timestamp (reader.getStart ()) << std::endl
+		<< "end " << Timestamp (reader.getEnd ()) << std::endl;
+	for (std::vector <BinLogDevice>::iterator iter = reader.getDevices ().begin (); iter != reader.getDevices ().end (); iter++)
+	{
+		std::cout << "device " << iter->name;
+		for (std::vector <BinLogColumn>::iterator ci = iter->columns.begin (); ci != iter->columns.end (); ci++)
+			std::cout << " " << ci->name;
+		std::cout << std::endl;
+	}
+	return 0;
+}
+
+int LogBin::printQuery (BinLogReader &reader)
+{
+	BinLogDevice *dev = reader.getDevice (device);
+	if (dev == NULL)
+	{
+		std::cerr << "device " << device << " is not logged" << std::endl;
+		return -1;
+	}
+
+	std::vector <int> slots;
+	if (values.empty ())
+	{
+		for (int i = 0; i < dev->nslots; i++)
+			slots.push_back (i);
+	}
+	for (std::vector <std::string>::iterator iter = values.begin (); iter != values.end (); iter++)
+	{
+		int s = dev->findSlot (iter->c_str ());
+		if (s < 0)
+		{
+			std::cerr << "value " << *iter << " of device " << device << " is not logged" << std::endl;
+			return -1;
+		}
+		slots.push_back (s);
+	}
+
+	std::cout << std::setprecision (10);
+
+	if (!isnan (step))
+	{
+		if (slots.size () != 1)
+		{
+			std::cerr << "downsampling requires single value" << std::endl;
+			return -1;
+		}
+		std::vector <BinLogBin> bins;
+		reader.downsample (dev->id, slots[0], isinf (from) ? reader.getStart () : from, to, step, bins);
+		for (std::vector <BinLogBin>::iterator iter = bins.begin (); iter != bins.end (); iter++)
+			std::cout << Timestamp (iter->time) << " " << iter->mean << " " << iter->min << " " << iter->max << " " << iter->count << std::endl;
+		return 0;
+	}
+
+	std::vector <const BinLogRecordHeader *> records;
+	reader.query (dev->id, from, to, records);
+	for (std::vector <const BinLogRecordHeader *>::iterator iter = records.begin (); iter != records.end (); iter++)
+	{
+		if ((*iter)->flags & BINLOG_INFO_FAILED)
+			continue;
+		const double *v = BinLogReader::getValues (*iter);
+		std::cout << Timestamp ((*iter)->time);
+		for (std::vector <int>::iterator si = slots.begin (); si != slots.end (); si++)
+			std::cout << " " << v[*si];
+		std::cout << '\n';
+	}
+	return 0;
+}
+
+int LogBin::fromText ()
+{
+	if (configFile == NULL || outputFile == NULL)
+	{
+		std::cerr << "conversion from text log requires configuration file (-c) and output file (-o)" << std::endl;
+		return -1;
+	}
+
+	// configuration has the same format as rts2-logger configuration - device name, timeout and value names
+	std::map <std::string, std::vector <std::string> > config;
+	std::ifstream cis (configFile);
+	if (cis.fail ())
+	{
+		std::cerr << "cannot open " << configFile << std::endl;
+		return -1;
+	}
+	std::string line;
+	while (std::getline (cis, line))
+	{
+		std::istringstream ls (line);
+		std::string devName;
+		double timeout;
+		std::string v;
+		if (!(ls >> devName >> timeout))
+			continue;
+		while (ls >> v)
+			config[devName].push_back (v);
+	}
+
+	BinLogWriter *writer = BinLogWriter::open (outputFile);
+	if (writer == NULL)
+		return -1;
+
+	int ret = 0;
+	for (std::vector <std::string>::iterator iter = files.begin (); iter != files.end (); iter++)
+	{
+		std::ifstream is (iter->c_str ());
+		if (is.fail ())
+		{
+			std::cerr << "cannot open " << *iter << std::endl;
+			ret = -1;
+			break;
+		}
+		std::cout << *iter << ": " << textToBinary (is, config, writer) << " records" << std::endl;
+	}
+	writer->release ();
+	return ret;
+}
+
+int LogBin::doProcessing ()
+{
+	if (files.empty ())
+	{
+		std::cerr << "missing input files" << std::endl;
+		help ();
+		return -1;
+	}
+
+	if (mode == FROM_TEXT)
+		return fromText ();
+
+	for (std::vector <std::string>::iterator iter = files.begin (); iter != files.end (); iter++)
+	{
+		BinLogReader reader;
+		try
+		{
+			reader.open (iter->c_str ());
+		}
+		catch (rts2core::Error &er)
+		{
+			std::cerr << er << std::endl;
+			return -1;
+		}
+
+		int ret = 0;
+		switch (mode)
+		{
+			case INFO:
+				std::cout << *iter << std::endl;
+				ret = printInfo (reader);
+				break;
+			case QUERY:
+				ret = printQuery (reader);
+				break;
+			case TO_TEXT:
+				reader.toText (std::cout, from, to);
+				break;
+			case FROM_TEXT:
+				break;
+		}
+		if (ret)
+			return ret;
+	}
+	return 0;
+}
+
+int main (int argc, char **argv)
+{
+	LogBin app (argc, argv);
+	return app.run ();
+}
@@ -35,6 +35,7 @@ class Logger:public rts2core::Client, public LoggerBase
 		virtual int willConnect (rts2core::NetworkAddress * in_addr);
 	private:
 		std::istream * inputStream;
+		const char *outputFile;
 };
 
 }
@@ -45,8 +46,11 @@ Logger::Logger (int in_argc, char **in_argv):rts2core::Client (in_argc, in_argv,
 {
 	setTimeout (USEC_SEC);
 	inputStream = NULL;
+	outputFile = NULL;
 
 	addOption ('c', NULL, 1, "specify config file with logged device, timeouts and values");
+	addOption ('o', NULL, 1, "output log file expression (default to standard output)");
+	addOption ('b', NULL, 0, "write binary log; requires output file");
 }
 
 int Logger::processOption (int in_opt)
@@ -59,6 +63,12 @@ int Logger::processOption (int in_opt)
 			ret = readDevices (*inputStream);
 			delete inputStream;
 			return ret;
+		case 'o':
+			outputFile = optarg;
+			break;
+		case 'b':
+			binaryOutput = true;
+			break;
 		default:
 			return rts2core::Client::processOption (in_opt);
 	}
@@ -71,6 +81,11 @@ int Logger::init ()
 	ret = rts2core::Client::init ();
 	if (ret)
 		return ret;
+	if (binaryOutput && outputFile == NULL)
+	{
+		logStream (MESSAGE_ERROR) << "binary log cannot be written to standard output, please specify output file with -o" << sendLog;
+		return -1;
+	}
 	if (!inputStream)
 		ret = readDevices (std::cin);
 	return ret;
@@ -85,7 +100,11 @@ rts2core::DevClient * Logger::createOtherType (rts2core::Connection * conn, int
 {
 	rts2core::DevClient *cli = LoggerBase::createOtherType (conn, other_device_type);
 	if (cli)
+	{
+		if (outputFile)
+			cli->postEvent (new rts2core::Event (EVENT_SET_LOGFILE, (void *) outputFile));
 		return cli;
+	}
 	return rts2core::Client::createOtherType (conn, other_device_type);
 }
 
@@ -21,16 +21,21 @@
 
 using namespace rts2logd;
 
-DevClientLogger::DevClientLogger (rts2core::Connection * in_conn, double in_numberSec, time_t in_fileCreationInterval, std::list < std::string > &in_logNames):rts2core::DevClient (in_conn)
+DevClientLogger::DevClientLogger (rts2core::Connection * in_conn, double in_numberSec, time_t in_fileCreationInterval, std::list < std::string > &in_logNames, bool in_binary):rts2core::DevClient (in_conn)
 {
 	exp = NULL;
 
+	binary = in_binary;
+	binWriter = NULL;
+	binDevice = -1;
+
 	gettimeofday (&nextInfoCall, NULL);
 	numberSec.tv_sec = (int) (floor (in_numberSec));
 	numberSec.tv_usec = (int) (USEC_SEC * (in_numberSec - floor (in_numberSec)));
 
 	time(&nextFileCreationCheck);
 	fileCreationInterval = in_fileCreationInterval;
+	nextFlush = nextFileCreationCheck + LOGGER_FLUSH_INTERVAL;
 
 	logNames = in_logNames;
 
@@ -41,6 +46,10 @@ DevClientLogger::~DevClientLogger (void)
 {
 	if (outputStream != &std::cout)
 		delete outputStream;
+	else
+		outputStream->flush ();
+	if (binWriter)
+		binWriter->release ();
 	delete exp;
 }
 
@@ -83,6 +92,18 @@ void DevClientLogger::changeOutputStream ()
 	if (expanded == expandedFilename)
 		return;
 	expandedFilename = expanded;
+	if (binary)
+	{
+		BinLogWriter *nwriter = BinLogWriter::open (expandedFilename.c_str ());
+		if (nwriter == NULL)
+			return;
+		if (binWriter)
+			binWriter->release ();
+		binWriter = nwriter;
+		// device is registered in every file
+		binDevice = -1;
+		return;
+	}
 	std::ofstream * nstream = new std::ofstream (expandedFilename.c_str(), std::ios_base::app);
 	if (nstream->fail ())
 	{
@@ -101,18 +122,61 @@ void DevClientLogger::infoOK ()
 		fillLogValues ();
 	// check if we have to change log file..
 	changeOutputStream ();
+	if (binary)
+	{
+		writeBinary ();
+		return;
+	}
 	*outputStream << getName ();
 	for (std::list < rts2core::Value * >::iterator iter = logValues.begin (); iter != logValues.end (); iter++)
 	{
 		*outputStream << " " << rts2core::getDisplayValue (*iter);
 	}
-	*outputStream << std::endl;
+	// stream is flushed from idle
+	*outputStream << '\n';
 }
 
 void DevClientLogger::infoFailed ()
 {
  	changeOutputStream ();
-	*outputStream << "info failed" << std::endl;
+	if (binary)
+	{
+		if (binWriter && binDevice >= 0)
+			binWriter->writeRecord (binDevice, getNow (), NULL, BINLOG_INFO_FAILED);
+		return;
+	}
+	*outputStream << "info failed\n";
+}
+
+void DevClientLogger::writeBinary ()
+{
+	if (binWriter == NULL)
+		return;
+	if (binDevice < 0)
+	{
+		std::vector <BinLogColumn> columns;
+		for (std::list < rts2core::Value * >::iterator iter = logValues.begin (); iter != logValues.end (); iter++)
+			columns.push_back (BinLogColumn ((*iter)->getName ().c_str (), (*iter)->getValueType () | (*iter)->getValueDisplayType ()));
+		binDevice = binWriter->addDevice (getName (), columns);
+	}
+	binValues.clear ();
+	for (std::list < rts2core::Value * >::iterator iter = logValues.begin (); iter != logValues.end (); iter++)
+	{
+		switch ((*iter)->getValueBaseType ())
+		{
+			case RTS2_VALUE_RADEC:
+				binValues.push_back (((rts2core::ValueRaDec *) (*iter))->getRa ());
+				binValues.push_back (((rts2core::ValueRaDec *) (*iter))->getDec ());
+				break;
+			case RTS2_VALUE_ALTAZ:
+				binValues.push_back (((rts2core::ValueAltAz *) (*iter))->getAlt ());
+				binValues.push_back (((rts2core::ValueAltAz *) (*iter))->getAz ());
+				break;
+			default:
+				binValues.push_back ((*iter)->getValueDouble ());
+		}
+	}
+	binWriter->writeRecord (binDevice, getConnection ()->getInfoTime (), binValues.empty () ? NULL : &binValues[0]);
 }
 
 void DevClientLogger::idle ()
@@ -124,6 +188,14 @@ void DevClientLogger::idle ()
 		queCommand (new rts2core::CommandInfo (getMaster ()));
 		timeradd (&now, &numberSec, &nextInfoCall);
 	}
+	if (now.tv_sec >= nextFlush)
+	{
+		if (binWriter)
+			binWriter->flush ();
+		else
+			outputStream->flush ();
+		nextFlush = now.tv_sec + LOGGER_FLUSH_INTERVAL;
+	}
 }
 
 void DevClientLogger::postEvent (rts2core::Event * event)
@@ -139,6 +211,7 @@ void DevClientLogger::postEvent (rts2core::Event * event)
 
 LoggerBase::LoggerBase ()
 {
+	binaryOutput = false;
 }
 
 int LoggerBase::readDevices (std::istream & is)
@@ -206,6 +279,6 @@ rts2core::DevClient * LoggerBase::createOtherType (rts2core::Connection * conn,
 {
 	LogValName *val = getLogVal (conn->getName ());
 	if (val)
-		return new DevClientLogger (conn, val->timeout, 60, val->valueList);
+		return new DevClientLogger (conn, val->timeout, 60, val->valueList, binaryOutput);
 	return NULL;
 }
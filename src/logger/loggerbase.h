@@ -17,6 +17,7 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#include "binlog.h"
 #include "devclient.h"
 #include "displayvalue.h"
 #include "command.h"
@@ -25,6 +26,9 @@
 
 #define EVENT_SET_LOGFILE RTS2_LOCAL_EVENT+800
 
+// interval (in seconds) between flushes of the log file
+#define LOGGER_FLUSH_INTERVAL  5
+
 namespace rts2logd
 {
 
@@ -45,8 +49,9 @@ class DevClientLogger:public rts2core::DevClient
 		 * @param in_numberSec             Number of seconds when the info command will be send.
 		 * @param in_fileCreationInterval  Interval between file creation.
 		 * @param in_logNames              String with space separated names of values which will be logged.
+		 * @param in_binary                Write binary log instead of text log.
 		 */
-		DevClientLogger (rts2core::Connection * in_conn, double in_numberSec, time_t in_fileCreationInterval, std::list < std::string > &in_logNames);
+		DevClientLogger (rts2core::Connection * in_conn, double in_numberSec, time_t in_fileCreationInterval, std::list < std::string > &in_logNames, bool in_binary = false);
 
 		virtual ~ DevClientLogger (void);
 		virtual void infoOK ();
@@ -68,6 +73,14 @@ class DevClientLogger:public rts2core::DevClient
 
 		std::ostream * outputStream;
 
+		bool binary;
+		// binary log writer, NULL until output file is opened
+		BinLogWriter *binWriter;
+		int binDevice;
+		std::vector <double> binValues;
+
+		time_t nextFlush;
+
 		rts2core::Expander * exp;
 		std::string expandPattern;
 		std::string expandedFilename;
@@ -101,6 +114,11 @@ class DevClientLogger:public rts2core::DevClient
 		 * Change output stream according to new expansion.
 		 */
 		void changeOutputStream ();
+
+		/**
+		 * Write record to binary log.
+		 */
+		void writeBinary ();
 };
 
 /**
@@ -140,6 +158,11 @@ class LoggerBase
 
 		LogValName *getLogVal (const char *name);
 		int willConnect (rts2core::NetworkAddress * in_addr);
+
+		/**
+		 * Log to binary files.
+		 */
+		bool binaryOutput;
 	private:
 		std::list < LogValName > devicesNames;
 };
@@ -27,6 +27,7 @@
 #include "rts2script/executorque.h"
 #include "rts2script/execcli.h"
 #include "rts2script/execclidb.h"
+#include "rts2script/scriptcache.h"
 #include "rts2devcliphot.h"
 
 #define OPT_IGNORE_DAY    OPT_LOCAL + 100
@@ -169,6 +170,7 @@ Executor::Executor (int in_argc, char **in_argv):rts2db::DeviceDb (in_argc, in_a
 
 	notifyConn = new rts2core::ConnNotify (this);
 	rts2db::MasterConstraints::setNotifyConnection (notifyConn);
+	rts2script::ScriptCache::setNotifyConnection (notifyConn);
 
 	waitState = 0;
 
@@ -1211,6 +1213,7 @@ int Executor::commandAuthorized (rts2core::Connection * conn)
 #ifdef RTS2_HAVE_SYS_INOTIFY_H
 void Executor::fileModified (struct inotify_event *event)
 {
+	rts2script::ScriptCache::revalidate (event->wd);
 	currentTarget->revalidateConstraints (event->wd);
 	for (std::list <ExecutorQueue>::iterator iter = queues.begin (); iter != queues.end (); iter++)
 		iter->revalidateConstraints (event->wd);
@@ -20,6 +20,7 @@
 #include "status.h"
 #include "rts2script/connimgprocess.h"
 #include "rts2script/script.h"
+#include "pluto/satcatalogue.h"
 
 #include <glob.h>
 #include <sys/types.h>
@@ -27,6 +28,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <iostream>
+#include <sstream>
 #include <stdio.h>
 
 #ifdef RTS2_HAVE_PGSQL
@@ -84,6 +86,12 @@ class ImageProc:public rts2core::Device
 		int checkNotProcessed ();
 		void changeRunning (ConnProcess * newImage, int slot);
 
+		/**
+		 * Search satellites catalogue for satellites crossing image field,
+		 * record them in image header.
+		 */
+		void screenSatellites (rts2image::Image *image);
+
 		virtual int commandAuthorized (rts2core::Connection * conn);
 
 	protected:
@@ -134,6 +142,13 @@ class ImageProc:public rts2core::Device
 		rts2core::ValueInteger *nightDarks;
 		rts2core::ValueInteger *nightFlats;
 
+		rts2core::ValueInteger *satObjects;
+		rts2core::ValueDouble *satRadius;
+		rts2core::ValueInteger *satImages;
+		rts2core::ValueInteger *lastSats;
+
+		rts2sat::SatCatalogue *satellites;
+
 		int sendStop;			 // if stop running astrometry with stop signal; it ussually doesn't work, so we will use FIFO
 
 		std::string defaultImgProcess;
@@ -204,6 +219,14 @@ ImageProc::ImageProc (int _argc, char **_argv)
 
 	createValue (image_glob, "image_glob", "glob path for images processed in standy mode", false, RTS2_VALUE_WRITABLE);
 
+	createValue (satObjects, "sat_objects", "number of satellites in catalogue used to screen images", false);
+	createValue (satRadius, "sat_radius", "[deg] radius around image centre searched for satellites", false, RTS2_VALUE_WRITABLE | RTS2_DT_DEG_DIST);
+	createValue (satImages, "sat_images", "number of images crossed by satellites", false);
+	satImages->setValueInteger (0);
+	createValue (lastSats, "last_sats", "number of satellites crossing last image", false);
+
+	satellites = NULL;
+
 	imageGlob.gl_pathc = 0;
 	imageGlob.gl_offs = 0;
 	globPos = 0;
@@ -227,6 +250,7 @@ ImageProc::~ImageProc (void)
 		globfree (&imageGlob);
 	if (runningImage)
 		delete[] runningImage;
+	delete satellites;
 }
 
 int ImageProc::reloadConfig ()
@@ -257,6 +281,26 @@ int ImageProc::reloadConfig ()
 		logStream (MESSAGE_ERROR) << "ImageProc::reloadConfig cannot get obs process script, exiting" << sendLog;
 	}
 
+	const char *satFile = config->getStringDefault ("imgproc", "satellites", NULL);
+	if (satFile)
+	{
+		if (satellites == NULL)
+			satellites = new rts2sat::SatCatalogue (config->getIntegerDefault ("imgproc", "satellites_threads", 1));
+		int ns = satellites->load (satFile);
+		if (ns < 0)
+			logStream (MESSAGE_ERROR) << "cannot load satellites from " << satFile << sendLog;
+		else
+			logStream (MESSAGE_INFO) << "loaded " << ns << " satellites from " << satFile << sendLog;
+		satObjects->setValueInteger (ns < 0 ? 0 : ns);
+		satRadius->setValueDouble (config->getDoubleDefault ("imgproc", "satellites_radius", 0.5));
+	}
+	else
+	{
+		delete satellites;
+		satellites = NULL;
+		satObjects->setValueInteger (0);
+	}
+
 	ret = config->getString ("imgproc", "imageglob", imgglob);
 	if (ret || imgglob.length () == 0)
 		return ret;
@@ -316,6 +360,10 @@ void ImageProc::postEvent (rts2core::Event * event)
 			obsId = *((int *) event->getArg ());
 			queObs (obsId);
 			break;
+		case EVENT_OK_ASTROMETRY:
+			if (satellites)
+				screenSatellites ((rts2image::Image *) event->getArg ());
+			break;
 	}
 #ifdef RTS2_HAVE_PGSQL
 	rts2db::DeviceDb::postEvent (event);
@@ -324,6 +372,56 @@ void ImageProc::postEvent (rts2core::Event * event)
 #endif
 }
 
+void ImageProc::screenSatellites (rts2image::Image *image)
+{
+	struct ln_equ_posn pos;
+	try
+	{
+		image->getCoordBest (pos);
+	}
+	catch (rts2core::Error &er)
+	{
+		logStream (MESSAGE_WARNING) << "cannot get coordinates of " << image->getFileName () << " for satellites screening: " << er << sendLog;
+		return;
+	}
+
+	struct ln_lnlat_posn *observer = Configuration::instance ()->getObserver ();
+	std::vector <rts2sat::SatMatch> matches;
+	satellites->query (image->getExposureJD (), image->getExposureLength (), observer->lng, observer->lat, Configuration::instance ()->getObservatoryAltitude (), pos.ra, pos.dec, satRadius->getValueDouble (), matches);
+
+	try
+	{
+		image->setValue ("SATNUM", (int) matches.size (), "number of satellites crossing the field");
+		// keywords are limited to 8 characters
+		int i = 1;
+		for (std::vector <rts2sat::SatMatch>::iterator iter = matches.begin (); iter != matches.end () && i < 100; iter++, i++)
+		{
+			std::ostringstream k_id, k_sep, k_mot, k_pa;
+			k_id << "SATID" << i;
+			k_sep << "SATSEP" << i;
+			k_mot << "SATMOT" << i;
+			k_pa << "SATPA" << i;
+			image->setValue (k_id.str ().c_str (), iter->norad, "NORAD number of satellite crossing the field");
+			image->setValue (k_sep.str ().c_str (), iter->separation, "[deg] closest distance of satellite from field centre");
+			image->setValue (k_mot.str ().c_str (), iter->motion, "[deg/s] satellite apparent motion");
+			image->setValue (k_pa.str ().c_str (), iter->pa, "[deg] position angle of satellite motion");
+		}
+	}
+	catch (rts2core::Error &er)
+	{
+		logStream (MESSAGE_ERROR) << "cannot write satellites to " << image->getFileName () << ": " << er << sendLog;
+	}
+
+	lastSats->setValueInteger (matches.size ());
+	sendValueAll (lastSats);
+	if (matches.size () > 0)
+	{
+		satImages->inc ();
+		sendValueAll (satImages);
+		logStream (MESSAGE_INFO) << "image " << image->getFileName () << " crossed by " << matches.size () << " satellite(s), closest " << satellites->getIntlDesig (matches[0].index) << " (NORAD " << matches[0].norad << ")" << sendLog;
+	}
+}
+
 int ImageProc::getFreeSlot ()
 {
 	int free_slot = -1;
@@ -46,6 +46,7 @@ using namespace rts2image;
 
 #define OPT_NO_WRITE              OPT_LOCAL + 710
 #define OPT_RESET                 OPT_LOCAL + 711
+#define OPT_STREAM                OPT_LOCAL + 712
 
 bool usesNcurses = false;
 bool read100 = false;
@@ -219,6 +220,9 @@ int ScriptExec::processOption (int in_opt)
 		case OPT_NO_WRITE:
 			writeConnection = writeRTS2Values = false;
 			break;
+		case OPT_STREAM:
+			streamImage = true;
+			break;
 		default:
 			return rts2core::Client::processOption (in_opt);
 	}
@@ -265,10 +269,12 @@ ScriptExec::ScriptExec (int in_argc, char **in_argv):rts2core::Client (in_argc,
 	addOption ('o', NULL, 1, "filename expand string, existing file will be overwritten");
 	addOption ('t', NULL, 1, "template filename for FITS keys");
 	addOption (OPT_NO_WRITE, "no-metadata", 0, "don't write RTS2 metadata, use only template");
+	addOption (OPT_STREAM, "stream", 0, "write image data to disk as they arrive, keeping only last received chunk in memory");
 
 	srandom (time (NULL));
 
 	writeConnection = writeRTS2Values = true;
+	streamImage = false;
 }
 
 ScriptExec::~ScriptExec (void)
@@ -373,12 +379,14 @@ rts2core::DevClient *ScriptExec::createOtherType (rts2core::Connection * conn, i
 					bool b = !(Configuration::instance ()->getBoolean (conn->getName (), "no-metadata", true));
 					cli = new ClientCameraScript (conn, expandPath, tf, b, b);
 					((ClientCameraScript *) cli)->setOverwrite (overwrite);
+					((ClientCameraScript *) cli)->setStreamImage (streamImage);
 					break;
 				}
 			}
 
 			cli = new ClientCameraScript (conn, expandPath, templateFile, writeConnection, writeRTS2Values);
 			((ClientCameraScript *) cli)->setOverwrite (overwrite);
+			((ClientCameraScript *) cli)->setStreamImage (streamImage);
 			break;
 		case DEVICE_TYPE_FOCUS:
 			cli = new rts2image::DevClientFocusImage (conn);
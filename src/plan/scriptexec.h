@@ -91,6 +91,9 @@ class ScriptExec:public rts2core::Client, public rts2script::ScriptInterface
 
 		bool writeConnection;
 		bool writeRTS2Values;
+
+		// write images as data arrives
+		bool streamImage;
 };
 
 }
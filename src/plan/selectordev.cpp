@@ -22,6 +22,7 @@
 #include "rts2db/constraints.h"
 #include "rts2script/connselector.h"
 #include "rts2script/executorque.h"
+#include "rts2script/scriptcache.h"
 #include "rts2script/simulque.h"
 
 #include "connnotify.h"
@@ -30,6 +31,7 @@
 #include "command.h"
 #include "rts2db/devicedb.h"
 #include "rts2db/planset.h"
+#include "rts2db/targetcache.h"
 
 #define OPT_IDLE_SELECT         OPT_LOCAL + 5
 #define OPT_ADD_QUEUE           OPT_LOCAL + 6
@@ -199,6 +201,7 @@ SelectorDev::SelectorDev (int argc, char **argv):rts2db::DeviceDb (argc, argv, D
 	notifyConn = new rts2core::ConnNotify (this);
 	addConnection (notifyConn);
 	rts2db::MasterConstraints::setNotifyConnection (notifyConn);
+	rts2script::ScriptCache::setNotifyConnection (notifyConn);
 
 	createValue (next_id, "next_id", "ID of next target for selection", false);
 	next_id->setValueInteger (-1);
@@ -361,6 +364,13 @@ int SelectorDev::init ()
 	if (ret)
 		return ret;
 
+	// keep targets in memory, invalidate them on database notifications
+	rts2db::ConnTargetNotify *targetNotify = new rts2db::ConnTargetNotify (this);
+	if (targetNotify->init ())
+		delete targetNotify;
+	else
+		addConnection (targetNotify);
+
 	int i = 0;
 
 	setMessageMask (INFO_OBSERVATION_SLEW | INFO_OBSERVATION_INTERRUPTED | INFO_OBSERVATION_LOOP);
@@ -1034,6 +1044,7 @@ void SelectorDev::changeMasterState (rts2_status_t old_state, rts2_status_t new_
 #ifdef RTS2_HAVE_SYS_INOTIFY_H
 void SelectorDev::fileModified (struct inotify_event *event)
 {
+	rts2script::ScriptCache::revalidate (event->wd);
 	sel->revalidateConstraints (event->wd);
 	for (rts2plan::Queues::iterator iter = queues.begin (); iter != queues.end (); iter++)
 	{
@@ -20,23 +20,106 @@
 #include <string>
 #include "redis.h"
 
+#include <poll.h>
+#include <sstream>
+
+#define OPT_REDIS             OPT_LOCAL + 850
+
+// seconds between attempts to connect to redis
+#define REDIS_RETRY           5
+
+// when more commands wait for reply, value changes are only coalesced
+#define REDIS_MAX_OUTSTANDING 1000
+
 using namespace std;
 
-RedisProxy::RedisProxy (int in_argc, char **in_argv):rts2db::DeviceDb (in_argc, in_argv, DEVICE_TYPE_REDIS, "REDIS")
+// hiredis event loop adapter - registers redis socket in Block poll loop
+static void redisAddRead (void *privdata)
+{
+    ((RedisProxy *) privdata)->setRedisEvents (POLLIN, true);
+}
+
+static void redisDelRead (void *privdata)
+{
+    ((RedisProxy *) privdata)->setRedisEvents (POLLIN, false);
+}
+
+static void redisAddWrite (void *privdata)
+{
+    ((RedisProxy *) privdata)->setRedisEvents (POLLOUT, true);
+}
+
+static void redisDelWrite (void *privdata)
+{
+    ((RedisProxy *) privdata)->setRedisEvents (POLLOUT, false);
+}
+
+static void redisCleanup (void *privdata)
+{
+    ((RedisProxy *) privdata)->redisClosed ();
+}
+
+static void redisOnConnect (const redisAsyncContext *ac, int status)
 {
-    redisConn = redisConnect("127.0.0.1", 6379);
-    if (redisConn != NULL && redisConn->err) {
-        logStream (MESSAGE_ERROR) << "Redis connection error: " << redisConn->errstr << sendLog;
+    if (status != REDIS_OK)
+    {
+        logStream (MESSAGE_ERROR) << "Redis connection error: " << ac->errstr << sendLog;
+        return;
     }
+    ((RedisProxy *) ac->data)->redisConnected ();
 }
 
-RedisProxy::~RedisProxy (void)
+static void redisOnDisconnect (const redisAsyncContext *ac, int status)
+{
+    if (status != REDIS_OK)
+        logStream (MESSAGE_ERROR) << "Redis disconnected: " << ac->errstr << sendLog;
+}
+
+static void redisOnReply (redisAsyncContext *ac, void *reply, void *privdata)
+{
+    ((RedisProxy *) privdata)->redisReplied ((redisReply *) reply);
+}
+
+RedisProxy::RedisProxy (int in_argc, char **in_argv):rts2db::DeviceDb (in_argc, in_argv, DEVICE_TYPE_REDIS, "REDIS")
 {
+    notifyConn = NULL;
+
+    redisHost = "127.0.0.1";
+    redisPort = 6379;
+
+    redisAC = NULL;
+    redisFd = -1;
+    redisEvents = 0;
+    redisOutstanding = 0;
+    redisRetry = 0;
+    redisDropped = 0;
+
+    addOption (OPT_REDIS, "redis", 1, "redis server address and port (host:port), default to 127.0.0.1:6379");
+}
 
+RedisProxy::~RedisProxy (void)
+{
+    if (redisAC)
+        redisAsyncFree (redisAC);
 }
 
 int RedisProxy::processOption (int in_opt)
 {
+    switch (in_opt)
+    {
+        case OPT_REDIS:
+            {
+                string addr (optarg);
+                size_t pos = addr.find (':');
+                if (pos != string::npos)
+                {
+                    redisPort = atoi (addr.substr (pos + 1).c_str ());
+                    addr = addr.substr (0, pos);
+                }
+                redisHost = addr;
+            }
+            return 0;
+    }
     return rts2db::DeviceDb::processOption (in_opt);
 }
 
@@ -55,6 +138,8 @@ int RedisProxy::init ()
 
 	addConnection (notifyConn);
 
+	connectRedis ();
+
 	return ret;
 }
 
@@ -77,23 +162,38 @@ int RedisProxy::setValue (rts2core::Value *oldValue, rts2core::Value *newValue)
 
 int RedisProxy::deleteConnection (rts2core::Connection * in_conn)
 {
-    redisReply *r, *r2;
-    string connName;
-    if (in_conn == getSingleCentralConn())
-        connName = "centrald";
+    string connName = getConnName (in_conn);
+    std::map <std::string, RedisDevice>::iterator iter = devices.find (connName);
+
+    // delete keys which were written, do not search for them with KEYS
+    vector <string> keys;
+    keys.push_back ("rts2:" + connName + ":State");
+    keys.push_back ("rts2:" + connName + ":values");
+    if (iter != devices.end ())
+    {
+        for (std::map <std::string, std::string>::iterator vi = iter->second.values.begin (); vi != iter->second.values.end (); vi++)
+            keys.push_back ("rts2:" + connName + ":" + vi->first);
+        devices.erase (iter);
+    }
+
+    if (isRedisConnected ())
+    {
+        removeRedisDevice (connName, keys);
+    }
     else
-        connName = string(in_conn->getName());
-    r = (redisReply*)redisCommand(redisConn, "SREM rts2:devices %s", connName.c_str());
-    freeReplyObject(r);
-    r = (redisReply*)redisCommand(redisConn, "KEYS rts2:%s*", connName.c_str());
-    for (size_t i=0; i < r->elements; i++) {
-        r2 = (redisReply*)redisCommand(redisConn, "DEL %s", r->element[i]->str);
-        freeReplyObject(r2);
+    {
+        // keys might be stored from previous disconnection
+        vector <string> &removed = removedDevices[connName];
+        removed.insert (removed.end (), keys.begin (), keys.end ());
     }
-    freeReplyObject(r);
-    r = (redisReply*)redisCommand(redisConn, "PUBLISH %s disconnect", connName.c_str());
-    freeReplyObject(r);
-	return 0;
+
+    vector <string> args;
+    args.push_back ("PUBLISH");
+    args.push_back (connName);
+    args.push_back ("disconnect");
+    sendRedis (args);
+
+    return 0;
 }
 
 void RedisProxy::postEvent (rts2core::Event * event)
@@ -122,41 +222,38 @@ int RedisProxy::commandAuthorized (rts2core::Connection * conn)
 
 rts2core::DevClient *RedisProxy::createOtherType (rts2core::Connection *conn, int other_device_type)
 {
-    redisReply *r;
-    string connName(conn->getName());
-    if (connName == "") connName = "centrald";
-    r = (redisReply*)redisCommand(redisConn, "SADD rts2:devices %s", connName.c_str());
-    freeReplyObject(r);
-    r = (redisReply*)redisCommand(redisConn, "PUBLISH %s connect", connName.c_str());
-    freeReplyObject(r);
+    string connName (conn->getName ());
+    if (connName == "")
+        connName = "centrald";
+
+    vector <string> args;
+    args.push_back ("SADD");
+    args.push_back ("rts2:devices");
+    args.push_back (connName);
+    sendRedis (args);
+
+    args.clear ();
+    args.push_back ("PUBLISH");
+    args.push_back (connName);
+    args.push_back ("connect");
+    sendRedis (args);
+
     return new RedisProxyClient (conn);
 }
 
 void RedisProxy::stateChangedEvent(rts2core::Connection *conn, rts2core::ServerState *new_state)
 {
-    redisReply *r;
-    string connName(conn->getName());
-    if (conn == getSingleCentralConn())
-        connName = "centrald";
-    r = (redisReply*)redisCommand(redisConn, "SET rts2:%s:State %d", connName.c_str(), new_state->getValue());
-    freeReplyObject(r);
-    r = (redisReply*)redisCommand(redisConn, "PUBLISH %s state", connName.c_str());
-    freeReplyObject(r);
+    RedisDevice &dev = devices[getConnName (conn)];
+    dev.state = new_state->getValue ();
+    dev.stateChanged = true;
 }
 
 void RedisProxy::valueChangedEvent(rts2core::Connection *conn, rts2core::Value *new_value)
 {
-    redisReply *r;
-    string connName(conn->getName());
-    if (conn == getSingleCentralConn())
-        connName = "centrald";
-    r = (redisReply*)redisCommand(redisConn, "SADD rts2:%s:values %s", connName.c_str(), string(new_value->getName()).c_str());
-    freeReplyObject(r);
-    string key = "rts2:" + connName + ":" + new_value->getName();
-    r = (redisReply*)redisCommand(redisConn, "SET %s %s", key.c_str(), new_value->getValue());
-    freeReplyObject(r);
-    r = (redisReply*)redisCommand(redisConn, "PUBLISH %s value %s", connName.c_str(), new_value->getName().c_str());
-    freeReplyObject(r);
+    RedisDevice &dev = devices[getConnName (conn)];
+    const char *v = new_value->getValue ();
+    dev.values[new_value->getName ()] = v ? v : "";
+    dev.changed.insert (new_value->getName ());
 }
 
 void RedisProxy::message(rts2core::Message &msg)
@@ -168,9 +265,239 @@ void RedisProxy::message(rts2core::Message &msg)
     snprintf(buf, 1000, "%02i:%02i:%02i.%03i %s %s %s", tmesg.tm_hour, tmesg.tm_min, tmesg.tm_sec,
              (int)(msg.getMessageTimeUSec() / 1000), msg.getMessageOName(), msg.getTypeString(), msg.getMessageString().c_str());
 
-    redisReply *r;
-    r = (redisReply*)redisCommand(redisConn, "PUBLISH message %s", buf);
-    freeReplyObject(r);
+    vector <string> args;
+    args.push_back ("PUBLISH");
+    args.push_back ("message");
+    args.push_back (buf);
+    sendRedis (args);
+}
+
+void RedisProxy::addPollSocks ()
+{
+    rts2db::DeviceDb::addPollSocks ();
+    flushRedis ();
+    if (redisAC && redisEvents)
+        addPollFD (redisFd, redisEvents);
+}
+
+void RedisProxy::pollSuccess ()
+{
+    rts2db::DeviceDb::pollSuccess ();
+    if (redisAC == NULL)
+        return;
+    short ev = getPollEvents (redisFd);
+    if (ev & (POLLIN | POLLPRI | POLLHUP | POLLERR))
+        redisAsyncHandleRead (redisAC);
+    // context can be freed in read handler
+    if (redisAC && (ev & POLLOUT))
+        redisAsyncHandleWrite (redisAC);
+}
+
+int RedisProxy::idle ()
+{
+    if (redisAC == NULL && getNow () > redisRetry)
+        connectRedis ();
+    return rts2db::DeviceDb::idle ();
+}
+
+void RedisProxy::setRedisEvents (short events, bool enable)
+{
+    if (enable)
+        redisEvents |= events;
+    else
+        redisEvents &= ~events;
+}
+
+void RedisProxy::redisClosed ()
+{
+    removePollFD (redisFd);
+    redisAC = NULL;
+    redisFd = -1;
+    redisEvents = 0;
+    redisOutstanding = 0;
+    redisRetry = getNow () + REDIS_RETRY;
+}
+
+void RedisProxy::redisConnected ()
+{
+    logStream (MESSAGE_INFO) << "connected to redis at " << redisHost << ":" << redisPort << sendLog;
+    if (redisDropped > 0)
+    {
+        logStream (MESSAGE_WARNING) << redisDropped << " redis commands were not send while redis was disconnected, messages and events published during that time were lost" << sendLog;
+        redisDropped = 0;
+    }
+
+    // devices which disconnected in meantime, the same device might be connected again - it is added bellow
+    for (std::map <std::string, std::vector <std::string> >::iterator iter = removedDevices.begin (); iter != removedDevices.end (); iter++)
+        removeRedisDevice (iter->first, iter->second);
+    removedDevices.clear ();
+
+    // redis might be restarted, send all values again
+    for (std::map <std::string, RedisDevice>::iterator iter = devices.begin (); iter != devices.end (); iter++)
+    {
+        iter->second.stored.clear ();
+        for (std::map <std::string, std::string>::iterator vi = iter->second.values.begin (); vi != iter->second.values.end (); vi++)
+            iter->second.changed.insert (vi->first);
+        iter->second.stateChanged = true;
+
+        vector <string> args;
+        args.push_back ("SADD");
+        args.push_back ("rts2:devices");
+        args.push_back (iter->first);
+        sendRedis (args);
+    }
+}
+
+void RedisProxy::redisReplied (redisReply *reply)
+{
+    redisOutstanding--;
+    // connection was closed before command was executed
+    if (reply == NULL)
+        redisDropped++;
+    if (reply && reply->type == REDIS_REPLY_ERROR)
+        logStream (MESSAGE_ERROR) << "Redis error: " << reply->str << sendLog;
+}
+
+string RedisProxy::getConnName (rts2core::Connection *conn)
+{
+    if (conn == getSingleCentralConn ())
+        return string ("centrald");
+    return string (conn->getName ());
+}
+
+void RedisProxy::connectRedis ()
+{
+    redisAC = redisAsyncConnect (redisHost.c_str (), redisPort);
+    if (redisAC == NULL)
+    {
+        logStream (MESSAGE_ERROR) << "cannot allocate redis context" << sendLog;
+        redisRetry = getNow () + REDIS_RETRY;
+        return;
+    }
+    if (redisAC->err)
+    {
+        logStream (MESSAGE_ERROR) << "Redis connection error: " << redisAC->errstr << sendLog;
+        redisAsyncFree (redisAC);
+        redisAC = NULL;
+        redisRetry = getNow () + REDIS_RETRY;
+        return;
+    }
+
+    redisAC->data = this;
+    redisFd = redisAC->c.fd;
+    redisEvents = 0;
+
+    redisAC->ev.data = this;
+    redisAC->ev.addRead = redisAddRead;
+    redisAC->ev.delRead = redisDelRead;
+    redisAC->ev.addWrite = redisAddWrite;
+    redisAC->ev.delWrite = redisDelWrite;
+    redisAC->ev.cleanup = redisCleanup;
+
+    redisAsyncSetConnectCallback (redisAC, redisOnConnect);
+    redisAsyncSetDisconnectCallback (redisAC, redisOnDisconnect);
+
+    // connection is completed when socket becomes writable
+    setRedisEvents (POLLOUT, true);
+}
+
+void RedisProxy::removeRedisDevice (const string &connName, const vector <string> &keys)
+{
+    vector <string> args;
+    args.push_back ("SREM");
+    args.push_back ("rts2:devices");
+    args.push_back (connName);
+    sendRedis (args);
+
+    args.clear ();
+    args.push_back ("DEL");
+    args.insert (args.end (), keys.begin (), keys.end ());
+    sendRedis (args);
+}
+
+void RedisProxy::sendRedis (const vector <string> &args)
+{
+    if (!isRedisConnected ())
+    {
+        redisDropped++;
+        return;
+    }
+
+    vector <const char *> argv (args.size ());
+    vector <size_t> argvlen (args.size ());
+    for (size_t i = 0; i < args.size (); i++)
+    {
+        argv[i] = args[i].c_str ();
+        argvlen[i] = args[i].length ();
+    }
+    if (redisAsyncCommandArgv (redisAC, redisOnReply, this, args.size (), &argv[0], &argvlen[0]) == REDIS_OK)
+        redisOutstanding++;
+}
+
+void RedisProxy::flushRedis ()
+{
+    // when redis is slow, keep coalescing changes
+    if (redisAC == NULL || !(redisAC->c.flags & REDIS_CONNECTED) || redisOutstanding > REDIS_MAX_OUTSTANDING)
+        return;
+
+    for (std::map <std::string, RedisDevice>::iterator iter = devices.begin (); iter != devices.end (); iter++)
+    {
+        RedisDevice &dev = iter->second;
+        const string &connName = iter->first;
+
+        if (!dev.changed.empty ())
+        {
+            vector <string> sadd;
+            vector <string> mset;
+            vector <string> pub;
+
+            sadd.push_back ("SADD");
+            sadd.push_back ("rts2:" + connName + ":values");
+
+            mset.push_back ("MSET");
+
+            pub.push_back ("PUBLISH");
+            pub.push_back (connName);
+            string names = "value";
+
+            for (std::set <std::string>::iterator ci = dev.changed.begin (); ci != dev.changed.end (); ci++)
+            {
+                if (dev.stored.insert (*ci).second)
+                    sadd.push_back (*ci);
+                mset.push_back ("rts2:" + connName + ":" + *ci);
+                mset.push_back (dev.values[*ci]);
+                names += " " + *ci;
+            }
+            pub.push_back (names);
+
+            if (sadd.size () > 2)
+                sendRedis (sadd);
+            sendRedis (mset);
+            sendRedis (pub);
+
+            dev.changed.clear ();
+        }
+
+        if (dev.stateChanged)
+        {
+            ostringstream os;
+            os << dev.state;
+
+            vector <string> args;
+            args.push_back ("SET");
+            args.push_back ("rts2:" + connName + ":State");
+            args.push_back (os.str ());
+            sendRedis (args);
+
+            args.clear ();
+            args.push_back ("PUBLISH");
+            args.push_back (connName);
+            args.push_back ("state");
+            sendRedis (args);
+
+            dev.stateChanged = false;
+        }
+    }
 }
 
 int main (int argc, char **argv)
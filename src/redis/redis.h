@@ -27,6 +27,31 @@
 #include <rts2db/target.h>
 #include <devclient.h>
 #include <hiredis.h>
+#include <async.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * Redis image of single device. Value changes received within one run of
+ * the event loop are coalesced - only the last value is sent to redis.
+ */
+struct RedisDevice
+{
+    RedisDevice () { state = 0; stateChanged = false; }
+
+    // last known values
+    std::map <std::string, std::string> values;
+    // names of values changed since last flush
+    std::set <std::string> changed;
+    // names of values stored in rts2:<device>:values set
+    std::set <std::string> stored;
+
+    int state;
+    bool stateChanged;
+};
 
 class RedisProxy : public rts2db::DeviceDb
 {
@@ -57,6 +82,30 @@ public:
 
     virtual void message (rts2core::Message & msg);
 
+    virtual void addPollSocks ();
+
+    virtual void pollSuccess ();
+
+    /**
+     * Hiredis event loop adapter calls - enable or disable read or write events.
+     */
+    void setRedisEvents (short events, bool enable);
+
+    /**
+     * Called when hiredis context is about to be freed.
+     */
+    void redisClosed ();
+
+    /**
+     * Called when connection to redis was established.
+     */
+    void redisConnected ();
+
+    /**
+     * Called on reply to command send by sendRedis.
+     */
+    void redisReplied (redisReply *reply);
+
 protected:
     virtual int processOption (int in_opt);
 
@@ -68,9 +117,53 @@ protected:
 
     virtual int deleteConnection (rts2core::Connection * in_conn);
 
+    virtual int idle ();
+
 private:
     rts2core::ConnNotify *notifyConn;
-    redisContext *redisConn;
+
+    std::string redisHost;
+    int redisPort;
+
+    redisAsyncContext *redisAC;
+    int redisFd;
+    short redisEvents;
+    // number of commands waiting for reply
+    int redisOutstanding;
+    // time of next connection attempt
+    double redisRetry;
+    // number of commands which were not send because redis was not connected
+    long redisDropped;
+
+    std::map <std::string, RedisDevice> devices;
+
+    // keys of devices which disconnected while redis was not connected, deleted on reconnect
+    std::map <std::string, std::vector <std::string> > removedDevices;
+
+    std::string getConnName (rts2core::Connection *conn);
+
+    void connectRedis ();
+
+    bool isRedisConnected () { return redisAC != NULL && (redisAC->c.flags & REDIS_CONNECTED); }
+
+    /**
+     * Append command to redis pipeline. Command is send when redis
+     * socket is ready for write. Commands are dropped and counted when
+     * redis is not connected - values, states and device list are send
+     * again after reconnect, device removals are replayed from
+     * removedDevices.
+     */
+    void sendRedis (const std::vector <std::string> &args);
+
+    /**
+     * Remove device from rts2:devices set and delete its keys.
+     */
+    void removeRedisDevice (const std::string &connName, const std::vector <std::string> &keys);
+
+    /**
+     * Send coalesced value and state changes, one batch per device.
+     */
+    void flushRedis ();
 };
 
 class RedisProxyClient : public rts2core::DevClient
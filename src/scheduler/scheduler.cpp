@@ -23,8 +23,14 @@
 
 #include "rts2scheduler/schedbag.h"
 
+#include <unistd.h>
+
 #define OPT_START_DATE		OPT_LOCAL + 210
 #define OPT_END_DATE		OPT_LOCAL + 211
+#define OPT_EPHEMERIS_STEP	OPT_LOCAL + 212
+#define OPT_THREADS		OPT_LOCAL + 213
+#define OPT_SEED		OPT_LOCAL + 214
+#define OPT_BENCHMARK		OPT_LOCAL + 215
 
 /**
  * Class of the scheduler application.  Prepares schedule, and run
@@ -74,6 +80,18 @@ class Rts2ScheduleApp: public rts2db::AppDb
 		double startDate;
 		double endDate;
 
+		// step of precomputed target ephemeris
+		double ephemerisStep;
+
+		// number of threads evaluating schedules
+		int threads;
+
+		// random generator seed, -1 to seed from time
+		long seed;
+
+		// if true, only generations speed is reported
+		bool benchmark;
+
 		/**
 		 * Print merit of given type.
 		 *
@@ -130,6 +148,14 @@ Rts2ScheduleApp::Rts2ScheduleApp (int argc, char ** argv): rts2db::AppDb (argc,
 	startDate = NAN;
 	endDate = NAN;
 
+	ephemerisStep = 60;
+
+	long ncpu = sysconf (_SC_NPROCESSORS_ONLN);
+	threads = ncpu > 0 ? ncpu : 1;
+
+	seed = -1;
+	benchmark = false;
+
 	addOption ('v', NULL, 0, "verbosity level");
 	addOption ('g', NULL, 1, "number of generations");
 	addOption ('p', NULL, 1, "population size");
@@ -140,6 +166,10 @@ Rts2ScheduleApp::Rts2ScheduleApp (int argc, char ** argv): rts2db::AppDb (argc,
 
 	addOption (OPT_START_DATE, "start", 1, "produce schedule from this date");
 	addOption (OPT_END_DATE, "end", 1, "produce schedule till this date");
+	addOption (OPT_EPHEMERIS_STEP, "ephemeris-step", 1, "step (in seconds) of precomputed target altitude tables, 0 to compute target positions at each evaluation (default to 60)");
+	addOption (OPT_THREADS, "threads", 1, "number of threads evaluating schedules, needs ephemeris tables (default to number of CPUs)");
+	addOption (OPT_SEED, "seed", 1, "seed of the random number generator, for reproducible runs");
+	addOption (OPT_BENCHMARK, "benchmark", 0, "do not print generation statistics, report number of generations per second");
 }
 
 Rts2ScheduleApp::~Rts2ScheduleApp (void)
@@ -153,6 +183,8 @@ int Rts2ScheduleApp::doProcessing ()
 	if (verbose)
 	  	printMerits ();
 
+	double startTime = getNow ();
+
 	for (int i = 1; i <= generations; i++)
 	{
 		switch (algorithm)
@@ -165,6 +197,9 @@ int Rts2ScheduleApp::doProcessing ()
 				break;
 		}
 
+		if (benchmark)
+			continue;
+
 
 		if (verbose > 1)
 		{
@@ -210,6 +245,16 @@ int Rts2ScheduleApp::doProcessing ()
 		}
 	}
 
+	if (benchmark)
+	{
+		double duration = getNow () - startTime;
+		double _min, _avg, _max;
+		schedBag->getStatistics (_min, _avg, _max);
+		std::cout << "population " << popSize << " threads " << threads << " seed " << seed << std::endl
+			<< generations << " generations in " << duration << " s, " << generations / duration << " generations/second" << std::endl
+			<< "final fitness min " << _min << " avg " << _avg << " max " << _max << std::endl;
+	}
+
 	if (verbose)	
 		printMerits ();
 	if (printMeritsStat)
@@ -222,7 +267,9 @@ void Rts2ScheduleApp::usage ()
 {
 	std::cout << "\t" << getAppName () << std::endl
 		<< " To get schedule from 17th January 2006 01:17:18 UT to 18th January 2006 01:17:18 UT" << std::endl
-		<< "\t" << getAppName () << " --start 2006-01-17T01:17:18 --end 2006-01-18T02:03:04" << std::endl;
+		<< "\t" << getAppName () << " --start 2006-01-17T01:17:18 --end 2006-01-18T02:03:04" << std::endl
+		<< " To measure speed of 200 generations of population of 400 schedules, with reproducible results" << std::endl
+		<< "\t" << getAppName () << " -p 400 -g 200 --seed 1 --benchmark" << std::endl;
 }
 
 void Rts2ScheduleApp::help ()
@@ -279,6 +326,28 @@ int Rts2ScheduleApp::processOption (int _opt)
 			return parseDate (optarg, startDate);
 		case OPT_END_DATE:
 			return parseDate (optarg, endDate);
+		case OPT_THREADS:
+			threads = atoi (optarg);
+			if (threads <= 0)
+			{
+				logStream (MESSAGE_ERROR) << "Number of threads must be positive number " << optarg << sendLog;
+				return -1;
+			}
+			break;
+		case OPT_SEED:
+			seed = atol (optarg);
+			break;
+		case OPT_BENCHMARK:
+			benchmark = true;
+			break;
+		case OPT_EPHEMERIS_STEP:
+			ephemerisStep = atof (optarg);
+			if (ephemerisStep < 0)
+			{
+				logStream (MESSAGE_ERROR) << "Ephemeris step must not be negative " << optarg << sendLog;
+				return -1;
+			}
+			break;
 		default:
 			return rts2db::AppDb::processOption (_opt);
 	}
@@ -292,7 +361,7 @@ int Rts2ScheduleApp::init ()
 	if (ret)
 		return ret;
 
-	srandom (time (NULL));
+	srandom (seed >= 0 ? seed : time (NULL));
 
 	// initialize schedules..
 	if (std::isnan (startDate))
@@ -313,6 +382,8 @@ int Rts2ScheduleApp::init ()
 		std::cout << "Generating schedule for night " << LibnovaDate (obsNight) << std::endl;
 
 		schedBag = new Rts2SchedBag (NAN, NAN);
+		schedBag->setEphemerisStep (ephemerisStep);
+		schedBag->setThreads (threads);
 		ret = schedBag->constructSchedulesFromObsSet (popSize, obsNight);
 		if (ret)
 			return ret;
@@ -322,6 +393,8 @@ int Rts2ScheduleApp::init ()
 		std::cout << "Generating schedule from " << LibnovaDate (startDate) << " to " << LibnovaDate (endDate) << std::endl;
 
 		schedBag = new Rts2SchedBag (startDate, endDate);
+		schedBag->setEphemerisStep (ephemerisStep);
+		schedBag->setThreads (threads);
 
 		ret = schedBag->constructSchedules (popSize);
 		if (ret)
@@ -0,0 +1,19 @@
+-- notify listeners about changes of targets, so they can invalidate cached targets
+CREATE OR REPLACE FUNCTION targets_notify () RETURNS trigger AS $$
+BEGIN
+	IF TG_OP = 'DELETE' THEN
+		PERFORM pg_notify ('rts2_targets', OLD.tar_id::text);
+		RETURN OLD;
+	END IF;
+	PERFORM pg_notify ('rts2_targets', NEW.tar_id::text);
+	RETURN NEW;
+END;
+$$ LANGUAGE plpgsql;
+
+DROP TRIGGER IF EXISTS targets_notify ON targets;
+CREATE TRIGGER targets_notify AFTER INSERT OR UPDATE OR DELETE ON targets
+	FOR EACH ROW EXECUTE PROCEDURE targets_notify ();
+
+DROP TRIGGER IF EXISTS grb_notify ON grb;
+CREATE TRIGGER grb_notify AFTER INSERT OR UPDATE OR DELETE ON grb
+	FOR EACH ROW EXECUTE PROCEDURE targets_notify ();
@@ -0,0 +1,214 @@
+/*
+ * Fit RTS2 pointing model to measured data.
+ * Copyright (C) 2026 Petr Kubanek <petr@kubanek.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "cliapp.h"
+#include "gpointfit.h"
+#include "utilsfunc.h"
+
+#include <fstream>
+#include <iomanip>
+
+#define OPT_LATITUDE       OPT_LOCAL + 240
+#define OPT_FIX            OPT_LOCAL + 241
+
+namespace rts2teld
+{
+
+/**
+ * Fit GPoint model to data files in gpoint input format.
+ *
+ * @author Petr Kubanek <petr@kubanek.net>
+ */
+class GPointFitApp:public rts2core::CliApp
+{
+	public:
+		GPointFitApp (int in_argc, char **in_argv);
+
+	protected:
+		virtual void usage ();
+
+		virtual int processOption (int in_opt);
+		virtual int processArgs (const char *arg);
+
+		virtual int doProcessing ();
+
+	private:
+		const char *modelFile;
+		const char *outputFile;
+		double latitude;
+		std::vector <std::string> fixed;
+		std::vector <std::string> dataFiles;
+};
+
+}
+
+using namespace rts2teld;
+
+GPointFitApp::GPointFitApp (int in_argc, char **in_argv):rts2core::CliApp (in_argc, in_argv)
+{
+	modelFile = NULL;
+	outputFile = NULL;
+	latitude = NAN;
+
+	addOption ('m', NULL, 1, "initial model file; its extra terms are fitted together with base parameters");
+	addOption ('o', NULL, 1, "write fitted model to given file");
+	addOption (OPT_LATITUDE, "latitude", 1, "observatory latitude, if not specified in input files");
+	addOption (OPT_FIX, "fix", 1, "comma separated list of base parameters which will not be fitted");
+}
+
+void GPointFitApp::usage ()
+{
+	std::cout << "To fit model to data from pointing run, using extra terms from model file:" << std::endl
+		<< "\t" << getAppName () << " -m model.in -o model.out pointing.dat" << std::endl
+		<< "To fit alt-az model without tube flexure:" << std::endl
+		<< "\t" << getAppName () << " --fix tf pointing.dat" << std::endl;
+}
+
+int GPointFitApp::processOption (int in_opt)
+{
+	switch (in_opt)
+	{
+		case 'm':
+			modelFile = optarg;
+			break;
+		case 'o':
+			outputFile = optarg;
+			break;
+		case OPT_LATITUDE:
+			latitude = atof (optarg);
+			break;
+		case OPT_FIX:
+			{
+				std::vector <std::string> f = SplitStr (optarg, ",");
+				fixed.insert (fixed.end (), f.begin (), f.end ());
+			}
+			break;
+		default:
+			return rts2core::CliApp::processOption (in_opt);
+	}
+	return 0;
+}
+
+int GPointFitApp::processArgs (const char *arg)
+{
+	dataFiles.push_back (arg);
+	return 0;
+}
+
+int GPointFitApp::doProcessing ()
+{
+	if (dataFiles.empty ())
+	{
+		std::cerr << "missing input files" << std::endl;
+		help ();
+		return -1;
+	}
+
+	rts2telmodel::GPointFit fit;
+	fit.setLatitude (latitude);
+
+	for (std::vector <std::string>::iterator iter = dataFiles.begin (); iter != dataFiles.end (); iter++)
+	{
+		std::ifstream is (iter->c_str ());
+		if (is.fail ())
+		{
+			std::cerr << "cannot open " << *iter << std::endl;
+			return -1;
+		}
+		try
+		{
+			fit.loadData (is);
+		}
+		catch (rts2core::Error &er)
+		{
+			std::cerr << *iter << ": " << er << std::endl;
+			return -1;
+		}
+	}
+
+	for (std::vector <std::string>::iterator iter = fixed.begin (); iter != fixed.end (); iter++)
+	{
+		if (fit.setFixed (iter->c_str ()))
+		{
+			std::cerr << "unknown parameter " << *iter << std::endl;
+			return -1;
+		}
+	}
+
+	rts2telmodel::GPointModel model (fit.getLatitude ());
+	if (modelFile)
+	{
+		std::ifstream is (modelFile);
+		try
+		{
+			model.load (is);
+		}
+		catch (rts2core::Error &er)
+		{
+			std::cerr << modelFile << ": " << er << std::endl;
+			return -1;
+		}
+		if (model.altaz != fit.isAltAz ())
+		{
+			std::cerr << "model and data mount type differ" << std::endl;
+			return -1;
+		}
+	}
+
+	std::cout << std::fixed << std::setprecision (2);
+	std::cout << "points " << fit.getData ().size () << (fit.isAltAz () ? " alt-az" : " equatorial") << " mount, latitude " << fit.getLatitude () << std::endl;
+	std::cout << "initial RMS " << fit.getRMS (&model) * 3600.0 << "\"" << std::endl;
+
+	double t1 = getNow ();
+	if (fit.fit (&model))
+	{
+		std::cerr << "cannot fit model - not enough points, or parameters are degenerate" << std::endl;
+		return -1;
+	}
+	double t2 = getNow ();
+
+	std::cout << std::left << std::setw (24) << "name" << std::right << std::setw (12) << "value[\"]" << std::setw (12) << "stderr[\"]" << std::endl;
+	for (size_t i = 0; i < fit.getParamNames ().size (); i++)
+		std::cout << std::left << std::setw (24) << fit.getParamNames ()[i] << std::right << std::setw (12) << ln_rad_to_deg (fit.getParamValues ()[i]) * 3600.0 << std::setw (12) << ln_rad_to_deg (fit.getParamErrors ()[i]) * 3600.0 << std::endl;
+
+	std::cout << "fitted RMS " << fit.getRMS (&model) * 3600.0 << "\" in " << std::setprecision (3) << (t2 - t1) << " s" << std::endl;
+
+	if (outputFile)
+	{
+		std::ofstream os (outputFile);
+		model.print (os, '"');
+		if (os.fail ())
+		{
+			std::cerr << "cannot write model to " << outputFile << std::endl;
+			return -1;
+		}
+	}
+	else
+	{
+		model.print (std::cout, '"');
+	}
+
+	return 0;
+}
+
+int main (int argc, char **argv)
+{
+	GPointFitApp app (argc, argv);
+	return app.run ();
+}